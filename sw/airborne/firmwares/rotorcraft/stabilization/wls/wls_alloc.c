@@ -72,7 +72,10 @@ void print_in_and_outputs(int n_c, int n_free, float** A_free_ptr, float* d, flo
  * @param n number of columns
  */
 void qr_solve_wrapper(int m, int n, float** A, float* b, float* x) {
-  float in[m * n];
+  // workspace of the largest problem, m <= CA_N_C and n <= CA_N_U
+  static float in[CA_N_C * CA_N_U];
+  static float work[QR_SOLVE_WORK_SIZE(CA_N_C, CA_N_U)];
+  static int iwork[QR_SOLVE_IWORK_SIZE(CA_N_C, CA_N_U)];
   // convert A to 1d array
   int k = 0;
   for (int j = 0; j < n; j++) {
@@ -81,7 +84,7 @@ void qr_solve_wrapper(int m, int n, float** A, float* b, float* x) {
     }
   }
   // use solver
-  qr_solve(m, n, in, b, x);
+  qr_solve_ws(m, n, in, b, x, work, iwork);
 }
 
 /**
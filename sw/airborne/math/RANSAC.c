@@ -29,101 +29,209 @@
  * Read: Fischler, M. A., & Bolles, R. C. (1981). Random sample consensus: a paradigm for model fitting with applications to image analysis and automated cartography.
  * Communications of the ACM, 24(6), 381-395.
  *
- * This file depends on the function fit_linear_model in math/pprz_matrix_decomp_float.h/c
+ * The hypotheses are evaluated by blocks of RANSAC_BLOCK, with NEON when
+ * available, and the evaluation of a block stops as soon as it can no longer
+ * beat the best hypothesis found so far.
+ *
+ * This file depends on the header-only solver in math/qr_solve/qr_solve_fixed.h
  */
 
 
 #include "RANSAC.h"
-#include "math/pprz_matrix_decomp_float.h"
-#include "math/pprz_algebra_float.h"
+#include "math/qr_solve/qr_solve_fixed.h"
 #include <math.h>
+#include <float.h>
 #include <string.h>
 #include <stdlib.h>
-#include "stdio.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RANSAC_USE_NEON 1
+#endif
+
+#if RANSAC_BLOCK != 4
+#error RANSAC_BLOCK has to match the NEON vector size
+#endif
+
+/** Number of samples evaluated between two early termination checks */
+#define RANSAC_CHUNK 32
+
+/** Workspace of RANSAC_linear_model, A is column-major with a last column of ones for the bias */
+static struct {
+  int indices_subset[RANSAC_MAX_SAMPLES];
+  float subset_A[RANSAC_MAX_SAMPLES * (RANSAC_MAX_D + 1)];
+  float subset_targets[RANSAC_MAX_SAMPLES];
+  float qr[RANSAC_MAX_SAMPLES * (RANSAC_MAX_D + 1)];
+  float qtb[RANSAC_MAX_SAMPLES];
+  int piv[RANSAC_MAX_D + 1];
+  float hypotheses[RANSAC_MAX_ITERATIONS * (RANSAC_MAX_D + 1)];
+} ransac_ws;
 
 /** Perform RANSAC to fit a linear model.
  *
- * @param[in] n_samples The number of samples to use for a single fit
- * @param[in] n_iterations The number of times a linear fit is performed
+ * The hypotheses are stored in a static workspace, so this function is not
+ * reentrant. The parameters are set to zero when D is above RANSAC_MAX_D.
+ *
+ * @param[in] n_samples The number of samples to use for a single fit, at most RANSAC_MAX_SAMPLES
+ * @param[in] n_iterations The number of times a linear fit is performed, at most RANSAC_MAX_ITERATIONS
  * @param[in] error_threshold The threshold used to cap errors in the RANSAC process
  * @param[in] targets The target values
  * @param[in] samples The samples / feature vectors
  * @param[in] D The dimensionality of the samples
  * @param[in] count The number of samples
  * @param[out] parameters* Parameters of the linear fit, of size D + 1 (accounting for a constant 1 being added to the samples to represent a potential bias)
- * @param[out] fit_error* Total error of the fit
+ * @param[out] fit_error* Total capped error of the fit, can be NULL
  *
  */
 void RANSAC_linear_model(int n_samples, int n_iterations, float error_threshold, float *targets, int D,
-                         float (*samples)[D], uint16_t count, float *params, float *fit_error __attribute__((unused)))
+                         float (*samples)[D], uint16_t count, float *params, float *fit_error)
 {
 
-  uint8_t D_1 = D + 1;
+  int D_1 = D + 1;
   float err;
-  float errors[n_iterations];
-  int indices_subset[n_samples];
-  float subset_targets[n_samples];
-  float subset_samples[n_samples][D];
-  float subset_params[n_iterations][D_1];
-  bool use_bias = true;
+
+  if (count == 0 || n_iterations <= 0 || D > RANSAC_MAX_D) {
+    memset(params, 0, D_1 * sizeof(float));
+    return;
+  }
+  n_iterations = (n_iterations < RANSAC_MAX_ITERATIONS) ? n_iterations : RANSAC_MAX_ITERATIONS;
 
   // ensure that n_samples is high enough to ensure a result for a single fit:
   n_samples = (n_samples < D_1) ? D_1 : n_samples;
-  // n_samples should not be higher than count:
+  // n_samples should not be higher than count and the workspace:
   n_samples = (n_samples < count) ? n_samples : count;
+  n_samples = (n_samples < RANSAC_MAX_SAMPLES) ? n_samples : RANSAC_MAX_SAMPLES;
 
-  // do the RANSAC iterations:
+  // generate the hypotheses:
   for (int i = 0; i < n_iterations; i++) {
 
     // get a subset of indices
-    get_indices_without_replacement(indices_subset, n_samples, count);
+    get_indices_without_replacement(ransac_ws.indices_subset, n_samples, count);
 
     // get the corresponding samples and targets:
     for (int j = 0; j < n_samples; j++) {
-      subset_targets[j] = targets[indices_subset[j]];
+      int idx = ransac_ws.indices_subset[j];
+      ransac_ws.subset_targets[j] = targets[idx];
       for (int k = 0; k < D; k++) {
-        subset_samples[j][k] = samples[indices_subset[j]][k];
+        ransac_ws.subset_A[j + k * n_samples] = samples[idx][k];
       }
+      ransac_ws.subset_A[j + D * n_samples] = 1.0f;
     }
 
     // fit a linear model on the small system:
-    fit_linear_model(subset_targets, D, subset_samples, n_samples, use_bias, subset_params[i], &err);
-    printf("params normal: %f, %f\n", subset_params[i][0], subset_params[i][1]);
-    float priors[2];
-    priors[0] = 1.0f;
-    priors[1] = 10.0f;
-    fit_linear_model_prior(subset_targets, D, subset_samples, n_samples, use_bias, priors, subset_params[i], &err);
-    printf("params prior: %f, %f\n", subset_params[i][0], subset_params[i][1]);
-
-    // determine the error on the whole set:
-    float err_sum = 0.0f;
-    float prediction;
-    for (int j = 0; j < count; j++) {
-      // predict the sample's value and determine the absolute error:
-      prediction = predict_value(samples[j], subset_params[i], D, use_bias);
-      err = fabsf(prediction - targets[j]);
-      // cap the error with the threshold:
-      err = (err > error_threshold) ? error_threshold : err;
-      err_sum += err;
-    }
-    errors[i] = err_sum;
+    qr_solve_fixed_impl(n_samples, D_1, ransac_ws.subset_A, ransac_ws.subset_targets, &ransac_ws.hypotheses[i * D_1],
+                        ransac_ws.qr, ransac_ws.qtb, ransac_ws.piv);
   }
 
-  // determine the minimal error:
-  float min_err = errors[0];
-  int min_ind = 0;
-  for (int i = 1; i < n_iterations; i++) {
-    if (errors[i] < min_err) {
-      min_err = errors[i];
-      min_ind = i;
+  // keep the one with the minimal error on the whole set:
+  int best = RANSAC_best_linear_hypothesis(n_iterations, D, ransac_ws.hypotheses, samples, targets, count,
+                                           error_threshold, &err);
+
+  // copy the parameters:
+  memcpy(params, &ransac_ws.hypotheses[best * D_1], D_1 * sizeof(float));
+  if (fit_error != NULL) {
+    *fit_error = err;
+  }
+}
+
+/** Capped errors of a block of hypotheses on the samples [start, end[
+ *
+ * @param[in] w Parameters of the block, w[d * RANSAC_BLOCK + h] for dimension d (D is the bias) of hypothesis h
+ * @param[in,out] err Error sums of the block
+ */
+static void capped_errors_block(int D, const float *w, float (*samples)[D], const float *targets,
+                                int start, int end, float error_threshold, float *err)
+{
+#if RANSAC_USE_NEON
+  float32x4_t e = vld1q_f32(err);
+  const float32x4_t thr = vdupq_n_f32(error_threshold);
+  const float32x4_t bias = vld1q_f32(&w[D * RANSAC_BLOCK]);
+  for (int p = start; p < end; p++) {
+    float32x4_t pred = vdupq_n_f32(0.f);
+    for (int d = 0; d < D; d++) {
+      pred = vmlaq_n_f32(pred, vld1q_f32(&w[d * RANSAC_BLOCK]), samples[p][d]);
+    }
+    pred = vaddq_f32(pred, bias);
+    e = vaddq_f32(e, vminq_f32(vabdq_f32(pred, vdupq_n_f32(targets[p])), thr));
+  }
+  vst1q_f32(err, e);
+#else
+  for (int p = start; p < end; p++) {
+    float pred[RANSAC_BLOCK] = { 0.f };
+    for (int d = 0; d < D; d++) {
+      for (int h = 0; h < RANSAC_BLOCK; h++) {
+        pred[h] += w[d * RANSAC_BLOCK + h] * samples[p][d];
+      }
+    }
+    for (int h = 0; h < RANSAC_BLOCK; h++) {
+      float e = fabsf(pred[h] + w[D * RANSAC_BLOCK + h] - targets[p]);
+      err[h] += (e < error_threshold) ? e : error_threshold;
     }
   }
+#endif
+}
 
-  // copy the parameters:
-  for (int d = 0; d < D_1; d++) {
-    params[d] = subset_params[min_ind][d];
+/** Select the linear hypothesis with the minimal capped error.
+ *
+ * @param[in] n_hyp The number of hypotheses
+ * @param[in] D The dimensionality of the samples, at most RANSAC_MAX_D
+ * @param[in] hypotheses The parameters of the hypotheses, n_hyp times D + 1 (the last one is the bias)
+ * @param[in] samples The samples / feature vectors
+ * @param[in] targets The target values
+ * @param[in] count The number of samples
+ * @param[in] error_threshold The threshold used to cap errors
+ * @param[out] min_error Total capped error of the selected hypothesis, can be NULL
+ * @return The index of the selected hypothesis, the first one in case of equal errors (0 when D is too large)
+ */
+int RANSAC_best_linear_hypothesis(int n_hyp, int D, const float *hypotheses, float (*samples)[D],
+                                  const float *targets, int count, float error_threshold, float *min_error)
+{
+  int D_1 = D + 1;
+  int best = 0;
+  float best_err = FLT_MAX;
+  float w[(RANSAC_MAX_D + 1) * RANSAC_BLOCK];
+  float err[RANSAC_BLOCK];
+
+  if (D > RANSAC_MAX_D) {
+    n_hyp = 0;
   }
 
+  for (int first = 0; first < n_hyp; first += RANSAC_BLOCK) {
+    // the last block is padded with copies of the last hypothesis
+    int nb = (n_hyp - first < RANSAC_BLOCK) ? n_hyp - first : RANSAC_BLOCK;
+    for (int h = 0; h < RANSAC_BLOCK; h++) {
+      const float *hyp = &hypotheses[(first + (h < nb ? h : nb - 1)) * D_1];
+      for (int d = 0; d < D_1; d++) {
+        w[d * RANSAC_BLOCK + h] = hyp[d];
+      }
+      err[h] = 0.f;
+    }
+
+    for (int start = 0; start < count; start += RANSAC_CHUNK) {
+      int end = (start + RANSAC_CHUNK < count) ? start + RANSAC_CHUNK : count;
+      capped_errors_block(D, w, samples, targets, start, end, error_threshold, err);
+      // the errors only grow, stop when no hypothesis of the block can be selected anymore
+      float block_min = err[0];
+      for (int h = 1; h < nb; h++) {
+        block_min = (err[h] < block_min) ? err[h] : block_min;
+      }
+      if (block_min >= best_err) {
+        break;
+      }
+    }
+
+    for (int h = 0; h < nb; h++) {
+      if (err[h] < best_err) {
+        best_err = err[h];
+        best = first + h;
+      }
+    }
+  }
+
+  if (min_error != NULL) {
+    *min_error = best_err;
+  }
+  return best;
 }
 
 /** Predict the value of a sample with linear weights.
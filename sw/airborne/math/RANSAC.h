@@ -29,7 +29,9 @@
  * Read: Fischler, M. A., & Bolles, R. C. (1981). Random sample consensus: a paradigm for model fitting with applications to image analysis and automated cartography.
  * Communications of the ACM, 24(6), 381-395.
  *
- * This file depends on the function fit_linear_model in math/pprz_matrix_decomp_float.h/c
+ * The hypotheses are evaluated by blocks of RANSAC_BLOCK, with NEON when
+ * available, and the evaluation of a block stops as soon as it can no longer
+ * beat the best hypothesis found so far.
  */
 
 #ifndef RANSAC_H
@@ -41,21 +43,57 @@ extern "C" {
 
 #include "std.h"
 
+/** Number of hypotheses evaluated together */
+#define RANSAC_BLOCK 4
+
+/** Maximum dimensionality of the samples, larger ones are not fit */
+#ifndef RANSAC_MAX_D
+#define RANSAC_MAX_D 8
+#endif
+
+/** Maximum number of samples of a single fit, more are clamped */
+#ifndef RANSAC_MAX_SAMPLES
+#define RANSAC_MAX_SAMPLES 32
+#endif
+
+/** Maximum number of iterations of RANSAC_linear_model, more are clamped */
+#ifndef RANSAC_MAX_ITERATIONS
+#define RANSAC_MAX_ITERATIONS 100
+#endif
+
 /** Perform RANSAC to fit a linear model.
  *
- * @param[in] n_samples The number of samples to use for a single fit
- * @param[in] n_iterations The number of times a linear fit is performed
+ * The hypotheses are stored in a static workspace, so this function is not
+ * reentrant. The parameters are set to zero when D is above RANSAC_MAX_D.
+ *
+ * @param[in] n_samples The number of samples to use for a single fit, at most RANSAC_MAX_SAMPLES
+ * @param[in] n_iterations The number of times a linear fit is performed, at most RANSAC_MAX_ITERATIONS
  * @param[in] error_threshold The threshold used to cap errors in the RANSAC process
  * @param[in] targets The target values
  * @param[in] samples The samples / feature vectors
  * @param[in] D The dimensionality of the samples
  * @param[in] count The number of samples
  * @param[out] parameters* Parameters of the linear fit
- * @param[out] fit_error* Total error of the fit
+ * @param[out] fit_error* Total capped error of the fit, can be NULL
  */
 void RANSAC_linear_model(int n_samples, int n_iterations, float error_threshold, float *targets, int D,
                          float (*samples)[D], uint16_t count, float *params, float *fit_error);
 
+/** Select the linear hypothesis with the minimal capped error.
+ *
+ * @param[in] n_hyp The number of hypotheses
+ * @param[in] D The dimensionality of the samples, at most RANSAC_MAX_D
+ * @param[in] hypotheses The parameters of the hypotheses, n_hyp times D + 1 (the last one is the bias)
+ * @param[in] samples The samples / feature vectors
+ * @param[in] targets The target values
+ * @param[in] count The number of samples
+ * @param[in] error_threshold The threshold used to cap errors
+ * @param[out] min_error Total capped error of the selected hypothesis, can be NULL
+ * @return The index of the selected hypothesis, the first one in case of equal errors (0 when D is too large)
+ */
+int RANSAC_best_linear_hypothesis(int n_hyp, int D, const float *hypotheses, float (*samples)[D],
+                                  const float *targets, int count, float error_threshold, float *min_error);
+
 /** Get indices without replacement.
  *
  * @param[out] indices_subset This will be filled with the sampled indices
@@ -26,6 +26,28 @@
 
 #include "pprz_algebra_float.h"
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FLOAT_BATCH_SIMD 1
+typedef float32x4_t float4_t;
+#define F4_LOAD(_p) vld1q_f32(_p)
+#define F4_STORE(_p, _v) vst1q_f32(_p, _v)
+#define F4_SET(_f) vdupq_n_f32(_f)
+#define F4_ADD(_a, _b) vaddq_f32(_a, _b)
+#define F4_SUB(_a, _b) vsubq_f32(_a, _b)
+#define F4_MUL(_a, _b) vmulq_f32(_a, _b)
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define FLOAT_BATCH_SIMD 1
+typedef __m128 float4_t;
+#define F4_LOAD(_p) _mm_loadu_ps(_p)
+#define F4_STORE(_p, _v) _mm_storeu_ps(_p, _v)
+#define F4_SET(_f) _mm_set1_ps(_f)
+#define F4_ADD(_a, _b) _mm_add_ps(_a, _b)
+#define F4_SUB(_a, _b) _mm_sub_ps(_a, _b)
+#define F4_MUL(_a, _b) _mm_mul_ps(_a, _b)
+#endif
+
 /** in place first order integration of a 3D-vector */
 void float_vect3_integrate_fi(struct FloatVect3 *vec, struct FloatVect3 *dv, float dt)
 {
@@ -992,3 +1014,170 @@ void vect_scale(struct FloatVect3 *vect3, float norm_des) {
     vect3->y *= scale;
   }
 }
+
+/*
+ * Batch operations
+ *
+ * Four elements at a time with SIMD, the remaining ones with the scalar functions.
+ */
+
+void float_rmat_vmult_batch(struct FloatVect3Array *vb, struct FloatRMat *m_a2b,
+                            struct FloatVect3Array *va, int n)
+{
+  int i = 0;
+#if FLOAT_BATCH_SIMD
+  float4_t m[9];
+  for (int k = 0; k < 9; k++) {
+    m[k] = F4_SET(m_a2b->m[k]);
+  }
+  for (; i + 4 <= n; i += 4) {
+    float4_t x = F4_LOAD(&va->x[i]);
+    float4_t y = F4_LOAD(&va->y[i]);
+    float4_t z = F4_LOAD(&va->z[i]);
+    F4_STORE(&vb->x[i], F4_ADD(F4_ADD(F4_MUL(m[0], x), F4_MUL(m[1], y)), F4_MUL(m[2], z)));
+    F4_STORE(&vb->y[i], F4_ADD(F4_ADD(F4_MUL(m[3], x), F4_MUL(m[4], y)), F4_MUL(m[5], z)));
+    F4_STORE(&vb->z[i], F4_ADD(F4_ADD(F4_MUL(m[6], x), F4_MUL(m[7], y)), F4_MUL(m[8], z)));
+  }
+#endif
+  for (; i < n; i++) {
+    struct FloatVect3 a = { va->x[i], va->y[i], va->z[i] };
+    struct FloatVect3 b;
+    float_rmat_vmult(&b, m_a2b, &a);
+    vb->x[i] = b.x;
+    vb->y[i] = b.y;
+    vb->z[i] = b.z;
+  }
+}
+
+void float_quat_vmult_batch(struct FloatVect3Array *v_out, struct FloatQuatArray *q,
+                            struct FloatVect3Array *v_in, int n)
+{
+  int i = 0;
+#if FLOAT_BATCH_SIMD
+  const float4_t half = F4_SET(0.5f);
+  for (; i + 4 <= n; i += 4) {
+    float4_t qi = F4_LOAD(&q->qi[i]);
+    float4_t qx = F4_LOAD(&q->qx[i]);
+    float4_t qy = F4_LOAD(&q->qy[i]);
+    float4_t qz = F4_LOAD(&q->qz[i]);
+    // same as float_quat_vmult
+    float4_t qi2_M1_2 = F4_SUB(F4_MUL(qi, qi), half);
+    float4_t qiqx = F4_MUL(qi, qx);
+    float4_t qiqy = F4_MUL(qi, qy);
+    float4_t qiqz = F4_MUL(qi, qz);
+    float4_t qxqy = F4_MUL(qx, qy);
+    float4_t qxqz = F4_MUL(qx, qz);
+    float4_t qyqz = F4_MUL(qy, qz);
+    float4_t m00 = F4_ADD(qi2_M1_2, F4_MUL(qx, qx));
+    float4_t m01 = F4_ADD(qxqy, qiqz);
+    float4_t m02 = F4_SUB(qxqz, qiqy);
+    float4_t m10 = F4_SUB(qxqy, qiqz);
+    float4_t m11 = F4_ADD(qi2_M1_2, F4_MUL(qy, qy));
+    float4_t m12 = F4_ADD(qyqz, qiqx);
+    float4_t m20 = F4_ADD(qxqz, qiqy);
+    float4_t m21 = F4_SUB(qyqz, qiqx);
+    float4_t m22 = F4_ADD(qi2_M1_2, F4_MUL(qz, qz));
+    float4_t x = F4_LOAD(&v_in->x[i]);
+    float4_t y = F4_LOAD(&v_in->y[i]);
+    float4_t z = F4_LOAD(&v_in->z[i]);
+    float4_t ox = F4_ADD(F4_ADD(F4_MUL(m00, x), F4_MUL(m01, y)), F4_MUL(m02, z));
+    float4_t oy = F4_ADD(F4_ADD(F4_MUL(m10, x), F4_MUL(m11, y)), F4_MUL(m12, z));
+    float4_t oz = F4_ADD(F4_ADD(F4_MUL(m20, x), F4_MUL(m21, y)), F4_MUL(m22, z));
+    F4_STORE(&v_out->x[i], F4_ADD(ox, ox));
+    F4_STORE(&v_out->y[i], F4_ADD(oy, oy));
+    F4_STORE(&v_out->z[i], F4_ADD(oz, oz));
+  }
+#endif
+  for (; i < n; i++) {
+    struct FloatQuat qs = { q->qi[i], q->qx[i], q->qy[i], q->qz[i] };
+    struct FloatVect3 a = { v_in->x[i], v_in->y[i], v_in->z[i] };
+    struct FloatVect3 b;
+    float_quat_vmult(&b, &qs, &a);
+    v_out->x[i] = b.x;
+    v_out->y[i] = b.y;
+    v_out->z[i] = b.z;
+  }
+}
+
+void float_quat_comp_batch(struct FloatQuatArray *a2c, struct FloatQuatArray *a2b,
+                           struct FloatQuatArray *b2c, int n)
+{
+  int i = 0;
+#if FLOAT_BATCH_SIMD
+  for (; i + 4 <= n; i += 4) {
+    float4_t ai = F4_LOAD(&a2b->qi[i]);
+    float4_t ax = F4_LOAD(&a2b->qx[i]);
+    float4_t ay = F4_LOAD(&a2b->qy[i]);
+    float4_t az = F4_LOAD(&a2b->qz[i]);
+    float4_t bi = F4_LOAD(&b2c->qi[i]);
+    float4_t bx = F4_LOAD(&b2c->qx[i]);
+    float4_t by = F4_LOAD(&b2c->qy[i]);
+    float4_t bz = F4_LOAD(&b2c->qz[i]);
+    float4_t ci = F4_SUB(F4_SUB(F4_SUB(F4_MUL(ai, bi), F4_MUL(ax, bx)), F4_MUL(ay, by)), F4_MUL(az, bz));
+    float4_t cx = F4_SUB(F4_ADD(F4_ADD(F4_MUL(ai, bx), F4_MUL(ax, bi)), F4_MUL(ay, bz)), F4_MUL(az, by));
+    float4_t cy = F4_ADD(F4_ADD(F4_SUB(F4_MUL(ai, by), F4_MUL(ax, bz)), F4_MUL(ay, bi)), F4_MUL(az, bx));
+    float4_t cz = F4_ADD(F4_SUB(F4_ADD(F4_MUL(ai, bz), F4_MUL(ax, by)), F4_MUL(ay, bx)), F4_MUL(az, bi));
+    F4_STORE(&a2c->qi[i], ci);
+    F4_STORE(&a2c->qx[i], cx);
+    F4_STORE(&a2c->qy[i], cy);
+    F4_STORE(&a2c->qz[i], cz);
+  }
+#endif
+  for (; i < n; i++) {
+    struct FloatQuat a = { a2b->qi[i], a2b->qx[i], a2b->qy[i], a2b->qz[i] };
+    struct FloatQuat b = { b2c->qi[i], b2c->qx[i], b2c->qy[i], b2c->qz[i] };
+    struct FloatQuat c;
+    float_quat_comp(&c, &a, &b);
+    a2c->qi[i] = c.qi;
+    a2c->qx[i] = c.qx;
+    a2c->qy[i] = c.qy;
+    a2c->qz[i] = c.qz;
+  }
+}
+
+void float_quat_integrate_batch(struct FloatQuatArray *q, struct FloatRatesArray *omega, float dt, int n)
+{
+  int i = 0;
+#if FLOAT_BATCH_SIMD
+  for (; i + 4 <= n; i += 4) {
+    // the trigonometric terms are scalar, a null rotation gives the identity
+    float ca[4], dp[4], dq[4], dr[4];
+    for (int k = 0; k < 4; k++) {
+      struct FloatRates w = { omega->p[i + k], omega->q[i + k], omega->r[i + k] };
+      const float no = FLOAT_RATES_NORM(w);
+      if (no > FLT_MIN) {
+        const float a = 0.5 * no * dt;
+        const float sa_ov_no = sinf(a) / no;
+        ca[k] = cosf(a);
+        dp[k] = sa_ov_no * w.p;
+        dq[k] = sa_ov_no * w.q;
+        dr[k] = sa_ov_no * w.r;
+      } else {
+        ca[k] = 1.f;
+        dp[k] = dq[k] = dr[k] = 0.f;
+      }
+    }
+    float4_t c = F4_LOAD(ca);
+    float4_t p = F4_LOAD(dp);
+    float4_t r = F4_LOAD(dr);
+    float4_t s = F4_LOAD(dq);
+    float4_t qi = F4_LOAD(&q->qi[i]);
+    float4_t qx = F4_LOAD(&q->qx[i]);
+    float4_t qy = F4_LOAD(&q->qy[i]);
+    float4_t qz = F4_LOAD(&q->qz[i]);
+    F4_STORE(&q->qi[i], F4_SUB(F4_SUB(F4_SUB(F4_MUL(c, qi), F4_MUL(p, qx)), F4_MUL(s, qy)), F4_MUL(r, qz)));
+    F4_STORE(&q->qx[i], F4_SUB(F4_ADD(F4_ADD(F4_MUL(p, qi), F4_MUL(c, qx)), F4_MUL(r, qy)), F4_MUL(s, qz)));
+    F4_STORE(&q->qy[i], F4_ADD(F4_ADD(F4_SUB(F4_MUL(s, qi), F4_MUL(r, qx)), F4_MUL(c, qy)), F4_MUL(p, qz)));
+    F4_STORE(&q->qz[i], F4_ADD(F4_SUB(F4_ADD(F4_MUL(r, qi), F4_MUL(s, qx)), F4_MUL(p, qy)), F4_MUL(c, qz)));
+  }
+#endif
+  for (; i < n; i++) {
+    struct FloatQuat qs = { q->qi[i], q->qx[i], q->qy[i], q->qz[i] };
+    struct FloatRates w = { omega->p[i], omega->q[i], omega->r[i] };
+    float_quat_integrate(&qs, &w, dt);
+    q->qi[i] = qs.qi;
+    q->qx[i] = qs.qx;
+    q->qy[i] = qs.qy;
+    q->qz[i] = qs.qz;
+  }
+}
@@ -859,6 +859,57 @@ static inline void float_mat_diagonal_scal(float **o, float v, int n)
   }
 }
 
+/*
+ * Batch operations
+ *
+ * The elements are stored as structure of arrays and processed four at
+ * a time with SSE or NEON when available. Outputs can be the same arrays
+ * as the inputs.
+ */
+
+/** Array of 3D vectors, one array per component */
+struct FloatVect3Array {
+  float *x;
+  float *y;
+  float *z;
+};
+
+/** Array of quaternions, one array per component */
+struct FloatQuatArray {
+  float *qi;
+  float *qx;
+  float *qy;
+  float *qz;
+};
+
+/** Array of rotational speeds, one array per component */
+struct FloatRatesArray {
+  float *p;
+  float *q;
+  float *r;
+};
+
+/** rotate n vectors by the same rotation matrix.
+ * vb[i] = m_a2b * va[i]
+ */
+extern void float_rmat_vmult_batch(struct FloatVect3Array *vb, struct FloatRMat *m_a2b,
+                                   struct FloatVect3Array *va, int n);
+
+/** rotate n vectors by n quaternions.
+ * v_out[i] = q[i] * v_in[i] * q[i]^-1
+ */
+extern void float_quat_vmult_batch(struct FloatVect3Array *v_out, struct FloatQuatArray *q,
+                                   struct FloatVect3Array *v_in, int n);
+
+/** compose n pairs of quaternions.
+ * a2c[i] = a2b[i] comp b2c[i]
+ */
+extern void float_quat_comp_batch(struct FloatQuatArray *a2c, struct FloatQuatArray *a2b,
+                                  struct FloatQuatArray *b2c, int n);
+
+/** in place quaternion integration with constant rotational velocity, for n quaternions */
+extern void float_quat_integrate_batch(struct FloatQuatArray *q, struct FloatRatesArray *omega, float dt, int n);
+
 extern bool float_mat_inv_2d(float inv_out[4], float mat_in[4]);
 extern void float_mat2_mult(struct FloatVect2 *vect_out, float mat[4], struct FloatVect2 vect_in);
 extern bool float_mat_inv_4d(float invOut[16], float mat_in[16]);
@@ -28,6 +28,7 @@
 
 #include "std.h"
 #include "math/pprz_geodetic_wmm2020.h"
+#include <math.h>
 
 const double gh1[MAXCOEFF] = {
   //WMM 2020 data
@@ -256,3 +257,106 @@ int16_t mag_calc(int16_t igdgc, double flat, double flon, double elev, int16_t n
   *geo_mag_z = *geo_mag_z * cd - aa * sd;
   return (ios);
 }
+
+/**
+ * Initialize the cache for a given date
+ *
+ * @param cache the cache
+ * @param date date in decimal year, for example 2021.5
+ */
+void wmm2020_cache_init(struct Wmm2020Cache *cache, double date)
+{
+  cache->nmax = extrapsh(date, GEO_EPOCH, NMAX_1, NMAX_2, cache->gh);
+  cache->date = date;
+  cache->tile_valid = false;
+  cache->last_valid = false;
+  cache->nb_eval = 0;
+}
+
+static void wmm2020_cache_eval(struct Wmm2020Cache *cache, double lat, double lon, double alt, double *field)
+{
+  mag_calc(1, lat, lon, alt, cache->nmax, cache->gh, &field[0], &field[1], &field[2],
+           IEXT, EXT_COEFF1, EXT_COEFF2, EXT_COEFF3);
+  cache->nb_eval++;
+}
+
+/** Evaluate the corners of the tile containing a position, reusing the corners shared with the current one */
+static void wmm2020_cache_tile(struct Wmm2020Cache *cache, double lat, double lon, double alt)
+{
+  const double step = WMM2020_CACHE_TILE_DEG;
+  double lat0 = floor(lat / step) * step;
+  double lon0 = floor(lon / step) * step;
+  double corner[4][3];
+
+  for (int i = 0; i < 4; i++) {
+    double clat = lat0 + (i / 2) * step;
+    double clon = lon0 + (i % 2) * step;
+    bool found = false;
+    if (cache->tile_valid && cache->tile_alt == alt) {
+      for (int j = 0; j < 4 && !found; j++) {
+        if (cache->tile_lat + (j / 2) * step == clat && cache->tile_lon + (j % 2) * step == clon) {
+          corner[i][0] = cache->corner[j][0];
+          corner[i][1] = cache->corner[j][1];
+          corner[i][2] = cache->corner[j][2];
+          found = true;
+        }
+      }
+    }
+    if (!found) {
+      wmm2020_cache_eval(cache, clat, clon, alt, corner[i]);
+    }
+  }
+
+  for (int i = 0; i < 4; i++) {
+    for (int k = 0; k < 3; k++) {
+      cache->corner[i][k] = corner[i][k];
+    }
+  }
+  cache->tile_lat = lat0;
+  cache->tile_lon = lon0;
+  cache->tile_alt = alt;
+  cache->tile_valid = true;
+}
+
+/**
+ * Field at a position, from the cache
+ *
+ * Same frame and units as mag_calc (geodetic coordinates).
+ * @param cache the cache, initialized with wmm2020_cache_init
+ * @param lat latitude in decimal degrees
+ * @param lon longitude in decimal degrees
+ * @param alt altitude in km
+ */
+void wmm2020_cache_get(struct Wmm2020Cache *cache, double lat, double lon, double alt,
+                       double *geo_mag_x, double *geo_mag_y, double *geo_mag_z)
+{
+  const double step = WMM2020_CACHE_TILE_DEG;
+
+  if (!cache->last_valid || fabs(lat - cache->last_lat) > WMM2020_CACHE_MIN_DIST_DEG ||
+      fabs(lon - cache->last_lon) > WMM2020_CACHE_MIN_DIST_DEG ||
+      fabs(alt - cache->last_alt) > WMM2020_CACHE_TILE_ALT / 10.) {
+    // the tile altitude is quantized so that nearby positions share it
+    double tile_alt = floor(alt / WMM2020_CACHE_TILE_ALT + 0.5) * WMM2020_CACHE_TILE_ALT;
+    if (!cache->tile_valid || tile_alt != cache->tile_alt ||
+        lat < cache->tile_lat || lat >= cache->tile_lat + step ||
+        lon < cache->tile_lon || lon >= cache->tile_lon + step) {
+      wmm2020_cache_tile(cache, lat, lon, tile_alt);
+    }
+
+    double u = (lon - cache->tile_lon) / step;
+    double v = (lat - cache->tile_lat) / step;
+    for (int k = 0; k < 3; k++) {
+      double south = cache->corner[0][k] + u * (cache->corner[1][k] - cache->corner[0][k]);
+      double north = cache->corner[2][k] + u * (cache->corner[3][k] - cache->corner[2][k]);
+      cache->last[k] = south + v * (north - south);
+    }
+    cache->last_lat = lat;
+    cache->last_lon = lon;
+    cache->last_alt = alt;
+    cache->last_valid = true;
+  }
+
+  *geo_mag_x = cache->last[0];
+  *geo_mag_y = cache->last[1];
+  *geo_mag_z = cache->last[2];
+}
@@ -38,6 +38,8 @@
 extern "C" {
 #endif
 
+#include "std.h"
+
 #define WMM2020_FRAC 2
 #define N_MAX_OF_GH  12
 
@@ -66,6 +68,45 @@ extern "C" {
 #define MAXDEG 13
 #define MAXCOEFF (MAXDEG*(MAXDEG+2)+1)
 
+/** Size of the cache tiles in degrees of latitude and longitude */
+#ifndef WMM2020_CACHE_TILE_DEG
+#define WMM2020_CACHE_TILE_DEG 1.
+#endif
+
+/** Altitude change in km after which the tile is evaluated again */
+#ifndef WMM2020_CACHE_TILE_ALT
+#define WMM2020_CACHE_TILE_ALT 1.
+#endif
+
+/** Displacement in degrees under which the last field is returned as is */
+#ifndef WMM2020_CACHE_MIN_DIST_DEG
+#define WMM2020_CACHE_MIN_DIST_DEG 0.001
+#endif
+
+/**
+ * Cached evaluation of the field
+ *
+ * The field is evaluated with the full model at the corners of a tile of
+ * WMM2020_CACHE_TILE_DEG and interpolated bilinearly inside it. When moving
+ * to a neighbour tile, the shared corners are reused.
+ */
+struct Wmm2020Cache {
+  double gh[MAXCOEFF];        ///< model coefficients at the cache date
+  int16_t nmax;               ///< degree of the model
+  double date;                ///< date of the coefficients in decimal year
+  bool tile_valid;            ///< corners are evaluated
+  double tile_lat;            ///< latitude of the south west corner in degrees
+  double tile_lon;            ///< longitude of the south west corner in degrees
+  double tile_alt;            ///< altitude of the tile in km
+  double corner[4][3];        ///< field at the SW, SE, NW and NE corners
+  bool last_valid;            ///< last field is valid
+  double last_lat;            ///< latitude of the last field in degrees
+  double last_lon;            ///< longitude of the last field in degrees
+  double last_alt;            ///< altitude of the last field in km
+  double last[3];             ///< last field
+  uint32_t nb_eval;           ///< number of full model evaluations
+};
+
 extern const double gh1[];
 extern const double gh2[];
 
@@ -74,6 +115,10 @@ int16_t mag_calc(int16_t igdgc, double flat, double flon, double elev, int16_t n
                  double *gh, double *geo_mag_x, double *geo_mag_y, double *geo_mag_z,
                  int16_t iext, double ext1, double ext2, double ext3);
 
+extern void wmm2020_cache_init(struct Wmm2020Cache *cache, double date);
+extern void wmm2020_cache_get(struct Wmm2020Cache *cache, double lat, double lon, double alt,
+                              double *geo_mag_x, double *geo_mag_y, double *geo_mag_z);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file math/pprz_matrix_sym_float.h
+ * @brief Fixed size kernels for symmetric (covariance) matrices.
+ *
+ * A symmetric N by N matrix P is stored as its upper triangle, row by row,
+ * in an array of SYM_MAT_SIZE(N) floats. The kernels only compute this
+ * triangle, so the covariance stays exactly symmetric and about half of the
+ * products of the full matrix version are saved.
+ *
+ * The usual Kalman filter steps are provided:
+ *  - propagation P = F P F' + diag(Q), fused row by row
+ *  - P H', H P H' + diag(R) and the correction P = P - K (P H')'
+ *    which is (I - K H) P when K = P H' S^-1
+ *
+ * Define the kernels for a state of size N with
+ *
+ *     SYM_MAT_FIXED_DEFINE(6)
+ *
+ * and for measurements of size M with
+ *
+ *     SYM_MAT_FIXED_UPDATE_DEFINE(6, 3)
+ *
+ * As for qr_solve_fixed.h, the sizes are constants so the compiler can
+ * unroll the loops and the work arrays have a fixed size on the stack.
+ * Matrices other than P are plain row-major arrays.
+ */
+
+#ifndef PPRZ_MATRIX_SYM_FLOAT_H
+#define PPRZ_MATRIX_SYM_FLOAT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** number of floats to store a symmetric matrix of size n */
+#define SYM_MAT_SIZE(_n) ((_n) * ((_n) + 1) / 2)
+
+/** index of element (i, j) in the packed upper triangle, i <= j */
+#define SYM_MAT_IDX(_n, _i, _j) ((_i) * (_n) - ((_i) * ((_i) - 1)) / 2 + (_j) - (_i))
+
+/** element (i, j) of a packed symmetric matrix, in any order */
+static inline float sym_mat_get(const int n, const float *p, const int i, const int j)
+{
+  return i <= j ? p[SYM_MAT_IDX(n, i, j)] : p[SYM_MAT_IDX(n, j, i)];
+}
+
+/**
+ * Pack the upper triangle of a full matrix
+ * @param n size
+ * @param p output packed matrix [SYM_MAT_SIZE(n)]
+ * @param a input matrix [n*n], row-major
+ */
+static inline __attribute__((always_inline)) void sym_mat_pack_impl(const int n, float *p, const float *a)
+{
+  int i, j, k = 0;
+  for (i = 0; i < n; i++) {
+    for (j = i; j < n; j++) {
+      p[k++] = a[i * n + j];
+    }
+  }
+}
+
+/**
+ * Expand a packed matrix to a full one
+ * @param n size
+ * @param a output matrix [n*n], row-major
+ * @param p input packed matrix [SYM_MAT_SIZE(n)]
+ */
+static inline __attribute__((always_inline)) void sym_mat_unpack_impl(const int n, float *a, const float *p)
+{
+  int i, j, k = 0;
+  for (i = 0; i < n; i++) {
+    for (j = i; j < n; j++) {
+      a[i * n + j] = p[k];
+      a[j * n + i] = p[k];
+      k++;
+    }
+  }
+}
+
+/**
+ * P = F P F' + diag(Q)
+ * @param n size of the state
+ * @param p packed covariance [SYM_MAT_SIZE(n)], updated in place
+ * @param f state transition [n*n], row-major
+ * @param q diagonal of the process noise [n], can be NULL
+ * @param pf workspace [n*n]
+ * @param fp workspace [n]
+ */
+static inline __attribute__((always_inline)) void sym_mat_propagate_impl(const int n, float *p,
+    const float *f, const float *q, float *pf, float *fp)
+{
+  int i, j, k;
+  sym_mat_unpack_impl(n, pf, p);
+  for (i = 0; i < n; i++) {
+    /* row i of F P */
+    for (j = 0; j < n; j++) {
+      float s = 0.f;
+      for (k = 0; k < n; k++) {
+        s += f[i * n + k] * pf[k * n + j];
+      }
+      fp[j] = s;
+    }
+    /* row i of (F P) F', upper triangle only */
+    for (j = i; j < n; j++) {
+      float s = 0.f;
+      for (k = 0; k < n; k++) {
+        s += fp[k] * f[j * n + k];
+      }
+      p[SYM_MAT_IDX(n, i, j)] = s;
+    }
+    if (q) {
+      p[SYM_MAT_IDX(n, i, i)] += q[i];
+    }
+  }
+}
+
+/**
+ * P H'
+ * @param n size of the state
+ * @param m size of the measurement
+ * @param pht output [n*m], row-major
+ * @param p packed covariance [SYM_MAT_SIZE(n)]
+ * @param h measurement matrix [m*n], row-major
+ */
+static inline __attribute__((always_inline)) void sym_mat_pht_impl(const int n, const int m, float *pht,
+    const float *p, const float *h)
+{
+  int i, j, k;
+  for (i = 0; i < n; i++) {
+    for (j = 0; j < m; j++) {
+      float s = 0.f;
+      for (k = 0; k < n; k++) {
+        s += sym_mat_get(n, p, i, k) * h[j * n + k];
+      }
+      pht[i * m + j] = s;
+    }
+  }
+}
+
+/**
+ * S = H (P H') + diag(R), full symmetric output
+ * @param n size of the state
+ * @param m size of the measurement
+ * @param s output innovation covariance [m*m], row-major
+ * @param h measurement matrix [m*n], row-major
+ * @param pht P H' [n*m], row-major
+ * @param r diagonal of the measurement noise [m], can be NULL
+ */
+static inline __attribute__((always_inline)) void sym_mat_hpht_impl(const int n, const int m, float *s,
+    const float *h, const float *pht, const float *r)
+{
+  int i, j, k;
+  for (i = 0; i < m; i++) {
+    for (j = i; j < m; j++) {
+      float t = 0.f;
+      for (k = 0; k < n; k++) {
+        t += h[i * n + k] * pht[k * m + j];
+      }
+      s[i * m + j] = t;
+      s[j * m + i] = t;
+    }
+    if (r) {
+      s[i * m + i] += r[i];
+    }
+  }
+}
+
+/**
+ * P = P - K (P H')'
+ * @param n size of the state
+ * @param m size of the measurement
+ * @param p packed covariance [SYM_MAT_SIZE(n)], updated in place
+ * @param k gain [n*m], row-major
+ * @param pht P H' [n*m], row-major
+ */
+static inline __attribute__((always_inline)) void sym_mat_correct_impl(const int n, const int m, float *p,
+    const float *k, const float *pht)
+{
+  int i, j, l;
+  for (i = 0; i < n; i++) {
+    for (j = i; j < n; j++) {
+      float s = 0.f;
+      for (l = 0; l < m; l++) {
+        s += k[i * m + l] * pht[j * m + l];
+      }
+      p[SYM_MAT_IDX(n, i, j)] -= s;
+    }
+  }
+}
+
+/**
+ * Define for a state of size N, with p the packed matrix [SYM_MAT_SIZE(N)]
+ * and a, f full matrices [N*N]:
+ *  - sym_mat_pack_N(p, a)
+ *  - sym_mat_unpack_N(a, p)
+ *  - sym_mat_propagate_N(p, f, q)
+ */
+#define SYM_MAT_FIXED_DEFINE(_n) \
+  static inline void sym_mat_pack_##_n(float *p, const float *a) \
+  { \
+    sym_mat_pack_impl((_n), p, a); \
+  } \
+  static inline void sym_mat_unpack_##_n(float *a, const float *p) \
+  { \
+    sym_mat_unpack_impl((_n), a, p); \
+  } \
+  static inline void sym_mat_propagate_##_n(float *p, const float *f, const float *q) \
+  { \
+    float pf[(_n) * (_n)]; \
+    float fp[(_n)]; \
+    sym_mat_propagate_impl((_n), p, f, q, pf, fp); \
+  }
+
+/**
+ * Define for a state of size N and a measurement of size M, with
+ * pht [N*M], h [M*N], s [M*M], k [N*M] and r [M]:
+ *  - sym_mat_pht_NxM(pht, p, h)
+ *  - sym_mat_hpht_NxM(s, h, pht, r)
+ *  - sym_mat_correct_NxM(p, k, pht)
+ */
+#define SYM_MAT_FIXED_UPDATE_DEFINE(_n, _m) \
+  static inline void sym_mat_pht_##_n##x##_m(float *pht, const float *p, const float *h) \
+  { \
+    sym_mat_pht_impl((_n), (_m), pht, p, h); \
+  } \
+  static inline void sym_mat_hpht_##_n##x##_m(float *s, const float *h, const float *pht, const float *r) \
+  { \
+    sym_mat_hpht_impl((_n), (_m), s, h, pht, r); \
+  } \
+  static inline void sym_mat_correct_##_n##x##_m(float *p, const float *k, const float *pht) \
+  { \
+    sym_mat_correct_impl((_n), (_m), p, k, pht); \
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PPRZ_MATRIX_SYM_FLOAT_H */
@@ -26,8 +26,9 @@
 
 #include "pprz_trig_int.h"
 #include "pprz_algebra_int.h"
+#include "pprz_trig_int_tables.h"
 #if !defined(PPRZ_TRIG_INT_USE_FLOAT)
-#if !defined(PPRZ_TRIG_INT_COMPR_FLASH) || defined(PPRZ_TRIG_INT_TEST)
+#if (!defined(PPRZ_TRIG_INT_COMPR_FLASH) && !defined(PPRZ_TRIG_INT_INTERP)) || defined(PPRZ_TRIG_INT_TEST)
 PPRZ_TRIG_CONST int16_t pprz_trig_int[6434] = {    0,
                                                    3,     7,    11,    15,    19,    23,    27,    31,    35,    39,    43,    47,    51,    55,    59,    63,
                                                    67,    71,    75,    79,    83,    87,    91,    95,    99,   103,   107,   111,   115,   119,   123,   127,
@@ -864,6 +865,8 @@ int32_t pprz_itrig_sin(int32_t angle)
   tmp = sinf(tmp);
   angle = ANGLE_BFP_OF_REAL(tmp);
   return angle;
+#elif defined(PPRZ_TRIG_INT_INTERP)
+  return pprz_itrig_sin_interp(angle);
 #else
   INT32_ANGLE_NORMALIZE(angle);
   if (angle > INT32_ANGLE_PI_2) {
@@ -887,7 +890,44 @@ int32_t pprz_itrig_sin(int32_t angle)
 
 int32_t pprz_itrig_cos(int32_t angle)
 {
+#if defined(PPRZ_TRIG_INT_INTERP) && !defined(PPRZ_TRIG_INT_USE_FLOAT)
+  return pprz_itrig_cos_interp(angle);
+#else
   return pprz_itrig_sin(angle + INT32_ANGLE_PI_2);
+#endif
+}
+
+/* The angle is converted to a phase of 2^32 per turn, wrapping around with
+ * the unsigned overflow: the two top bits are the quadrant and the others
+ * the position in the quarter of turn, mirrored in the odd quadrants.
+ */
+
+/** 2^32 / (2 pi 2^INT32_ANGLE_FRAC), error of 3e-7 relative to the angle */
+#define TRIG_INT_INTERP_PHASE_OF_ANGLE 166886u
+
+static inline int32_t trig_int_interp_sin_phase(uint32_t phase)
+{
+  const uint32_t odd = -((phase >> 30) & 1);
+  const int32_t neg = -(int32_t)(phase >> 31);
+  uint32_t x = phase & 0x3FFFFFFF;
+  x = ((x ^ odd) - odd) + (odd & 0x40000000);
+  /* index in the table and 16 bits of interpolation, x = 2^30 uses the padding point */
+  const uint32_t i = x >> (30 - TRIG_INT_INTERP_BITS);
+  const int32_t frac = (x >> (14 - TRIG_INT_INTERP_BITS)) & 0xFFFF;
+  const int32_t s0 = pprz_trig_int_interp_sin[i];
+  int32_t s = s0 + (((pprz_trig_int_interp_sin[i + 1] - s0) * frac) >> 16);
+  s = (s + (1 << (TRIG_INT_INTERP_SIN_FRAC - INT32_TRIG_FRAC - 1))) >> (TRIG_INT_INTERP_SIN_FRAC - INT32_TRIG_FRAC);
+  return (s ^ neg) - neg;
+}
+
+int32_t pprz_itrig_sin_interp(int32_t angle)
+{
+  return trig_int_interp_sin_phase((uint32_t)angle * TRIG_INT_INTERP_PHASE_OF_ANGLE);
+}
+
+int32_t pprz_itrig_cos_interp(int32_t angle)
+{
+  return trig_int_interp_sin_phase((uint32_t)angle * TRIG_INT_INTERP_PHASE_OF_ANGLE + 0x40000000);
 }
 
 
@@ -940,3 +980,34 @@ int32_t int32_atan2_2(int32_t y, int32_t x)
     return a;
   }
 }
+
+/* pi/2 and pi with TRIG_INT_INTERP_ATAN_FRAC */
+#define TRIG_INT_INTERP_ATAN_PI_2 102944
+#define TRIG_INT_INTERP_ATAN_PI   205887
+
+int32_t int32_atan2_interp(int32_t y, int32_t x)
+{
+  const int32_t sy = y >> 31;
+  const int32_t sx = x >> 31;
+  const uint32_t ay = ((uint32_t)y ^ (uint32_t)sy) - (uint32_t)sy;
+  const uint32_t ax = ((uint32_t)x ^ (uint32_t)sx) - (uint32_t)sx;
+  /* ratio of min over max in [0, 1] */
+  const uint32_t swap = -(uint32_t)(ay > ax);
+  uint32_t mx = ax ^ ((ax ^ ay) & swap);
+  uint32_t mn = ay ^ ((ax ^ ay) & swap);
+  /* keep at most 16 bits so that the ratio with 16 bits fits */
+  int32_t sh = 16 - __builtin_clz(mx | 1);
+  sh &= ~(sh >> 31);
+  mx >>= sh;
+  mn >>= sh;
+  const uint32_t r = (mn << 16) / (mx + (mx == 0));
+  const uint32_t i = r >> (16 - TRIG_INT_INTERP_BITS);
+  const int32_t frac = r & ((1 << (16 - TRIG_INT_INTERP_BITS)) - 1);
+  const int32_t a0 = pprz_trig_int_interp_atan[i];
+  int32_t a = a0 + (((pprz_trig_int_interp_atan[i + 1] - a0) * frac) >> (16 - TRIG_INT_INTERP_BITS));
+  /* back to the octant: pi/2 - a above the diagonal, pi - a for x < 0, -a for y < 0 */
+  a = ((a ^ (int32_t)swap) - (int32_t)swap) + ((int32_t)swap & TRIG_INT_INTERP_ATAN_PI_2);
+  a = ((a ^ sx) - sx) + (sx & TRIG_INT_INTERP_ATAN_PI);
+  a = (a + (1 << (TRIG_INT_INTERP_ATAN_FRAC - INT32_ANGLE_FRAC - 1))) >> (TRIG_INT_INTERP_ATAN_FRAC - INT32_ANGLE_FRAC);
+  return (a ^ sy) - sy;
+}
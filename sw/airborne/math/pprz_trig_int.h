@@ -69,7 +69,24 @@ extern "C" {
 #define TREE_BUF_12_2 2145
 #define TREE_BUF_12_3 3474
 
-#if !defined(PPRZ_TRIG_INT_COMPR_FLASH) || defined(PPRZ_TRIG_INT_TEST)
+/** Interpolated trig functions.
+ * Linear interpolation in short const tables (sine over a quarter of turn
+ * and arc tangent over [0, 1]) generated by sw/tools/gen_trig_int_tables.py
+ * into pprz_trig_int_tables.h, without branches.
+ * With PPRZ_TRIG_INT_INTERP they are used by pprz_itrig_sin/cos, the full
+ * table is not compiled and no init is needed, so it replaces
+ * PPRZ_TRIG_INT_COMPR_FLASH on small targets. int32_atan2 keeps its fast
+ * polynomial: int32_atan2_interp is far more precise (0.7 lsb against
+ * about 300) but 2 to 4 times slower because of its division.
+ */
+#define TRIG_INT_INTERP_BITS    8
+#define TRIG_INT_INTERP_SIZE    (1 << TRIG_INT_INTERP_BITS)
+
+#if defined(PPRZ_TRIG_INT_INTERP) && defined(PPRZ_TRIG_INT_COMPR_FLASH) && !defined(PPRZ_TRIG_INT_TEST)
+#error "PPRZ_TRIG_INT_INTERP doesn't need PPRZ_TRIG_INT_COMPR_FLASH"
+#endif
+
+#if (!defined(PPRZ_TRIG_INT_COMPR_FLASH) && !defined(PPRZ_TRIG_INT_INTERP)) || defined(PPRZ_TRIG_INT_TEST)
 extern PPRZ_TRIG_CONST int16_t pprz_trig_int[];
 #endif
 
@@ -78,6 +95,12 @@ extern int32_t pprz_itrig_cos(int32_t angle);
 extern int32_t int32_atan2(int32_t y, int32_t x);
 extern int32_t int32_atan2_2(int32_t y, int32_t x);
 
+/** sine with #INT32_TRIG_FRAC of an angle with #INT32_ANGLE_FRAC, not normalized */
+extern int32_t pprz_itrig_sin_interp(int32_t angle);
+extern int32_t pprz_itrig_cos_interp(int32_t angle);
+/** arc tangent of y/x in ]-pi, pi] with #INT32_ANGLE_FRAC */
+extern int32_t int32_atan2_interp(int32_t y, int32_t x);
+
 #if defined(PPRZ_TRIG_INT_COMPR_FLASH)
 uint8_t get_nibble(uint16_t pos);
 int pprz_trig_int_init(void);
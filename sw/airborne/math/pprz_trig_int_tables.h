@@ -0,0 +1,74 @@
+/*
+ * This file is generated by sw/tools/gen_trig_int_tables.py, do not edit.
+ */
+
+/**
+ * @file pprz_trig_int_tables.h
+ * @brief Const tables of the interpolated fixed point trig functions.
+ *
+ * Only included by pprz_trig_int.c.
+ */
+
+#ifndef PPRZ_TRIG_INT_TABLES_H
+#define PPRZ_TRIG_INT_TABLES_H
+
+#if TRIG_INT_INTERP_BITS != 8
+#error "pprz_trig_int_tables.h generated for a different TRIG_INT_INTERP_BITS"
+#endif
+
+#define TRIG_INT_INTERP_SIN_FRAC 15
+#define TRIG_INT_INTERP_ATAN_FRAC 16
+
+/** sin(pi/2 * i / TRIG_INT_INTERP_SIZE) with TRIG_INT_INTERP_SIN_FRAC */
+static const uint16_t pprz_trig_int_interp_sin[TRIG_INT_INTERP_SIZE + 2] = {
+      0,   201,   402,   603,   804,  1005,  1206,  1407,  1608,  1809,  2009,  2210,
+   2411,  2611,  2811,  3012,  3212,  3412,  3612,  3812,  4011,  4211,  4410,  4609,
+   4808,  5007,  5205,  5404,  5602,  5800,  5998,  6195,  6393,  6590,  6787,  6983,
+   7180,  7376,  7571,  7767,  7962,  8157,  8351,  8546,  8740,  8933,  9127,  9319,
+   9512,  9704,  9896, 10088, 10279, 10469, 10660, 10850, 11039, 11228, 11417, 11605,
+  11793, 11980, 12167, 12354, 12540, 12725, 12910, 13095, 13279, 13463, 13646, 13828,
+  14010, 14192, 14373, 14553, 14733, 14912, 15091, 15269, 15447, 15624, 15800, 15976,
+  16151, 16326, 16500, 16673, 16846, 17018, 17190, 17361, 17531, 17700, 17869, 18037,
+  18205, 18372, 18538, 18703, 18868, 19032, 19195, 19358, 19520, 19681, 19841, 20001,
+  20160, 20318, 20475, 20632, 20788, 20943, 21097, 21251, 21403, 21555, 21706, 21856,
+  22006, 22154, 22302, 22449, 22595, 22740, 22884, 23028, 23170, 23312, 23453, 23593,
+  23732, 23870, 24008, 24144, 24279, 24414, 24548, 24680, 24812, 24943, 25073, 25202,
+  25330, 25457, 25583, 25708, 25833, 25956, 26078, 26199, 26320, 26439, 26557, 26674,
+  26791, 26906, 27020, 27133, 27246, 27357, 27467, 27576, 27684, 27791, 27897, 28002,
+  28106, 28209, 28311, 28411, 28511, 28610, 28707, 28803, 28899, 28993, 29086, 29178,
+  29269, 29359, 29448, 29535, 29622, 29707, 29792, 29875, 29957, 30038, 30118, 30196,
+  30274, 30350, 30425, 30499, 30572, 30644, 30715, 30784, 30853, 30920, 30986, 31050,
+  31114, 31177, 31238, 31298, 31357, 31415, 31471, 31527, 31581, 31634, 31686, 31737,
+  31786, 31834, 31881, 31927, 31972, 32015, 32058, 32099, 32138, 32177, 32214, 32251,
+  32286, 32319, 32352, 32383, 32413, 32442, 32470, 32496, 32522, 32546, 32568, 32590,
+  32610, 32629, 32647, 32664, 32679, 32693, 32706, 32718, 32729, 32738, 32746, 32753,
+  32758, 32762, 32766, 32767, 32768, 32768
+};
+
+/** atan(i / TRIG_INT_INTERP_SIZE) with TRIG_INT_INTERP_ATAN_FRAC */
+static const uint16_t pprz_trig_int_interp_atan[TRIG_INT_INTERP_SIZE + 2] = {
+      0,   256,   512,   768,  1024,  1280,  1536,  1792,  2047,  2303,  2559,  2814,
+   3070,  3325,  3580,  3836,  4091,  4346,  4600,  4855,  5110,  5364,  5618,  5872,
+   6126,  6380,  6633,  6887,  7140,  7392,  7645,  7898,  8150,  8402,  8653,  8905,
+   9156,  9407,  9657,  9908, 10158, 10408, 10657, 10906, 11155, 11403, 11652, 11899,
+  12147, 12394, 12641, 12887, 13133, 13379, 13624, 13869, 14114, 14358, 14601, 14845,
+  15088, 15330, 15572, 15814, 16055, 16296, 16536, 16776, 17015, 17254, 17492, 17730,
+  17968, 18205, 18441, 18677, 18913, 19148, 19382, 19616, 19850, 20083, 20315, 20547,
+  20779, 21009, 21240, 21469, 21699, 21927, 22156, 22383, 22610, 22836, 23062, 23288,
+  23512, 23737, 23960, 24183, 24406, 24627, 24849, 25069, 25289, 25509, 25727, 25946,
+  26163, 26380, 26597, 26813, 27028, 27242, 27456, 27670, 27882, 28094, 28306, 28517,
+  28727, 28936, 29145, 29354, 29561, 29768, 29975, 30180, 30386, 30590, 30794, 30997,
+  31200, 31402, 31603, 31803, 32003, 32203, 32401, 32600, 32797, 32994, 33190, 33385,
+  33580, 33774, 33968, 34160, 34353, 34544, 34735, 34925, 35115, 35304, 35492, 35680,
+  35867, 36053, 36239, 36424, 36608, 36792, 36975, 37158, 37340, 37521, 37701, 37881,
+  38060, 38239, 38417, 38594, 38771, 38947, 39123, 39297, 39472, 39645, 39818, 39990,
+  40162, 40333, 40503, 40673, 40842, 41010, 41178, 41346, 41512, 41678, 41844, 42008,
+  42172, 42336, 42499, 42661, 42823, 42984, 43145, 43304, 43464, 43622, 43780, 43938,
+  44095, 44251, 44407, 44562, 44716, 44870, 45024, 45176, 45328, 45480, 45631, 45781,
+  45931, 46080, 46229, 46377, 46525, 46672, 46818, 46964, 47109, 47254, 47398, 47542,
+  47685, 47827, 47969, 48111, 48251, 48392, 48531, 48671, 48809, 48947, 49085, 49222,
+  49359, 49495, 49630, 49765, 49899, 50033, 50167, 50299, 50432, 50563, 50695, 50826,
+  50956, 51086, 51215, 51344, 51472, 51472
+};
+
+#endif /* PPRZ_TRIG_INT_TABLES_H */
@@ -428,20 +428,40 @@ void dqrank ( float a[], int lda, int m, int n, float tol, int *kr,
     Output, float QRAUX[N], will contain extra information defining
     the QR factorization.
 */
+{
+  float work[n];
+  /*work = ( float * ) malloc ( n * sizeof ( float ) );*/
+
+  dqrank_ws ( a, lda, m, n, tol, kr, jpvt, qraux, work );
+}
+/******************************************************************************/
+
+void dqrank_ws ( float a[], int lda, int m, int n, float tol, int *kr,
+  int jpvt[], float qraux[], float work[] )
+
+/******************************************************************************/
+/*
+  Purpose:
+
+    DQRANK_WS is DQRANK with a caller provided workspace.
+
+  Parameters:
+
+    As DQRANK, plus:
+
+    Workspace, float WORK[N].
+*/
 {
   int i;
   int j;
   int job;
   int k;
-  /*float *work;*/
 
   for ( i = 0; i < n; i++ )
   {
     jpvt[i] = 0;
   }
 
-  float work[n];
-  /*work = ( float * ) malloc ( n * sizeof ( float ) );*/
   job = 1;
 
   dqrdc ( a, lda, m, n, qraux, jpvt, work, job );
@@ -1595,22 +1615,61 @@ void qr_solve ( int m, int n, float a[], float b[], float x[]  )
     Output, float QR_SOLVE[N], the least squares solution.
 */
 {
-  int ind UNUSED;
-  int itask;
+  float work[QR_SOLVE_WORK_SIZE ( m, n )];
+  int iwork[QR_SOLVE_IWORK_SIZE ( m, n )];
+
+  qr_solve_ws ( m, n, a, b, x, work, iwork );
+}
+/******************************************************************************/
+
+void qr_solve_ws ( int m, int n, float a[], float b[], float x[],
+  float work[], int iwork[] )
+
+/******************************************************************************/
+/*
+  Purpose:
+
+    QR_SOLVE_WS is QR_SOLVE with a caller provided workspace.
+
+  Discussion:
+
+    It does not use the heap nor any variable length array, so the stack
+    usage is fixed and the workspace can be allocated statically for the
+    largest problem solved, see QR_SOLVE_WORK_SIZE and QR_SOLVE_IWORK_SIZE.
+
+  Parameters:
+
+    Input, int M, the number of rows of A.
+
+    Input, int N, the number of columns of A.
+
+    Input, float A[M*N], the matrix.
+
+    Input, float B[M], the right hand side.
+
+    Output, float X[N], the least squares solution.
+
+    Workspace, float WORK[QR_SOLVE_WORK_SIZE(M,N)].
+
+    Workspace, int IWORK[QR_SOLVE_IWORK_SIZE(M,N)].
+*/
+{
   int kr;
   int lda;
   float tol;
+  float *a_qr = work;
+  float *qraux = a_qr + m * n;
+  float *r = qraux + n;
+  float *dqrdc_work = r + m;
+  int *jpvt = iwork;
 
-  float a_qr[m*n];
   r8mat_copy_new ( m, n, a, a_qr );
   lda = m;
   tol = r8_epsilon ( ) / r8mat_amax ( m, n, a_qr );
-  int jpvt[n];
-  float qraux[n];
-  float r[m];
-  itask = 1;
-
-  ind = dqrls ( a_qr, lda, m, n, tol, &kr, b, x, r, jpvt, qraux, itask );
+/*
+  Same as DQRLS with ITASK = 1, the sizes are valid by construction.
+*/
+  dqrank_ws ( a_qr, lda, m, n, tol, &kr, jpvt, qraux, dqrdc_work );
+  dqrlss ( a_qr, lda, m, n, kr, b, x, r, jpvt, qraux );
 }
 /******************************************************************************/
-
@@ -8,11 +8,17 @@
  * This code is distributed under the GNU LGPL license.
  */
 
+/* Workspace sizes of qr_solve_ws for a M by N system */
+#define QR_SOLVE_WORK_SIZE(_m, _n) ((_m) * (_n) + 2 * (_n) + (_m))
+#define QR_SOLVE_IWORK_SIZE(_m, _n) (_n)
+
 void daxpy ( int n, float da, float dx[], int incx, float dy[], int incy );
 float ddot ( int n, float dx[], int incx, float dy[], int incy );
 float dnrm2 ( int n, float x[], int incx );
 void dqrank ( float a[], int lda, int m, int n, float tol, int *kr, 
   int jpvt[], float qraux[] );
+void dqrank_ws ( float a[], int lda, int m, int n, float tol, int *kr,
+  int jpvt[], float qraux[], float work[] );
 void dqrdc ( float a[], int lda, int n, int p, float qraux[], int jpvt[], 
   float work[], int job );
 int dqrls ( float a[], int lda, int m, int n, float tol, int *kr, float b[], 
@@ -25,3 +31,5 @@ void drotg ( float *sa, float *sb, float *c, float *s );
 void dscal ( int n, float sa, float x[], int incx );
 void dswap ( int n, float x[], int incx, float y[], int incy );
 void qr_solve ( int m, int n, float a[], float b[], float x[] );
+void qr_solve_ws ( int m, int n, float a[], float b[], float x[],
+  float work[], int iwork[] );
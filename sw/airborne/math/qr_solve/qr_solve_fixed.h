@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file math/qr_solve/qr_solve_fixed.h
+ * @brief Least squares solver for systems of size known at compile time.
+ *
+ * Same problem and conventions as qr_solve: A is M by N in column-major
+ * order, the rank is estimated with the LINPACK tolerance and the
+ * dependent columns get a zero in the solution. The factorization is a
+ * Householder QR with column pivoting, applied to B on the fly, so only
+ * the copy of A and the pivots are needed.
+ *
+ * Define a solver for a given size with
+ *
+ *     QR_SOLVE_FIXED_DEFINE(6, 4)
+ *
+ * which provides qr_solve_fixed_6x4(a, b, x). As the sizes are constants the
+ * compiler can unroll the loops and keep the work arrays on the stack with a
+ * fixed size. Solvers of other sizes are independent functions.
+ */
+
+#ifndef QR_SOLVE_FIXED_H
+#define QR_SOLVE_FIXED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <math.h>
+#include <float.h>
+
+/**
+ * Generic solver, inlined in the fixed size versions
+ *
+ * @param m number of rows of A
+ * @param n number of columns of A
+ * @param a input matrix A[m*n], column-major
+ * @param b right hand side b[m]
+ * @param x output least squares solution x[n]
+ * @param qr workspace [m*n]
+ * @param qtb workspace [m]
+ * @param piv workspace [n]
+ * @return the numerical rank of A
+ */
+static inline __attribute__((always_inline)) int qr_solve_fixed_impl(const int m, const int n,
+    const float *a, const float *b, float *x, float *qr, float *qtb, int *piv)
+{
+  int i, j, k;
+  const int p = m < n ? m : n;
+  float amax = 0.f;
+
+  for (i = 0; i < m * n; i++) {
+    qr[i] = a[i];
+    if (fabsf(a[i]) > amax) {
+      amax = fabsf(a[i]);
+    }
+  }
+  for (i = 0; i < m; i++) {
+    qtb[i] = b[i];
+  }
+  for (j = 0; j < n; j++) {
+    piv[j] = j;
+    x[j] = 0.f;
+  }
+  if (amax == 0.f) {
+    return 0;
+  }
+  const float tol = FLT_EPSILON / amax;
+
+  int rank = 0;
+  float r00 = 0.f;
+  for (k = 0; k < p; k++) {
+    /* pivot: column with the largest remaining norm */
+    int best = k;
+    float best_nrm2 = -1.f;
+    for (j = k; j < n; j++) {
+      float nrm2 = 0.f;
+      for (i = k; i < m; i++) {
+        nrm2 += qr[i + j * m] * qr[i + j * m];
+      }
+      if (nrm2 > best_nrm2) {
+        best_nrm2 = nrm2;
+        best = j;
+      }
+    }
+    if (best != k) {
+      for (i = 0; i < m; i++) {
+        float t = qr[i + k * m];
+        qr[i + k * m] = qr[i + best * m];
+        qr[i + best * m] = t;
+      }
+      int t = piv[k];
+      piv[k] = piv[best];
+      piv[best] = t;
+    }
+
+    /* Householder reflection of column k, as in LINPACK dqrdc */
+    float *v = &qr[k * m];
+    float nrmxl = sqrtf(best_nrm2);
+    if (nrmxl == 0.f) {
+      break;
+    }
+    if (v[k] < 0.f) {
+      nrmxl = -nrmxl;
+    }
+    for (i = k; i < m; i++) {
+      v[i] /= nrmxl;
+    }
+    v[k] += 1.f;
+    for (j = k + 1; j < n; j++) {
+      float *c = &qr[j * m];
+      float t = 0.f;
+      for (i = k; i < m; i++) {
+        t -= v[i] * c[i];
+      }
+      t /= v[k];
+      for (i = k; i < m; i++) {
+        c[i] += t * v[i];
+      }
+    }
+    float t = 0.f;
+    for (i = k; i < m; i++) {
+      t -= v[i] * qtb[i];
+    }
+    t /= v[k];
+    for (i = k; i < m; i++) {
+      qtb[i] += t * v[i];
+    }
+    /* diagonal of R, stored in place of the reflector head */
+    v[k] = -nrmxl;
+
+    if (k == 0) {
+      r00 = fabsf(v[0]);
+    }
+    if (fabsf(v[k]) <= tol * r00) {
+      break;
+    }
+    rank = k + 1;
+  }
+
+  /* back substitution on the independent columns */
+  for (k = rank - 1; k >= 0; k--) {
+    float s = qtb[k];
+    for (j = k + 1; j < rank; j++) {
+      s -= qr[k + j * m] * x[piv[j]];
+    }
+    x[piv[k]] = s / qr[k + k * m];
+  }
+  return rank;
+}
+
+/**
+ * Define qr_solve_fixed_MxN(const float a[M*N], const float b[M], float x[N])
+ * returning the numerical rank of A
+ */
+#define QR_SOLVE_FIXED_DEFINE(_m, _n) \
+  static inline int qr_solve_fixed_##_m##x##_n(const float a[(_m) * (_n)], const float b[(_m)], float x[(_n)]) \
+  { \
+    float qr[(_m) * (_n)]; \
+    float qtb[(_m)]; \
+    int piv[(_n)]; \
+    return qr_solve_fixed_impl((_m), (_n), a, b, x, qr, qtb, piv); \
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QR_SOLVE_FIXED_H */
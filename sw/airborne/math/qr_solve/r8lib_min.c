@@ -278,13 +278,40 @@ float *r8mat_l_solve ( int n, float a[], float b[] )
 
     Output, float R8MAT_L_SOLVE[N], the solution of the linear system.
 */
+{
+  float *x;
+
+  x = ( float * ) malloc ( n * sizeof ( float ) );
+  r8mat_l_solve_ws ( n, a, b, x );
+
+  return x;
+}
+/******************************************************************************/
+
+void r8mat_l_solve_ws ( int n, float a[], float b[], float x[] )
+
+/******************************************************************************/
+/*
+  Purpose:
+
+    R8MAT_L_SOLVE_WS solves a lower triangular linear system, without allocation.
+
+  Parameters:
+
+    Input, int N, the number of rows and columns of
+    the matrix A.
+
+    Input, float A[N*N], the N by N lower triangular matrix.
+
+    Input, float B[N], the right hand side of the linear system.
+
+    Output, float X[N], the solution of the linear system.
+*/
 {
   float dot;
   int i;
   int j;
-  float *x;
 
-  x = ( float * ) malloc ( n * sizeof ( float ) );
 /*
   Solve L * x = b.
 */
@@ -297,8 +324,6 @@ float *r8mat_l_solve ( int n, float a[], float b[] )
     }
     x[i] = ( b[i] - dot ) / a[i+i*n];
   }
-
-  return x;
 }
 /******************************************************************************/
 
@@ -342,11 +367,37 @@ float *r8mat_lt_solve ( int n, float a[], float b[] )
     Output, float R8MAT_LT_SOLVE[N], the solution of the linear system.
 */
 {
-  int i;
-  int j;
   float *x;
 
   x = ( float * ) malloc ( n * sizeof ( float ) );
+  r8mat_lt_solve_ws ( n, a, b, x );
+
+  return x;
+}
+/******************************************************************************/
+
+void r8mat_lt_solve_ws ( int n, float a[], float b[], float x[] )
+
+/******************************************************************************/
+/*
+  Purpose:
+
+    R8MAT_LT_SOLVE_WS solves a transposed lower triangular linear system,
+    without allocation.
+
+  Parameters:
+
+    Input, int N, the number of rows and columns of the matrix A.
+
+    Input, float A[N*N], the N by N lower triangular matrix.
+
+    Input, float B[N], the right hand side of the linear system.
+
+    Output, float X[N], the solution of the linear system.
+*/
+{
+  int i;
+  int j;
 
   for ( j = n-1; 0 <= j; j-- )
   {
@@ -357,8 +408,6 @@ float *r8mat_lt_solve ( int n, float a[], float b[] )
     }
     x[j] = x[j] / a[j+j*n];
   }
-
-  return x;
 }
 /******************************************************************************/
 
@@ -400,11 +449,36 @@ float *r8mat_mtv_new ( int m, int n, float a[], float x[] )
     Output, float R8MAT_MTV_NEW[N], the product A'*X.
 */
 {
-  int i;
-  int j;
   float *y;
 
   y = ( float * ) malloc ( n * sizeof ( float ) );
+  r8mat_mtv ( m, n, a, x, y );
+
+  return y;
+}
+/******************************************************************************/
+
+void r8mat_mtv ( int m, int n, float a[], float x[], float y[] )
+
+/******************************************************************************/
+/*
+  Purpose:
+
+    R8MAT_MTV multiplies a transposed matrix times a vector, without allocation.
+
+  Parameters:
+
+    Input, int M, N, the number of rows and columns of the matrix.
+
+    Input, float A[M,N], the M by N matrix.
+
+    Input, float X[M], the vector to be multiplied by A.
+
+    Output, float Y[N], the product A'*X.
+*/
+{
+  int i;
+  int j;
 
   for ( j = 0; j < n; j++ )
   {
@@ -414,8 +488,6 @@ float *r8mat_mtv_new ( int m, int n, float a[], float x[] )
       y[j] = y[j] + a[i+j*m] * x[i];
     }
   }
-
-  return y;
 }
 /******************************************************************************/
 
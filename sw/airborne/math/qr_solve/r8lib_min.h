@@ -18,8 +18,11 @@ float *r8mat_cholesky_factor ( int n, float a[], int *flag );
 float *r8mat_mv_new ( int m, int n, float a[], float x[] );
 float *r8mat_cholesky_solve ( int n, float l[], float b[] );
 float *r8mat_l_solve ( int n, float a[], float b[] );
+void r8mat_l_solve_ws ( int n, float a[], float b[], float x[] );
 float *r8mat_lt_solve ( int n, float a[], float b[] );
+void r8mat_lt_solve_ws ( int n, float a[], float b[], float x[] );
 float *r8mat_mtv_new ( int m, int n, float a[], float x[] );
+void r8mat_mtv ( int m, int n, float a[], float x[], float y[] );
 float r8vec_max ( int n, float r8vec[] );
 int i4_min ( int i1, int i2 );
 int i4_max ( int i1, int i2 );
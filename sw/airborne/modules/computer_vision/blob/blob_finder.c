@@ -29,6 +29,13 @@
 
 #include "blob_finder.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifndef BLOB_FINDER_MAX_THREADS
+#define BLOB_FINDER_MAX_THREADS 4 ///< Maximum amount of row bands labeled in parallel
+#endif
 
 void image_labeling(struct image_t *input, struct image_t *output, struct image_filter_t *filters, uint8_t filters_cnt,
                     struct image_label_t *labels, uint16_t *labels_count)
@@ -192,3 +199,322 @@ void image_labeling(struct image_t *input, struct image_t *output, struct image_
     }
   }
 }
+
+/**
+ * Create the run-length encoding and labeling memory for a mask
+ * @param[out] *runs The runs to create
+ * @param[in] width The width of the mask
+ * @param[in] height The height of the mask
+ */
+void image_runs_create(struct image_runs_t *runs, uint16_t width, uint16_t height)
+{
+  runs->w = width;
+  runs->h = height;
+  runs->row_size = (width + 1) / 2; // alternating pixels give the most runs
+  runs->runs = malloc(sizeof(struct image_run_t) * runs->row_size * height);
+  runs->runs_cnt = calloc(height, sizeof(uint16_t));
+  runs->parent = malloc(sizeof(uint32_t) * runs->row_size * height);
+  runs->pool = NULL;
+}
+
+static void runs_pool_stop(struct runs_pool_t *pool);
+
+/**
+ * Free the run-length encoding and labeling memory
+ * @param[in] *runs The runs to free
+ */
+void image_runs_free(struct image_runs_t *runs)
+{
+  if (runs->pool != NULL) {
+    runs_pool_stop(runs->pool);
+    runs->pool = NULL;
+  }
+  free(runs->runs);
+  free(runs->runs_cnt);
+  free(runs->parent);
+  runs->runs = NULL;
+  runs->runs_cnt = NULL;
+  runs->parent = NULL;
+}
+
+/* Find the root run of a set (with path halving) */
+static inline uint32_t runs_find(uint32_t *parent, uint32_t i)
+{
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+/* Join two sets, the root is always the run with the lowest index (first in the image) */
+static inline void runs_union(uint32_t *parent, uint32_t a, uint32_t b)
+{
+  a = runs_find(parent, a);
+  b = runs_find(parent, b);
+  if (a < b) {
+    parent[b] = a;
+  } else if (b < a) {
+    parent[a] = b;
+  }
+}
+
+/* Encode one row of the mask as runs */
+static void runs_encode_row(struct image_mask_t *mask, struct image_runs_t *runs, uint16_t y)
+{
+  uint8_t *row = &mask->buf[y * mask->w];
+  uint32_t idx = y * runs->row_size;
+  struct image_run_t *run = &runs->runs[idx];
+  uint16_t cnt = 0;
+  uint16_t x = 0;
+
+  while (x < mask->w) {
+    // Skip the empty pixels
+    while (x < mask->w && !row[x]) { x++; }
+    if (x >= mask->w) { break; }
+
+    run[cnt].x_start = x;
+    while (x < mask->w && row[x]) { x++; }
+    run[cnt].x_end = x;
+    runs->parent[idx + cnt] = idx + cnt;
+    cnt++;
+  }
+  runs->runs_cnt[y] = cnt;
+}
+
+/* Join the runs of row y with the (8-connected) runs of the row above */
+static void runs_merge_rows(struct image_runs_t *runs, uint16_t y)
+{
+  uint32_t idx_a = (y - 1) * runs->row_size;
+  uint32_t idx_b = y * runs->row_size;
+  struct image_run_t *a = &runs->runs[idx_a];
+  struct image_run_t *b = &runs->runs[idx_b];
+  uint16_t i = 0, j = 0;
+
+  while (i < runs->runs_cnt[y - 1] && j < runs->runs_cnt[y]) {
+    if (a[i].x_end < b[j].x_start) {
+      i++;
+    } else if (b[j].x_end < a[i].x_start) {
+      j++;
+    } else {
+      runs_union(runs->parent, idx_a + i, idx_b + j);
+      // Continue with the run that reaches further
+      if (a[i].x_end < b[j].x_end) {
+        i++;
+      } else {
+        j++;
+      }
+    }
+  }
+}
+
+/* A band of rows which is encoded and labeled on its own */
+struct runs_band_t {
+  struct image_mask_t *mask;
+  struct image_runs_t *runs;
+  uint16_t y_start;
+  uint16_t y_end;
+};
+
+static void *runs_label_band(void *data)
+{
+  struct runs_band_t *band = (struct runs_band_t *)data;
+  for (uint16_t y = band->y_start; y < band->y_end; y++) {
+    runs_encode_row(band->mask, band->runs, y);
+    if (y > band->y_start) {
+      runs_merge_rows(band->runs, y);
+    }
+  }
+  return NULL;
+}
+
+/* A worker thread of the pool, always labeling the same band */
+struct runs_worker_t {
+  struct runs_pool_t *pool;
+  pthread_t thread;
+  uint8_t band;
+};
+
+/* Worker threads kept with the labeling memory, they wait for the next frame between two labelings */
+struct runs_pool_t {
+  struct runs_worker_t workers[BLOB_FINDER_MAX_THREADS - 1];
+  uint8_t workers_cnt;
+  pthread_mutex_t mutex;
+  pthread_cond_t start;     ///< Signaled on a new frame or on stop
+  pthread_cond_t done;      ///< Signaled when the workers labeled all their bands
+  struct runs_band_t bands[BLOB_FINDER_MAX_THREADS];
+  uint8_t bands_cnt;
+  uint32_t frame;           ///< Incremented for every labeling
+  uint8_t pending;          ///< Bands still being labeled by the workers
+  bool stop;
+};
+
+static void *runs_worker(void *data)
+{
+  struct runs_worker_t *w = (struct runs_worker_t *)data;
+  struct runs_pool_t *pool = w->pool;
+  uint32_t frame = 0;
+
+  pthread_mutex_lock(&pool->mutex);
+  while (true) {
+    while (!pool->stop && pool->frame == frame) {
+      pthread_cond_wait(&pool->start, &pool->mutex);
+    }
+    if (pool->stop) {
+      break;
+    }
+    frame = pool->frame;
+    if (w->band < pool->bands_cnt) {
+      pthread_mutex_unlock(&pool->mutex);
+      runs_label_band(&pool->bands[w->band]);
+      pthread_mutex_lock(&pool->mutex);
+      if (--pool->pending == 0) {
+        pthread_cond_signal(&pool->done);
+      }
+    }
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return NULL;
+}
+
+/* Start the worker threads, bands without a worker (when the creation fails) are labeled by the caller */
+static struct runs_pool_t *runs_pool_start(void)
+{
+  struct runs_pool_t *pool = calloc(1, sizeof(struct runs_pool_t));
+  if (pool == NULL) {
+    return NULL;
+  }
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->done, NULL);
+  for (uint8_t i = 0; i < BLOB_FINDER_MAX_THREADS - 1; i++) {
+    struct runs_worker_t *w = &pool->workers[pool->workers_cnt];
+    w->pool = pool;
+    w->band = pool->workers_cnt + 1;
+    if (pthread_create(&w->thread, NULL, runs_worker, w) != 0) {
+      break;
+    }
+    pool->workers_cnt++;
+  }
+  return pool;
+}
+
+static void runs_pool_stop(struct runs_pool_t *pool)
+{
+  pthread_mutex_lock(&pool->mutex);
+  pool->stop = true;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->mutex);
+  for (uint8_t i = 0; i < pool->workers_cnt; i++) {
+    pthread_join(pool->workers[i].thread, NULL);
+  }
+  pthread_cond_destroy(&pool->done);
+  pthread_cond_destroy(&pool->start);
+  pthread_mutex_destroy(&pool->mutex);
+  free(pool);
+}
+
+/**
+ * Label the blobs of 8-connected pixels in a color mask
+ * The mask is run-length encoded and the runs are joined with union-find, after which the
+ * moments of every blob are accumulated per run. Contours and corners are not filled in.
+ * Optionally the rows are split in bands which are encoded and labeled in parallel before
+ * the band borders are joined. The worker threads are started on the first threaded call
+ * and stopped by image_runs_free().
+ * @param[in] *mask The color mask (from image_yuv422_color_mask())
+ * @param[in,out] *runs The labeling memory, created with the mask size
+ * @param[out] *labels The blobs ordered by their first pixel in the image
+ * @param[in,out] *labels_count The maximum amount of labels as input and the found amount as output
+ * @param[in] nb_threads The amount of row bands labeled in parallel (1 is no threading)
+ */
+void image_labeling_runs(struct image_mask_t *mask, struct image_runs_t *runs, struct image_label_t *labels,
+                         uint16_t *labels_count, uint8_t nb_threads)
+{
+  if (nb_threads < 1) { nb_threads = 1; }
+  if (nb_threads > BLOB_FINDER_MAX_THREADS) { nb_threads = BLOB_FINDER_MAX_THREADS; }
+  if (nb_threads > mask->h) { nb_threads = mask->h; }
+
+  // Encode and label the bands
+  struct runs_band_t bands[BLOB_FINDER_MAX_THREADS];
+  for (uint8_t b = 0; b < nb_threads; b++) {
+    bands[b].mask = mask;
+    bands[b].runs = runs;
+    bands[b].y_start = (uint32_t)mask->h * b / nb_threads;
+    bands[b].y_end = (uint32_t)mask->h * (b + 1) / nb_threads;
+  }
+  if (nb_threads > 1 && runs->pool == NULL) {
+    runs->pool = runs_pool_start();
+  }
+  struct runs_pool_t *pool = (nb_threads > 1) ? runs->pool : NULL;
+  uint8_t workers_cnt = 0;
+  if (pool != NULL) {
+    // band b is labeled by the worker b - 1, the first one by the caller
+    workers_cnt = Min(pool->workers_cnt, nb_threads - 1);
+    pthread_mutex_lock(&pool->mutex);
+    memcpy(pool->bands, bands, sizeof(struct runs_band_t) * nb_threads);
+    pool->bands_cnt = nb_threads;
+    pool->pending = workers_cnt;
+    pool->frame++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->mutex);
+  }
+  runs_label_band(&bands[0]);
+  for (uint8_t b = workers_cnt + 1; b < nb_threads; b++) {
+    runs_label_band(&bands[b]);
+  }
+  if (pool != NULL) {
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->pending > 0) {
+      pthread_cond_wait(&pool->done, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+  }
+
+  // Join the band borders
+  for (uint8_t b = 1; b < nb_threads; b++) {
+    runs_merge_rows(runs, bands[b].y_start);
+  }
+
+  // Give every set a label and accumulate the moments (the root always comes first)
+  uint16_t labels_size = *labels_count;
+  uint16_t labels_cnt = 0;
+  for (uint16_t y = 0; y < mask->h; y++) {
+    uint32_t idx = y * runs->row_size;
+    for (uint16_t i = 0; i < runs->runs_cnt[y]; i++, idx++) {
+      struct image_run_t *run = &runs->runs[idx];
+      uint32_t root = runs_find(runs->parent, idx);
+
+      if (root != idx) {
+        run->label = runs->runs[root].label;
+      } else if (labels_cnt < labels_size) {
+        run->label = labels_cnt;
+        labels[labels_cnt].id = labels_cnt;
+        labels[labels_cnt].filter = 0;
+        labels[labels_cnt].pixel_cnt = 0;
+        labels[labels_cnt].x_min = run->x_start;
+        labels[labels_cnt].y_min = y;
+        labels[labels_cnt].x_sum = 0;
+        labels[labels_cnt].y_sum = 0;
+        labels[labels_cnt].contour_cnt = 0;
+        labels_cnt++;
+      } else {
+        run->label = 0xFFFF;
+      }
+
+      if (run->label == 0xFFFF) {
+        continue;
+      }
+
+      struct image_label_t *label = &labels[run->label];
+      uint32_t len = run->x_end - run->x_start;
+      label->pixel_cnt += len;
+      label->x_sum += len * (run->x_start + run->x_end - 1) / 2;
+      label->y_sum += len * y;
+      if (run->x_start < label->x_min) {
+        label->x_min = run->x_start;
+      }
+    }
+  }
+
+  *labels_count = labels_cnt;
+}
@@ -59,7 +59,30 @@ struct image_label_t {
   uint16_t corners[4];
 };
 
+/* Run of connected pixels on a single row of a mask */
+struct image_run_t {
+  uint16_t x_start;         ///< First pixel of the run
+  uint16_t x_end;           ///< Pixel after the last one of the run
+  uint16_t label;           ///< Blob number of the run (0xFFFF when out of labels)
+};
+
+/* Run-length encoded mask with the working memory of the union-find labeling */
+struct image_runs_t {
+  uint16_t w;               ///< Mask width
+  uint16_t h;               ///< Mask height
+  uint16_t row_size;        ///< Maximum number of runs in one row
+  struct image_run_t *runs; ///< Runs of every row, row y starts at runs[y * row_size]
+  uint16_t *runs_cnt;       ///< Number of runs per row
+  uint32_t *parent;         ///< Union-find parents, indexed like the runs
+  struct runs_pool_t *pool; ///< Worker threads labeling the row bands, NULL until the first threaded labeling
+};
+
 void image_labeling(struct image_t *input, struct image_t *output, struct image_filter_t *filters, uint8_t filters_cnt,
                     struct image_label_t *labels, uint16_t *labels_count);
 
+void image_runs_create(struct image_runs_t *runs, uint16_t width, uint16_t height);
+void image_runs_free(struct image_runs_t *runs);
+void image_labeling_runs(struct image_mask_t *mask, struct image_runs_t *runs, struct image_label_t *labels,
+                         uint16_t *labels_count, uint8_t nb_threads);
+
 #endif /* BLOB_FINDER_H */
@@ -29,11 +29,22 @@
 #include <stdio.h>
 
 #include "cv.h"
+#include "cv_trace.h"
 #include "rt_priority.h"
 
 
+/**
+ * Give the captured images to the asynchronous listeners without copying them.
+ * The listeners then read the capture buffers directly, so no listener may modify the image
+ * in place, and the device needs an extra buffer for every asynchronous listener.
+ */
+#ifndef CV_ASYNC_ZERO_COPY
+#define CV_ASYNC_ZERO_COPY FALSE
+#endif
+PRINT_CONFIG_VAR(CV_ASYNC_ZERO_COPY)
+
 void cv_attach_listener(struct video_config_t *device, struct video_listener *new_listener);
-int8_t cv_async_function(struct cv_async *async, struct image_t *img);
+int8_t cv_async_function(struct cv_async *async, struct image_t *img, bool shared);
 void *cv_async_thread(void *args);
 
 
@@ -55,6 +66,10 @@ struct video_listener *cv_add_to_device(struct video_config_t *device, cv_functi
   new_listener->async = NULL;
   new_listener->maximum_fps = fps;
 
+  // Number the listeners in order of registration
+  static uint8_t listener_cnt = 0;
+  new_listener->id = listener_cnt++;
+
   // Initialise the device that we want our function to use
   add_video_device(device);
 
@@ -92,6 +107,7 @@ struct video_listener *cv_add_to_device_async(struct video_config_t *device, cv_
   // Explicitly mark img_copy as uninitialized
   listener->async->img_copy.buf = NULL;
   listener->async->img_copy.buf_size = 0;
+  listener->async->img = &listener->async->img_copy;
 
   // Initialize mutex and condition variable
   pthread_mutex_init(&listener->async->img_mutex, NULL);
@@ -108,13 +124,30 @@ struct video_listener *cv_add_to_device_async(struct video_config_t *device, cv_
 }
 
 
-int8_t cv_async_function(struct cv_async *async, struct image_t *img)
+int8_t cv_async_function(struct cv_async *async, struct image_t *img, bool shared)
 {
   // If the previous image is not yet processed, return
   if (!async->img_processed || pthread_mutex_trylock(&async->img_mutex) != 0) {
     return -1;
   }
 
+#if CV_ASYNC_ZERO_COPY
+  // Keep a reference on the captured buffer instead of copying it
+  if (shared && img->buf_ops != NULL) {
+    image_retain(img);
+    async->img_shared = *img;
+    async->img = &async->img_shared;
+
+    // Inform thread of new image
+    async->img_processed = false;
+    pthread_cond_signal(&async->img_available);
+    pthread_mutex_unlock(&async->img_mutex);
+    return 0;
+  }
+#else
+  (void)shared;
+#endif
+
   // update image copy if input image size changed or not yet initialised
   if (async->img_copy.buf_size != img->buf_size) {
     if (async->img_copy.buf !=  NULL) {
@@ -132,6 +165,7 @@ int8_t cv_async_function(struct cv_async *async, struct image_t *img)
 
   // Copy image
   image_copy(img, &async->img_copy);
+  async->img = &async->img_copy;
 
   // Inform thread of new image
   async->img_processed = false;
@@ -163,7 +197,14 @@ void *cv_async_thread(void *args)
     }
 
     // Execute vision function from this thread
-    listener->func(&async->img_copy);
+    cv_trace_listener(CV_TRACE_LISTENER_START, listener, async->img);
+    listener->func(async->img);
+    cv_trace_listener(CV_TRACE_LISTENER_END, listener, async->img);
+
+    // Give the captured buffer back
+    if (async->img == &async->img_shared) {
+      image_release(&async->img_shared);
+    }
 
     // Mark image as processed
     async->img_processed = true;
@@ -177,6 +218,7 @@ void *cv_async_thread(void *args)
 void cv_run_device(struct video_config_t *device, struct image_t *img)
 {
   struct image_t *result;
+  bool shared = true;   // img is still the captured image, which can be shared with the asynchronous listeners
 
   // Loop through computer vision pipeline
   for (struct video_listener *listener = device->cv_listener; listener != NULL; listener = listener->next) {
@@ -192,17 +234,20 @@ void cv_run_device(struct video_config_t *device, struct image_t *img)
 
     if (listener->async != NULL) {
       // Send image to asynchronous thread, only update listener if successful
-      if (!cv_async_function(listener->async, img)) {
+      if (!cv_async_function(listener->async, img, shared)) {
         // Store timestamp
         listener->ts = img->ts;
       }
     } else {
       // Execute the cvFunction and catch result
+      cv_trace_listener(CV_TRACE_LISTENER_START, listener, img);
       result = listener->func(img);
+      cv_trace_listener(CV_TRACE_LISTENER_END, listener, img);
 
       // If result gives an image pointer, use it in the next stage
-      if (result != NULL) {
+      if (result != NULL && result != img) {
         img = result;
+        shared = false;
       }
       // Store timestamp
       listener->ts = img->ts;
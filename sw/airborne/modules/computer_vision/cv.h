@@ -46,6 +46,8 @@ struct cv_async {
   pthread_cond_t img_available;
   volatile bool img_processed;
   struct image_t img_copy;
+  struct image_t img_shared;    ///< Reference to the captured image when it is not copied
+  struct image_t *img;          ///< The image to process (img_copy or img_shared)
 };
 
 struct video_listener {
@@ -53,6 +55,7 @@ struct video_listener {
   struct cv_async *async;
   struct timeval ts;
   cv_function func;
+  uint8_t id;           ///< Listener number, in order of registration
 
   // Can be set by user
   uint16_t maximum_fps;
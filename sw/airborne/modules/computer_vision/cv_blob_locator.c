@@ -34,6 +34,11 @@
 #endif
 PRINT_CONFIG_VAR(BLOB_LOCATOR_FPS)
 
+#ifndef BLOB_LOCATOR_THREADS
+#define BLOB_LOCATOR_THREADS 1   ///< Amount of row bands labeled in parallel
+#endif
+PRINT_CONFIG_VAR(BLOB_LOCATOR_THREADS)
+
 
 uint8_t color_lum_min;
 uint8_t color_lum_max;
@@ -136,28 +141,26 @@ struct image_t *cv_blob_locator_func(struct image_t *img)
   }
 
 
+  // Color mask and labeling memory, kept between frames
+  static struct image_mask_t mask;
+  static struct image_runs_t runs;
+  if (mask.buf == NULL || mask.w != img->w || mask.h != img->h) {
+    image_mask_free(&mask);
+    image_runs_free(&runs);
+    image_mask_create(&mask, img->w, img->h, false);
+    image_runs_create(&runs, img->w, img->h);
+  }
+
   // Color Filter
-  struct image_filter_t filter[2];
-  filter[0].y_min = color_lum_min;
-  filter[0].y_max = color_lum_max;
-  filter[0].u_min = color_cb_min;
-  filter[0].u_max = color_cb_max;
-  filter[0].v_min = color_cr_min;
-  filter[0].v_max = color_cr_max;
-
-  // Output image
-  struct image_t dst;
-  image_create(&dst,
-               img->w,
-               img->h,
-               IMAGE_GRADIENT);
+  image_yuv422_color_mask(img, &mask, color_lum_min, color_lum_max, color_cb_min, color_cb_max,
+                          color_cr_min, color_cr_max);
 
   // Labels
   uint16_t labels_count = 512;
-  struct image_label_t labels[512];
+  static struct image_label_t labels[512];
 
   // Blob finder
-  image_labeling(img, &dst, filter, 1, labels, &labels_count);
+  image_labeling_runs(&mask, &runs, labels, &labels_count, BLOB_LOCATOR_THREADS);
 
   int largest_id = -1;
   int largest_size = 0;
@@ -175,39 +178,37 @@ struct image_t *cv_blob_locator_func(struct image_t *img)
 
   if (largest_id >= 0) {
     uint8_t *p = (uint8_t *) img->buf;
-    uint16_t *l = (uint16_t *) dst.buf;
-    for (int y = 0; y < dst.h; y++) {
-      for (int x = 0; x < dst.w / 2; x++) {
-        if (l[y * dst.w + x] != 0xffff) {
-          uint8_t c = 0xff;
-          if (l[y * dst.w + x] == largest_id) {
-            c = 0;
-          }
-          p[y * dst.w * 2 + x * 4] = c;
-          p[y * dst.w * 2 + x * 4 + 1] = 0x80;
-          p[y * dst.w * 2 + x * 4 + 2] = c;
-          p[y * dst.w * 2 + x * 4 + 3] = 0x80;
+    for (int y = 0; y < img->h; y++) {
+      struct image_run_t *run = &runs.runs[y * runs.row_size];
+      for (int r = 0; r < runs.runs_cnt[y]; r++) {
+        uint8_t c = (run[r].label == largest_id) ? 0 : 0xff;
+        // Color whole UYVY pairs
+        for (int x = run[r].x_start & ~1; x < run[r].x_end; x += 2) {
+          p[y * img->w * 2 + x * 2] = c;
+          p[y * img->w * 2 + x * 2 + 1] = 0x80;
+          p[y * img->w * 2 + x * 2 + 2] = c;
+          p[y * img->w * 2 + x * 2 + 3] = 0x80;
         }
       }
     }
 
-
-    uint16_t cgx = labels[largest_id].x_sum / labels[largest_id].pixel_cnt * 2;
+    // Center of gravity (on an even pixel)
+    uint16_t cgx = (labels[largest_id].x_sum / labels[largest_id].pixel_cnt) & ~1;
     uint16_t cgy = labels[largest_id].y_sum / labels[largest_id].pixel_cnt;
 
-    if ((cgx > 1) && (cgx < (dst.w - 2)) &&
-        (cgy > 1) && (cgy < (dst.h - 2))
+    if ((cgx > 1) && (cgx < (img->w - 2)) &&
+        (cgy > 1) && (cgy < (img->h - 2))
        ) {
-      p[cgy * dst.w * 2 + cgx * 2 - 4] = 0xff;
-      p[cgy * dst.w * 2 + cgx * 2 - 2] = 0x00;
-      p[cgy * dst.w * 2 + cgx * 2] = 0xff;
-      p[cgy * dst.w * 2 + cgx * 2 + 2] = 0x00;
-      p[cgy * dst.w * 2 + cgx * 2 + 4] = 0xff;
-      p[cgy * dst.w * 2 + cgx * 2 + 6] = 0x00;
-      p[(cgy - 1)*dst.w * 2 + cgx * 2] = 0xff;
-      p[(cgy - 1)*dst.w * 2 + cgx * 2 + 2] = 0x00;
-      p[(cgy + 1)*dst.w * 2 + cgx * 2] = 0xff;
-      p[(cgy + 1)*dst.w * 2 + cgx * 2 + 2] = 0x00;
+      p[cgy * img->w * 2 + cgx * 2 - 4] = 0xff;
+      p[cgy * img->w * 2 + cgx * 2 - 2] = 0x00;
+      p[cgy * img->w * 2 + cgx * 2] = 0xff;
+      p[cgy * img->w * 2 + cgx * 2 + 2] = 0x00;
+      p[cgy * img->w * 2 + cgx * 2 + 4] = 0xff;
+      p[cgy * img->w * 2 + cgx * 2 + 6] = 0x00;
+      p[(cgy - 1)*img->w * 2 + cgx * 2] = 0xff;
+      p[(cgy - 1)*img->w * 2 + cgx * 2 + 2] = 0x00;
+      p[(cgy + 1)*img->w * 2 + cgx * 2] = 0xff;
+      p[(cgy + 1)*img->w * 2 + cgx * 2 + 2] = 0x00;
     }
 
 
@@ -217,8 +218,6 @@ struct image_t *cv_blob_locator_func(struct image_t *img)
     blob_locator = temp;
   }
 
-  image_free(&dst);
-
   return NULL; // No new image is available for follow up modules
 }
 
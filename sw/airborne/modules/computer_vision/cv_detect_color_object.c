@@ -79,8 +79,11 @@ struct color_object_t {
 };
 struct color_object_t global_filters[2];
 
+// Color masks, one per filter as both cameras run in their own thread
+static struct image_mask_t masks[2];
+
 // Function
-uint32_t find_object_centroid(struct image_t *img, int32_t* p_xc, int32_t* p_yc, bool draw,
+uint32_t find_object_centroid(struct image_t *img, struct image_mask_t *mask, int32_t* p_xc, int32_t* p_yc, bool draw,
                               uint8_t lum_min, uint8_t lum_max,
                               uint8_t cb_min, uint8_t cb_max,
                               uint8_t cr_min, uint8_t cr_max);
@@ -124,7 +127,7 @@ static struct image_t *object_detector(struct image_t *img, uint8_t filter)
   int32_t x_c, y_c;
 
   // Filter and find centroid
-  uint32_t count = find_object_centroid(img, &x_c, &y_c, draw, lum_min, lum_max, cb_min, cb_max, cr_min, cr_max);
+  uint32_t count = find_object_centroid(img, &masks[filter-1], &x_c, &y_c, draw, lum_min, lum_max, cb_min, cb_max, cr_min, cr_max);
   VERBOSE_PRINT("Color count %d: %u, threshold %u, x_c %d, y_c %d\n", camera, object_count, count_threshold, x_c, y_c);
   VERBOSE_PRINT("centroid %d: (%d, %d) r: %4.2f a: %4.2f\n", camera, x_c, y_c,
         hypotf(x_c, y_c) / hypotf(img->w * 0.5, img->h * 0.5), RadOfDeg(atan2f(y_c, x_c)));
@@ -154,6 +157,7 @@ struct image_t *object_detector2(struct image_t *img)
 void color_object_detector_init(void)
 {
   memset(global_filters, 0, 2*sizeof(struct color_object_t));
+  memset(masks, 0, 2*sizeof(struct image_mask_t));
   pthread_mutex_init(&mutex, NULL);
 #ifdef COLOR_OBJECT_DETECTOR_CAMERA1
 #ifdef COLOR_OBJECT_DETECTOR_LUM_MIN1
@@ -193,8 +197,10 @@ void color_object_detector_init(void)
  *
  * Finds the centroid of pixels in an image within filter bounds.
  * Also returns the amount of pixels that satisfy these filter bounds.
+ * The color test is done once per frame into a mask, which also holds the moments of the object.
  *
  * @param img - input image to process formatted as YUV422.
+ * @param mask - color mask of the filter, (re)created when the image size changes
  * @param p_xc - x coordinate of the centroid of color object
  * @param p_yc - y coordinate of the centroid of color object
  * @param lum_min - minimum y value for the filter in YCbCr colorspace
@@ -206,49 +212,31 @@ void color_object_detector_init(void)
  * @param draw - whether or not to draw on image
  * @return number of pixels of image within the filter bounds.
  */
-uint32_t find_object_centroid(struct image_t *img, int32_t* p_xc, int32_t* p_yc, bool draw,
+uint32_t find_object_centroid(struct image_t *img, struct image_mask_t *mask, int32_t* p_xc, int32_t* p_yc, bool draw,
                               uint8_t lum_min, uint8_t lum_max,
                               uint8_t cb_min, uint8_t cb_max,
                               uint8_t cr_min, uint8_t cr_max)
 {
-  uint32_t cnt = 0;
-  uint32_t tot_x = 0;
-  uint32_t tot_y = 0;
-  uint8_t *buffer = img->buf;
+  if (mask->buf == NULL || mask->w != img->w || mask->h != img->h) {
+    image_mask_free(mask);
+    image_mask_create(mask, img->w, img->h, false);
+  }
 
-  // Go through all the pixels
-  for (uint16_t y = 0; y < img->h; y++) {
-    for (uint16_t x = 0; x < img->w; x ++) {
-      // Check if the color is inside the specified values
-      uint8_t *yp, *up, *vp;
-      if (x % 2 == 0) {
-        // Even x
-        up = &buffer[y * 2 * img->w + 2 * x];      // U
-        yp = &buffer[y * 2 * img->w + 2 * x + 1];  // Y1
-        vp = &buffer[y * 2 * img->w + 2 * x + 2];  // V
-        //yp = &buffer[y * 2 * img->w + 2 * x + 3]; // Y2
-      } else {
-        // Uneven x
-        up = &buffer[y * 2 * img->w + 2 * x - 2];  // U
-        //yp = &buffer[y * 2 * img->w + 2 * x - 1]; // Y1
-        vp = &buffer[y * 2 * img->w + 2 * x];      // V
-        yp = &buffer[y * 2 * img->w + 2 * x + 1];  // Y2
-      }
-      if ( (*yp >= lum_min) && (*yp <= lum_max) &&
-           (*up >= cb_min ) && (*up <= cb_max ) &&
-           (*vp >= cr_min ) && (*vp <= cr_max )) {
-        cnt ++;
-        tot_x += x;
-        tot_y += y;
-        if (draw){
-          *yp = 255;  // make pixel brighter in image
-        }
+  // Filter all pixels at once
+  uint32_t cnt = image_yuv422_color_mask(img, mask, lum_min, lum_max, cb_min, cb_max, cr_min, cr_max);
+
+  if (draw) {
+    uint8_t *buffer = img->buf;
+    for (uint32_t i = 0; i < (uint32_t)img->w * img->h; i++) {
+      if (mask->buf[i]) {
+        buffer[2 * i + 1] = 255;  // make pixel brighter in image
       }
     }
   }
+
   if (cnt > 0) {
-    *p_xc = (int32_t)roundf(tot_x / ((float) cnt) - img->w * 0.5f);
-    *p_yc = (int32_t)roundf(img->h * 0.5f - tot_y / ((float) cnt));
+    *p_xc = (int32_t)roundf(mask->sum_x / ((float) cnt) - img->w * 0.5f);
+    *p_yc = (int32_t)roundf(img->h * 0.5f - mask->sum_y / ((float) cnt));
   } else {
     *p_xc = 0;
     *p_yc = 0;
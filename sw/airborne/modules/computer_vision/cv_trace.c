@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of Paparazzi.
+ *
+ * Paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * Paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * @file modules/computer_vision/cv_trace.c
+ *
+ * Latency tracing of the frames through the vision pipeline.
+ * The trace points are called from the video threads and the asynchronous listener threads,
+ * so the event buffer and the latency histograms are only updated with atomic operations.
+ */
+
+#include "modules/computer_vision/cv_trace.h"
+#include "mcu_periph/sys_time.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifndef CV_TRACE_BUFFER_SIZE
+#define CV_TRACE_BUFFER_SIZE 8192   ///< Amount of events kept for the dump (power of 2)
+#endif
+PRINT_CONFIG_VAR(CV_TRACE_BUFFER_SIZE)
+
+#if (CV_TRACE_BUFFER_SIZE & (CV_TRACE_BUFFER_SIZE - 1)) != 0
+#error "CV_TRACE_BUFFER_SIZE must be a power of 2"
+#endif
+
+#ifndef CV_TRACE_MAX_LISTENERS
+#define CV_TRACE_MAX_LISTENERS 16   ///< Amount of listeners with latency statistics
+#endif
+
+#ifndef CV_TRACE_HIST_RES
+#define CV_TRACE_HIST_RES 1000      ///< Resolution of the latency histograms in us
+#endif
+#define CV_TRACE_HIST_BINS 256      ///< Latencies above CV_TRACE_HIST_BINS * CV_TRACE_HIST_RES end up in the last bin
+
+#ifndef CV_TRACE_PATH
+#define CV_TRACE_PATH /data/video
+#endif
+
+/* One trace event */
+struct cv_trace_event_t {
+  uint32_t ts;          ///< Time of the event in us since system startup
+  uint32_t frame_id;    ///< Frame number on its device
+  uint8_t point;        ///< The trace point (enum cv_trace_point)
+  uint8_t listener;     ///< The listener for listener and publish events
+};
+
+/* Latency histograms of a listener, since the last telemetry message */
+struct cv_trace_stats_t {
+  uint32_t process[CV_TRACE_HIST_BINS + 1];  ///< Capture to end of the listener
+  uint32_t publish[CV_TRACE_HIST_BINS + 1];  ///< Capture to publication of the result
+  bool used;
+};
+
+static struct cv_trace_event_t cv_trace_events[CV_TRACE_BUFFER_SIZE];
+static uint32_t cv_trace_head = 0;
+static struct cv_trace_stats_t cv_trace_stats[CV_TRACE_MAX_LISTENERS];
+static uint16_t cv_trace_dump_cnt = 0;
+
+uint8_t cv_trace_dump_file = 0;
+
+static void cv_trace_add(uint32_t ts, uint32_t frame_id, enum cv_trace_point point, uint8_t listener)
+{
+  uint32_t idx = __atomic_fetch_add(&cv_trace_head, 1, __ATOMIC_RELAXED) & (CV_TRACE_BUFFER_SIZE - 1);
+  cv_trace_events[idx].ts = ts;
+  cv_trace_events[idx].frame_id = frame_id;
+  cv_trace_events[idx].point = point;
+  cv_trace_events[idx].listener = listener;
+}
+
+static void cv_trace_hist_add(uint32_t *hist, uint32_t dt)
+{
+  uint32_t bin = dt / CV_TRACE_HIST_RES;
+  if (bin > CV_TRACE_HIST_BINS) {
+    bin = CV_TRACE_HIST_BINS;
+  }
+  __atomic_fetch_add(&hist[bin], 1, __ATOMIC_RELAXED);
+}
+
+#if PERIODIC_TELEMETRY
+#include "subsystems/datalink/telemetry.h"
+
+/**
+ * Take the histogram, clear it and compute its percentiles
+ * @return The amount of samples in the histogram
+ */
+static uint32_t cv_trace_hist_take(uint32_t *hist, uint32_t *p50, uint32_t *p99)
+{
+  uint32_t counts[CV_TRACE_HIST_BINS + 1];
+  uint32_t total = 0;
+  for (int i = 0; i <= CV_TRACE_HIST_BINS; i++) {
+    counts[i] = __atomic_exchange_n(&hist[i], 0, __ATOMIC_RELAXED);
+    total += counts[i];
+  }
+
+  // Upper bound of the bin containing the percentile
+  *p50 = 0;
+  *p99 = 0;
+  uint32_t cnt = 0;
+  for (int i = 0; i <= CV_TRACE_HIST_BINS && total > 0; i++) {
+    cnt += counts[i];
+    if (*p50 == 0 && cnt * 2 >= total) {
+      *p50 = (i + 1) * CV_TRACE_HIST_RES;
+    }
+    if (cnt * 100 >= total * 99) {
+      *p99 = (i + 1) * CV_TRACE_HIST_RES;
+      break;
+    }
+  }
+  return total;
+}
+
+/**
+ * Send the latency of one listener per message
+ */
+static void cv_trace_telem_send(struct transport_tx *trans, struct link_device *dev)
+{
+  static uint8_t listener = 0;
+
+  for (uint8_t i = 0; i < CV_TRACE_MAX_LISTENERS; i++) {
+    listener = (listener + 1) % CV_TRACE_MAX_LISTENERS;
+    if (cv_trace_stats[listener].used) {
+      uint32_t process_p50, process_p99, publish_p50, publish_p99;
+      uint16_t nb_processed = cv_trace_hist_take(cv_trace_stats[listener].process, &process_p50, &process_p99);
+      uint16_t nb_published = cv_trace_hist_take(cv_trace_stats[listener].publish, &publish_p50, &publish_p99);
+      pprz_msg_send_VISION_LATENCY(trans, dev, AC_ID, &listener, &nb_processed, &process_p50, &process_p99,
+                                   &nb_published, &publish_p50, &publish_p99);
+      return;
+    }
+  }
+}
+#endif
+
+void cv_trace_init(void)
+{
+  memset(cv_trace_stats, 0, sizeof(cv_trace_stats));
+
+#if PERIODIC_TELEMETRY
+  register_periodic_telemetry(DefaultPeriodic, PPRZ_MSG_ID_VISION_LATENCY, cv_trace_telem_send);
+#endif
+}
+
+/**
+ * Trace a new frame from the video thread, before it goes to the listeners
+ * @param[in] *img The frame (with its capture and dequeue time)
+ */
+void cv_trace_frame(struct image_t *img)
+{
+  cv_trace_add(img->pprz_ts, img->frame_id, CV_TRACE_CAPTURE, 0);
+  cv_trace_add(img->dequeue_ts, img->frame_id, CV_TRACE_DEQUEUE, 0);
+  cv_trace_add(get_sys_time_usec(), img->frame_id, CV_TRACE_PIPELINE, 0);
+}
+
+/**
+ * Trace the start or end of a listener on a frame
+ * @param[in] point CV_TRACE_LISTENER_START or CV_TRACE_LISTENER_END
+ * @param[in] *listener The listener
+ * @param[in] *img The frame given to the listener
+ */
+void cv_trace_listener(enum cv_trace_point point, struct video_listener *listener, struct image_t *img)
+{
+  uint32_t now = get_sys_time_usec();
+  cv_trace_add(now, img->frame_id, point, listener->id);
+
+  if (point == CV_TRACE_LISTENER_END && listener->id < CV_TRACE_MAX_LISTENERS) {
+    cv_trace_stats[listener->id].used = true;
+    cv_trace_hist_add(cv_trace_stats[listener->id].process, now - img->pprz_ts);
+  }
+}
+
+/**
+ * Trace the publication of a result computed by a listener
+ * @param[in] *listener The listener which computed the result (as returned by cv_add_to_device())
+ * @param[in] frame_id The frame the result was computed from
+ * @param[in] capture_ts The capture time of that frame (pprz_ts)
+ */
+void cv_trace_publish(struct video_listener *listener, uint32_t frame_id, uint32_t capture_ts)
+{
+  if (listener == NULL) {
+    return;
+  }
+
+  uint32_t now = get_sys_time_usec();
+  cv_trace_add(now, frame_id, CV_TRACE_PUBLISH, listener->id);
+
+  if (listener->id < CV_TRACE_MAX_LISTENERS) {
+    cv_trace_stats[listener->id].used = true;
+    cv_trace_hist_add(cv_trace_stats[listener->id].publish, now - capture_ts);
+  }
+}
+
+/**
+ * Dump the events in the buffer in the Chrome trace event format
+ * Frame events are on the first track and every listener has its own track.
+ * Events written while dumping may be inconsistent.
+ * @param[in] *filename The file to write, NULL for a numbered file in CV_TRACE_PATH
+ * @return Whether the file was written
+ */
+bool cv_trace_dump(const char *filename)
+{
+  char path[512];
+  if (filename == NULL) {
+    snprintf(path, sizeof(path), "%s/cv_trace_%05d.json", STRINGIFY(CV_TRACE_PATH), cv_trace_dump_cnt++);
+    filename = path;
+  }
+
+  FILE *fp = fopen(filename, "w");
+  if (fp == NULL) {
+    perror("[cv_trace] Could not open the trace file");
+    return false;
+  }
+
+  static const char *names[] = {"capture", "dequeue", "pipeline", "listener", "listener", "publish"};
+  static const char *phases[] = {"i", "i", "i", "B", "E", "i"};
+
+  fprintf(fp, "{\"traceEvents\":[\n");
+  fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"frames\"}}");
+  for (uint8_t i = 0; i < CV_TRACE_MAX_LISTENERS; i++) {
+    if (cv_trace_stats[i].used) {
+      fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"listener %d\"}}",
+              i + 1, i);
+    }
+  }
+
+  uint32_t head = __atomic_load_n(&cv_trace_head, __ATOMIC_RELAXED);
+  uint32_t start = (head > CV_TRACE_BUFFER_SIZE) ? head - CV_TRACE_BUFFER_SIZE : 0;
+  for (uint32_t i = start; i < head; i++) {
+    struct cv_trace_event_t *ev = &cv_trace_events[i & (CV_TRACE_BUFFER_SIZE - 1)];
+    int tid = (ev->point >= CV_TRACE_LISTENER_START) ? ev->listener + 1 : 0;
+    fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"%s\",%s\"ts\":%u,\"pid\":0,\"tid\":%d,\"args\":{\"frame\":%u}}",
+            names[ev->point], phases[ev->point], (phases[ev->point][0] == 'i') ? "\"s\":\"t\"," : "",
+            ev->ts, tid, ev->frame_id);
+  }
+  fprintf(fp, "\n]}\n");
+  fclose(fp);
+  return true;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of Paparazzi.
+ *
+ * Paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * Paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * @file modules/computer_vision/cv_trace.h
+ *
+ * Latency tracing of the frames through the vision pipeline.
+ * Every frame is traced from its capture, through the video thread and every listener,
+ * up to the publication of its results. The events go in a lock-free ring buffer which
+ * can be dumped in the Chrome trace format (chrome://tracing or Perfetto), and the
+ * latency percentiles of every listener are sent with the VISION_LATENCY message.
+ * Without the cv_trace module all trace points compile to nothing.
+ */
+
+#ifndef CV_TRACE_H
+#define CV_TRACE_H
+
+#include "std.h"
+#include "modules/computer_vision/cv.h"
+
+/* The points of the pipeline a frame passes */
+enum cv_trace_point {
+  CV_TRACE_CAPTURE,         ///< Frame captured by the device
+  CV_TRACE_DEQUEUE,         ///< Frame taken by the video thread
+  CV_TRACE_PIPELINE,        ///< Frame ready for the listeners (after the video filters)
+  CV_TRACE_LISTENER_START,  ///< Listener started on the frame
+  CV_TRACE_LISTENER_END,    ///< Listener finished the frame
+  CV_TRACE_PUBLISH          ///< Result of the frame published (e.g. on ABI)
+};
+
+#if CV_TRACE
+
+extern uint8_t cv_trace_dump_file;
+
+extern void cv_trace_init(void);
+extern void cv_trace_frame(struct image_t *img);
+extern void cv_trace_listener(enum cv_trace_point point, struct video_listener *listener, struct image_t *img);
+extern void cv_trace_publish(struct video_listener *listener, uint32_t frame_id, uint32_t capture_ts);
+extern bool cv_trace_dump(const char *filename);
+
+/** Settings handler, dumps the trace to CV_TRACE_PATH */
+#define cv_trace_Dump(_v) { cv_trace_dump_file = _v; if (_v) { cv_trace_dump(NULL); cv_trace_dump_file = 0; } }
+
+#else
+
+static inline void cv_trace_frame(struct image_t *img __attribute__((unused))) {}
+static inline void cv_trace_listener(enum cv_trace_point point __attribute__((unused)),
+                                     struct video_listener *listener __attribute__((unused)),
+                                     struct image_t *img __attribute__((unused))) {}
+static inline void cv_trace_publish(struct video_listener *listener __attribute__((unused)),
+                                    uint32_t frame_id __attribute__((unused)),
+                                    uint32_t capture_ts __attribute__((unused))) {}
+
+#endif /* CV_TRACE */
+
+#endif /* CV_TRACE_H */
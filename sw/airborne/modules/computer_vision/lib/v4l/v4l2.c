@@ -45,6 +45,14 @@
 
 #define CLEAR(x) memset(&(x), 0, sizeof (x))
 static void *v4l2_capture_thread(void *data);
+static void v4l2_buf_retain(struct image_t *img);
+static void v4l2_buf_release(struct image_t *img);
+
+/* Reference counting of the capture buffers shared with image_retain() and image_release() */
+static const struct image_buf_ops_t v4l2_buf_ops = {
+  .retain = v4l2_buf_retain,
+  .release = v4l2_buf_release
+};
 
 /**
  * The main capturing thread
@@ -355,6 +363,7 @@ void v4l2_image_get(struct v4l2_device *dev, struct image_t *img)
       if (dev->buffers_deq_idx != V4L2_IMG_NONE) {
         img_idx = dev->buffers_deq_idx;
         dev->buffers_deq_idx = V4L2_IMG_NONE;
+        dev->buffers[img_idx].refs = 1;
       }
 
       pthread_mutex_unlock(&dev->mutex);
@@ -370,6 +379,10 @@ void v4l2_image_get(struct v4l2_device *dev, struct image_t *img)
   img->buf = dev->buffers[img_idx].buf;
   img->ts = dev->buffers[img_idx].timestamp;
   img->pprz_ts =  dev->buffers[img_idx].pprz_timestamp;
+  img->dequeue_ts = get_sys_time_usec();
+  img->frame_id = dev->frame_cnt++;
+  img->buf_ops = &v4l2_buf_ops;
+  img->buf_owner = dev;
 }
 
 /**
@@ -389,6 +402,7 @@ bool v4l2_image_get_nonblock(struct v4l2_device *dev, struct image_t *img)
   if (dev->buffers_deq_idx != V4L2_IMG_NONE) {
     img_idx = dev->buffers_deq_idx;
     dev->buffers_deq_idx = V4L2_IMG_NONE;
+    dev->buffers[img_idx].refs = 1;
   }
   pthread_mutex_unlock(&dev->mutex);
 
@@ -406,12 +420,33 @@ bool v4l2_image_get_nonblock(struct v4l2_device *dev, struct image_t *img)
   img->buf = dev->buffers[img_idx].buf;
   img->ts = dev->buffers[img_idx].timestamp;
   img->pprz_ts = dev->buffers[img_idx].pprz_timestamp;
+  img->dequeue_ts = get_sys_time_usec();
+  img->frame_id = dev->frame_cnt++;
+  img->buf_ops = &v4l2_buf_ops;
+  img->buf_owner = dev;
   return true;
 }
 
+/**
+ * Take an extra reference on the buffer of an image (Thread safe)
+ * The buffer is only enqueued again after every reference is dropped with v4l2_image_free(),
+ * so the image can be processed further (e.g. in another thread) without copying it.
+ * Keep in mind that a held buffer can not be used by the device for new images.
+ * @param[in] *dev The video for linux device which the image is from
+ * @param[in] *img The image to keep
+ */
+void v4l2_image_retain(struct v4l2_device *dev, struct image_t *img)
+{
+  pthread_mutex_lock(&dev->mutex);
+  dev->buffers[img->buf_idx].refs++;
+  pthread_mutex_unlock(&dev->mutex);
+}
+
 /**
  * Free the image and enqueue the buffer (Thread safe)
- * This must be done after processing the image, because else all buffers are locked
+ * This must be done after processing the image, because else all buffers are locked.
+ * When other references were taken with v4l2_image_retain(), the buffer is only enqueued
+ * by the last one.
  * @param[in] *dev The video for linux device which the image is from
  * @param[in] *img The image to free
  */
@@ -419,6 +454,19 @@ void v4l2_image_free(struct v4l2_device *dev, struct image_t *img)
 {
   struct v4l2_buffer buf;
 
+  // Only enqueue after the last reference
+  pthread_mutex_lock(&dev->mutex);
+  bool last = (dev->buffers[img->buf_idx].refs <= 1);
+  if (!last) {
+    dev->buffers[img->buf_idx].refs--;
+  } else {
+    dev->buffers[img->buf_idx].refs = 0;
+  }
+  pthread_mutex_unlock(&dev->mutex);
+  if (!last) {
+    return;
+  }
+
   // Enqueue the buffer
   CLEAR(buf);
   buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
@@ -429,6 +477,17 @@ void v4l2_image_free(struct v4l2_device *dev, struct image_t *img)
   }
 }
 
+/* The image_buf_ops_t of the capture buffers */
+static void v4l2_buf_retain(struct image_t *img)
+{
+  v4l2_image_retain((struct v4l2_device *)img->buf_owner, img);
+}
+
+static void v4l2_buf_release(struct image_t *img)
+{
+  v4l2_image_free((struct v4l2_device *)img->buf_owner, img);
+}
+
 /**
  * Start capturing images in streaming mode (Thread safe)
  * @param[in] *dev The video for linux device to start capturing from
@@ -451,6 +510,7 @@ bool v4l2_start_capture(struct v4l2_device *dev)
   dev->buffers_deq_idx = V4L2_IMG_NONE;
   for (i = 0; i < dev->buffers_cnt; ++i) {
     struct v4l2_buffer buf;
+    dev->buffers[i].refs = 0;
 
     CLEAR(buf);
     buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
@@ -44,6 +44,7 @@ struct v4l2_img_buf {
   uint32_t pprz_timestamp;    ///< The time of the image in us since system startup
   void *buf;                  ///< Pointer to the memory mapped buffer
   uint32_t physp;             ///< Physical address pointer
+  uint8_t refs;               ///< References on the buffer while it is out of the driver queue (locked by the device mutex)
 };
 
 /* V4L2 device */
@@ -55,6 +56,7 @@ struct v4l2_device {
   uint16_t h;                       ///< The height of the image
   uint8_t buffers_cnt;              ///< The number of image buffers
   volatile uint8_t buffers_deq_idx; ///< The current dequeued index
+  uint32_t frame_cnt;               ///< The number of images taken from the device
   pthread_mutex_t mutex;            ///< Mutex lock for enqueue/dequeue of buffers (change the deq_idx)
   struct v4l2_img_buf *buffers;     ///< The memory mapped image buffers
 };
@@ -66,6 +68,7 @@ struct v4l2_device *v4l2_init(char *device_name, struct img_size_t size, struct
 void v4l2_image_get(struct v4l2_device *dev, struct image_t *img);
 bool v4l2_image_get_nonblock(struct v4l2_device *dev, struct image_t *img);
 void v4l2_image_free(struct v4l2_device *dev, struct image_t *img);
+void v4l2_image_retain(struct v4l2_device *dev, struct image_t *img);
 bool v4l2_start_capture(struct v4l2_device *dev);
 bool v4l2_stop_capture(struct v4l2_device *dev);
 void v4l2_close(struct v4l2_device *dev);
@@ -29,6 +29,11 @@
 #include <string.h>
 #include "lucas_kanade.h"
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define IMAGE_USE_NEON 1
+#endif
+
 #ifndef CACHE_LINE_LENGTH
 #define CACHE_LINE_LENGTH 64
 #endif
@@ -46,6 +51,8 @@ void image_create(struct image_t *img, uint16_t width, uint16_t height, enum ima
   img->type = type;
   img->w = width;
   img->h = height;
+  img->buf_ops = NULL;
+  img->buf_owner = NULL;
 
   // Depending on the type the size differs
   if (type == IMAGE_YUV422) {
@@ -98,10 +105,35 @@ void image_copy(struct image_t *input, struct image_t *output)
   output->ts = input->ts;
   output->eulers = input->eulers;
   output->pprz_ts = input->pprz_ts;
+  output->dequeue_ts = input->dequeue_ts;
+  output->frame_id = input->frame_id;
 
   memcpy(output->buf, input->buf, input->buf_size);
 }
 
+/**
+ * Take an extra reference on a shared image buffer
+ * This allows to keep using the buffer of a captured image without copying it.
+ * @param[in] *img The image with the shared buffer
+ */
+void image_retain(struct image_t *img)
+{
+  if (img->buf_ops != NULL) {
+    img->buf_ops->retain(img);
+  }
+}
+
+/**
+ * Drop a reference on a shared image buffer taken with image_retain()
+ * @param[in] *img The image with the shared buffer
+ */
+void image_release(struct image_t *img)
+{
+  if (img->buf_ops != NULL) {
+    img->buf_ops->release(img);
+  }
+}
+
 /**
  * This will switch image *a and *b
  * This is faster as image_copy because it doesn't copy the
@@ -176,15 +208,11 @@ uint16_t image_yuv422_colorfilt(struct image_t *input, struct image_t *output, u
   // Go trough all the pixels
   for (uint16_t y = 0; y < output->h; y++) {
     for (uint16_t x = 0; x < output->w; x += 2) {
-      // Check if the color is inside the specified values
-      if (
-        (dest[1] >= y_m)
-        && (dest[1] <= y_M)
-        && (dest[0] >= u_m)
-        && (dest[0] <= u_M)
-        && (dest[2] >= v_m)
-        && (dest[2] <= v_M)
-      ) {
+      // Check if the color is inside the specified values (without branching on every channel)
+      uint8_t pass = (source[1] >= y_m) & (source[1] <= y_M)
+                     & (source[0] >= u_m) & (source[0] <= u_M)
+                     & (source[2] >= v_m) & (source[2] <= v_M);
+      if (pass) {
         cnt ++;
         // UYVY
         dest[0] = 64;        // U
@@ -243,22 +271,144 @@ int check_color_yuv422(struct image_t *im, int x, int y, uint8_t y_m, uint8_t y_
   uint8_t *buf = im->buf;
   buf += 2 * (y * (im->w) + x); // each pixel has two bytes
 
-  if (
-    (buf[1] >= y_m)
-    && (buf[1] <= y_M)
-    && (buf[0] >= u_m)
-    && (buf[0] <= u_M)
-    && (buf[2] >= v_m)
-    && (buf[2] <= v_M)
-  ) {
-    // the pixel passes:
-    return 1;
+  // 1 if the pixel passes, 0 if it does not:
+  return (buf[1] >= y_m) & (buf[1] <= y_M)
+         & (buf[0] >= u_m) & (buf[0] <= u_M)
+         & (buf[2] >= v_m) & (buf[2] <= v_M);
+}
+
+/**
+ * Create a new color mask
+ * @param[out] *mask The output mask
+ * @param[in] width The width of the image to filter
+ * @param[in] height The height of the image to filter
+ * @param[in] integral Whether to also keep an integral image of the mask (needed for image_mask_count())
+ */
+void image_mask_create(struct image_mask_t *mask, uint16_t width, uint16_t height, bool integral)
+{
+  mask->w = width;
+  mask->h = height;
+  mask->cnt = 0;
+  mask->sum_x = 0;
+  mask->sum_y = 0;
+  mask->buf = malloc(sizeof(uint8_t) * width * height);
+
+  // The first row and column of the integral image stay zero
+  if (integral) {
+    mask->integral = calloc((width + 1) * (height + 1), sizeof(uint32_t));
   } else {
-    // the pixel does not:
-    return 0;
+    mask->integral = NULL;
+  }
+}
+
+/**
+ * Free the color mask
+ * @param[in] *mask The mask to free
+ */
+void image_mask_free(struct image_mask_t *mask)
+{
+  if (mask->buf != NULL) {
+    free(mask->buf);
+    mask->buf = NULL;
+  }
+  if (mask->integral != NULL) {
+    free(mask->integral);
+    mask->integral = NULL;
   }
 }
 
+/**
+ * Filter colors in an YUV422 image into a pixel mask.
+ * All pixels are tested once without branches (with NEON when available), after which the
+ * amount of passing pixels, their moments and optionally the integral image are computed.
+ * Detectors can then query the mask instead of testing the color of every sample again.
+ * @param[in] *input The input image to filter
+ * @param[out] *mask The output mask, created with the same size as the input image
+ * @param[in] y_m The Y minimum value
+ * @param[in] y_M The Y maximum value
+ * @param[in] u_m The U minimum value
+ * @param[in] u_M The U maximum value
+ * @param[in] v_m The V minimum value
+ * @param[in] v_M The V maximum value
+ * @return The amount of filtered pixels
+ */
+uint32_t image_yuv422_color_mask(struct image_t *input, struct image_mask_t *mask, uint8_t y_m, uint8_t y_M,
+                                 uint8_t u_m, uint8_t u_M, uint8_t v_m, uint8_t v_M)
+{
+  uint8_t *source = (uint8_t *)input->buf;
+  uint8_t *dest = mask->buf;
+  uint32_t nb_pairs = (mask->w * mask->h) / 2;
+  uint32_t i = 0;
+
+#if IMAGE_USE_NEON
+  uint8x16_t ym = vdupq_n_u8(y_m), yM = vdupq_n_u8(y_M);
+  uint8x16_t um = vdupq_n_u8(u_m), uM = vdupq_n_u8(u_M);
+  uint8x16_t vm = vdupq_n_u8(v_m), vM = vdupq_n_u8(v_M);
+  uint8x16_t one = vdupq_n_u8(1);
+
+  // 16 UYVY pairs at a time, deinterleaved in U, Y1, V and Y2
+  for (; i + 16 <= nb_pairs; i += 16) {
+    uint8x16x4_t uyvy = vld4q_u8(source);
+    uint8x16_t uv = vandq_u8(vandq_u8(vcgeq_u8(uyvy.val[0], um), vcleq_u8(uyvy.val[0], uM)),
+                             vandq_u8(vcgeq_u8(uyvy.val[2], vm), vcleq_u8(uyvy.val[2], vM)));
+    uv = vandq_u8(uv, one);
+
+    uint8x16x2_t pix;
+    pix.val[0] = vandq_u8(uv, vandq_u8(vcgeq_u8(uyvy.val[1], ym), vcleq_u8(uyvy.val[1], yM)));
+    pix.val[1] = vandq_u8(uv, vandq_u8(vcgeq_u8(uyvy.val[3], ym), vcleq_u8(uyvy.val[3], yM)));
+    vst2q_u8(dest, pix);
+
+    source += 64;
+    dest += 32;
+  }
+#endif
+
+  // Remaining pixels (or all of them without NEON), UYVY
+  for (; i < nb_pairs; i++) {
+    uint8_t uv = (source[0] >= u_m) & (source[0] <= u_M) & (source[2] >= v_m) & (source[2] <= v_M);
+    dest[0] = uv & (source[1] >= y_m) & (source[1] <= y_M);
+    dest[1] = uv & (source[3] >= y_m) & (source[3] <= y_M);
+
+    source += 4;
+    dest += 2;
+  }
+
+  // Count the pixels, their moments and build the integral image in one pass
+  uint32_t cnt = 0;
+  uint64_t sum_x = 0;
+  uint64_t sum_y = 0;
+  uint32_t stride = mask->w + 1;
+  for (uint16_t y = 0; y < mask->h; y++) {
+    uint8_t *row = &mask->buf[y * mask->w];
+    uint32_t row_cnt = 0;
+    uint32_t row_sum_x = 0;
+
+    if (mask->integral != NULL) {
+      uint32_t *integral_prev = &mask->integral[y * stride + 1];
+      uint32_t *integral = &mask->integral[(y + 1) * stride + 1];
+      for (uint16_t x = 0; x < mask->w; x++) {
+        row_cnt += row[x];
+        row_sum_x += x * row[x];
+        integral[x] = integral_prev[x] + row_cnt;
+      }
+    } else {
+      for (uint16_t x = 0; x < mask->w; x++) {
+        row_cnt += row[x];
+        row_sum_x += x * row[x];
+      }
+    }
+
+    cnt += row_cnt;
+    sum_x += row_sum_x;
+    sum_y += (uint64_t)y * row_cnt;
+  }
+
+  mask->cnt = cnt;
+  mask->sum_x = sum_x;
+  mask->sum_y = sum_y;
+  return cnt;
+}
+
 /**
  * Sets Y,U,V for a single pixel.
  *
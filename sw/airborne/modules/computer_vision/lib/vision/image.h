@@ -40,6 +40,14 @@ enum image_type {
   IMAGE_INT16     ///< An image to hold disparity image data from openCV (int16 per pixel)
 };
 
+struct image_t;
+
+/* Reference counting of a buffer shared between images (e.g. a V4L2 capture buffer) */
+struct image_buf_ops_t {
+  void (*retain)(struct image_t *img);   ///< Take an extra reference on the buffer of the image
+  void (*release)(struct image_t *img);  ///< Drop a reference, the buffer is recycled after the last one
+};
+
 /* Main image structure */
 struct image_t {
   enum image_type type;   ///< The image type
@@ -48,10 +56,14 @@ struct image_t {
   struct timeval ts;      ///< The timestamp of creation
   struct FloatEulers eulers;   ///< Euler Angles at time of image
   uint32_t pprz_ts;       ///< The timestamp in us since system startup
+  uint32_t dequeue_ts;    ///< The time the image was taken from the device in us since system startup
+  uint32_t frame_id;      ///< Sequence number of the image on its device (for latency tracing)
 
   uint8_t buf_idx;        ///< Buffer index for V4L2 freeing
   uint32_t buf_size;      ///< The buffer size
   void *buf;              ///< Image buffer (depending on the image_type)
+  const struct image_buf_ops_t *buf_ops;  ///< Reference counting of a shared buffer (NULL when the image owns its buffer)
+  void *buf_owner;        ///< The owner of the shared buffer (e.g. the V4L2 device)
 };
 
 /* Image point structure */
@@ -96,16 +108,33 @@ struct crop_t {
   uint16_t h;    ///< height of the cropped area
 };
 
+/* Pixel mask of a color filter with its integral image */
+struct image_mask_t {
+  uint16_t w;             ///< Mask width
+  uint16_t h;             ///< Mask height
+  uint8_t *buf;           ///< Mask (one byte per pixel, 1 if the pixel passes the filter, 0 otherwise)
+  uint32_t *integral;     ///< Integral image of the mask ((w+1)*(h+1) entries) or NULL when not used
+  uint32_t cnt;           ///< Amount of pixels passing the filter
+  uint64_t sum_x;         ///< Sum of the x coordinates of the passing pixels
+  uint64_t sum_y;         ///< Sum of the y coordinates of the passing pixels
+};
+
 /* Usefull image functions */
 void image_add_border(struct image_t *input, struct image_t *output, uint8_t border_size);
 void image_create(struct image_t *img, uint16_t width, uint16_t height, enum image_type type);
 void image_free(struct image_t *img);
 void image_copy(struct image_t *input, struct image_t *output);
+void image_retain(struct image_t *img);
+void image_release(struct image_t *img);
 void image_switch(struct image_t *a, struct image_t *b);
 void image_to_grayscale(struct image_t *input, struct image_t *output);
 uint16_t image_yuv422_colorfilt(struct image_t *input, struct image_t *output, uint8_t y_m, uint8_t y_M, uint8_t u_m,
                                 uint8_t u_M, uint8_t v_m, uint8_t v_M);
 int check_color_yuv422(struct image_t *im, int x, int y, uint8_t y_m, uint8_t y_M, uint8_t u_m, uint8_t u_M, uint8_t v_m, uint8_t v_M);
+void image_mask_create(struct image_mask_t *mask, uint16_t width, uint16_t height, bool integral);
+void image_mask_free(struct image_mask_t *mask);
+uint32_t image_yuv422_color_mask(struct image_t *input, struct image_mask_t *mask, uint8_t y_m, uint8_t y_M,
+                                 uint8_t u_m, uint8_t u_M, uint8_t v_m, uint8_t v_M);
 void set_color_yuv422(struct image_t *im, int x, int y, uint8_t Y, uint8_t U, uint8_t V);
 void image_yuv422_downsample(struct image_t *input, struct image_t *output, uint8_t downsample);
 void image_subpixel_window(struct image_t *input, struct image_t *output, struct point_t *center,
@@ -127,4 +156,45 @@ void pyramid_next_level(struct image_t *input, struct image_t *output, uint8_t b
 void pyramid_build(struct image_t *input, struct image_t *output_array, uint8_t pyr_level, uint16_t border_size);
 void image_gradient_pixel(struct image_t *img, struct point_t *loc, int method, int *dx, int *dy);
 
+/**
+ * Get a single pixel of a color mask
+ * @param[in] *mask The mask from image_yuv422_color_mask()
+ * @param[in] x The x-coordinate of the pixel
+ * @param[in] y The y-coordinate of the pixel
+ * @return 1 if the pixel passed the filter, 0 if it did not or is outside the image
+ */
+static inline uint8_t image_mask_get(struct image_mask_t *mask, int x, int y)
+{
+  if (x < 0 || x >= mask->w || y < 0 || y >= mask->h) {
+    return 0;
+  }
+  return mask->buf[y * mask->w + x];
+}
+
+/**
+ * Count the passing pixels in a rectangle of a color mask in constant time
+ * The mask needs to be created with an integral image.
+ * The rectangle is clipped to the image, max coordinates are exclusive.
+ * @param[in] *mask The mask from image_yuv422_color_mask()
+ * @param[in] x_min The first column of the rectangle
+ * @param[in] y_min The first row of the rectangle
+ * @param[in] x_max The column after the last one of the rectangle
+ * @param[in] y_max The row after the last one of the rectangle
+ * @return The amount of passing pixels inside the rectangle
+ */
+static inline uint32_t image_mask_count(struct image_mask_t *mask, int x_min, int y_min, int x_max, int y_max)
+{
+  if (x_min < 0) { x_min = 0; }
+  if (y_min < 0) { y_min = 0; }
+  if (x_max > mask->w) { x_max = mask->w; }
+  if (y_max > mask->h) { y_max = mask->h; }
+  if (x_min >= x_max || y_min >= y_max) {
+    return 0;
+  }
+
+  uint32_t stride = mask->w + 1;
+  return mask->integral[y_max * stride + x_max] - mask->integral[y_min * stride + x_max]
+         - mask->integral[y_max * stride + x_min] + mask->integral[y_min * stride + x_min];
+}
+
 #endif
@@ -40,14 +40,33 @@
 //#include "defs_and_types.h"
 #include "linear_flow_fit.h"
 #include "math/pprz_algebra_float.h"
-#include "math/pprz_matrix_decomp_float.h"
-#include "math/pprz_simple_matrix.h"
-
-// Is this still necessary?
-#define MAX_COUNT_PT 50
+#include "math/RANSAC.h"
 
 #define MIN_SAMPLES_FIT 3
 
+/** Maximum number of flow vectors used in the fit, the others are ignored */
+#ifndef LINEAR_FLOW_FIT_MAX_POINTS
+#define LINEAR_FLOW_FIT_MAX_POINTS 512
+#endif
+
+/** Maximum number of RANSAC iterations */
+#ifndef LINEAR_FLOW_FIT_MAX_ITERATIONS
+#define LINEAR_FLOW_FIT_MAX_ITERATIONS 100
+#endif
+
+/** Preallocated workspace of the fit */
+static struct {
+  float pos[LINEAR_FLOW_FIT_MAX_POINTS][2];             ///< Positions (x, y) of the flow vectors
+  float flow_u[LINEAR_FLOW_FIT_MAX_POINTS];             ///< Horizontal flow
+  float flow_v[LINEAR_FLOW_FIT_MAX_POINTS];             ///< Vertical flow
+  float hyp_u[LINEAR_FLOW_FIT_MAX_ITERATIONS * 3];      ///< Horizontal flow field hypotheses
+  float hyp_v[LINEAR_FLOW_FIT_MAX_ITERATIONS * 3];      ///< Vertical flow field hypotheses
+  int indices[LINEAR_FLOW_FIT_MAX_POINTS];              ///< Subset of a single fit
+} lff_ws;
+
+static void fit_flow_subset(const int *indices, int n, float *pu, float *pv);
+static float flow_error(const float *params, const float *flow, int count, float error_threshold, int *n_inliers);
+
 /**
  * Analyze a linear flow field, retrieving information such as divergence, surface roughness, focus of expansion, etc.
  * @param[out] outcome If 0, there were too few vectors for a fit. If 1, the fit was successful.
@@ -68,9 +87,18 @@ bool analyze_linear_flow_field(struct flow_t *vectors, int count, float error_th
     return false;
   }
 
+  // only the first LINEAR_FLOW_FIT_MAX_POINTS vectors are fit, warn once when some are left out
+  static bool truncation_reported = false;
+  info->n_ignored = (count > LINEAR_FLOW_FIT_MAX_POINTS) ? count - LINEAR_FLOW_FIT_MAX_POINTS : 0;
+  if (info->n_ignored > 0 && !truncation_reported) {
+    fprintf(stderr, "[linear_flow_fit] %d flow vectors, only the first %d are fit (LINEAR_FLOW_FIT_MAX_POINTS)\n",
+            count, LINEAR_FLOW_FIT_MAX_POINTS);
+    truncation_reported = true;
+  }
+
   // fit linear flow field:
   float parameters_u[3], parameters_v[3], min_error_u, min_error_v;
-  fit_linear_flow_field(vectors, count, n_iterations, error_threshold, n_samples, parameters_u, parameters_v, &info->fit_error, &min_error_u, &min_error_v, &info->n_inliers_u, &info->n_inliers_v);
+  fit_linear_flow_field(vectors, count, error_threshold, n_iterations, n_samples, parameters_u, parameters_v, &info->fit_error, &min_error_u, &min_error_v, &info->n_inliers_u, &info->n_inliers_v);
 
   // extract information from the parameters:
   extract_information_from_parameters(parameters_u, parameters_v, im_width, im_height, info);
@@ -88,7 +116,7 @@ bool analyze_linear_flow_field(struct flow_t *vectors, int count, float error_th
 /**
  * Analyze a linear flow field, retrieving information such as divergence, surface roughness, focus of expansion, etc.
  * @param[in] vectors The optical flow vectors
- * @param[in] count The number of optical flow vectors
+ * @param[in] count The number of optical flow vectors, only the first LINEAR_FLOW_FIT_MAX_POINTS are used
  * @param[in] error_threshold Error used to determine inliers / outliers.
  * @param[in] n_iterations Number of RANSAC iterations.
  * @param[in] n_samples Number of samples used for a single fit (min. 3).
@@ -103,204 +131,127 @@ bool analyze_linear_flow_field(struct flow_t *vectors, int count, float error_th
 void fit_linear_flow_field(struct flow_t *vectors, int count, float error_threshold, int n_iterations, int n_samples, float *parameters_u, float *parameters_v, float *fit_error, float *min_error_u, float *min_error_v, int *n_inliers_u, int *n_inliers_v)
 {
 
-  // We will solve systems of the form A x = b,
+  // We solve systems of the form A x = b,
   // where A = [nx3] matrix with entries [x, y, 1] for each optic flow location
   // and b = [nx1] vector with either the horizontal (bu) or vertical (bv) flow.
   // x in the system are the parameters for the horizontal (pu) or vertical (pv) flow field.
 
-  // local vars for iterating, random numbers:
-  int sam, p, i_rand, si, add_si;
+  count = (count < LINEAR_FLOW_FIT_MAX_POINTS) ? count : LINEAR_FLOW_FIT_MAX_POINTS;
+  n_iterations = (n_iterations < LINEAR_FLOW_FIT_MAX_ITERATIONS) ? n_iterations : LINEAR_FLOW_FIT_MAX_ITERATIONS;
+  n_iterations = (n_iterations < 1) ? 1 : n_iterations;
 
   // ensure that n_samples is high enough to ensure a result for a single fit:
   n_samples = (n_samples < MIN_SAMPLES_FIT) ? MIN_SAMPLES_FIT : n_samples;
   // n_samples should not be higher than count:
   n_samples = (n_samples < count) ? n_samples : count;
 
-  // initialize matrices and vectors for the full point set problem:
-  // this is used for determining inliers
-  float _AA[count][3];
-  MAKE_MATRIX_PTR(AA, _AA, count);
-  float _bu_all[count][1];
-  MAKE_MATRIX_PTR(bu_all, _bu_all, count);
-  float _bv_all[count][1];
-  MAKE_MATRIX_PTR(bv_all, _bv_all, count);
-  for (sam = 0; sam < count; sam++) {
-    AA[sam][0] = (float) vectors[sam].pos.x;
-    AA[sam][1] = (float) vectors[sam].pos.y;
-    AA[sam][2] = 1.0f;
-    bu_all[sam][0] = (float) vectors[sam].flow_x;
-    bv_all[sam][0] = (float) vectors[sam].flow_y;
+  // the full point set, used for determining inliers:
+  for (int p = 0; p < count; p++) {
+    lff_ws.pos[p][0] = (float) vectors[p].pos.x;
+    lff_ws.pos[p][1] = (float) vectors[p].pos.y;
+    lff_ws.flow_u[p] = (float) vectors[p].flow_x;
+    lff_ws.flow_v[p] = (float) vectors[p].flow_y;
   }
 
-  // later used to determine the error of a set of parameters on the whole set:
-  float _bb[count][1];
-  MAKE_MATRIX_PTR(bb, _bb, count);
-  float _C[count][1];
-  MAKE_MATRIX_PTR(C, _C, count);
-
   // ***************
   // perform RANSAC:
   // ***************
 
-  // set up variables for small linear system solved repeatedly inside RANSAC:
-  float _A[n_samples][3];
-  MAKE_MATRIX_PTR(A, _A, n_samples);
-  float _bu[n_samples][1];
-  MAKE_MATRIX_PTR(bu, _bu, n_samples);
-  float _bv[n_samples][1];
-  MAKE_MATRIX_PTR(bv, _bv, n_samples);
-  float w[n_samples], _v[3][3];
-  MAKE_MATRIX_PTR(v, _v, 3);
-  float _pu[3][1];
-  MAKE_MATRIX_PTR(pu, _pu, 3);
-  float _pv[3][1];
-  MAKE_MATRIX_PTR(pv, _pv, 3);
-
-  // iterate and store parameters, errors, inliers per fit:
-  float PU[n_iterations * 3];
-  float PV[n_iterations * 3];
-  float errors_pu[n_iterations];
-  errors_pu[0] = 0.0;
-  float errors_pv[n_iterations];
-  errors_pv[0] = 0.0;
-  int n_inliers_pu[n_iterations];
-  int n_inliers_pv[n_iterations];
-  int it, ii;
-  for (it = 0; it < n_iterations; it++) {
-    // select a random sample of n_sample points:
-    int sample_indices[n_samples];
-    i_rand = 0;
-
-    // sampling without replacement:
-    while (i_rand < n_samples) {
-      si = rand() % count;
-      add_si = 1;
-      for (ii = 0; ii < i_rand; ii++) {
-        if (sample_indices[ii] == si) { add_si = 0; }
-      }
-      if (add_si) {
-        sample_indices[i_rand] = si;
-        i_rand ++;
-      }
-    }
-
-    // Setup the system:
-    for (sam = 0; sam < n_samples; sam++) {
-      A[sam][0] = (float) vectors[sample_indices[sam]].pos.x;
-      A[sam][1] = (float) vectors[sample_indices[sam]].pos.y;
-      A[sam][2] = 1.0f;
-      bu[sam][0] = (float) vectors[sample_indices[sam]].flow_x;
-      bv[sam][0] = (float) vectors[sample_indices[sam]].flow_y;
-      //printf("%d,%d,%d,%d,%d\n",A[sam][0],A[sam][1],A[sam][2],bu[sam][0],bv[sam][0]);
-    }
+  // generate all hypotheses, both flow directions are fit on the same subset:
+  for (int it = 0; it < n_iterations; it++) {
+    get_indices_without_replacement(lff_ws.indices, n_samples, count);
+    fit_flow_subset(lff_ws.indices, n_samples, &lff_ws.hyp_u[it * 3], &lff_ws.hyp_v[it * 3]);
+  }
 
-    // Solve the small system:
-
-    // for horizontal flow:
-    // decompose A in u, w, v with singular value decomposition A = u * w * vT.
-    // u replaces A as output:
-    pprz_svd_float(A, w, v, n_samples, 3);
-    pprz_svd_solve_float(pu, A, w, v, bu, n_samples, 3, 1);
-    PU[it * 3] = pu[0][0];
-    PU[it * 3 + 1] = pu[1][0];
-    PU[it * 3 + 2] = pu[2][0];
-
-    // for vertical flow:
-    pprz_svd_solve_float(pv, A, w, v, bv, n_samples, 3, 1);
-    PV[it * 3] = pv[0][0];
-    PV[it * 3 + 1] = pv[1][0];
-    PV[it * 3 + 2] = pv[2][0];
-
-    // count inliers and determine their error on all points:
-    errors_pu[it] = 0;
-    errors_pv[it] = 0;
-    n_inliers_pu[it] = 0;
-    n_inliers_pv[it] = 0;
-
-    // for horizontal flow:
-    // bb = AA * pu:
-    MAT_MUL(count, 3, 1, bb, AA, pu);
-    // subtract bu_all: C = 0 in case of perfect fit:
-    MAT_SUB(count, 1, C, bb, bu_all);
-
-    for (p = 0; p < count; p++) {
-      C[p][0] = abs(C[p][0]);
-      if (C[p][0] < error_threshold) {
-        errors_pu[it] += C[p][0];
-        n_inliers_pu[it]++;
-      } else {
-        errors_pu[it] += error_threshold;
-      }
-    }
+  // select the parameters with lowest capped error on all points:
+  int best_u = RANSAC_best_linear_hypothesis(n_iterations, 2, lff_ws.hyp_u, lff_ws.pos, lff_ws.flow_u, count,
+                                             error_threshold, NULL);
+  int best_v = RANSAC_best_linear_hypothesis(n_iterations, 2, lff_ws.hyp_v, lff_ws.pos, lff_ws.flow_v, count,
+                                             error_threshold, NULL);
+  memcpy(parameters_u, &lff_ws.hyp_u[best_u * 3], 3 * sizeof(float));
+  memcpy(parameters_v, &lff_ws.hyp_v[best_v * 3], 3 * sizeof(float));
 
-    // for vertical flow:
-    // bb = AA * pv:
-    MAT_MUL(count, 3, 1, bb, AA, pv);
-    // subtract bv_all: C = 0 in case of perfect fit:
-    MAT_SUB(count, 1, C, bb, bv_all);
-
-    for (p = 0; p < count; p++) {
-      C[p][0] = abs(C[p][0]);
-      if (C[p][0] < error_threshold) {
-        errors_pv[it] += C[p][0];
-        n_inliers_pv[it]++;
-      } else {
-        errors_pv[it] += error_threshold;
-      }
-    }
-  }
+  // error has to be determined on the entire set without threshold:
+  *min_error_u = flow_error(parameters_u, lff_ws.flow_u, count, error_threshold, n_inliers_u);
+  *min_error_v = flow_error(parameters_v, lff_ws.flow_v, count, error_threshold, n_inliers_v);
+  *fit_error = (*min_error_u + *min_error_v) / (2 * count);
+}
 
-  // After all iterations:
-  // select the parameters with lowest error:
-  // for horizontal flow:
-  int param;
-  int min_ind = 0;
-  *min_error_u = (float)errors_pu[0];
-  for (it = 1; it < n_iterations; it++) {
-    if (errors_pu[it] < *min_error_u) {
-      *min_error_u = (float)errors_pu[it];
-      min_ind = it;
-    }
-  }
-  for (param = 0; param < 3; param++) {
-    parameters_u[param] = PU[min_ind * 3 + param];
-  }
-  *n_inliers_u = n_inliers_pu[min_ind];
-
-  // for vertical flow:
-  min_ind = 0;
-  *min_error_v = (float)errors_pv[0];
-  for (it = 0; it < n_iterations; it++) {
-    if (errors_pv[it] < *min_error_v) {
-      *min_error_v = (float)errors_pv[it];
-      min_ind = it;
-    }
+/**
+ * Least squares fit of the flow fields on a subset of the flow vectors
+ *
+ * The positions are centered so that the normal equations of the slopes
+ * are well conditioned. A degenerate (collinear) subset gives a uniform flow.
+ * @param[in] indices The indices of the subset in the workspace
+ * @param[in] n The number of points in the subset
+ * @param[out] pu Parameters of the horizontal flow field
+ * @param[out] pv Parameters of the vertical flow field
+ */
+static void fit_flow_subset(const int *indices, int n, float *pu, float *pv)
+{
+  float mx = 0.f, my = 0.f, mu = 0.f, mv = 0.f;
+  for (int i = 0; i < n; i++) {
+    mx += lff_ws.pos[indices[i]][0];
+    my += lff_ws.pos[indices[i]][1];
+    mu += lff_ws.flow_u[indices[i]];
+    mv += lff_ws.flow_v[indices[i]];
   }
-  for (param = 0; param < 3; param++) {
-    parameters_v[param] = PV[min_ind * 3 + param];
+  mx /= n;
+  my /= n;
+  mu /= n;
+  mv /= n;
+
+  float sxx = 0.f, sxy = 0.f, syy = 0.f, sxu = 0.f, syu = 0.f, sxv = 0.f, syv = 0.f;
+  for (int i = 0; i < n; i++) {
+    float dx = lff_ws.pos[indices[i]][0] - mx;
+    float dy = lff_ws.pos[indices[i]][1] - my;
+    float du = lff_ws.flow_u[indices[i]] - mu;
+    float dv = lff_ws.flow_v[indices[i]] - mv;
+    sxx += dx * dx;
+    sxy += dx * dy;
+    syy += dy * dy;
+    sxu += dx * du;
+    syu += dy * du;
+    sxv += dx * dv;
+    syv += dy * dv;
   }
-  *n_inliers_v = n_inliers_pv[min_ind];
 
-  // error has to be determined on the entire set without threshold:
-  // bb = AA * pu:
-  MAT_MUL(count, 3, 1, bb, AA, pu);
-  // subtract bu_all: C = 0 in case of perfect fit:
-  MAT_SUB(count, 1, C, bb, bu_all);
-  *min_error_u = 0;
-  for (p = 0; p < count; p++) {
-    *min_error_u += abs(C[p][0]);
-  }
-  // bb = AA * pv:
-  MAT_MUL(count, 3, 1, bb, AA, pv);
-  // subtract bv_all: C = 0 in case of perfect fit:
-  MAT_SUB(count, 1, C, bb, bv_all);
-  *min_error_v = 0;
-  for (p = 0; p < count; p++) {
-    *min_error_v += abs(C[p][0]);
+  float det = sxx * syy - sxy * sxy;
+  if (det > 1e-6f * sxx * syy) {
+    pu[0] = (syy * sxu - sxy * syu) / det;
+    pu[1] = (sxx * syu - sxy * sxu) / det;
+    pv[0] = (syy * sxv - sxy * syv) / det;
+    pv[1] = (sxx * syv - sxy * sxv) / det;
+  } else {
+    pu[0] = pu[1] = pv[0] = pv[1] = 0.f;
   }
-  *fit_error = (*min_error_u + *min_error_v) / (2 * count);
+  pu[2] = mu - pu[0] * mx - pu[1] * my;
+  pv[2] = mv - pv[0] * mx - pv[1] * my;
+}
 
+/**
+ * Error of a flow field on all points
+ * @param[in] params Parameters of the flow field
+ * @param[in] flow The flow in the direction of the field
+ * @param[in] count The number of points
+ * @param[in] error_threshold Error used to determine inliers / outliers.
+ * @param[out] n_inliers The number of points with an error below the threshold
+ * @return The sum of the absolute errors
+ */
+static float flow_error(const float *params, const float *flow, int count, float error_threshold, int *n_inliers)
+{
+  float error = 0.f;
+  *n_inliers = 0;
+  for (int p = 0; p < count; p++) {
+    float e = fabsf(params[0] * lff_ws.pos[p][0] + params[1] * lff_ws.pos[p][1] + params[2] - flow[p]);
+    error += e;
+    if (e < error_threshold) {
+      (*n_inliers)++;
+    }
+  }
+  return error;
 }
+
 /**
  * Extract information from the parameters that were fit to the optical flow field.
  * @param[in] parameters_u* Parameters of the horizontal flow field
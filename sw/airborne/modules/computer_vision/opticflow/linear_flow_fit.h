@@ -51,6 +51,7 @@ struct linear_flow_fit_info {
   float fit_error;    ///< Error of the fit (same as surface roughness)
   int n_inliers_u;    ///< Number of inliers in the horizontal flow fit
   int n_inliers_v;    ///< Number of inliers in the vertical flow fit
+  int n_ignored;      ///< Number of flow vectors left out of the fit (above LINEAR_FLOW_FIT_MAX_POINTS)
 };
 
 // This is the function called externally, passing the vector of optical flow vectors and information on the number of vectors and image size:
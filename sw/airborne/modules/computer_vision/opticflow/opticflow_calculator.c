@@ -45,6 +45,7 @@
 #include "size_divergence.h"
 #include "linear_flow_fit.h"
 #include "modules/sonar/agl_dist.h"
+#include "math/pprz_algebra_float.h"
 
 // to get the definition of front_camera / bottom_camera
 #include BOARD_CONFIG
@@ -630,9 +631,16 @@ bool calc_fast9_lukas_kanade(struct opticflow_t *opticflow, struct image_t *img,
 static struct flow_t *predict_flow_vectors(struct flow_t *flow_vectors, uint16_t n_points, float phi_diff,
     float theta_diff, float psi_diff, struct opticflow_t *opticflow)
 {
-
-  // reserve memory for the predicted flow vectors:
-  struct flow_t *predicted_flow_vectors = malloc(sizeof(struct flow_t) * n_points);
+  // buffers for the predicted flow vectors and the camera rays, only grown when needed
+  static struct flow_t *predicted_flow_vectors = NULL;
+  static float *ray_buf = NULL;
+  static uint16_t capacity = 0;
+  if (n_points > capacity) {
+    predicted_flow_vectors = realloc(predicted_flow_vectors, sizeof(struct flow_t) * n_points);
+    ray_buf = realloc(ray_buf, sizeof(float) * 3 * n_points);
+    capacity = n_points;
+  }
+  struct FloatVect3Array rays = { ray_buf, ray_buf + capacity, ray_buf + 2 * capacity };
 
   float K[9] = {OPTICFLOW_CAMERA.camera_intrinsics.focal_x, 0.0f, OPTICFLOW_CAMERA.camera_intrinsics.center_x,
                 0.0f, OPTICFLOW_CAMERA.camera_intrinsics.focal_y, OPTICFLOW_CAMERA.camera_intrinsics.center_y,
@@ -641,51 +649,56 @@ static struct flow_t *predict_flow_vectors(struct flow_t *flow_vectors, uint16_t
   // TODO: make an option to not do distortion / undistortion (Dhane_k = 1)
   float k = OPTICFLOW_CAMERA.camera_intrinsics.Dhane_k;
 
-  float A, B, C; // as in Longuet-Higgins
+  struct FloatVect3 rot_vect; // A, B, C as in Longuet-Higgins
 
   if (strcmp(OPTICFLOW_CAMERA.dev_name, front_camera.dev_name) == 0) {
     // specific for the x,y swapped Bebop 2 images:
-    A = -psi_diff;
-    B = theta_diff;
-    C = phi_diff;
+    rot_vect.x = -psi_diff;
+    rot_vect.y = theta_diff;
+    rot_vect.z = phi_diff;
   } else {
-    A = theta_diff;
-    B = phi_diff;
-    C = psi_diff;
+    rot_vect.x = theta_diff;
+    rot_vect.y = phi_diff;
+    rot_vect.z = psi_diff;
   }
 
+  // the linear Longuet-Higgins model is the first order of rotating the rays
+  // with the camera: apply the full rotation to all rays at once
+  struct FloatQuat q;
+  struct FloatRMat rot;
+  float_quat_of_orientation_vect(&q, &rot_vect);
+  float_rmat_of_quat(&rot, &q);
+
   float x_n, y_n;
-  float x_n_new, y_n_new, x_pix_new, y_pix_new;
-  float predicted_flow_x, predicted_flow_y;
   for (uint16_t i = 0; i < n_points; i++) {
     // the from-coordinate is always the same:
     predicted_flow_vectors[i].pos.x = flow_vectors[i].pos.x;
     predicted_flow_vectors[i].pos.y = flow_vectors[i].pos.y;
+    predicted_flow_vectors[i].flow_x = 0;
+    predicted_flow_vectors[i].flow_y = 0;
 
     bool success = distorted_pixels_to_normalized_coords((float)flow_vectors[i].pos.x / opticflow->subpixel_factor,
                    (float)flow_vectors[i].pos.y / opticflow->subpixel_factor, &x_n, &y_n, k, K);
-    if (success) {
-      // predict flow as in a linear pinhole camera model:
-      predicted_flow_x = A * x_n * y_n - B * x_n * x_n - B + C * y_n;
-      predicted_flow_y = -C * x_n + A + A * y_n * y_n - B * x_n * y_n;
-
-      x_n_new = x_n + predicted_flow_x;
-      y_n_new = y_n + predicted_flow_y;
+    predicted_flow_vectors[i].error = success ? 0 : LARGE_FLOW_ERROR;
+    rays.x[i] = success ? x_n : 0.f;
+    rays.y[i] = success ? y_n : 0.f;
+    rays.z[i] = 1.f;
+  }
 
-      success = normalized_coords_to_distorted_pixels(x_n_new, y_n_new, &x_pix_new, &y_pix_new, k, K);
+  float_rmat_vmult_batch(&rays, &rot, &rays, n_points);
 
-      if (success) {
-        predicted_flow_vectors[i].flow_x = (int16_t)(x_pix_new * opticflow->subpixel_factor - (float)flow_vectors[i].pos.x);
-        predicted_flow_vectors[i].flow_y = (int16_t)(y_pix_new * opticflow->subpixel_factor - (float)flow_vectors[i].pos.y);
-        predicted_flow_vectors[i].error = 0;
-      } else {
-        predicted_flow_vectors[i].flow_x = 0;
-        predicted_flow_vectors[i].flow_y = 0;
-        predicted_flow_vectors[i].error = LARGE_FLOW_ERROR;
-      }
+  float x_pix_new, y_pix_new;
+  for (uint16_t i = 0; i < n_points; i++) {
+    if (predicted_flow_vectors[i].error != 0) {
+      continue;
+    }
+    bool success = rays.z[i] > 0.f &&
+                   normalized_coords_to_distorted_pixels(rays.x[i] / rays.z[i], rays.y[i] / rays.z[i],
+                       &x_pix_new, &y_pix_new, k, K);
+    if (success) {
+      predicted_flow_vectors[i].flow_x = (int16_t)(x_pix_new * opticflow->subpixel_factor - (float)flow_vectors[i].pos.x);
+      predicted_flow_vectors[i].flow_y = (int16_t)(y_pix_new * opticflow->subpixel_factor - (float)flow_vectors[i].pos.y);
     } else {
-      predicted_flow_vectors[i].flow_x = 0;
-      predicted_flow_vectors[i].flow_y = 0;
       predicted_flow_vectors[i].error = LARGE_FLOW_ERROR;
     }
   }
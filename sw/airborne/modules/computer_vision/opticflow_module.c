@@ -38,6 +38,7 @@
 #include "errno.h"
 
 #include "cv.h"
+#include "cv_trace.h"
 
 /* ABI messages sender ID */
 #ifndef OPTICFLOW_AGL_ID
@@ -56,6 +57,9 @@ static struct opticflow_result_t opticflow_result; ///< The opticflow result
 
 static bool opticflow_got_result;                ///< When we have an optical flow calculation
 static pthread_mutex_t opticflow_mutex;            ///< Mutex lock fo thread safety
+static struct video_listener *opticflow_listener;  ///< The listener on the camera, for latency tracing
+static uint32_t opticflow_result_frame_id;         ///< Frame number of the result
+static uint32_t opticflow_result_capture_ts;       ///< Capture time of the frame of the result
 
 /* Static functions */
 struct image_t *opticflow_module_calc(struct image_t *img);     ///< The main optical flow calculation thread
@@ -93,7 +97,7 @@ void opticflow_module_init(void)
   opticflow_got_result = false;
   opticflow_calc_init(&opticflow);
 
-  cv_add_to_device(&OPTICFLOW_CAMERA, opticflow_module_calc, OPTICFLOW_FPS);
+  opticflow_listener = cv_add_to_device(&OPTICFLOW_CAMERA, opticflow_module_calc, OPTICFLOW_FPS);
 
 #if PERIODIC_TELEMETRY
   register_periodic_telemetry(DefaultPeriodic, PPRZ_MSG_ID_OPTIC_FLOW_EST, opticflow_telem_send);
@@ -129,6 +133,7 @@ void opticflow_module_run(void)
                                   -1.0f //opticflow_result.noise_measurement // negative value disables filter updates with OF-based vertical velocity.
                                  );
     }
+    cv_trace_publish(opticflow_listener, opticflow_result_frame_id, opticflow_result_capture_ts);
     opticflow_got_result = false;
   }
   pthread_mutex_unlock(&opticflow_mutex);
@@ -155,6 +160,8 @@ struct image_t *opticflow_module_calc(struct image_t *img)
     // Copy the result if finished
     pthread_mutex_lock(&opticflow_mutex);
     opticflow_result = temp_result;
+    opticflow_result_frame_id = img->frame_id;
+    opticflow_result_capture_ts = img->pprz_ts;
     opticflow_got_result = true;
     pthread_mutex_unlock(&opticflow_mutex);
   }
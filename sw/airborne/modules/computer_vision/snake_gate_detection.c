@@ -76,6 +76,9 @@ int min_pixel_size;
 // so that we can better restrain the total number of samples taken:
 int n_total_samples;
 
+// Color mask of the current image, so that the many samples per frame are only lookups
+static struct image_mask_t color_mask;
+
 // Result
 struct gate_img temp_check_gate;
 struct image_t img_result;
@@ -160,6 +163,14 @@ int snake_gate_detection(struct image_t *img, int n_samples, int min_px_size, fl
   color_V_max  = color_VM;
   min_pixel_size = min_px_size;
 
+  // filter the whole image once:
+  if (color_mask.buf == NULL || color_mask.w != img->w || color_mask.h != img->h) {
+    image_mask_free(&color_mask);
+    image_mask_create(&color_mask, img->w, img->h, true);
+  }
+  image_yuv422_color_mask(img, &color_mask, color_Y_min, color_Y_max, color_U_min, color_U_max, color_V_min,
+                          color_V_max);
+
   int x, y;
   best_quality = 0;
   best_gate->quality = 0;
@@ -749,48 +760,43 @@ extern void check_gate_initial(struct image_t *im, struct gate_img gate, float *
 }
 
 /* Check inside of a gate, in order to exclude solid areas.
+ * The ratio is taken exactly from the integral image of the color mask,
+ * while n_samples_in still counts towards the sample budget of the frame.
  *
  * @param[out] center_factor The ratio of pixels inside the box that are of the right color.
  * @param[in] im The YUV422 image.
  * @param[in] x The center x-coordinate of the gate
  * @param[in] y The center y-coordinate of the gate
  * @param[in] sz The size of the gate - when approximated as square.
- * @param[in] n_samples_in The number of samples used to determine the ratio.
+ * @param[in] n_samples_in The number of samples accounted for in the sample budget.
  */
 
 float check_inside(struct image_t *im, int x, int y, int sz, int n_samples_in)
 {
-  int num_color_center = 0;
-  int n_samples = 0;
-
-  if (sz == 0) {
+  if (sz <= 0) {
     return 1.0f;
   }
 
-  for (int i = 0; i < n_samples_in; i++) {
-    // get a random coordinate:
-    int x_in = x + (rand() % sz) - (0.5 * sz);
-    int y_in = y + (rand() % sz) - (0.5 * sz);
-
-    if (y_in >= 0 && y_in < im->w && x_in >= 0 && x_in < im->h) {
-      n_samples++;
-      // check if it has the right color
-      if (check_color_snake_gate_detection(im, x_in, y_in)) {
-        num_color_center ++;
-      }
-    }
-  }
+  n_total_samples += n_samples_in;
+
+  // the box around the center, clipped to the image:
+  // Please note that x and y are switched around here, due to the strange sensor mounting in the Bebop:
+  int x_min = x - (int)(0.5 * sz);
+  int y_min = y - (int)(0.5 * sz);
+  int x_max = x_min + sz;
+  int y_max = y_min + sz;
+  if (x_min < 0) { x_min = 0; }
+  if (y_min < 0) { y_min = 0; }
+  if (x_max > im->h) { x_max = im->h; }
+  if (y_max > im->w) { y_max = im->w; }
 
   //how much center pixels colored?
-  if (n_samples == 0) {
+  if (x_min >= x_max || y_min >= y_max) {
     return 1.0f;
   }
 
-  float center_factor = 0;
-  if (n_samples != 0) {
-    center_factor = num_color_center / (float)n_samples;
-  }
-  return center_factor;
+  uint32_t num_color_center = image_mask_count(&color_mask, y_min, x_min, y_max, x_max);
+  return num_color_center / (float)((x_max - x_min) * (y_max - y_min));
 }
 
 /**
@@ -1102,10 +1108,9 @@ void refine_single_corner(struct image_t *im, int *corner_x, int *corner_y, int
 int check_color_snake_gate_detection(struct image_t *im, int x, int y)
 {
 
-  // Call the function in image.c with the color thresholds:
+  // Look up the pixel in the color mask of this image:
   // Please note that we have to switch x and y around here, due to the strange sensor mounting in the Bebop:
-  int success = check_color_yuv422(im, y, x, color_Y_min, color_Y_max, color_U_min, color_U_max, color_V_min,
-                                   color_V_max);
+  int success = (im->w == color_mask.w && im->h == color_mask.h) ? image_mask_get(&color_mask, y, x) : 0;
   n_total_samples++;
   /*
   #ifdef DEBUG_SNAKE_GATE
@@ -31,15 +31,30 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "modules/computer_vision/cv.h"
 #include "modules/computer_vision/textons.h"
 
-float ** **dictionary;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define TEXTONS_USE_NEON 1
+#endif
+
+float *dictionary;
 uint32_t learned_samples = 0;
 uint8_t dictionary_initialized = 0;
 float *texton_distribution;
 
 // initial settings:
+#ifndef TEXTONS_CAMERA
+#define TEXTONS_CAMERA front_camera
+#endif
+
+#ifndef TEXTONS_FPS
+#define TEXTONS_FPS 0 ///< Default FPS (zero means run at camera fps)
+#endif
+PRINT_CONFIG_VAR(TEXTONS_FPS)
+
 #ifndef TEXTONS_LOAD_DICTIONARY
 #define TEXTONS_LOAD_DICTIONARY 1
 #endif
@@ -112,6 +127,16 @@ static FILE *dictionary_logger = NULL;
 #define DICTIONARY_PATH /data/video/
 #endif
 
+// Preallocated working memory, only reallocated when the number of textons or the patch size change
+static float *patch;                  ///< Current image patch, (patch_size * patch_size * 2) features
+static float *texton_distances;       ///< Squared distance from the current patch to every texton
+static uint8_t allocated_n_textons = 0;
+static uint8_t allocated_patch_size = 0;
+
+static void textons_alloc(void);
+static void extract_patch(uint8_t *frame, uint16_t width, int x, int y);
+static int find_closest_texton(void);
+
 /**
  * Main texton processing function that first either loads or learns a dictionary and then extracts the texton histogram.
  * @param[out] *img The output image
@@ -129,6 +154,9 @@ struct image_t *texton_func(struct image_t *img)
   // if patch size odd, correct:
   if (patch_size % 2 == 1) { patch_size++; }
 
+  // if the settings changed, the dictionary has to be made again:
+  textons_alloc();
+
   // if dictionary not initialized:
   if (dictionary_ready == 0) {
     if (load_dictionary == 0) {
@@ -156,6 +184,103 @@ struct image_t *texton_func(struct image_t *img)
   return img; // Colorfilter did not make a new image
 }
 
+/**
+ * (Re)allocate the dictionary and the working memory for the current settings.
+ * The dictionary is stored as one contiguous structure of arrays: for every patch feature
+ * (row, column, channel) the values of all textons follow each other, so that the distance
+ * to all textons is computed with contiguous (vectorizable) loads.
+ * This does nothing if the number of textons and the patch size did not change.
+ */
+static void textons_alloc(void)
+{
+  if (allocated_n_textons == n_textons && allocated_patch_size == patch_size) {
+    return;
+  }
+
+  free(dictionary);
+  free(patch);
+  free(texton_distances);
+  free(texton_distribution);
+
+  dictionary = (float *)calloc(TEXTONS_N_FEATURES(patch_size) * n_textons, sizeof(float));
+  patch = (float *)calloc(TEXTONS_N_FEATURES(patch_size), sizeof(float));
+  texton_distances = (float *)calloc(n_textons, sizeof(float));
+  texton_distribution = (float *)calloc(n_textons, sizeof(float));
+  allocated_n_textons = n_textons;
+  allocated_patch_size = patch_size;
+
+  // A new dictionary is needed
+  dictionary_initialized = 0;
+  dictionary_ready = 0;
+  learned_samples = 0;
+}
+
+/**
+ * Copy an image patch in the working memory
+ * @param[in] frame* The YUV image data
+ * @param[in] width The width of the image
+ * @param[in] x The x-coordinate of the top left corner of the patch
+ * @param[in] y The y-coordinate of the top left corner of the patch
+ */
+static void extract_patch(uint8_t *frame, uint16_t width, int x, int y)
+{
+  float *p = patch;
+  for (int i = 0; i < patch_size; i++) {
+    // U/V and Y1/Y2 components are consecutive in the image
+    uint8_t *buf = frame + (width * 2 * (i + y)) + 2 * x;
+    for (int j = 0; j < 2 * patch_size; j++) {
+      *p++ = (float) buf[j];
+    }
+  }
+}
+
+/**
+ * Compute the squared distances from the current patch to all textons and return the closest one.
+ * With NEON, four textons are handled at a time with the accumulators kept in registers.
+ * @return The index of the closest texton
+ */
+static int find_closest_texton(void)
+{
+  uint16_t n_features = TEXTONS_N_FEATURES(patch_size);
+  int texton = 0;
+
+#if TEXTONS_USE_NEON
+  for (; texton + 4 <= n_textons; texton += 4) {
+    float32x4_t dist = vdupq_n_f32(0.f);
+    const float *dict = &dictionary[texton];
+    for (uint16_t f = 0; f < n_features; f++) {
+      float32x4_t diff = vsubq_f32(vdupq_n_f32(patch[f]), vld1q_f32(dict));
+      dist = vmlaq_f32(dist, diff, diff);
+      dict += n_textons;
+    }
+    vst1q_f32(&texton_distances[texton], dist);
+  }
+#endif
+
+  // Remaining textons (or all of them without NEON)
+  for (; texton < n_textons; texton++) {
+    float dist = 0.f;
+    const float *dict = &dictionary[texton];
+    for (uint16_t f = 0; f < n_features; f++) {
+      float diff = patch[f] - *dict;
+      dist += diff * diff;
+      dict += n_textons;
+    }
+    texton_distances[texton] = dist;
+  }
+
+  // search the closest texton
+  int assignment = 0;
+  float min_dist = texton_distances[0];
+  for (texton = 1; texton < n_textons; texton++) {
+    if (texton_distances[texton] < min_dist) {
+      min_dist = texton_distances[texton];
+      assignment = texton;
+    }
+  }
+  return assignment;
+}
+
 /**
  * Function that performs one pass for dictionary training. It extracts samples from an image, finds the closest texton
  * and moves it towards the sample.
@@ -165,11 +290,11 @@ struct image_t *texton_func(struct image_t *img)
  */
 void DictionaryTrainingYUV(uint8_t *frame, uint16_t width, uint16_t height)
 {
-  int i, j, w, s, texton, c; // iterators
+  int w, s, f; // iterators
   int x, y; // image coordinates
-  float error_texton; // distance between an image patch and a texton
+  uint16_t n_features = TEXTONS_N_FEATURES(patch_size);
 
-  uint8_t *buf;
+  textons_alloc();
 
   // ***********************
   //   DICTIONARY LEARNING
@@ -188,22 +313,10 @@ void DictionaryTrainingYUV(uint8_t *frame, uint16_t width, uint16_t height)
       x = rand() % (width - patch_size);
       y = rand() % (height - patch_size);
 
-      //printf("(x,y) = (%d,%d), (w,h) = (%d,%d), ps = %d\n", x, y, width, height, patch_size);
-      // take the sample
-      for (i = 0; i < patch_size; i++) {
-        buf = frame + (width * 2 * (i + y)) + 2 * x;
-        for (j = 0; j < patch_size; j++) {
-          // put it in a texton
-          printf("Setting dictionary:\n");
-          // U/V component
-
-          dictionary[w][i][j][0] = (float) * buf;
-          buf += 1;
-          // Y1/Y2 component
-          dictionary[w][i][j][1] = (float) * buf;
-          buf += 1;
-          printf("Done!\n");
-        }
+      // take the sample and put it in a texton
+      extract_patch(frame, width, x, y);
+      for (f = 0; f < n_features; f++) {
+        TEXTON_DICT(w, f) = patch[f];
       }
     }
     dictionary_initialized = 1;
@@ -211,95 +324,29 @@ void DictionaryTrainingYUV(uint8_t *frame, uint16_t width, uint16_t height)
     // ********
     // LEARNING
     // ********
-    printf("Learning!");
     alpha = ((float) alpha_uint) / 255.0;
 
-    float *texton_distances, * **patch;
-    texton_distances = (float *)calloc(n_textons, sizeof(float));
-    patch = (float ** *)calloc(patch_size, sizeof(float **));
-
-    for (i = 0; i < patch_size; i++) {
-      patch[i] = (float **)calloc(patch_size, sizeof(float *));
-      for (j = 0; j < patch_size; j++) {
-        patch[i][j] = (float *)calloc(2, sizeof(float));
-      }
-    }
-
     // Extract and learn from n_samples_image per image
     for (s = 0; s < n_samples_image; s++) {
       // select a random sample from the image
       x = rand() % (width - patch_size);
       y = rand() % (height - patch_size);
 
-      // reset texton_distances
-      for (texton = 0; texton < n_textons; texton++) {
-        texton_distances[texton] = 0;
-      }
-
       // extract sample
-      for (i = 0; i < patch_size; i++) {
-        buf = frame + (width * 2 * (i + y)) + 2 * x;
-        for (j = 0; j < patch_size; j++) {
-          // U/V component
-          patch[i][j][0] = (float) * buf;
-          buf += 1;
-          // Y1/Y2 component
-          patch[i][j][1] = (float) * buf;
-          buf += 1;
-        }
-      }
-
-      // determine distances to the textons:
-      for (i = 0; i < patch_size; i++) {
-        for (j = 0; j < patch_size; j++) {
-          for (c = 0; c < 2; c++) {
-            // determine the distance to textons
-            for (texton = 0; texton < n_textons; texton++) {
-              texton_distances[texton] += (patch[i][j][c] - dictionary[texton][i][j][c])
-                                          * (patch[i][j][c] - dictionary[texton][i][j][c]);
-            }
-          }
-        }
-      }
+      extract_patch(frame, width, x, y);
 
       // search the closest texton
-      int assignment = 0;
-      float min_dist = texton_distances[0];
-      for (texton = 1; texton < n_textons; texton++) {
-        if (texton_distances[texton] < min_dist) {
-          min_dist = texton_distances[texton];
-          assignment = texton;
-        }
-      }
+      int assignment = find_closest_texton();
 
       // move the neighbour closer to the input
-      for (i = 0; i < patch_size; i++) {
-        for (j = 0; j < patch_size; j++) {
-          for (c = 0; c < 2; c++) {
-            error_texton = patch[i][j][c] - dictionary[assignment][i][j][c];
-            dictionary[assignment][i][j][c] += (alpha * error_texton);
-          }
-        }
+      for (f = 0; f < n_features; f++) {
+        TEXTON_DICT(assignment, f) += alpha * (patch[f] - TEXTON_DICT(assignment, f));
       }
 
       // Augment the number of learned samples:
       learned_samples++;
     }
-
-    // Free the allocated memory:
-    for (i = 0; i < patch_size; i++) {
-      for (j = 0; j < patch_size; j++) {
-        free(patch[i][j]);
-      }
-      free(patch[i]);
-    }
-    free(patch);
-    free(texton_distances);
   }
-
-  // Free the buffer
-  buf = NULL;
-  free(buf);
 }
 
 /**
@@ -310,28 +357,18 @@ void DictionaryTrainingYUV(uint8_t *frame, uint16_t width, uint16_t height)
  */
 void DistributionExtraction(uint8_t *frame, uint16_t width, uint16_t height)
 {
-  int i, j, texton, c; // iterators
+  int i; // iterators
   int x, y; // coordinates
   int n_extracted_textons = 0;
 
-  uint8_t *buf;
+  textons_alloc();
 
   // ************************
   //       EXECUTION
   // ************************
 
-  printf("Execute!\n");
-
-  // Allocate memory for texton distances and image patch:
-  float *texton_distances, * **patch;
-  texton_distances = (float *)calloc(n_textons, sizeof(float));
-  patch = (float ** *)calloc(patch_size, sizeof(float **));
-  for (i = 0; i < patch_size; i++) {
-    patch[i] = (float **)calloc(patch_size, sizeof(float *));
-    for (j = 0; j < patch_size; j++) {
-      patch[i][j] = (float *)calloc(2, sizeof(float));
-    }
-  }
+  // start a new histogram for this image:
+  memset(texton_distribution, 0, n_textons * sizeof(float));
 
   int finished = 0;
   x = 0;
@@ -342,47 +379,11 @@ void DistributionExtraction(uint8_t *frame, uint16_t width, uint16_t height)
       y = border_height + rand() % (height - patch_size - 2 * border_height);
     }
 
-    // reset texton_distances
-    for (texton = 0; texton < n_textons; texton++) {
-      texton_distances[texton] = 0;
-    }
-
     // extract sample
-    for (i = 0; i < patch_size; i++) {
-      buf = frame + (width * 2 * (i + y)) + 2 * x;
-      for (j = 0; j < patch_size; j++) {
-        // U/V component
-        patch[i][j][0] = (float) * buf;
-        buf += 1;
-        // Y1/Y2 component
-        patch[i][j][1] = (float) * buf;
-        buf += 1;
-      }
-    }
-
-    // determine distances:
-    for (i = 0; i < patch_size; i++) {
-      for (j = 0; j < patch_size; j++) {
-        for (c = 0; c < 2; c++) {
-          // determine the distance to words
-          for (texton = 0; texton < n_textons; texton++) {
-            texton_distances[texton] += (patch[i][j][c] - dictionary[texton][i][j][c])
-                                        * (patch[i][j][c] - dictionary[texton][i][j][c]);
-          }
-        }
-      }
-    }
+    extract_patch(frame, width, x, y);
 
     // determine the nearest neighbour
-    // search the closest centroid
-    int assignment = 0;
-    float min_dist = texton_distances[0];
-    for (texton = 1; texton < n_textons; texton++) {
-      if (texton_distances[texton] < min_dist) {
-        min_dist = texton_distances[texton];
-        assignment = texton;
-      }
-    }
+    int assignment = find_closest_texton();
 
     // put the assignment in the histogram
     texton_distribution[assignment]++;
@@ -417,20 +418,6 @@ void DistributionExtraction(uint8_t *frame, uint16_t width, uint16_t height)
   }
   // printf("\n");
 
-
-  // free memory:
-  for (i = 0; i < patch_size; i++) {
-    for (j = 0; j < patch_size; j++) {
-      free(patch[i][j]);
-    }
-    free(patch[i]);
-  }
-  free(patch);
-  free(texton_distances);
-
-  buf = NULL;
-  free(buf);
-
 } // EXECUTION
 
 
@@ -452,12 +439,10 @@ void save_texton_dictionary(void)
     perror("Error while opening the file.\n");
   } else {
     // (over-)write dictionary
+    // (same order as before: per texton, per row, per column, U/V then Y)
     for (uint8_t i = 0; i < n_textons; i++) {
-      for (uint8_t j = 0; j < patch_size; j++) {
-        for (uint8_t k = 0; k < patch_size; k++) {
-          fprintf(dictionary_logger, "%f\n", dictionary[i][j][k][0]);
-          fprintf(dictionary_logger, "%f\n", dictionary[i][j][k][1]);
-        }
+      for (uint16_t f = 0; f < TEXTONS_N_FEATURES(patch_size); f++) {
+        fprintf(dictionary_logger, "%f\n", TEXTON_DICT(i, f));
       }
     }
     fclose(dictionary_logger);
@@ -473,14 +458,13 @@ void load_texton_dictionary(void)
   char filename[512];
   sprintf(filename, "%s/Dictionary_%05d.dat", STRINGIFY(DICTIONARY_PATH), dictionary_number);
 
+  textons_alloc();
+
   if ((dictionary_logger = fopen(filename, "r"))) {
     // Load the dictionary:
     for (int i = 0; i < n_textons; i++) {
-      for (int j = 0; j < patch_size; j++) {
-        for (int k = 0; k < patch_size; k++) {
-          if (fscanf(dictionary_logger, "%f\n", &dictionary[i][j][k][0]) == EOF) { break; }
-          if (fscanf(dictionary_logger, "%f\n", &dictionary[i][j][k][1]) == EOF) { break; }
-        }
+      for (uint16_t f = 0; f < TEXTONS_N_FEATURES(patch_size); f++) {
+        if (fscanf(dictionary_logger, "%f\n", &TEXTON_DICT(i, f)) == EOF) { break; }
       }
     }
 
@@ -501,27 +485,21 @@ void load_texton_dictionary(void)
 void textons_init(void)
 {
   printf("Textons init\n");
-  texton_distribution = (float *)calloc(n_textons, sizeof(float));
-  dictionary_initialized = 0;
-  learned_samples = 0;
-  dictionary_ready = 0;
-  dictionary = (float ** **)calloc(n_textons, sizeof(float ** *));
-  for (int w = 0; w < n_textons; w++) {
-    dictionary[w] = (float ** *) calloc(patch_size, sizeof(float **));
-    for (int i = 0; i < patch_size; i++) {
-      dictionary[w][i] = (float **) calloc(patch_size, sizeof(float *));
-      for (int j = 0; j < patch_size; j++) {
-        dictionary[w][i][j] = (float *) calloc(2, sizeof(float));
-      }
-    }
-  }
+  textons_alloc();
 
-  cv_add(texton_func);
+  cv_add_to_device(&TEXTONS_CAMERA, texton_func, TEXTONS_FPS);
 }
 
 void textons_stop(void)
 {
   free(texton_distribution);
   free(dictionary);
+  free(patch);
+  free(texton_distances);
+  texton_distribution = NULL;
+  dictionary = NULL;
+  patch = NULL;
+  texton_distances = NULL;
+  allocated_n_textons = 0;
+  allocated_patch_size = 0;
 }
-
@@ -53,10 +53,16 @@ extern uint8_t dictionary_number;
 // status variables
 extern uint8_t dictionary_ready;
 extern float alpha;
-extern float ** **dictionary;
+extern float *dictionary; // textons as structure of arrays, see TEXTON_DICT()
 extern uint32_t learned_samples;
 extern uint8_t dictionary_initialized;
 
+/** Number of features (values) of a texton: a square YUV422 patch has one U/V and one Y value per pixel */
+#define TEXTONS_N_FEATURES(_patch_size) ((_patch_size) * (_patch_size) * 2)
+
+/** Feature f of texton t, where f = (row * patch_size + column) * 2 + channel (0 is U/V, 1 is Y) */
+#define TEXTON_DICT(_t, _f) dictionary[(_f) * n_textons + (_t)]
+
 // functions:
 void DictionaryTrainingYUV(uint8_t *frame, uint16_t width, uint16_t height);
 void DistributionExtraction(uint8_t *frame, uint16_t width, uint16_t height);
@@ -37,6 +37,7 @@
 #include "lib/v4l/v4l2.h"
 #include "lib/vision/image.h"
 #include "lib/vision/bayer.h"
+#include "modules/computer_vision/cv_trace.h"
 
 #include "mcu_periph/sys_time.h"
 
@@ -141,11 +142,17 @@ static void *video_thread_function(void *data)
     // Run selected filters
     if (vid->filters & VIDEO_FILTER_DEBAYER) {
       BayerToYUV(&img, &img_color, 0, 0);
+      // keep the timing of the captured frame
+      img_color.ts = img.ts;
+      img_color.pprz_ts = img.pprz_ts;
+      img_color.dequeue_ts = img.dequeue_ts;
+      img_color.frame_id = img.frame_id;
       // use color image for further processing
       img_final = &img_color;
     }
 
     // Run processing if required
+    cv_trace_frame(img_final);
     cv_run_device(vid, img_final);
 
     // Free the image
@@ -40,8 +40,20 @@
 #define GEO_MAG_SENDER_ID 1
 #endif
 
+/** Update the field along the flight, not only once on the ground */
+#ifndef GEO_MAG_CONTINUOUS
+#define GEO_MAG_CONTINUOUS FALSE
+#endif
+
 struct GeoMag geo_mag;
 
+/** Field evaluation cache, the full model is only evaluated when changing of tile */
+static struct Wmm2020Cache geo_mag_cache;
+static bool geo_mag_cache_init = false;
+
+/** Update requested by the continuous periodic path, only sent when the field changed */
+static bool geo_mag_continuous_update = false;
+
 void geo_mag_init(void)
 {
   geo_mag.calc_once = false;
@@ -54,14 +66,17 @@ void geo_mag_periodic(void)
   if (!geo_mag.ready && GpsFixValid() && autopilot_throttle_killed()) {
     geo_mag.calc_once = true;
   }
+#if GEO_MAG_CONTINUOUS
+  if (geo_mag.ready && GpsFixValid() && !geo_mag.calc_once) {
+    geo_mag.calc_once = true;
+    geo_mag_continuous_update = true;
+  }
+#endif
 }
 
 void geo_mag_event(void)
 {
   if (geo_mag.calc_once) {
-    double gha[MAXCOEFF]; // Geomag global variables
-    int32_t nmax;
-
     /* Current date in decimal year, for example 2015.68 */
     double sdate = GPS_EPOCH_BEGIN +
                    (double)gps.week / WEEKS_IN_YEAR +
@@ -72,21 +87,28 @@ void geo_mag_event(void)
     double longitude = (double)gps.lla_pos.lon / 1e7;
     double alt = (double)gps.lla_pos.alt / 1e6;
 
-    // Calculates additional coeffs
-    nmax = extrapsh(sdate, GEO_EPOCH, NMAX_1, NMAX_2, gha);
+    // Calculates additional coeffs, once a day is enough
+    if (!geo_mag_cache_init || fabs(sdate - geo_mag_cache.date) > 1. / 365.) {
+      wmm2020_cache_init(&geo_mag_cache, sdate);
+      geo_mag_cache_init = true;
+    }
     // Calculates absolute magnet fields
-    mag_calc(1, latitude, longitude, alt, nmax, gha,
-             &geo_mag.vect.x, &geo_mag.vect.y, &geo_mag.vect.z,
-             IEXT, EXT_COEFF1, EXT_COEFF2, EXT_COEFF3);
+    struct DoubleVect3 prev = geo_mag.vect;
+    wmm2020_cache_get(&geo_mag_cache, latitude, longitude, alt,
+                      &geo_mag.vect.x, &geo_mag.vect.y, &geo_mag.vect.z);
 
-    // send as normalized float vector via ABI
-    struct FloatVect3 h = { .x = geo_mag.vect.x,
-                            .y = geo_mag.vect.y,
-                            .z = geo_mag.vect.z };
-    float_vect3_normalize(&h);
-    AbiSendMsgGEO_MAG(GEO_MAG_SENDER_ID, &h);
+    // send as normalized float vector via ABI, continuous updates only when it changed
+    if (!geo_mag.ready || !geo_mag_continuous_update ||
+        prev.x != geo_mag.vect.x || prev.y != geo_mag.vect.y || prev.z != geo_mag.vect.z) {
+      struct FloatVect3 h = { .x = geo_mag.vect.x,
+                              .y = geo_mag.vect.y,
+                              .z = geo_mag.vect.z };
+      float_vect3_normalize(&h);
+      AbiSendMsgGEO_MAG(GEO_MAG_SENDER_ID, &h);
+    }
 
     geo_mag.ready = true;
   }
   geo_mag.calc_once = false;
+  geo_mag_continuous_update = false;
 }
@@ -213,6 +213,11 @@ struct InsMekfWindPrivate {
 #define INS_MEKF_WIND_DISABLE_WIND true
 #endif
 
+// Full matrix updates by default
+#ifndef INS_MEKF_WIND_SEQUENTIAL_UPDATE
+#define INS_MEKF_WIND_SEQUENTIAL_UPDATE false
+#endif
+
 // paramters
 struct ins_mekf_wind_parameters ins_mekf_wind_params;
 
@@ -302,6 +307,74 @@ static Matrix3f skew_sym(const Vector3f& v) {
   return m;
 }
 
+typedef Matrix<float, MEKF_WIND_COV_SIZE, 1> MEKFWErr;
+
+/**
+ * Sequential scalar update
+ *
+ * Process one row of the measurement matrix, given by its non-zero
+ * elements, with its own noise variance. The error state correction is
+ * accumulated in dx and the residual is corrected with the previous rows,
+ * so that processing all the rows gives the same result as the full
+ * update when the measurement noise is diagonal.
+ *
+ * @param idx indexes of the non-zero elements of the row
+ * @param h values of the non-zero elements of the row
+ * @param nnz number of non-zero elements
+ * @param res residual z_m - h(z) of this row
+ * @param r noise variance of this row
+ * @param dx accumulated error state correction
+ */
+static void scalar_update(const int *idx, const float *h, const int nnz, const float res, const float r, MEKFWErr& dx)
+{
+  // P*Ht only depends on the columns of the non-zero elements
+  MEKFWErr PHt = mwp.P.col(idx[0]) * h[0];
+  for (int k = 1; k < nnz; k++) {
+    PHt += mwp.P.col(idx[k]) * h[k];
+  }
+  // S = H*P*Ht + R
+  float S = r;
+  float inno = res;
+  for (int k = 0; k < nnz; k++) {
+    S += h[k] * PHt(idx[k]);
+    inno -= h[k] * dx(idx[k]);
+  }
+  // K = P*Ht*S^-1
+  const MEKFWErr K = PHt / S;
+  dx += K * inno;
+  // P = P - K*(P*Ht)', upper triangle copied to keep P symmetric
+  for (int i = 0; i < MEKF_WIND_COV_SIZE; i++) {
+    for (int j = i; j < MEKF_WIND_COV_SIZE; j++) {
+      mwp.P(i,j) -= K(i) * PHt(j);
+      mwp.P(j,i) = mwp.P(i,j);
+    }
+  }
+}
+
+/**
+ * Apply the error state correction of the sequential updates
+ */
+static void apply_correction(const MEKFWErr& dx, bool attitude_only)
+{
+  Quaternionf q_tmp;
+  q_tmp.w() = 1.f;
+  q_tmp.vec() = 0.5f * dx.segment<3>(MEKF_WIND_qx);
+  q_tmp.normalize();
+  mwp.state.quat = q_tmp * mwp.state.quat;
+  mwp.state.quat.normalize();
+  mwp.state.rates_bias  += dx.segment<3>(MEKF_WIND_rbp);
+  if (attitude_only) {
+    return;
+  }
+  mwp.state.speed       += dx.segment<3>(MEKF_WIND_vx);
+  mwp.state.pos         += dx.segment<3>(MEKF_WIND_px);
+  mwp.state.accel_bias  += dx.segment<3>(MEKF_WIND_abx);
+  mwp.state.baro_bias   += dx(MEKF_WIND_bb);
+  if (!ins_mekf_wind_params.disable_wind) {
+    mwp.state.wind        += dx.segment<3>(MEKF_WIND_wx);
+  }
+}
+
 /**
  * Init function
  */
@@ -324,6 +397,7 @@ void ins_mekf_wind_init(void)
   ins_mekf_wind_params.R_aoa        = INS_MEKF_WIND_R_AOA;
   ins_mekf_wind_params.R_aos        = INS_MEKF_WIND_R_AOS;
   ins_mekf_wind_params.disable_wind = INS_MEKF_WIND_DISABLE_WIND;
+  ins_mekf_wind_params.sequential_update = INS_MEKF_WIND_SEQUENTIAL_UPDATE;
 
   // init state and measurements
   init_mekf_state();
@@ -504,17 +578,31 @@ void ins_mekf_wind_update_mag(struct FloatVect3* mag, bool attitude_only)
   mwp.measurements.mag(1) = mag->y;
   mwp.measurements.mag(2) = mag->z;
 
-  // H and Ht matrices
   const Matrix3f Rqt = mwp.state.quat.toRotationMatrix().transpose();
+  const Matrix3f Hq = Rqt * skew_sym(mwp.mag_h);
+  // Residual z_m - h(z)
+  Vector3f res = mwp.measurements.mag - (Rqt * mwp.mag_h);
+
+  if (ins_mekf_wind_params.sequential_update) {
+    // each row only depends on the attitude error
+    const int idx[3] = { MEKF_WIND_qx, MEKF_WIND_qy, MEKF_WIND_qz };
+    MEKFWErr dx = MEKFWErr::Zero();
+    for (int i = 0; i < 3; i++) {
+      const RowVector3f h = Hq.row(i);
+      scalar_update(idx, h.data(), 3, res(i), mwp.R(MEKF_WIND_rmx + i, MEKF_WIND_rmx + i), dx);
+    }
+    apply_correction(dx, attitude_only);
+    return;
+  }
+
+  // H and Ht matrices
   Matrix<float, 3, MEKF_WIND_COV_SIZE> H = Matrix<float, 3, MEKF_WIND_COV_SIZE>::Zero();
-  H.block<3,3>(0,0) = Rqt * skew_sym(mwp.mag_h);
+  H.block<3,3>(0,0) = Hq;
   Matrix<float, MEKF_WIND_COV_SIZE, 3> Ht = H.transpose();
   // S = H*P*Ht + Hn*N*Hnt
   Matrix3f S = H * mwp.P * Ht + mwp.R.block<3,3>(MEKF_WIND_rmx,MEKF_WIND_rmx);
   // K = P*Ht*S^-1
   Matrix<float, MEKF_WIND_COV_SIZE, 3> K = mwp.P * Ht * S.inverse();
-  // Residual z_m - h(z)
-  Vector3f res = mwp.measurements.mag - (Rqt * mwp.mag_h);
   // Update state
   Quaternionf q_tmp;
   q_tmp.w() = 1.f;
@@ -542,17 +630,28 @@ void ins_mekf_wind_update_baro(float baro_alt)
 {
   mwp.measurements.baro_alt = baro_alt;
 
+  // Residual z_m - h(z)
+  float res = mwp.measurements.baro_alt - (mwp.state.pos(2) - mwp.state.baro_bias);
+
+  if (ins_mekf_wind_params.sequential_update) {
+    const int idx[2] = { MEKF_WIND_pz, MEKF_WIND_bb };
+    const float h[2] = { 1.f, -1.f };
+    MEKFWErr dx = MEKFWErr::Zero();
+    scalar_update(idx, h, 2, res, mwp.R(MEKF_WIND_rb,MEKF_WIND_rb), dx);
+    apply_correction(dx, false);
+    return;
+  }
+
   // H and Ht matrices
   Matrix<float, 1, MEKF_WIND_COV_SIZE> H = Matrix<float, 1, MEKF_WIND_COV_SIZE>::Zero();
   H(0,MEKF_WIND_pz) = 1.0f; // TODO check index
   H(0,MEKF_WIND_bb) = -1.0f;
   Matrix<float, MEKF_WIND_COV_SIZE, 1> Ht = H.transpose();
-  // S = H*P*Ht + Hn*N*Hnt -> only pos.z component
-  float S = mwp.P(MEKF_WIND_pz,MEKF_WIND_pz) - mwp.P(MEKF_WIND_bb,MEKF_WIND_bb) + mwp.R(MEKF_WIND_rb,MEKF_WIND_rb);
+  // S = H*P*Ht + Hn*N*Hnt -> only pos.z and baro bias components
+  float S = mwp.P(MEKF_WIND_pz,MEKF_WIND_pz) - 2.f * mwp.P(MEKF_WIND_pz,MEKF_WIND_bb)
+    + mwp.P(MEKF_WIND_bb,MEKF_WIND_bb) + mwp.R(MEKF_WIND_rb,MEKF_WIND_rb);
   // K = P*Ht*S^-1
   Matrix<float, MEKF_WIND_COV_SIZE, 1> K = mwp.P * Ht / S;
-  // Residual z_m - h(z)
-  float res = mwp.measurements.baro_alt - (mwp.state.pos(2) - mwp.state.baro_bias);
   // Update state
   Quaternionf q_tmp;
   q_tmp.w() = 1.f;
@@ -581,6 +680,23 @@ void ins_mekf_wind_update_pos_speed(struct FloatVect3 *pos, struct FloatVect3 *s
   mwp.measurements.speed(1) = speed->y;
   mwp.measurements.speed(2) = speed->z;
 
+  // Residual z_m - h(z)
+  Matrix<float, 6, 1> res = Matrix<float, 6, 1>::Zero();
+  res.block<3,1>(0,0) = mwp.measurements.speed - mwp.state.speed;
+  res.block<3,1>(3,0) = mwp.measurements.pos - mwp.state.pos;
+
+  if (ins_mekf_wind_params.sequential_update) {
+    // speed and position are measured directly
+    const float h = 1.f;
+    MEKFWErr dx = MEKFWErr::Zero();
+    for (int i = 0; i < 6; i++) {
+      const int idx = MEKF_WIND_vx + i;
+      scalar_update(&idx, &h, 1, res(i), mwp.R(MEKF_WIND_rvx + i, MEKF_WIND_rvx + i), dx);
+    }
+    apply_correction(dx, false);
+    return;
+  }
+
   // H and Ht matrices
   Matrix<float, 6, MEKF_WIND_COV_SIZE> H = Matrix<float, 6, MEKF_WIND_COV_SIZE>::Zero();
   H.block<6,6>(0,MEKF_WIND_vx) = Matrix<float,6,6>::Identity();
@@ -589,10 +705,6 @@ void ins_mekf_wind_update_pos_speed(struct FloatVect3 *pos, struct FloatVect3 *s
   Matrix<float, 6, 6> S = mwp.P.block<6,6>(MEKF_WIND_vx,MEKF_WIND_vx) + mwp.R.block<6,6>(MEKF_WIND_rvx,MEKF_WIND_rvx);
   // K = P*Ht*S^-1
   Matrix<float, MEKF_WIND_COV_SIZE, 6> K = mwp.P * Ht * S.inverse();
-  // Residual z_m - h(z)
-  Matrix<float, 6, 1> res = Matrix<float, 6, 1>::Zero();
-  res.block<3,1>(0,0) = mwp.measurements.speed - mwp.state.speed;
-  res.block<3,1>(3,0) = mwp.measurements.pos - mwp.state.pos;
   // Update state
   Quaternionf q_tmp;
   q_tmp.w() = 1.f;
@@ -619,8 +731,29 @@ void ins_mekf_wind_update_airspeed(float airspeed)
   // H and Ht matrices
   const RowVector3f IuRqt = mwp.state.quat.toRotationMatrix().transpose().block<1,3>(0,0);
   const Vector3f va = mwp.state.speed - mwp.state.wind;
+  const RowVector3f Hq = IuRqt * skew_sym(va);
+  // Residual z_m - h(z)
+  float res = mwp.measurements.airspeed - IuRqt * va;
+
+  if (ins_mekf_wind_params.sequential_update) {
+    const int idx[9] = {
+      MEKF_WIND_qx, MEKF_WIND_qy, MEKF_WIND_qz,
+      MEKF_WIND_vx, MEKF_WIND_vy, MEKF_WIND_vz,
+      MEKF_WIND_wx, MEKF_WIND_wy, MEKF_WIND_wz
+    };
+    const float h[9] = {
+      Hq(0), Hq(1), Hq(2),
+      IuRqt(0), IuRqt(1), IuRqt(2),
+      -IuRqt(0), -IuRqt(1), -IuRqt(2)
+    };
+    MEKFWErr dx = MEKFWErr::Zero();
+    scalar_update(idx, h, 9, res, mwp.R(MEKF_WIND_ras,MEKF_WIND_ras), dx);
+    apply_correction(dx, false);
+    return;
+  }
+
   Matrix<float, 1, MEKF_WIND_COV_SIZE> H = Matrix<float, 1, MEKF_WIND_COV_SIZE>::Zero();
-  H.block<1,3>(0,MEKF_WIND_qx) = IuRqt * skew_sym(va);
+  H.block<1,3>(0,MEKF_WIND_qx) = Hq;
   H.block<1,3>(0,MEKF_WIND_vx) = IuRqt;
   H.block<1,3>(0,MEKF_WIND_wx) = -IuRqt;
   Matrix<float, MEKF_WIND_COV_SIZE, 1> Ht = H.transpose();
@@ -628,8 +761,6 @@ void ins_mekf_wind_update_airspeed(float airspeed)
   float S = H * mwp.P * Ht + mwp.R(MEKF_WIND_ras,MEKF_WIND_ras);
   // K = P*Ht*S^-1
   Matrix<float, MEKF_WIND_COV_SIZE, 1> K = mwp.P * Ht / S;
-  // Residual z_m - h(z)
-  float res = mwp.measurements.airspeed - IuRqt * va;
   // Update state
   Quaternionf q_tmp;
   q_tmp.w() = 1.f;
@@ -674,28 +805,53 @@ void ins_mekf_wind_update_incidence(float aoa, float aos)
   const float c_aos = cosf(aos);
   const Matrix3f B = Vector3f(s_aos * s_aos, - c_aos * c_aos, 0.f).asDiagonal();
   const RowVector3f vBRqt = 2.f * va.transpose() * B * Rqt;
+  const Matrix3f Sva = skew_sym(mwp.state.speed - mwp.state.wind);
+  // Hn matrix
+  Matrix2f Hn = Matrix2f::Identity();
+  Hn(0,0) = C(2) * va(0) - C(0) * va(2);
+  const float s_2aos = sinf(2.0f * aos);
+  Hn(1,1) = (RowVector3f(-s_2aos, 0.f, s_2aos) * va.asDiagonal()) * va;
+  // Residual z_m - h(z)
+  Vector2f res = Vector2f::Zero();
+  res(0) = - C * va;
+  res(1) = - va.transpose() * B * va;
+
+  if (ins_mekf_wind_params.sequential_update) {
+    // Hn is diagonal, the noise of both rows is independent
+    const int idx[9] = {
+      MEKF_WIND_qx, MEKF_WIND_qy, MEKF_WIND_qz,
+      MEKF_WIND_vx, MEKF_WIND_vy, MEKF_WIND_vz,
+      MEKF_WIND_wx, MEKF_WIND_wy, MEKF_WIND_wz
+    };
+    const RowVector3f rows[2] = { CRqt, vBRqt };
+    MEKFWErr dx = MEKFWErr::Zero();
+    for (int i = 0; i < 2; i++) {
+      const RowVector3f Hq = rows[i] * Sva;
+      const float h[9] = {
+        Hq(0), Hq(1), Hq(2),
+        rows[i](0), rows[i](1), rows[i](2),
+        -rows[i](0), -rows[i](1), -rows[i](2)
+      };
+      const float r = Hn(i,i) * Hn(i,i) * mwp.R(MEKF_WIND_raoa + i, MEKF_WIND_raoa + i);
+      scalar_update(idx, h, 9, res(i), r, dx);
+    }
+    apply_correction(dx, false);
+    return;
+  }
+
   Matrix<float, 2, MEKF_WIND_COV_SIZE> H = Matrix<float, 2, MEKF_WIND_COV_SIZE>::Zero();
-  H.block<1,3>(0,MEKF_WIND_qx) = CRqt * skew_sym(mwp.state.speed - mwp.state.wind);
+  H.block<1,3>(0,MEKF_WIND_qx) = CRqt * Sva;
   H.block<1,3>(0,MEKF_WIND_vx) = CRqt;
   H.block<1,3>(0,MEKF_WIND_wx) = -CRqt;
-  H.block<1,3>(1,MEKF_WIND_qx) = vBRqt * skew_sym(mwp.state.speed - mwp.state.wind);
+  H.block<1,3>(1,MEKF_WIND_qx) = vBRqt * Sva;
   H.block<1,3>(1,MEKF_WIND_vx) = vBRqt;
   H.block<1,3>(1,MEKF_WIND_wx) = -vBRqt;
   Matrix<float, MEKF_WIND_COV_SIZE, 2> Ht = H.transpose();
-  // Hn and Hnt matrices
-  Matrix2f Hn = Matrix2f::Identity();
-  Hn(0,0) = C(2) * va(0) - C(0) * va(2);
-  const float s_2aos = sinf(2.0f * aos);
-  Hn(1,1) = (RowVector3f(-s_2aos, 0.f, s_2aos) * va.asDiagonal()) * va;
   Matrix2f Hnt = Hn.transpose();
   // S = H*P*Ht + Hn*N*Hnt
   Matrix2f S = H * mwp.P * Ht + Hn * mwp.R.block<2,2>(MEKF_WIND_raoa,MEKF_WIND_raoa) * Hnt;
   // K = P*Ht*S^-1
   Matrix<float, MEKF_WIND_COV_SIZE, 2> K = mwp.P * Ht * S.inverse();
-  // Residual z_m - h(z)
-  Vector2f res = Vector2f::Zero();
-  res(0) = - C * va;
-  res(1) = - va.transpose() * B * va;
   // Update state
   Quaternionf q_tmp;
   q_tmp.w() = 1.f;
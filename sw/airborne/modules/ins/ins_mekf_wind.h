@@ -56,6 +56,7 @@ struct ins_mekf_wind_parameters {
   float R_aoa;        ///< angle of attack measurement noise
   float R_aos;        ///< sideslip angle measurement noise
   bool disable_wind;  ///< disable wind estimation
+  bool sequential_update; ///< process measurements as sequential scalar updates
 };
 
 extern struct ins_mekf_wind_parameters ins_mekf_wind_params;
@@ -67,6 +67,10 @@ static void set_state_from_ins(void);
 #define PrintLog fprintf
 #define LogFileIsOpen() (pprzLogFile != NULL)
 static FILE* pprzLogFile = NULL;
+#if USE_NPS
+// ground truth from the simulator, to replay the log with test/ins/run_ins_bank
+#include "nps_fdm.h"
+#endif
 #endif
 #endif
 
@@ -269,11 +273,12 @@ static void pressure_diff_cb(uint8_t __attribute__((unused)) sender_id, float pd
 static void airspeed_cb(uint8_t __attribute__((unused)) sender_id, float airspeed)
 {
   if (ins_mekf_wind.is_aligned) {
-    ins_mekf_wind_update_airspeed(tas_from_eas(airspeed));
+    float tas = tas_from_eas(airspeed);
+    ins_mekf_wind_update_airspeed(tas);
 
 #if LOG_MEKF_WIND
     if (LogFileIsOpen()) {
-      PrintLog(pprzLogFile, "%.3f airspeed %.3f\n", get_sys_time_float(), airspeed);
+      PrintLog(pprzLogFile, "%.3f airspeed %.3f\n", get_sys_time_float(), tas);
     }
 #endif
   }
@@ -370,6 +375,17 @@ static void gyro_cb(uint8_t sender_id __attribute__((unused)),
           "%.3f %.3f %.3f %.3f %.3f %.3f %.3f %.3f %.3f %.3f %.3f\n",
           ab.x, ab.y, ab.z, rb.p, rb.q, rb.r, bb,
           wind.x, wind.y, wind.z, airspeed);
+
+#if SITL && USE_NPS
+      PrintLog(pprzLogFile,
+          "%.3f truth %.6f %.6f %.6f %.6f %.3f %.3f %.3f %.3f %.3f %.3f %.3f %.3f %.3f\n",
+          time,
+          fdm.ltpprz_to_body_quat.qi, fdm.ltpprz_to_body_quat.qx,
+          fdm.ltpprz_to_body_quat.qy, fdm.ltpprz_to_body_quat.qz,
+          fdm.ltpprz_pos.x, fdm.ltpprz_pos.y, fdm.ltpprz_pos.z,
+          fdm.ltpprz_ecef_vel.x, fdm.ltpprz_ecef_vel.y, fdm.ltpprz_ecef_vel.z,
+          fdm.wind.x, fdm.wind.y, fdm.wind.z);
+#endif
     }
 #endif
   }
@@ -484,7 +500,7 @@ static void gps_cb(uint8_t sender_id __attribute__((unused)),
       }
       ins_mekf_wind_update_pos_speed(&pos, &speed);
 
-#if LOG_MEKFW_FILTER
+#if LOG_MEKF_WIND
       if (LogFileIsOpen()) {
         PrintLog(pprzLogFile,
             "%.3f gps %.3f %.3f %.3f %.3f %.3f %.3f \n",
@@ -506,7 +522,7 @@ static void gps_cb(uint8_t sender_id __attribute__((unused)),
 			ned_of_ecef_vect_f(&speed, &state.ned_origin_f, &ecef_vel);
       ins_mekf_wind_update_pos_speed(&pos, &speed);
 
-#if LOG_MEKFW_FILTER
+#if LOG_MEKF_WIND
       if (LogFileIsOpen()) {
         PrintLog(pprzLogFile,
             "%.3f gps %.3f %.3f %.3f %.3f %.3f %.3f \n",
@@ -0,0 +1,431 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file "modules/meteo/ukf_wind_sr.c"
+ *
+ * Square-root UKF of the wind estimator.
+ *
+ * The steps are the ones of the generated code, but:
+ *  - the weights are computed once at init
+ *  - the sigma points are propagated and centered in place, and only
+ *    the airspeed states are integrated (the other states are constant)
+ *  - the QR factorizations only compute the triangular factor
+ *  - the weighted first sigma point and the Kalman correction are applied
+ *    as rank one updates of the square root instead of rebuilding and
+ *    factorizing the full covariance
+ *  - the gain is obtained with triangular solves instead of LU divisions
+ * All matrices are in a static workspace, the filter does not need a large
+ * stack.
+ *
+ * The square roots are kept upper triangular with positive diagonal, so
+ * that S stored by rows is the lower factor in column major order output
+ * by the generated code in Pout.
+ */
+
+#include "modules/meteo/ukf_wind_sr.h"
+#include <math.h>
+#include <string.h>
+
+#define UKF_N UKF_WIND_SR_N
+#define UKF_M UKF_WIND_SR_M
+#define UKF_L UKF_WIND_SR_L
+
+// matrix element of the generated code (column major)
+#define MAT_EL(_m, _l, _c, _n) _m[_l + _c * _n]
+
+struct UkfWindSr ukf_wind_sr;
+
+/** Filter workspace
+ * outside of the stack of the estimation thread, reused by each step
+ */
+static struct {
+  float X[UKF_L][UKF_N];              ///< state sigma points, propagated then centered
+  float Z[UKF_L][UKF_M];              ///< measurement sigma points, centered
+  float A[UKF_L - 1 + UKF_N][UKF_N];  ///< input of the QR factorizations
+  float Sz[UKF_N][UKF_N];             ///< square root of the innovation covariance
+  float chol[UKF_N][UKF_N];           ///< saved factor for the cholesky fallback
+  float U[UKF_N][UKF_M];              ///< cross covariance, then Pxz.Sz^-1
+  float K[UKF_N][UKF_M];              ///< Kalman gain
+  float v[UKF_N];                     ///< rank one update vector
+} ws;
+
+/** Cholesky factorization in place
+ * S is symmetric on input, upper triangular with S^T S equal to the input
+ * on output.
+ * @return false if the matrix is not positive definite, the factorization
+ * is then stopped with the non positive pivot on the diagonal, as the
+ * generated code does
+ */
+static bool chol_upper(float S[][UKF_N], int n)
+{
+  int i, j, k;
+  bool ok = true;
+  for (j = 0; j < n && ok; j++) {
+    float s = S[j][j];
+    for (k = 0; k < j; k++) {
+      s -= S[k][j] * S[k][j];
+    }
+    if (s > 0.f) {
+      S[j][j] = sqrtf(s);
+      const float inv = 1.f / S[j][j];
+      for (i = j + 1; i < n; i++) {
+        float a = S[j][i];
+        for (k = 0; k < j; k++) {
+          a -= S[k][j] * S[k][i];
+        }
+        S[j][i] = a * inv;
+      }
+    } else {
+      S[j][j] = s;
+      ok = false;
+    }
+    for (i = 0; i < j; i++) {
+      S[j][i] = 0.f;
+    }
+  }
+  return ok;
+}
+
+/** Rank one update or downdate of an upper triangular square root
+ * S^T S +/- v v^T, v is destroyed.
+ * When a downdate would make the matrix non positive, the full matrix is
+ * factorized like in the generated code.
+ */
+static void chol_rank1(float S[][UKF_N], float *v, int n, bool downdate)
+{
+  int i, j, k;
+  float v0[UKF_N];
+  const float sign = downdate ? -1.f : 1.f;
+  memcpy(ws.chol, S, sizeof(ws.chol));
+  memcpy(v0, v, n * sizeof(float));
+  for (k = 0; k < n; k++) {
+    const float skk = S[k][k];
+    const float r2 = skk * skk + sign * v[k] * v[k];
+    if (r2 <= 0.f || skk == 0.f) {
+      // fallback: S = chol(C^T C +/- v v^T) with the saved factor C
+      for (i = 0; i < n; i++) {
+        for (j = i; j < n; j++) {
+          float p = sign * v0[i] * v0[j];
+          for (k = 0; k <= i; k++) {
+            p += ws.chol[k][i] * ws.chol[k][j];
+          }
+          S[i][j] = p;
+        }
+      }
+      chol_upper(S, n);
+      return;
+    }
+    const float r = sqrtf(r2);
+    const float c = r / skk;
+    const float s = v[k] / skk;
+    S[k][k] = r;
+    for (j = k + 1; j < n; j++) {
+      S[k][j] = (S[k][j] + sign * s * v[j]) / c;
+      v[j] = c * v[j] - s * S[k][j];
+    }
+  }
+}
+
+/** Triangular factor of the QR factorization of A (rows x cols)
+ * Householder reflections in place, Q is not formed.
+ * R is upper triangular with positive diagonal, R^T R = A^T A.
+ */
+static void qr_upper(float A[][UKF_N], int rows, int cols, float R[][UKF_N])
+{
+  int i, j, k;
+  for (k = 0; k < cols; k++) {
+    float norm2 = 0.f;
+    for (i = k; i < rows; i++) {
+      norm2 += A[i][k] * A[i][k];
+    }
+    if (norm2 == 0.f) {
+      continue;
+    }
+    const float norm = sqrtf(norm2);
+    const float akk = A[k][k];
+    const float alpha = akk > 0.f ? -norm : norm;
+    // reflector v = A(k:rows, k) - alpha.e1, stored in place
+    const float vtv = 2.f * norm * (norm + fabsf(akk));
+    A[k][k] = akk - alpha;
+    for (j = k + 1; j < cols; j++) {
+      float s = 0.f;
+      for (i = k; i < rows; i++) {
+        s += A[i][k] * A[i][j];
+      }
+      s *= 2.f / vtv;
+      for (i = k; i < rows; i++) {
+        A[i][j] -= s * A[i][k];
+      }
+    }
+    A[k][k] = alpha;
+  }
+  for (k = 0; k < cols; k++) {
+    const float sign = A[k][k] < 0.f ? -1.f : 1.f;
+    for (j = 0; j < k; j++) {
+      R[k][j] = 0.f;
+    }
+    for (j = k; j < cols; j++) {
+      R[k][j] = sign * A[k][j];
+    }
+  }
+}
+
+/** Derivative of the airspeed vector, the other states are constant */
+static inline void uvw_dot(float *d, const float *x)
+{
+  const float *w = ukf_U.rates;
+  const float *a = ukf_U.accel;
+  d[0] = (w[2] * x[1] + a[0]) - w[1] * x[2];
+  d[1] = (w[0] * x[2] + a[1]) - w[2] * x[0];
+  d[2] = (w[1] * x[0] + a[2]) - w[0] * x[1];
+}
+
+/** Runge-Kutta 4 integration of a sigma point, in place */
+static void propagate(float *x, float dt)
+{
+  int i;
+  float k1[3], k2[3], k3[3], k4[3], b[3];
+  uvw_dot(k1, x);
+  for (i = 0; i < 3; i++) {
+    b[i] = k1[i] / 2.f * dt + x[i];
+  }
+  uvw_dot(k2, b);
+  for (i = 0; i < 3; i++) {
+    b[i] = k2[i] / 2.f * dt + x[i];
+  }
+  uvw_dot(k3, b);
+  for (i = 0; i < 3; i++) {
+    b[i] = dt * k3[i] + x[i];
+  }
+  uvw_dot(k4, b);
+  const float h6 = dt / 6.f;
+  for (i = 0; i < 3; i++) {
+    x[i] = (((k2[i] + k3[i]) * 2.f + k1[i]) + k4[i]) * h6 + x[i];
+  }
+}
+
+/** Observation model
+ * @param rmat body to NED rotation matrix
+ */
+static void observation(float *z, const float *x, float rmat[3][3])
+{
+  int i;
+  const float va = sqrtf(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+  // ground speed = airspeed in NED + wind
+  for (i = 0; i < 3; i++) {
+    z[i] = rmat[i][0] * x[0] + rmat[i][1] * x[1] + rmat[i][2] * x[2] + x[3 + i];
+  }
+  z[3] = x[6] * va;
+  if (va > 0.0001f) {
+    z[4] = atan2f(x[2], x[0]);
+    z[5] = asinf(x[1] / va);
+  } else {
+    z[4] = 0.f;
+    z[5] = 0.f;
+  }
+}
+
+/** Weights, initial state and square root of the covariance */
+static void init_filter(void)
+{
+  int i, j;
+  struct UkfWindSr *f = &ukf_wind_sr;
+  const float a2 = ukf_init.alpha * ukf_init.alpha;
+  const float lambda = a2 * (UKF_N + ukf_init.ki) - UKF_N;
+  f->Wm0 = lambda / (UKF_N + lambda);
+  f->Wmi = 0.5f / (UKF_N + lambda);
+  f->Wc0 = ((1.f - a2) + ukf_init.beta) + f->Wm0;
+  // the generated code scales the first sigma point by |Wc0|^(1/4)
+  f->c0 = sqrtf(sqrtf(fabsf(f->Wc0)));
+  f->gamma = sqrtf(UKF_N + lambda);
+
+  for (i = 0; i < UKF_N; i++) {
+    f->x[i] = ukf_init.x0[i];
+    for (j = 0; j < UKF_N; j++) {
+      f->S[i][j] = MAT_EL(ukf_init.P0, i, j, UKF_N);
+    }
+  }
+  chol_upper(f->S, UKF_N);
+  f->initialized = true;
+}
+
+void ukf_wind_sr_reset(void)
+{
+  ukf_wind_sr.initialized = false;
+}
+
+void ukf_wind_sr_step(void)
+{
+  int i, j, k;
+  struct UkfWindSr *f = &ukf_wind_sr;
+
+  if (!f->initialized) {
+    init_filter();
+  }
+
+  // sigma points, the columns of the square root are the rows of S
+  for (j = 0; j < UKF_N; j++) {
+    ws.X[0][j] = f->x[j];
+  }
+  for (i = 0; i < UKF_N; i++) {
+    for (j = 0; j < UKF_N; j++) {
+      const float d = f->gamma * f->S[i][j];
+      ws.X[1 + i][j] = f->x[j] + d;
+      ws.X[1 + UKF_N + i][j] = f->x[j] - d;
+    }
+  }
+
+  // body to NED rotation
+  const float *q = ukf_U.q;
+  const float qn = 1.f / (q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+  float rmat[3][3] = {
+    {
+      (q[0] * q[0] + q[1] * q[1] - q[2] * q[2] - q[3] * q[3]) * qn,
+      2.f * (q[1] * q[2] - q[0] * q[3]) * qn,
+      2.f * (q[1] * q[3] + q[0] * q[2]) * qn
+    },
+    {
+      2.f * (q[1] * q[2] + q[0] * q[3]) * qn,
+      (q[0] * q[0] - q[1] * q[1] + q[2] * q[2] - q[3] * q[3]) * qn,
+      2.f * (q[2] * q[3] - q[0] * q[1]) * qn
+    },
+    {
+      2.f * (q[1] * q[3] - q[0] * q[2]) * qn,
+      2.f * (q[2] * q[3] + q[0] * q[1]) * qn,
+      (q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3]) * qn
+    }
+  };
+
+  // propagation, predicted state and measurements
+  float xp[UKF_N] = { 0.f };
+  float zp[UKF_M] = { 0.f };
+  for (i = 0; i < UKF_L; i++) {
+    const float w = i == 0 ? f->Wm0 : f->Wmi;
+    propagate(ws.X[i], ukf_params.dt);
+    observation(ws.Z[i], ws.X[i], rmat);
+    for (j = 0; j < UKF_N; j++) {
+      xp[j] += ws.X[i][j] * w;
+    }
+    for (j = 0; j < UKF_M; j++) {
+      zp[j] += ws.Z[i][j] * w;
+    }
+  }
+  for (i = 0; i < UKF_L; i++) {
+    for (j = 0; j < UKF_N; j++) {
+      ws.X[i][j] -= xp[j];
+    }
+    for (j = 0; j < UKF_M; j++) {
+      ws.Z[i][j] -= zp[j];
+    }
+  }
+
+  // predicted square root: qr([sqrt(Wmi).X(1:2n) sqrt(Q)]^T) then first sigma point
+  const float swi = sqrtf(f->Wmi);
+  for (i = 0; i < UKF_L - 1; i++) {
+    for (j = 0; j < UKF_N; j++) {
+      ws.A[i][j] = swi * ws.X[i + 1][j];
+    }
+  }
+  for (i = 0; i < UKF_N; i++) {
+    for (j = 0; j < UKF_N; j++) {
+      ws.A[UKF_L - 1 + i][j] = sqrtf(MAT_EL(ukf_params.Q, j, i, UKF_N));
+    }
+  }
+  qr_upper(ws.A, UKF_L - 1 + UKF_N, UKF_N, f->S);
+  for (j = 0; j < UKF_N; j++) {
+    ws.v[j] = f->c0 * ws.X[0][j];
+  }
+  chol_rank1(f->S, ws.v, UKF_N, f->Wc0 < 0.f);
+
+  // square root of the innovation covariance, same with R
+  for (i = 0; i < UKF_L - 1; i++) {
+    for (j = 0; j < UKF_M; j++) {
+      ws.A[i][j] = swi * ws.Z[i + 1][j];
+    }
+  }
+  for (i = 0; i < UKF_M; i++) {
+    for (j = 0; j < UKF_M; j++) {
+      ws.A[UKF_L - 1 + i][j] = sqrtf(MAT_EL(ukf_params.R, j, i, UKF_M));
+    }
+  }
+  qr_upper(ws.A, UKF_L - 1 + UKF_M, UKF_M, ws.Sz);
+  for (j = 0; j < UKF_M; j++) {
+    ws.v[j] = f->c0 * ws.Z[0][j];
+  }
+  chol_rank1(ws.Sz, ws.v, UKF_M, f->Wc0 < 0.f);
+
+  // cross covariance
+  for (i = 0; i < UKF_N; i++) {
+    for (j = 0; j < UKF_M; j++) {
+      float p = 0.f;
+      for (k = 0; k < UKF_L; k++) {
+        p += (k == 0 ? f->Wc0 : f->Wmi) * ws.X[k][i] * ws.Z[k][j];
+      }
+      ws.U[i][j] = p;
+    }
+  }
+
+  // gain K = Pxz.Pzz^-1 = (Pxz / Sz) / Sz^T,
+  // with U = Pxz / Sz = K.Sz^T kept for the covariance downdate
+  for (i = 0; i < UKF_N; i++) {
+    for (j = 0; j < UKF_M; j++) {
+      float a = ws.U[i][j];
+      for (k = 0; k < j; k++) {
+        a -= ws.Sz[k][j] * ws.U[i][k];
+      }
+      ws.U[i][j] = a / ws.Sz[j][j];
+    }
+    for (j = UKF_M - 1; j >= 0; j--) {
+      float a = ws.U[i][j];
+      for (k = j + 1; k < UKF_M; k++) {
+        a -= ws.Sz[j][k] * ws.K[i][k];
+      }
+      ws.K[i][j] = a / ws.Sz[j][j];
+    }
+  }
+
+  // covariance: one downdate per column of U
+  for (j = 0; j < UKF_M; j++) {
+    for (i = 0; i < UKF_N; i++) {
+      ws.v[i] = ws.U[i][j];
+    }
+    chol_rank1(f->S, ws.v, UKF_N, true);
+  }
+
+  // state correction
+  const float innov[UKF_M] = {
+    ukf_U.vk[0] - zp[0],
+    ukf_U.vk[1] - zp[1],
+    ukf_U.vk[2] - zp[2],
+    ukf_U.va - zp[3],
+    ukf_U.aoa - zp[4],
+    ukf_U.sideslip - zp[5]
+  };
+  for (i = 0; i < UKF_N; i++) {
+    float c = 0.f;
+    for (j = 0; j < UKF_M; j++) {
+      c += ws.K[i][j] * innov[j];
+    }
+    f->x[i] = xp[i] + c;
+    ukf_Y.xout[i] = f->x[i];
+  }
+  memcpy(ukf_Y.Pout, f->S, sizeof(ukf_Y.Pout));
+}
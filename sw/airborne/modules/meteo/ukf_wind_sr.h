@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file "modules/meteo/ukf_wind_sr.h"
+ *
+ * Square-root UKF of the wind estimator, hand written version of
+ * lib_ukf_wind_estimator/UKF_Wind_Estimator.c.
+ *
+ * Same model, inputs and outputs as the generated filter: the state is
+ * the airspeed vector in body frame, the wind vector in NED frame and the
+ * airspeed scale factor, the measurements are the ground speed vector,
+ * the airspeed norm, the angle of attack and the sideslip angle.
+ * The ukf_init, ukf_params, ukf_U and ukf_Y structures of the generated
+ * code are used, so that both filters can be swapped in the wrapper.
+ */
+
+#ifndef UKF_WIND_SR_H
+#define UKF_WIND_SR_H
+
+#include "std.h"
+#include "modules/meteo/lib_ukf_wind_estimator/UKF_Wind_Estimator.h"
+
+#define UKF_WIND_SR_N 7                       ///< state size
+#define UKF_WIND_SR_M 6                       ///< measurement size
+#define UKF_WIND_SR_L (2 * UKF_WIND_SR_N + 1) ///< number of sigma points
+
+struct UkfWindSr {
+  float x[UKF_WIND_SR_N];                 ///< state
+  float S[UKF_WIND_SR_N][UKF_WIND_SR_N];  ///< upper triangular square root of the covariance, P = S^T S
+  float Wm0, Wmi;                         ///< mean weights of the first and other sigma points
+  float Wc0;                              ///< covariance weight of the first sigma point, can be negative
+  float c0;                               ///< scale of the first sigma point in the rank one update
+  float gamma;                            ///< sigma point spread
+  bool initialized;
+};
+
+extern struct UkfWindSr ukf_wind_sr;
+
+/** Reset the filter, it is initialized from ukf_init at next step */
+extern void ukf_wind_sr_reset(void);
+
+/** Run a prediction and correction step
+ * inputs are read from ukf_U and ukf_params, outputs written to ukf_Y
+ */
+extern void ukf_wind_sr_step(void);
+
+#endif /* UKF_WIND_SR_H */
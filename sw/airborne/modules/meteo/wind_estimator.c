@@ -26,6 +26,7 @@
 
 #include "modules/meteo/wind_estimator.h"
 #include "modules/meteo/lib_ukf_wind_estimator/UKF_Wind_Estimator.h"
+#include "modules/meteo/ukf_wind_sr.h"
 #include "mcu_periph/sys_time.h"
 #include "math/pprz_algebra_float.h"
 #include "math/pprz_geodetic_float.h"
@@ -43,6 +44,9 @@
 /**
  * Default parameters
  */
+#ifndef WE_UKF_GENERATED
+#define WE_UKF_GENERATED TRUE   // use the Matlab generated filter, else the hand written one (same model)
+#endif
 #ifndef WE_UKF_KI
 #define WE_UKF_KI 0.f           // >= 0 to ensure that covariance is positive semi-definite
 #endif
@@ -157,6 +161,8 @@ void init_calculator(void)
   memset(&ukf_init, 0, sizeof(ukf_init_type));
   // zero params structure
   memset(&ukf_params, 0, sizeof(ukf_params_type));
+  // hand written filter is initialized at next step
+  ukf_wind_sr_reset();
 
   ukf_init.x0[6] = 1.0f; // initial airspeed scale factor
 
@@ -250,7 +256,11 @@ static inline void wind_estimator_step(void)
   // estimate wind if airspeed is high enough
   if (ukf_U.va > 5.0f) {
     // run estimation
+#if WE_UKF_GENERATED
     UKF_Wind_Estimator_step();
+#else
+    ukf_wind_sr_step();
+#endif
     // update output structure
     wind_estimator.airspeed.x = ukf_Y.xout[0];
     wind_estimator.airspeed.y = ukf_Y.xout[1];
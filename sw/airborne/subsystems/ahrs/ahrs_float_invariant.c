@@ -110,8 +110,8 @@ static inline void invariant_model(float *o, const float *x, const int n, const
 /** Right multiplication by a quaternion.
  * vi * q
  */
-void float_quat_vmul_right(struct FloatQuat *mright, const struct FloatQuat *q,
-                           struct FloatVect3 *vi);
+static void float_quat_vmul_right(struct FloatQuat *mright, const struct FloatQuat *q,
+                                  struct FloatVect3 *vi);
 
 /* init state and measurements */
 static inline void init_invariant_state(void)
@@ -367,7 +367,7 @@ static inline void error_output(struct AhrsFloatInv *_ahrs)
 }
 
 
-void float_quat_vmul_right(struct FloatQuat *mright, const struct FloatQuat *q,
+static void float_quat_vmul_right(struct FloatQuat *mright, const struct FloatQuat *q,
     struct FloatVect3 *vi)
 {
   struct FloatVect3 qvec, v1, v2;
@@ -31,15 +31,18 @@
 #include "subsystems/ahrs/ahrs_float_mlkf.h"
 #include "subsystems/ahrs/ahrs_float_utils.h"
 
-#include <string.h>  /* for memcpy      */
 
 #include "math/pprz_algebra_float.h"
 #include "math/pprz_algebra_int.h"
 #include "math/pprz_simple_matrix.h"
+#include "math/pprz_matrix_sym_float.h"
 #include "generated/airframe.h"
 
 //#include <stdio.h>
 
+SYM_MAT_FIXED_DEFINE(6)
+SYM_MAT_FIXED_UPDATE_DEFINE(6, 3)
+
 #ifndef AHRS_MAG_NOISE_X
 #define AHRS_MAG_NOISE_X 0.2
 #define AHRS_MAG_NOISE_Y 0.2
@@ -83,7 +86,7 @@ void ahrs_mlkf_init(void)
     { 0.,   0.,   0.,   0.,   P0_b, 0.  },
     { 0.,   0.,   0.,   0.,   0.,   P0_b}
   };
-  memcpy(ahrs_mlkf.P, P0, sizeof(P0));
+  sym_mat_pack_6(ahrs_mlkf.P, &P0[0][0]);
 
   VECT3_ASSIGN(ahrs_mlkf.mag_noise, AHRS_MAG_NOISE_X, AHRS_MAG_NOISE_Y, AHRS_MAG_NOISE_Z);
 }
@@ -201,14 +204,9 @@ static inline void propagate_state(float dt)
     {  0.,   0.,   0.,   0.,   0.,   1.  }
   };
   // P = FPF' + GQG
-  float tmp[6][6];
-  MAT_MUL(6, 6, 6, tmp, F, ahrs_mlkf.P);
-  MAT_MUL_T(6, 6, 6,  ahrs_mlkf.P, tmp, F);
   const float dt2 = dt * dt;
   const float GQG[6] = {dt2 * 10e-3, dt2 * 10e-3, dt2 * 10e-3, dt2 * 9e-6, dt2 * 9e-6, dt2 * 9e-6 };
-  for (int i = 0; i < 6; i++) {
-    ahrs_mlkf.P[i][i] += GQG[i];
-  }
+  sym_mat_propagate_6(ahrs_mlkf.P, &F[0][0], GQG);
 
 }
 
@@ -232,40 +230,22 @@ static inline void update_state(const struct FloatVect3 *i_expected, struct Floa
                    { b_expected.z,            0., -b_expected.x, 0., 0., 0.},
                    { -b_expected.y, b_expected.x,            0., 0., 0., 0.}
   };
-  float tmp[3][6];
-  MAT_MUL(3, 6, 6, tmp, H, ahrs_mlkf.P);
-  float S[3][3];
-  MAT_MUL_T(3, 6, 3, S, tmp, H);
-
+  float PHt[6][3];
+  sym_mat_pht_6x3(&PHt[0][0], ahrs_mlkf.P, &H[0][0]);
   /* add the measurement noise */
-  S[0][0] += noise->x;
-  S[1][1] += noise->y;
-  S[2][2] += noise->z;
+  const float R[3] = { noise->x, noise->y, noise->z };
+  float S[3][3];
+  sym_mat_hpht_6x3(&S[0][0], &H[0][0], &PHt[0][0], R);
 
   float invS[3][3];
   MAT_INV33(invS, S);
 
   // K = PH'invS
-  float tmp2[6][3];
-  MAT_MUL_T(6, 6, 3, tmp2, ahrs_mlkf.P, H);
   float K[6][3];
-  MAT_MUL(6, 3, 3, K, tmp2, invS);
-
-  // P = (I-KH)P
-  float tmp3[6][6];
-  MAT_MUL(6, 3, 6, tmp3, K, H);
-  float I6[6][6] = {{ 1., 0., 0., 0., 0., 0. },
-    {  0., 1., 0., 0., 0., 0. },
-    {  0., 0., 1., 0., 0., 0. },
-    {  0., 0., 0., 1., 0., 0. },
-    {  0., 0., 0., 0., 1., 0. },
-    {  0., 0., 0., 0., 0., 1. }
-  };
-  float tmp4[6][6];
-  MAT_SUB(6, 6, tmp4, I6, tmp3);
-  float tmp5[6][6];
-  MAT_MUL(6, 6, 6, tmp5, tmp4, ahrs_mlkf.P);
-  memcpy(ahrs_mlkf.P, tmp5, sizeof(ahrs_mlkf.P));
+  MAT_MUL(6, 3, 3, K, PHt, invS);
+
+  // P = (I-KH)P = P - K(PH')'
+  sym_mat_correct_6x3(ahrs_mlkf.P, &K[0][0], &PHt[0][0]);
 
   // X = X + Ke
   struct FloatVect3 e;
@@ -305,40 +285,22 @@ static inline void update_state_heading(const struct FloatVect3 *i_expected,
                    { 0., 0., b_yaw.y, 0., 0., 0.},
                    { 0., 0., b_yaw.z, 0., 0., 0.}
   };
-  float tmp[3][6];
-  MAT_MUL(3, 6, 6, tmp, H, ahrs_mlkf.P);
-  float S[3][3];
-  MAT_MUL_T(3, 6, 3, S, tmp, H);
-
+  float PHt[6][3];
+  sym_mat_pht_6x3(&PHt[0][0], ahrs_mlkf.P, &H[0][0]);
   /* add the measurement noise */
-  S[0][0] += noise->x;
-  S[1][1] += noise->y;
-  S[2][2] += noise->z;
+  const float R[3] = { noise->x, noise->y, noise->z };
+  float S[3][3];
+  sym_mat_hpht_6x3(&S[0][0], &H[0][0], &PHt[0][0], R);
 
   float invS[3][3];
   MAT_INV33(invS, S);
 
   // K = PH'invS
-  float tmp2[6][3];
-  MAT_MUL_T(6, 6, 3, tmp2, ahrs_mlkf.P, H);
   float K[6][3];
-  MAT_MUL(6, 3, 3, K, tmp2, invS);
-
-  // P = (I-KH)P
-  float tmp3[6][6];
-  MAT_MUL(6, 3, 6, tmp3, K, H);
-  float I6[6][6] = {{ 1., 0., 0., 0., 0., 0. },
-    {  0., 1., 0., 0., 0., 0. },
-    {  0., 0., 1., 0., 0., 0. },
-    {  0., 0., 0., 1., 0., 0. },
-    {  0., 0., 0., 0., 1., 0. },
-    {  0., 0., 0., 0., 0., 1. }
-  };
-  float tmp4[6][6];
-  MAT_SUB(6, 6, tmp4, I6, tmp3);
-  float tmp5[6][6];
-  MAT_MUL(6, 6, 6, tmp5, tmp4, ahrs_mlkf.P);
-  memcpy(ahrs_mlkf.P, tmp5, sizeof(ahrs_mlkf.P));
+  MAT_MUL(6, 3, 3, K, PHt, invS);
+
+  // P = (I-KH)P = P - K(PH')'
+  sym_mat_correct_6x3(ahrs_mlkf.P, &K[0][0], &PHt[0][0]);
 
   // X = X + Ke
   struct FloatVect3 e;
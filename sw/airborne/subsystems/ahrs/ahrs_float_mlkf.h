@@ -34,6 +34,7 @@
 #include "std.h"
 #include "math/pprz_algebra_float.h"
 #include "math/pprz_orientation_conversion.h"
+#include "math/pprz_matrix_sym_float.h"
 
 enum AhrsMlkfStatus {
   AHRS_MLKF_UNINIT,
@@ -51,7 +52,7 @@ struct AhrsMlkf {
   struct FloatVect3  mag_noise;
 
   struct FloatQuat  gibbs_cor;
-  float P[6][6];
+  float P[SYM_MAT_SIZE(6)];  ///< covariance, upper triangle
   float lp_accel;
 
   /** body_to_imu rotation */
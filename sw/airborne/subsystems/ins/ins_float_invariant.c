@@ -164,8 +164,8 @@ static inline void invariant_model(float *o, const float *x, const int n, const
 /** Right multiplication by a quaternion.
  * vi * q
  */
-void float_quat_vmul_right(struct FloatQuat *mright, const struct FloatQuat *q,
-                           struct FloatVect3 *vi);
+static void float_quat_vmul_right(struct FloatQuat *mright, const struct FloatQuat *q,
+                                  struct FloatVect3 *vi);
 
 
 /* init state and measurements */
@@ -696,8 +696,8 @@ static inline void error_output(struct InsFloatInv *_ins)
 }
 
 
-void float_quat_vmul_right(struct FloatQuat *mright, const struct FloatQuat *q,
-                           struct FloatVect3 *vi)
+static void float_quat_vmul_right(struct FloatQuat *mright, const struct FloatQuat *q,
+                                  struct FloatVect3 *vi)
 {
   struct FloatVect3 qvec, v1, v2;
   float qi;
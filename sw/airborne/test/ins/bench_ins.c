@@ -0,0 +1,333 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/ins/bench_ins.c
+ *
+ * Benchmark the filters of the INS bank on a recorded sensor stream.
+ *
+ * Every filter runs alone on the whole log (see ins_bank.c for the format)
+ * several times. Each update, i.e. the propagation and the measurement
+ * updates of one IMU sample, is timed. The update time reported is the
+ * median over the runs of the mean update time of a run, with the spread
+ * of these means. The 99th percentile and max times use the minimum over
+ * the runs of every update, to filter out the preemptions of the host.
+ * The errors are against the ground truth of the first run.
+ *
+ * The results can be written to a reference file, and compared to it on a
+ * later run: a filter is flagged when an rms error is above the reference
+ * with the given tolerance, and the exit status is 1.
+ * The timings are only comparable on the same host, and vary by tens of
+ * percent from one invocation to the next on a desktop. A slower update
+ * time is only reported, unless a time tolerance is given with -t. The
+ * tolerance used is then at least three times the spread of the runs.
+ *
+ * usage: bench_ins [-a align_time] [-s skip_time] [-n runs] [-w ref | -r ref]
+ *                  [-e error_tol] [-t time_tol] log [filter...]
+ *
+ *  -a align_time  time in seconds averaged for the initial alignment (default 0.5)
+ *  -s skip_time   time in seconds not used for the errors (default 0)
+ *  -n runs        number of runs of each filter (default 5)
+ *  -w ref         write the results to the reference file
+ *  -r ref         compare the results to the reference file
+ *  -e error_tol   relative tolerance on the rms errors (default 0.01)
+ *  -t time_tol    also fail when the update time is above the reference by
+ *                 this relative tolerance (default: timings only reported)
+ *
+ * All filters of the bank are run if none is given.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "test/ins/ins_bank.h"
+
+#define BENCH_NB_ERRORS 5
+
+struct BenchResult {
+  struct InsBankFilter *filter;
+  double err[BENCH_NB_ERRORS];  ///< rms errors: attitude, heading (deg), position (m), speed, wind (m/s)
+  double ns_median;             ///< median over the runs of the mean update time
+  double ns_spread;             ///< (max - min) / median of the mean update times of the runs
+  double ns_p99, ns_max;
+  bool in_ref;                  ///< found in the reference file
+  double ref_err[BENCH_NB_ERRORS];
+  double ref_ns_median, ref_ns_spread;
+};
+
+static struct InsBankLog bank_log;
+static double skip_time;
+
+static inline double now_ns(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/** time of an empty measurement, removed from the update times */
+static double timer_overhead(void)
+{
+  double best = 1e9;
+  for (int i = 0; i < 1000; i++) {
+    double t0 = now_ns();
+    double t1 = now_ns();
+    if (t1 - t0 < best) {
+      best = t1 - t0;
+    }
+  }
+  return best;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+  double da = *(const double *)a, db = *(const double *)b;
+  return (da > db) - (da < db);
+}
+
+static void bench_filter(struct BenchResult *res, int nb_runs, double overhead)
+{
+  struct InsBankFilter *f = res->filter;
+  int n = bank_log.nb_samples;
+  double *ns = malloc(n * sizeof(double));
+  double *run_mean = malloc(nb_runs * sizeof(double));
+  for (int i = 0; i < n; i++) {
+    ns[i] = 1e12;
+  }
+  struct InsBankErrors errors;
+  memset(&errors, 0, sizeof(errors));
+
+  for (int run = 0; run < nb_runs; run++) {
+    f->init();
+    f->align(&bank_log.lp_gyro, &bank_log.lp_accel, &bank_log.lp_mag);
+    double run_sum = 0.;
+    for (int i = 0; i < n; i++) {
+      struct InsBankSample *s = &bank_log.samples[i];
+      double t0 = now_ns();
+      f->run(s, bank_log.dt);
+      double t1 = now_ns();
+      run_sum += t1 - t0;
+      if (t1 - t0 < ns[i]) {
+        ns[i] = t1 - t0;
+      }
+      if (run == 0 && (s->flags & INS_BANK_TRUTH) && s->time >= bank_log.samples[0].time + skip_time) {
+        struct InsBankOutput o;
+        memset(&o, 0, sizeof(o));
+        f->get_output(&o);
+        ins_bank_add_errors(&errors, f, s, &o);
+      }
+    }
+    run_mean[run] = Max(run_sum / n - overhead, 0.);
+  }
+
+  qsort(run_mean, nb_runs, sizeof(double), compare_double);
+  res->ns_median = (run_mean[(nb_runs - 1) / 2] + run_mean[nb_runs / 2]) / 2.;
+  res->ns_spread = (run_mean[nb_runs - 1] - run_mean[0]) / Max(res->ns_median, 1.);
+  free(run_mean);
+
+  for (int i = 0; i < n; i++) {
+    ns[i] = Max(ns[i] - overhead, 0.);
+  }
+  qsort(ns, n, sizeof(double), compare_double);
+  res->ns_p99 = ns[(int)(0.99 * (n - 1))];
+  res->ns_max = ns[n - 1];
+  free(ns);
+
+  res->err[0] = ins_bank_rms(&errors.att) * 180. / M_PI;
+  res->err[1] = ins_bank_rms(&errors.heading) * 180. / M_PI;
+  res->err[2] = ins_bank_rms(&errors.pos);
+  res->err[3] = ins_bank_rms(&errors.speed);
+  res->err[4] = ins_bank_rms(&errors.wind);
+}
+
+static int write_ref(const char *filename, const char *log_name, struct BenchResult *res, int nb)
+{
+  FILE *fd = fopen(filename, "w");
+  if (fd == NULL) {
+    fprintf(stderr, "can't write reference file %s\n", filename);
+    return -1;
+  }
+  fprintf(fd, "# bench_ins reference on %s\n", log_name);
+  fprintf(fd, "# filter att_deg heading_deg pos_m speed_ms wind_ms ns_median ns_p99 ns_spread\n");
+  for (int i = 0; i < nb; i++) {
+    fprintf(fd, "%s", res[i].filter->name);
+    for (int j = 0; j < BENCH_NB_ERRORS; j++) {
+      fprintf(fd, " %.6g", res[i].err[j]);
+    }
+    fprintf(fd, " %.1f %.1f %.3f\n", res[i].ns_median, res[i].ns_p99, res[i].ns_spread);
+  }
+  fclose(fd);
+  printf("reference written to %s\n", filename);
+  return 0;
+}
+
+static int read_ref(const char *filename, struct BenchResult *res, int nb)
+{
+  FILE *fd = fopen(filename, "r");
+  if (fd == NULL) {
+    fprintf(stderr, "can't open reference file %s\n", filename);
+    return -1;
+  }
+  char line[512];
+  while (fgets(line, sizeof(line), fd)) {
+    char name[64];
+    double e[BENCH_NB_ERRORS], ns_median, ns_p99, ns_spread;
+    if (line[0] == '#' ||
+        sscanf(line, "%63s %lf %lf %lf %lf %lf %lf %lf %lf", name, &e[0], &e[1], &e[2], &e[3], &e[4],
+               &ns_median, &ns_p99, &ns_spread) != 9) {
+      continue;
+    }
+    for (int i = 0; i < nb; i++) {
+      if (strcmp(name, res[i].filter->name) == 0) {
+        res[i].in_ref = true;
+        memcpy(res[i].ref_err, e, sizeof(e));
+        res[i].ref_ns_median = ns_median;
+        res[i].ref_ns_spread = ns_spread;
+      }
+    }
+  }
+  fclose(fd);
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  double align_time = 0.5;
+  int nb_runs = 5;
+  const char *ref_out = NULL, *ref_in = NULL;
+  double error_tol = 0.01, time_tol = -1.;
+  int opt;
+  while ((opt = getopt(argc, argv, "a:s:n:w:r:e:t:h")) != -1) {
+    switch (opt) {
+      case 'a': align_time = atof(optarg); break;
+      case 's': skip_time = atof(optarg); break;
+      case 'n': nb_runs = Max(atoi(optarg), 1); break;
+      case 'w': ref_out = optarg; break;
+      case 'r': ref_in = optarg; break;
+      case 'e': error_tol = atof(optarg); break;
+      case 't': time_tol = atof(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-a align_time] [-s skip_time] [-n runs] [-w ref | -r ref] "
+                "[-e error_tol] [-t time_tol] log [filter...]\n", argv[0]);
+        fprintf(stderr, "filters:");
+        for (int i = 0; i < ins_bank_nb_filters; i++) {
+          fprintf(stderr, " %s", ins_bank_filters[i].name);
+        }
+        fprintf(stderr, "\n");
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "no log file, see %s -h\n", argv[0]);
+    return 1;
+  }
+  if (ins_bank_read_log(&bank_log, argv[optind]) < 0) {
+    return 1;
+  }
+  ins_bank_compute_alignment(&bank_log, align_time);
+
+  // select the filters
+  struct BenchResult res[ins_bank_nb_filters];
+  memset(res, 0, sizeof(res));
+  int nb = 0;
+  if (optind + 1 >= argc) {
+    for (int i = 0; i < ins_bank_nb_filters; i++) {
+      res[nb++].filter = &ins_bank_filters[i];
+    }
+  }
+  for (int j = optind + 1; j < argc && nb < ins_bank_nb_filters; j++) {
+    struct InsBankFilter *f = ins_bank_find_filter(argv[j]);
+    if (f == NULL) {
+      fprintf(stderr, "unknown filter %s, see %s -h\n", argv[j], argv[0]);
+      return 1;
+    }
+    res[nb++].filter = f;
+  }
+
+  double overhead = timer_overhead();
+  for (int i = 0; i < nb; i++) {
+    bench_filter(&res[i], nb_runs, overhead);
+  }
+  if (ref_in != NULL && read_ref(ref_in, res, nb) < 0) {
+    return 1;
+  }
+
+  printf("\n%d runs, timer overhead of %.0f ns removed\n", nb_runs, overhead);
+  printf("%-22s  %8s %8s %8s %8s %8s  %9s %7s %9s %9s", "filter", "att", "heading", "pos", "speed", "wind",
+         "ns median", "spread", "ns p99", "ns max");
+  printf(ref_in ? "  %9s\n" : "\n", "ns ref");
+  printf("%-22s  %8s %8s %8s %8s %8s\n", "", "(deg)", "(deg)", "(m)", "(m/s)", "(m/s)");
+  int nb_regressions = 0;
+  for (int i = 0; i < nb; i++) {
+    struct BenchResult *r = &res[i];
+    printf("%-22s ", r->filter->name);
+    bool regression = false;
+    for (int j = 0; j < BENCH_NB_ERRORS; j++) {
+      if (j >= 2 && r->err[j] == 0.) {
+        printf(" %8s", "-");
+        continue;
+      }
+      // small absolute margin for the zero errors of a reference
+      bool worse = r->in_ref && r->err[j] > r->ref_err[j] * (1. + error_tol) + 1e-4;
+      printf(" %7.3f%c", r->err[j], worse ? '!' : ' ');
+      regression |= worse;
+    }
+    printf("  %9.0f %6.0f%% %9.0f %9.0f", r->ns_median, r->ns_spread * 100., r->ns_p99, r->ns_max);
+    if (ref_in) {
+      if (r->in_ref) {
+        // below the run to run spread, a slower time is noise
+        double tol = Max(Max(time_tol, 0.2), 3. * Max(r->ns_spread, r->ref_ns_spread));
+        bool slower = r->ns_median > r->ref_ns_median * (1. + tol);
+        printf("  %8.0f%c", r->ref_ns_median, slower ? '!' : ' ');
+        regression |= slower && time_tol >= 0.;
+      } else {
+        printf("  %9s", "-");
+      }
+    }
+    printf("%s\n", regression ? "  REGRESSION" : "");
+    nb_regressions += regression;
+  }
+  if (bank_log.samples[0].flags & INS_BANK_TRUTH) {
+    printf("errors are rms against ground truth\n");
+  } else {
+    printf("no ground truth in the log\n");
+  }
+  if (ref_in && time_tol < 0.) {
+    printf("slower update times (!) are only reported, use -t time_tol to check them\n");
+  }
+
+  if (ref_out != NULL && write_ref(ref_out, argv[optind], res, nb) < 0) {
+    return 1;
+  }
+  free(bank_log.samples);
+
+  if (ref_in) {
+    if (nb_regressions > 0) {
+      printf("\n%d filter(s) worse than the reference %s\n", nb_regressions, ref_in);
+      return 1;
+    }
+    printf("\nno regression against the reference %s\n", ref_in);
+  }
+  return 0;
+}
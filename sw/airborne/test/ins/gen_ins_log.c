@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/ins/gen_ins_log.c
+ *
+ * Generate a synthetic sensor log for the INS bank.
+ *
+ * A fixedwing takes off from the local origin, climbs and flies left and
+ * right turns at constant airspeed in a constant wind. The measurements
+ * are written in the log format of run_ins_bank with the ground truth:
+ *  - IMU at 100Hz with gyro bias and noise
+ *  - magnetometer at 50Hz
+ *  - GPS at 4Hz
+ *  - baro and airspeed at 20Hz
+ *  - incidence at 20Hz
+ *
+ * The noise comes from a fixed seed pseudo random generator, the same log
+ * is generated on every host so that it can be used as fixed benchmark input.
+ *
+ * usage: gen_ins_log [duration] > log
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#define DT 0.01
+#define G 9.81
+#define AIRSPEED 15.
+
+/* toulouse, same as MAG_H in the Makefile */
+static const double mag_h[3] = { 0.51562740288882, -0.05707735220832, 0.85490967783446 };
+static const double wind[3] = { 3., -2., 0. };
+static const double gyro_bias[3] = { 0.01, -0.02, 0.015 };
+
+/** xorshift64*, no dependency on the libc generator */
+static uint64_t rng_state = 0x2545F4914F6CDD1DULL;
+
+static double rand_uniform(void)
+{
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return ((rng_state * 0x2545F4914F6CDD1DULL) >> 11) * (1. / 9007199254740992.);
+}
+
+static double rand_gauss(double sigma)
+{
+  // Box-Muller, only one of the two values is used
+  double u = rand_uniform();
+  double v = rand_uniform();
+  return sigma * sqrt(-2. * log(u + 1e-300)) * cos(2. * M_PI * v);
+}
+
+/** smooth step from 0 to 1 in 2 seconds, and its derivative */
+static void smooth_step(double x, double *s, double *ds)
+{
+  if (x <= 0.) {
+    *s = 0.; *ds = 0.;
+  } else if (x >= 2.) {
+    *s = 1.; *ds = 0.;
+  } else {
+    *s = (1. - cos(M_PI * x / 2.)) / 2.;
+    *ds = M_PI / 4. * sin(M_PI * x / 2.);
+  }
+}
+
+/** bank angle: straight flight, then turns of 40s alternating left and right */
+static void bank_profile(double t, double *phi, double *phi_dot)
+{
+  *phi = 0.; *phi_dot = 0.;
+  if (t < 20.) {
+    return;
+  }
+  double tt = fmod(t - 20., 80.);
+  double a = (((int)((t - 20.) / 80.)) % 2 == 0 ? 1. : -1.) * 25. * M_PI / 180.;
+  if (tt < 3.) {
+    *phi = a * tt / 3.; *phi_dot = a / 3.;
+  } else if (tt < 40.) {
+    *phi = a;
+  } else if (tt < 43.) {
+    *phi = a * (43. - tt) / 3.; *phi_dot = -a / 3.;
+  }
+}
+
+/** vertical speed: climb to 60m then level flight */
+static void climb_profile(double t, double *vz, double *vz_dot)
+{
+  double s1, ds1, s2, ds2;
+  smooth_step(t - 2., &s1, &ds1);
+  smooth_step(t - 32., &s2, &ds2);
+  *vz = -2. * (s1 - s2);
+  *vz_dot = -2. * (ds1 - ds2);
+}
+
+int main(int argc, char **argv)
+{
+  double duration = argc > 1 ? atof(argv[1]) : 300.;
+  double psi = 0.3;
+  double pos[3] = { 0., 0., 0. };
+
+  int nb = (int)(duration / DT);
+  for (int k = 0; k < nb; k++) {
+    double t = k * DT;
+    double phi, phi_dot, vz, vz_dot;
+    bank_profile(t, &phi, &phi_dot);
+    climb_profile(t, &vz, &vz_dot);
+    double psi_dot = G * tan(phi) / AIRSPEED;
+
+    // body to NED rotation, no pitch
+    double cf = cos(phi), sf = sin(phi), cp = cos(psi), sp = sin(psi);
+    double r[3][3] = {
+      { cp, -cf * sp, sf * sp },
+      { sp, cf * cp, -sf * cp },
+      { 0., sf, cf }
+    };
+    double va[3] = { AIRSPEED * cp, AIRSPEED * sp, vz };
+    double vg[3] = { va[0] + wind[0], va[1] + wind[1], va[2] + wind[2] };
+    // kinematic acceleration minus gravity, in body frame
+    double acc[3] = { -AIRSPEED * psi_dot * sp, AIRSPEED * psi_dot * cp, vz_dot - G };
+    double rates[3] = { phi_dot, sf * psi_dot, cf * psi_dot };
+
+    double gyro[3], accel[3], va_b[3], mag[3];
+    for (int i = 0; i < 3; i++) {
+      accel[i] = r[0][i] * acc[0] + r[1][i] * acc[1] + r[2][i] * acc[2] + rand_gauss(0.1);
+      va_b[i] = r[0][i] * va[0] + r[1][i] * va[1] + r[2][i] * va[2];
+      mag[i] = r[0][i] * mag_h[0] + r[1][i] * mag_h[1] + r[2][i] * mag_h[2] + rand_gauss(0.01);
+      gyro[i] = rates[i] + gyro_bias[i] + rand_gauss(0.005);
+    }
+    printf("%.3f gyro_accel %.5f %.5f %.5f %.4f %.4f %.4f\n", t,
+           gyro[0], gyro[1], gyro[2], accel[0], accel[1], accel[2]);
+
+    // NED to body quaternion, no pitch
+    double c1 = cos(phi / 2.), s1 = sin(phi / 2.), c3 = cos(psi / 2.), s3 = sin(psi / 2.);
+    printf("%.3f truth %.6f %.6f %.6f %.6f %.3f %.3f %.3f %.3f %.3f %.3f %.3f %.3f %.3f\n", t,
+           c1 * c3, s1 * c3, s1 * s3, c1 * s3, pos[0], pos[1], pos[2], vg[0], vg[1], vg[2],
+           wind[0], wind[1], wind[2]);
+
+    if (k % 2 == 0) {
+      printf("%.3f magneto %.4f %.4f %.4f\n", t, mag[0], mag[1], mag[2]);
+    }
+    // the noise is drawn in a fixed order, not in the arguments of printf
+    double va_norm = sqrt(va[0] * va[0] + va[1] * va[1] + va[2] * va[2]);
+    if (k % 25 == 0) {
+      double gps[6];
+      for (int i = 0; i < 3; i++) {
+        gps[i] = pos[i] + rand_gauss(i < 2 ? 1. : 2.);
+      }
+      for (int i = 0; i < 3; i++) {
+        gps[3 + i] = vg[i] + rand_gauss(0.2);
+      }
+      printf("%.3f gps %.3f %.3f %.3f %.3f %.3f %.3f\n", t, gps[0], gps[1], gps[2], gps[3], gps[4], gps[5]);
+    }
+    if (k % 5 == 0) {
+      double baro = pos[2] + rand_gauss(0.5);
+      double airspeed = va_norm + rand_gauss(0.3);
+      printf("%.3f baro %.3f\n", t, baro);
+      printf("%.3f airspeed %.3f\n", t, airspeed);
+    }
+    if (k % 5 == 2) {
+      double aoa = atan2(va_b[2], va_b[0]) + rand_gauss(0.01);
+      double aos = asin(va_b[1] / va_norm) + rand_gauss(0.01);
+      printf("%.3f incidence %.4f %.4f\n", t, aoa, aos);
+    }
+
+    psi += psi_dot * DT;
+    for (int i = 0; i < 3; i++) {
+      pos[i] += vg[i] * DT;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,69 @@
+/* fake generated ABI messages file
+ *
+ * only the messages used by the filters of the bank, same code as gen_abi
+ */
+
+#ifndef ABI_MESSAGES_H
+#define ABI_MESSAGES_H
+
+#include "subsystems/abi_common.h"
+
+/* Messages IDs */
+#define ABI_BARO_ABS_ID 0
+#define ABI_AGL_ID 2
+#define ABI_IMU_ACCEL_INT32_ID 5
+#define ABI_GPS_ID 10
+#define ABI_VELOCITY_ESTIMATE_ID 12
+#define ABI_POSITION_ESTIMATE_ID 18
+
+/* Array and linked list structure */
+#define ABI_MESSAGE_NB 19
+
+ABI_EXTERN abi_event *abi_queues[ABI_MESSAGE_NB];
+
+/* Callbacks */
+typedef void (*abi_callbackBARO_ABS)(uint8_t sender_id, uint32_t stamp, float pressure);
+typedef void (*abi_callbackAGL)(uint8_t sender_id, uint32_t stamp, float distance);
+typedef void (*abi_callbackIMU_ACCEL_INT32)(uint8_t sender_id, uint32_t stamp, struct Int32Vect3 *accel);
+typedef void (*abi_callbackGPS)(uint8_t sender_id, uint32_t stamp, struct GpsState *gps_s);
+typedef void (*abi_callbackVELOCITY_ESTIMATE)(uint8_t sender_id, uint32_t stamp, float x, float y, float z,
+    float noise_x, float noise_y, float noise_z);
+typedef void (*abi_callbackPOSITION_ESTIMATE)(uint8_t sender_id, uint32_t stamp, float x, float y, float z,
+    float noise_x, float noise_y, float noise_z);
+
+/* Bind and Send functions */
+#define ABI_FAKE_BIND(_name) \
+  static inline void AbiBindMsg##_name(uint8_t sender_id, abi_event *ev, abi_callback##_name cb) { \
+    if (abi_queues[ABI_##_name##_ID] == ev) return; \
+    ev->id = sender_id; \
+    ev->cb = (abi_callback)cb; \
+    ABI_PREPEND(abi_queues[ABI_##_name##_ID], ev); \
+  }
+
+#define ABI_FAKE_SEND(_name, _args, ...) \
+  static inline void AbiSendMsg##_name _args { \
+    abi_event *e; \
+    ABI_FOREACH(abi_queues[ABI_##_name##_ID], e) { \
+      if (e->id == ABI_BROADCAST || e->id == sender_id) { \
+        abi_callback##_name cb = (abi_callback##_name)(e->cb); \
+        cb(sender_id, __VA_ARGS__); \
+      } \
+    } \
+  }
+
+ABI_FAKE_BIND(BARO_ABS)
+ABI_FAKE_SEND(BARO_ABS, (uint8_t sender_id, uint32_t stamp, float pressure), stamp, pressure)
+
+ABI_FAKE_BIND(AGL)
+ABI_FAKE_SEND(AGL, (uint8_t sender_id, uint32_t stamp, float distance), stamp, distance)
+
+ABI_FAKE_BIND(IMU_ACCEL_INT32)
+ABI_FAKE_SEND(IMU_ACCEL_INT32, (uint8_t sender_id, uint32_t stamp, struct Int32Vect3 *accel), stamp, accel)
+
+ABI_FAKE_BIND(GPS)
+ABI_FAKE_SEND(GPS, (uint8_t sender_id, uint32_t stamp, struct GpsState *gps_s), stamp, gps_s)
+
+ABI_FAKE_BIND(VELOCITY_ESTIMATE)
+ABI_FAKE_BIND(POSITION_ESTIMATE)
+
+#endif // ABI_MESSAGES_H
@@ -0,0 +1,6 @@
+/* fake generated airframe file */
+
+#ifndef AIRFRAME_H
+#define AIRFRAME_H
+
+#endif // AIRFRAME_H
@@ -0,0 +1,15 @@
+/* fake generated flight plan file
+ *
+ * only the local origin, the NED positions of the bank samples are
+ * converted to GPS coordinates around it
+ */
+
+#ifndef FLIGHT_PLAN_H
+#define FLIGHT_PLAN_H
+
+#define NAV_LAT0 434622300 /* 1e7deg */
+#define NAV_LON0 12728700 /* 1e7deg */
+#define NAV_ALT0 185000 /* mm above msl */
+#define NAV_MSL0 51850 /* mm, EGM96 geoid-height for lat0/lon0 */
+
+#endif // FLIGHT_PLAN_H
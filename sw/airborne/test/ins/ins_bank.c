@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/ins/ins_bank.c
+ *
+ * Log reader and error statistics of the INS bank, shared by run_ins_bank
+ * and bench_ins.
+ *
+ * The input is the text log of ins_mekf_wind (LOG_MEKF_WIND), recorded in
+ * NPS so that it also contains the ground truth, or generated by
+ * gen_ins_log. Each line is
+ *
+ *     <time> <kind> <values>
+ *
+ * with kind:
+ *  - gyro_accel p q r ax ay az (body frame)
+ *  - magneto mx my mz (body frame)
+ *  - gps px py pz vx vy vz (NED)
+ *  - baro alt (Z down)
+ *  - airspeed va
+ *  - incidence aoa aos
+ *  - truth qi qx qy qz px py pz vx vy vz wx wy wz (NED, from NPS)
+ *
+ * other kinds are ignored.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "test/ins/ins_bank.h"
+
+int ins_bank_read_log(struct InsBankLog *log, const char *filename)
+{
+  FILE *fd = fopen(filename, "r");
+  if (fd == NULL) {
+    fprintf(stderr, "can't open log file %s\n", filename);
+    return -1;
+  }
+  int size = 0;
+  log->nb_samples = 0;
+  log->samples = NULL;
+  char line[512];
+  while (fgets(line, sizeof(line), fd)) {
+    double t;
+    char kind[32];
+    int n;
+    if (sscanf(line, "%lf %31s %n", &t, kind, &n) < 2) {
+      continue;
+    }
+    const char *v = line + n;
+    if (strcmp(kind, "gyro_accel") == 0) {
+      if (log->nb_samples == size) {
+        size = size ? 2 * size : 4096;
+        log->samples = realloc(log->samples, size * sizeof(struct InsBankSample));
+      }
+      struct InsBankSample *s = &log->samples[log->nb_samples];
+      memset(s, 0, sizeof(struct InsBankSample));
+      s->time = t;
+      if (sscanf(v, "%f %f %f %f %f %f", &s->gyro.p, &s->gyro.q, &s->gyro.r,
+                 &s->accel.x, &s->accel.y, &s->accel.z) == 6) {
+        log->nb_samples++;
+      }
+      continue;
+    }
+    // other measurements are attached to the last IMU sample
+    if (log->nb_samples == 0) {
+      continue;
+    }
+    struct InsBankSample *s = &log->samples[log->nb_samples - 1];
+    if (strcmp(kind, "magneto") == 0) {
+      if (sscanf(v, "%f %f %f", &s->mag.x, &s->mag.y, &s->mag.z) == 3) {
+        s->flags |= INS_BANK_MAG;
+      }
+    } else if (strcmp(kind, "gps") == 0) {
+      if (sscanf(v, "%f %f %f %f %f %f", &s->gps_pos.x, &s->gps_pos.y, &s->gps_pos.z,
+                 &s->gps_speed.x, &s->gps_speed.y, &s->gps_speed.z) == 6) {
+        s->flags |= INS_BANK_GPS;
+      }
+    } else if (strcmp(kind, "baro") == 0) {
+      if (sscanf(v, "%f", &s->baro_alt) == 1) {
+        s->flags |= INS_BANK_BARO;
+      }
+    } else if (strcmp(kind, "airspeed") == 0) {
+      if (sscanf(v, "%f", &s->airspeed) == 1) {
+        s->flags |= INS_BANK_AIRSPEED;
+      }
+    } else if (strcmp(kind, "incidence") == 0) {
+      if (sscanf(v, "%f %f", &s->aoa, &s->aos) == 2) {
+        s->flags |= INS_BANK_INCIDENCE;
+      }
+    } else if (strcmp(kind, "truth") == 0) {
+      if (sscanf(v, "%f %f %f %f %f %f %f %f %f %f %f %f %f",
+                 &s->quat_true.qi, &s->quat_true.qx, &s->quat_true.qy, &s->quat_true.qz,
+                 &s->pos_true.x, &s->pos_true.y, &s->pos_true.z,
+                 &s->speed_true.x, &s->speed_true.y, &s->speed_true.z,
+                 &s->wind_true.x, &s->wind_true.y, &s->wind_true.z) == 13) {
+        s->flags |= INS_BANK_TRUTH;
+      }
+    }
+  }
+  fclose(fd);
+  if (log->nb_samples < 2) {
+    fprintf(stderr, "not enough IMU samples in %s\n", filename);
+    free(log->samples);
+    log->samples = NULL;
+    return -1;
+  }
+  // the log time has a ms resolution, use the mean period
+  log->dt = (log->samples[log->nb_samples - 1].time - log->samples[0].time) / (log->nb_samples - 1);
+  printf("read %d samples in file %s, dt %.5f s\n", log->nb_samples, filename, log->dt);
+  return 0;
+}
+
+void ins_bank_compute_alignment(struct InsBankLog *log, double align_time)
+{
+  struct InsBankSample *samples = log->samples;
+  int nb = 0, nb_mag = 0;
+  FLOAT_RATES_ZERO(log->lp_gyro);
+  FLOAT_VECT3_ZERO(log->lp_accel);
+  FLOAT_VECT3_ZERO(log->lp_mag);
+  for (int i = 0; i < log->nb_samples && (nb == 0 || samples[i].time < samples[0].time + align_time); i++) {
+    RATES_ADD(log->lp_gyro, samples[i].gyro);
+    VECT3_ADD(log->lp_accel, samples[i].accel);
+    nb++;
+    if (samples[i].flags & INS_BANK_MAG) {
+      VECT3_ADD(log->lp_mag, samples[i].mag);
+      nb_mag++;
+    }
+  }
+  RATES_SDIV(log->lp_gyro, log->lp_gyro, nb);
+  VECT3_SDIV(log->lp_accel, log->lp_accel, nb);
+  if (nb_mag > 0) {
+    VECT3_SDIV(log->lp_mag, log->lp_mag, nb_mag);
+  } else {
+    // no magnetometer, heading is not aligned
+    VECT3_ASSIGN(log->lp_mag, AHRS_H_X, AHRS_H_Y, AHRS_H_Z);
+  }
+}
+
+static void add_error(struct InsBankError *e, double err)
+{
+  e->nb++;
+  e->sum2 += err * err;
+  if (err > e->max) {
+    e->max = err;
+  }
+}
+
+void ins_bank_add_errors(struct InsBankErrors *e, const struct InsBankFilter *f,
+                         const struct InsBankSample *s, struct InsBankOutput *o)
+{
+  struct FloatEulers eul, eul_true;
+  float_eulers_of_quat(&eul, &o->quat);
+  float_eulers_of_quat(&eul_true, (struct FloatQuat *)&s->quat_true);
+  struct FloatQuat q_err;
+  float_quat_inv_comp_norm_shortest(&q_err, (struct FloatQuat *)&s->quat_true, &o->quat);
+  add_error(&e->att, 2. * acos(Min(q_err.qi, 1.f)));
+  float d_psi = eul.psi - eul_true.psi;
+  NormRadAngle(d_psi);
+  add_error(&e->heading, fabsf(d_psi));
+  if (f->outputs & INS_BANK_OUT_POS) {
+    struct FloatVect3 d;
+    VECT3_DIFF(d, o->pos, s->pos_true);
+    add_error(&e->pos, float_vect3_norm(&d));
+    VECT3_DIFF(d, o->speed, s->speed_true);
+    add_error(&e->speed, float_vect3_norm(&d));
+  }
+  if (f->outputs & INS_BANK_OUT_WIND) {
+    struct FloatVect3 d;
+    VECT3_DIFF(d, o->wind, s->wind_true);
+    add_error(&e->wind, float_vect3_norm(&d));
+  }
+}
+
+double ins_bank_rms(const struct InsBankError *e)
+{
+  return e->nb > 0 ? sqrt(e->sum2 / e->nb) : 0.;
+}
+
+struct InsBankFilter *ins_bank_find_filter(const char *name)
+{
+  for (int i = 0; i < ins_bank_nb_filters; i++) {
+    if (strcmp(name, ins_bank_filters[i].name) == 0) {
+      return &ins_bank_filters[i];
+    }
+  }
+  return NULL;
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/ins/ins_bank.h
+ *
+ * Bank of attitude and INS filters run on the same recorded sensor stream.
+ *
+ * The samples are the IMU samples of the log (gyro and accel in body frame).
+ * The other measurements received after an IMU sample are attached to it,
+ * so that each filter does the same propagation and update sequence as on
+ * board. The ground truth is attached when the log comes from NPS.
+ */
+
+#ifndef INS_BANK_H
+#define INS_BANK_H
+
+#include "std.h"
+#include "math/pprz_algebra_float.h"
+#include "math/pprz_geodetic_float.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** measurements available in a sample */
+#define INS_BANK_MAG       (1 << 0)
+#define INS_BANK_BARO      (1 << 1)
+#define INS_BANK_GPS       (1 << 2)
+#define INS_BANK_AIRSPEED  (1 << 3)
+#define INS_BANK_INCIDENCE (1 << 4)
+#define INS_BANK_TRUTH     (1 << 5)
+
+struct InsBankSample {
+  double time;
+  uint8_t flags;
+  struct FloatRates gyro;       ///< body rates in rad/s
+  struct FloatVect3 accel;      ///< body specific force in m/s^2
+  struct FloatVect3 mag;        ///< body magnetic field, normalized
+  struct FloatVect3 gps_pos;    ///< NED position in m
+  struct FloatVect3 gps_speed;  ///< NED speed in m/s
+  float baro_alt;               ///< baro altitude in m, Z down
+  float airspeed;               ///< true airspeed in m/s
+  float aoa;                    ///< angle of attack in rad
+  float aos;                    ///< sideslip angle in rad
+  /* ground truth */
+  struct FloatQuat quat_true;   ///< NED to body
+  struct FloatVect3 pos_true;   ///< NED position in m
+  struct FloatVect3 speed_true; ///< NED speed in m/s
+  struct FloatVect3 wind_true;  ///< NED wind in m/s
+};
+
+/** filter output */
+#define INS_BANK_OUT_POS   (1 << 0)
+#define INS_BANK_OUT_WIND  (1 << 1)
+
+struct InsBankOutput {
+  struct FloatQuat quat;        ///< NED to body
+  struct FloatVect3 pos;
+  struct FloatVect3 speed;
+  struct FloatVect3 wind;
+};
+
+/**
+ * Filter of the bank
+ *
+ * Each filter keeps its state in its own global structure, so that all
+ * of them can run at the same time in different threads. The filters
+ * running with their wrapper code use the state interface and are flagged
+ * exclusive, they are run one after the other. A filter can only appear
+ * once in a bank.
+ */
+struct InsBankFilter {
+  const char *name;
+  uint8_t outputs;              ///< INS_BANK_OUT_x flags
+  bool exclusive;               ///< uses the state interface, can't run at the same time as other exclusive filters
+  void (*init)(void);
+  void (*align)(struct FloatRates *lp_gyro, struct FloatVect3 *lp_accel, struct FloatVect3 *lp_mag);
+  void (*run)(struct InsBankSample *s, float dt);
+  void (*get_output)(struct InsBankOutput *out);
+};
+
+extern struct InsBankFilter ins_bank_filters[];
+extern const int ins_bank_nb_filters;
+
+/** recorded sensor stream */
+struct InsBankLog {
+  struct InsBankSample *samples;
+  int nb_samples;
+  float dt;                     ///< mean IMU period
+  /* average of the measurements at the beginning of the log */
+  struct FloatRates lp_gyro;
+  struct FloatVect3 lp_accel;
+  struct FloatVect3 lp_mag;
+};
+
+/** error statistics */
+struct InsBankError {
+  int nb;
+  double sum2;
+  double max;
+};
+
+struct InsBankErrors {
+  struct InsBankError att, heading, pos, speed, wind;
+};
+
+/** Read a log file, returns -1 on error */
+extern int ins_bank_read_log(struct InsBankLog *log, const char *filename);
+
+/** Average the first align_time seconds of the log for the filters alignment */
+extern void ins_bank_compute_alignment(struct InsBankLog *log, double align_time);
+
+/** Add the errors of a filter output against the ground truth of a sample */
+extern void ins_bank_add_errors(struct InsBankErrors *e, const struct InsBankFilter *f,
+                                const struct InsBankSample *s, struct InsBankOutput *o);
+
+/** rms of an error, 0 when no error was added */
+extern double ins_bank_rms(const struct InsBankError *e);
+
+/** Find a filter of the bank by name, NULL if not found */
+extern struct InsBankFilter *ins_bank_find_filter(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INS_BANK_H */
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/ins/ins_bank_filters.c
+ *
+ * Filters of the bank.
+ *
+ * Only the filter cores are used, not their wrappers, so that no state
+ * interface or ABI message is shared between the filters. The samples are
+ * in body frame, the body to imu rotation is left to identity.
+ *
+ * The complete INS are in ins_bank_ins.c.
+ */
+
+#include "test/ins/ins_bank.h"
+#include "subsystems/ahrs/ahrs_float_utils.h"
+#include "subsystems/ahrs/ahrs_float_cmpl.h"
+#include "subsystems/ahrs/ahrs_float_mlkf.h"
+#include "subsystems/ahrs/ahrs_float_invariant.h"
+#include "modules/ins/ins_mekf_wind.h"
+
+static struct FloatQuat identity = { 1.f, 0.f, 0.f, 0.f };
+
+/*
+ * ahrs_float_cmpl, quaternion propagation
+ */
+static double fc_last_mag_time;
+
+static void fc_init(void)
+{
+  ahrs_fc_init();
+  fc_last_mag_time = -1.;
+}
+
+static void fc_align(struct FloatRates *lp_gyro, struct FloatVect3 *lp_accel, struct FloatVect3 *lp_mag)
+{
+  ahrs_fc_align(lp_gyro, lp_accel, lp_mag);
+}
+
+static void fc_run(struct InsBankSample *s, float dt)
+{
+  ahrs_fc_propagate(&s->gyro, dt);
+  ahrs_fc_update_accel(&s->accel, dt);
+  if (s->flags & INS_BANK_MAG) {
+    float dt_mag = fc_last_mag_time < 0. ? dt : (float)(s->time - fc_last_mag_time);
+    ahrs_fc_update_mag(&s->mag, dt_mag);
+    fc_last_mag_time = s->time;
+  }
+}
+
+static void fc_get_output(struct InsBankOutput *out)
+{
+  out->quat = ahrs_fc.ltp_to_imu_quat;
+}
+
+/*
+ * ahrs_float_mlkf
+ */
+static void mlkf_init(void)
+{
+  ahrs_mlkf_init();
+  ahrs_mlkf_set_body_to_imu_quat(&identity);
+}
+
+static void mlkf_align(struct FloatRates *lp_gyro, struct FloatVect3 *lp_accel, struct FloatVect3 *lp_mag)
+{
+  ahrs_mlkf_align(lp_gyro, lp_accel, lp_mag);
+}
+
+static void mlkf_run(struct InsBankSample *s, float dt)
+{
+  ahrs_mlkf_propagate(&s->gyro, dt);
+  ahrs_mlkf_update_accel(&s->accel);
+  if (s->flags & INS_BANK_MAG) {
+    ahrs_mlkf_update_mag(&s->mag);
+  }
+}
+
+static void mlkf_get_output(struct InsBankOutput *out)
+{
+  out->quat = ahrs_mlkf.ltp_to_imu_quat;
+}
+
+/*
+ * ahrs_float_invariant
+ */
+static void finv_init(void)
+{
+  ahrs_float_invariant_init();
+  ahrs_float_inv_set_body_to_imu_quat(&identity);
+}
+
+static void finv_run(struct InsBankSample *s, float dt)
+{
+  ahrs_float_invariant_propagate(&s->gyro, dt);
+  ahrs_float_invariant_update_accel(&s->accel);
+  if (s->flags & INS_BANK_MAG) {
+    ahrs_float_invariant_update_mag(&s->mag);
+  }
+}
+
+static void finv_get_output(struct InsBankOutput *out)
+{
+  out->quat = ahrs_float_inv.state.quat;
+}
+
+/*
+ * ins_mekf_wind, same sequence as ins_mekf_wind_wrapper
+ */
+static bool mekfw_gps_initialized;
+
+static void mekfw_init(void)
+{
+  ins_mekf_wind_init();
+  const struct FloatVect3 mag_h = { AHRS_H_X, AHRS_H_Y, AHRS_H_Z };
+  ins_mekf_wind_set_mag_h(&mag_h);
+  mekfw_gps_initialized = false;
+}
+
+static void mekfw_align(struct FloatRates *lp_gyro, struct FloatVect3 *lp_accel, struct FloatVect3 *lp_mag)
+{
+  struct FloatQuat quat;
+  ahrs_float_get_quat_from_accel_mag(&quat, lp_accel, lp_mag);
+  ins_mekf_wind_align(lp_gyro, &quat);
+}
+
+static void mekfw_run(struct InsBankSample *s, float dt)
+{
+  if (mekfw_gps_initialized) {
+    ins_mekf_wind_propagate(&s->gyro, &s->accel, dt);
+  } else {
+    ins_mekf_wind_propagate_ahrs(&s->gyro, &s->accel, dt);
+  }
+  if (s->flags & INS_BANK_MAG) {
+    ins_mekf_wind_update_mag(&s->mag, !mekfw_gps_initialized);
+  }
+  if (s->flags & INS_BANK_GPS) {
+    if (!mekfw_gps_initialized) {
+      ins_mekf_wind_set_pos_ned((struct NedCoor_f *)&s->gps_pos);
+      ins_mekf_wind_set_speed_ned((struct NedCoor_f *)&s->gps_speed);
+      mekfw_gps_initialized = true;
+    }
+    ins_mekf_wind_update_pos_speed(&s->gps_pos, &s->gps_speed);
+  }
+  if ((s->flags & INS_BANK_BARO) && mekfw_gps_initialized) {
+    ins_mekf_wind_update_baro(s->baro_alt);
+  }
+  if (s->flags & INS_BANK_AIRSPEED) {
+    ins_mekf_wind_update_airspeed(s->airspeed);
+  }
+  if (s->flags & INS_BANK_INCIDENCE) {
+    ins_mekf_wind_update_incidence(s->aoa, s->aos);
+  }
+}
+
+static void mekfw_get_output(struct InsBankOutput *out)
+{
+  out->quat = ins_mekf_wind_get_quat();
+  struct NedCoor_f pos = ins_mekf_wind_get_pos_ned();
+  struct NedCoor_f speed = ins_mekf_wind_get_speed_ned();
+  struct NedCoor_f wind = ins_mekf_wind_get_wind_ned();
+  VECT3_COPY(out->pos, pos);
+  VECT3_COPY(out->speed, speed);
+  VECT3_COPY(out->wind, wind);
+}
+
+/* complete INS, see ins_bank_ins.c */
+extern void ins_int_bank_init(void);
+extern void ins_int_bank_align(struct FloatRates *lp_gyro, struct FloatVect3 *lp_accel, struct FloatVect3 *lp_mag);
+extern void ins_int_bank_run(struct InsBankSample *s, float dt);
+extern void ins_int_bank_get_output(struct InsBankOutput *out);
+extern void ins_finv_bank_init(void);
+extern void ins_finv_bank_align(struct FloatRates *lp_gyro, struct FloatVect3 *lp_accel, struct FloatVect3 *lp_mag);
+extern void ins_finv_bank_run(struct InsBankSample *s, float dt);
+extern void ins_finv_bank_get_output(struct InsBankOutput *out);
+
+struct InsBankFilter ins_bank_filters[] = {
+  {
+    .name = "ahrs_float_cmpl", .outputs = 0,
+    .init = fc_init, .align = fc_align, .run = fc_run, .get_output = fc_get_output
+  },
+  {
+    .name = "ahrs_float_mlkf", .outputs = 0,
+    .init = mlkf_init, .align = mlkf_align, .run = mlkf_run, .get_output = mlkf_get_output
+  },
+  {
+    .name = "ahrs_float_invariant", .outputs = 0,
+    .init = finv_init, .align = ahrs_float_invariant_align, .run = finv_run, .get_output = finv_get_output
+  },
+  {
+    .name = "ins_mekf_wind", .outputs = INS_BANK_OUT_POS | INS_BANK_OUT_WIND,
+    .init = mekfw_init, .align = mekfw_align, .run = mekfw_run, .get_output = mekfw_get_output
+  },
+  {
+    .name = "ins_int", .outputs = INS_BANK_OUT_POS, .exclusive = true,
+    .init = ins_int_bank_init, .align = ins_int_bank_align, .run = ins_int_bank_run,
+    .get_output = ins_int_bank_get_output
+  },
+  {
+    .name = "ins_float_invariant", .outputs = INS_BANK_OUT_POS, .exclusive = true,
+    .init = ins_finv_bank_init, .align = ins_finv_bank_align, .run = ins_finv_bank_run,
+    .get_output = ins_finv_bank_get_output
+  }
+};
+
+const int ins_bank_nb_filters = sizeof(ins_bank_filters) / sizeof(ins_bank_filters[0]);
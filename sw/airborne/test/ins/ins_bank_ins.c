@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/ins/ins_bank_ins.c
+ *
+ * Complete INS of the bank, run with the state interface.
+ *
+ * ins_int and ins_float_invariant write their output to the state
+ * interface, they are flagged exclusive in the bank. ins_int gets the baro
+ * through the fake ABI of generated/abi_messages.h, like on board. The GPS
+ * measurements of the samples are converted to GPS states around the
+ * origin of the fake flight plan, and the baro altitudes to pressures.
+ *
+ * Not in ins_bank_filters.c as ins_float_invariant.h and
+ * ahrs_float_invariant.h can't be included together.
+ */
+
+#define ABI_C
+
+#include <string.h>
+
+#include "test/ins/ins_bank.h"
+#include "subsystems/ahrs/ahrs_int_cmpl_quat.h"
+#include "subsystems/ins/ins_int.h"
+#include "subsystems/ins/ins_float_invariant.h"
+#include "subsystems/abi.h"
+#include "subsystems/imu.h"
+#include "subsystems/gps.h"
+#include "state.h"
+#include "math/pprz_geodetic_double.h"
+#include "math/pprz_isa.h"
+#include "generated/flight_plan.h"
+
+static struct FloatQuat identity = { 1.f, 0.f, 0.f, 0.f };
+
+/* globals of the imu and gps subsystems used by ins_int */
+struct Imu imu;
+struct GpsState gps;
+
+/** origin of the local frame, same as the INS */
+static struct LtpDef_d ltp_def;
+
+static void init_origin(void)
+{
+  struct LlaCoor_i lla_i = { .lat = NAV_LAT0, .lon = NAV_LON0, .alt = NAV_ALT0 + NAV_MSL0 };
+  struct LlaCoor_d lla;
+  LLA_DOUBLE_OF_BFP(lla, lla_i);
+  ltp_def_from_lla_d(&ltp_def, &lla);
+}
+
+/** GPS state of a sample with a 3D fix */
+static void gps_of_sample(struct GpsState *gps_s, struct InsBankSample *s)
+{
+  struct NedCoor_d ned = { s->gps_pos.x, s->gps_pos.y, s->gps_pos.z };
+  struct NedCoor_d ned_vel = { s->gps_speed.x, s->gps_speed.y, s->gps_speed.z };
+  struct EcefCoor_d ecef, ecef_vel;
+  ecef_of_ned_point_d(&ecef, &ltp_def, &ned);
+  ecef_of_ned_vect_d(&ecef_vel, &ltp_def, &ned_vel);
+  struct LlaCoor_d lla;
+  lla_of_ecef_d(&lla, &ecef);
+
+  ECEF_BFP_OF_REAL(gps_s->ecef_pos, ecef);
+  ECEF_BFP_OF_REAL(gps_s->ecef_vel, ecef_vel);
+  LLA_BFP_OF_REAL(gps_s->lla_pos, lla);
+  gps_s->hmsl = NAV_ALT0 - (int32_t)(s->gps_pos.z * 1000.f);
+  VECT3_SMUL(gps_s->ned_vel, s->gps_speed, 100.f);
+  gps_s->gspeed = (uint16_t)(100.f * FLOAT_VECT2_NORM(s->gps_speed));
+  gps_s->speed_3d = (uint16_t)(100.f * float_vect3_norm(&s->gps_speed));
+  gps_s->course = (int32_t)(1e7f * atan2f(s->gps_speed.y, s->gps_speed.x));
+  gps_s->cacc = (uint32_t)RadOfDeg(1e7);
+  gps_s->fix = GPS_FIX_3D;
+}
+
+/** static pressure of a baro altitude above the flight plan ground altitude */
+static float pressure_of_sample(struct InsBankSample *s)
+{
+  return pprz_isa_pressure_of_height(NAV_ALT0 / 1000.f - s->baro_alt, PPRZ_ISA_SEA_LEVEL_PRESSURE);
+}
+
+/*
+ * ahrs_int_cmpl_quat with ins_int, hf_float and vf_extended_float, same
+ * sequence as the rotorcraft wrappers
+ */
+static double icq_last_mag_time;
+
+void ins_int_bank_init(void)
+{
+  stateInit();
+  init_origin();
+  memset(&gps, 0, sizeof(gps));
+  orientationSetQuat_f(&imu.body_to_imu, &identity);
+  ahrs_icq_init();
+  ahrs_icq_set_body_to_imu_quat(&identity);
+  ins_int_init();
+  // take the baro reference at the first measurement, like the ground
+  // reference reset of the flight plan before takeoff
+  ins_int.vf_reset = true;
+  icq_last_mag_time = -1.;
+}
+
+void ins_int_bank_align(struct FloatRates *lp_gyro, struct FloatVect3 *lp_accel, struct FloatVect3 *lp_mag)
+{
+  struct Int32Rates gyro_i;
+  struct Int32Vect3 accel_i, mag_i;
+  RATES_BFP_OF_REAL(gyro_i, *lp_gyro);
+  ACCELS_BFP_OF_REAL(accel_i, *lp_accel);
+  MAGS_BFP_OF_REAL(mag_i, *lp_mag);
+  ahrs_icq_align(&gyro_i, &accel_i, &mag_i);
+  stateSetNedToBodyQuat_i(&ahrs_icq.ltp_to_imu_quat);
+}
+
+void ins_int_bank_run(struct InsBankSample *s, float dt)
+{
+  struct Int32Rates gyro_i;
+  struct Int32Vect3 accel_i;
+  RATES_BFP_OF_REAL(gyro_i, s->gyro);
+  ACCELS_BFP_OF_REAL(accel_i, s->accel);
+  ahrs_icq_propagate(&gyro_i, dt);
+  ahrs_icq_update_accel(&accel_i, dt);
+  if (s->flags & INS_BANK_MAG) {
+    struct Int32Vect3 mag_i;
+    MAGS_BFP_OF_REAL(mag_i, s->mag);
+    float dt_mag = icq_last_mag_time < 0. ? dt : (float)(s->time - icq_last_mag_time);
+    ahrs_icq_update_mag(&mag_i, dt_mag);
+    icq_last_mag_time = s->time;
+  }
+  // body to imu is identity
+  stateSetNedToBodyQuat_i(&ahrs_icq.ltp_to_imu_quat);
+
+  ins_int_propagate(&accel_i, dt);
+  if (s->flags & INS_BANK_BARO) {
+    AbiSendMsgBARO_ABS(1, (uint32_t)(s->time * 1e6), pressure_of_sample(s));
+  }
+  if (s->flags & INS_BANK_GPS) {
+    gps_of_sample(&gps, s);
+    ahrs_icq_update_gps(&gps);
+    ins_int_update_gps(&gps);
+  }
+}
+
+void ins_int_bank_get_output(struct InsBankOutput *out)
+{
+  QUAT_FLOAT_OF_BFP(out->quat, ahrs_icq.ltp_to_imu_quat);
+  VECT3_COPY(out->pos, *stateGetPositionNed_f());
+  VECT3_COPY(out->speed, *stateGetSpeedNed_f());
+}
+
+/*
+ * ins_float_invariant, same sequence as ins_float_invariant_wrapper
+ */
+void ins_finv_bank_init(void)
+{
+  stateInit();
+  init_origin();
+  ins_float_invariant_init();
+  ins_float_inv_set_body_to_imu_quat(&identity);
+}
+
+void ins_finv_bank_align(struct FloatRates *lp_gyro, struct FloatVect3 *lp_accel, struct FloatVect3 *lp_mag)
+{
+  ins_float_invariant_align(lp_gyro, lp_accel, lp_mag);
+}
+
+void ins_finv_bank_run(struct InsBankSample *s, float dt)
+{
+  ins_float_invariant_propagate(&s->gyro, &s->accel, dt);
+  if (s->flags & INS_BANK_MAG) {
+    ins_float_invariant_update_mag(&s->mag);
+  }
+  if (s->flags & INS_BANK_BARO) {
+    ins_float_invariant_update_baro(pressure_of_sample(s));
+  }
+  if (s->flags & INS_BANK_GPS) {
+    struct GpsState gps_s;
+    memset(&gps_s, 0, sizeof(gps_s));
+    gps_of_sample(&gps_s, s);
+    ins_float_invariant_update_gps(&gps_s);
+  }
+}
+
+void ins_finv_bank_get_output(struct InsBankOutput *out)
+{
+  out->quat = ins_float_inv.state.quat;
+  VECT3_COPY(out->pos, ins_float_inv.state.pos);
+  VECT3_COPY(out->speed, ins_float_inv.state.speed);
+}
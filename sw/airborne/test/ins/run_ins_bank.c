@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/ins/run_ins_bank.c
+ *
+ * Run a bank of attitude and INS filters on a recorded sensor stream.
+ *
+ * The input is the text log of ins_mekf_wind, see ins_bank.c for the
+ * format. The log is read once, then every filter runs on the whole log in
+ * its own thread, the exclusive filters run one after the other in a last
+ * thread. The attitude, heading, position, speed and wind errors against
+ * the ground truth are reported for each filter.
+ *
+ * usage: run_ins_bank [-o prefix] [-a align_time] [-s skip_time] log [filter...]
+ *
+ *  -o prefix      write the estimates of each filter to prefix_<filter>.csv
+ *  -a align_time  time in seconds averaged for the initial alignment (default 0.5)
+ *  -s skip_time   time in seconds not used for the errors (default 0)
+ *
+ * All filters of the bank are run if none is given.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "test/ins/ins_bank.h"
+
+struct InsBankRun {
+  struct InsBankFilter *filter;
+  pthread_t thread;
+  double cpu_time;
+  struct InsBankErrors err;
+};
+
+static struct InsBankLog bank_log;
+static const char *out_prefix;
+static double skip_time;
+
+static void *run_filter(void *arg)
+{
+  struct InsBankRun *run = (struct InsBankRun *)arg;
+  struct InsBankFilter *f = run->filter;
+  FILE *out = NULL;
+  if (out_prefix) {
+    char filename[512];
+    snprintf(filename, sizeof(filename), "%s_%s.csv", out_prefix, f->name);
+    out = fopen(filename, "w");
+    if (out) {
+      fprintf(out, "time,phi,theta,psi,phi_true,theta_true,psi_true,"
+              "x,y,z,vx,vy,vz,wx,wy,wz\n");
+    }
+  }
+
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t0);
+  f->init();
+  f->align(&bank_log.lp_gyro, &bank_log.lp_accel, &bank_log.lp_mag);
+  for (int i = 0; i < bank_log.nb_samples; i++) {
+    struct InsBankSample *s = &bank_log.samples[i];
+    f->run(s, bank_log.dt);
+
+    struct InsBankOutput o;
+    memset(&o, 0, sizeof(o));
+    f->get_output(&o);
+    struct FloatEulers e, e_true = { 0.f, 0.f, 0.f };
+    float_eulers_of_quat(&e, &o.quat);
+    if (s->flags & INS_BANK_TRUTH) {
+      float_eulers_of_quat(&e_true, &s->quat_true);
+    }
+    if (out) {
+      fprintf(out, "%.3f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+              s->time, e.phi, e.theta, e.psi, e_true.phi, e_true.theta, e_true.psi,
+              o.pos.x, o.pos.y, o.pos.z, o.speed.x, o.speed.y, o.speed.z,
+              o.wind.x, o.wind.y, o.wind.z);
+    }
+    if ((s->flags & INS_BANK_TRUTH) && s->time >= bank_log.samples[0].time + skip_time) {
+      ins_bank_add_errors(&run->err, f, s, &o);
+    }
+  }
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t1);
+  run->cpu_time = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+  if (out) {
+    fclose(out);
+  }
+  return NULL;
+}
+
+/** exclusive filters, one after the other */
+static void *run_exclusive_filters(void *arg)
+{
+  struct InsBankRun *runs = (struct InsBankRun *)arg;
+  for (int i = 0; runs[i].filter != NULL; i++) {
+    run_filter(&runs[i]);
+  }
+  return NULL;
+}
+
+static void print_error(const struct InsBankError *e, double scale)
+{
+  if (e->nb > 0) {
+    printf("  %7.2f %7.2f", sqrt(e->sum2 / e->nb) * scale, e->max * scale);
+  } else {
+    printf("  %7s %7s", "-", "-");
+  }
+}
+
+int main(int argc, char **argv)
+{
+  double align_time = 0.5;
+  int opt;
+  while ((opt = getopt(argc, argv, "o:a:s:h")) != -1) {
+    switch (opt) {
+      case 'o': out_prefix = optarg; break;
+      case 'a': align_time = atof(optarg); break;
+      case 's': skip_time = atof(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-o prefix] [-a align_time] [-s skip_time] log [filter...]\n", argv[0]);
+        fprintf(stderr, "filters:");
+        for (int i = 0; i < ins_bank_nb_filters; i++) {
+          fprintf(stderr, " %s", ins_bank_filters[i].name);
+        }
+        fprintf(stderr, "\n");
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "no log file, see %s -h\n", argv[0]);
+    return 1;
+  }
+  if (ins_bank_read_log(&bank_log, argv[optind]) < 0) {
+    return 1;
+  }
+  ins_bank_compute_alignment(&bank_log, align_time);
+
+  // select the filters, the exclusive ones at the end
+  struct InsBankRun runs[ins_bank_nb_filters + 1];
+  memset(runs, 0, sizeof(runs));
+  int nb_runs = 0, nb_threads = 0;
+  for (int exclusive = 0; exclusive < 2; exclusive++) {
+    for (int i = 0; i < ins_bank_nb_filters; i++) {
+      bool selected = optind + 1 >= argc;
+      for (int j = optind + 1; j < argc; j++) {
+        selected |= strcmp(argv[j], ins_bank_filters[i].name) == 0;
+      }
+      if (selected && ins_bank_filters[i].exclusive == exclusive) {
+        runs[nb_runs++].filter = &ins_bank_filters[i];
+      }
+    }
+    if (!exclusive) {
+      nb_threads = nb_runs;
+    }
+  }
+  if (nb_runs == 0) {
+    fprintf(stderr, "no known filter selected, see %s -h\n", argv[0]);
+    return 1;
+  }
+
+  struct timespec t0, t1;
+  pthread_t exclusive_thread;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (int i = 0; i < nb_threads; i++) {
+    pthread_create(&runs[i].thread, NULL, run_filter, &runs[i]);
+  }
+  if (nb_threads < nb_runs) {
+    pthread_create(&exclusive_thread, NULL, run_exclusive_filters, &runs[nb_threads]);
+  }
+  for (int i = 0; i < nb_threads; i++) {
+    pthread_join(runs[i].thread, NULL);
+  }
+  if (nb_threads < nb_runs) {
+    pthread_join(exclusive_thread, NULL);
+  }
+  double cpu_time = 0.;
+  for (int i = 0; i < nb_runs; i++) {
+    cpu_time += runs[i].cpu_time;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  double wall_time = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+  printf("\nerrors against ground truth, rms and max\n");
+  printf("%-22s  %15s  %15s  %15s  %15s  %15s  %8s\n", "filter",
+         "attitude (deg)", "heading (deg)", "position (m)", "speed (m/s)", "wind (m/s)", "us/step");
+  for (int i = 0; i < nb_runs; i++) {
+    struct InsBankRun *r = &runs[i];
+    printf("%-22s", r->filter->name);
+    print_error(&r->err.att, 180. / M_PI);
+    print_error(&r->err.heading, 180. / M_PI);
+    print_error(&r->err.pos, 1.);
+    print_error(&r->err.speed, 1.);
+    print_error(&r->err.wind, 1.);
+    printf("  %8.2f\n", r->cpu_time / bank_log.nb_samples * 1e6);
+  }
+  if (runs[0].err.att.nb == 0) {
+    printf("no ground truth in the log\n");
+  }
+  printf("\n%d filters on %.0f s of flight in %.2f s (%.2f s of cpu time)\n", nb_runs,
+         bank_log.samples[bank_log.nb_samples - 1].time - bank_log.samples[0].time, wall_time, cpu_time);
+
+  free(bank_log.samples);
+  return 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/ins/test_mekf_wind_update.cpp
+ *
+ * Compare the full matrix and the sequential scalar updates of ins_mekf_wind.
+ *
+ * A fixedwing in level flight with wind is simulated at 100Hz with GPS,
+ * baro, mag, airspeed and incidence measurements. Each update is done with
+ * both paths from the same filter state and the results are compared, then
+ * two filters using one path each are run along the whole flight. The mean
+ * time of each update is reported for both paths.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test_utils.h"
+
+// access to the private filter state
+#include "modules/ins/ins_mekf_wind.cpp"
+
+#define DT 0.01f
+#define DURATION 120.f
+
+/** largest difference between two filter states, relative for the covariance */
+static float state_diff(const struct InsMekfWindPrivate &a, const struct InsMekfWindPrivate &b)
+{
+  float d = (a.state.quat.coeffs() - b.state.quat.coeffs()).cwiseAbs().maxCoeff();
+  d = fmaxf(d, (a.state.speed - b.state.speed).cwiseAbs().maxCoeff());
+  d = fmaxf(d, (a.state.pos - b.state.pos).cwiseAbs().maxCoeff());
+  d = fmaxf(d, (a.state.rates_bias - b.state.rates_bias).cwiseAbs().maxCoeff());
+  d = fmaxf(d, (a.state.accel_bias - b.state.accel_bias).cwiseAbs().maxCoeff());
+  d = fmaxf(d, fabsf(a.state.baro_bias - b.state.baro_bias));
+  d = fmaxf(d, (a.state.wind - b.state.wind).cwiseAbs().maxCoeff());
+  return d;
+}
+
+static float cov_diff(const struct InsMekfWindPrivate &a, const struct InsMekfWindPrivate &b)
+{
+  return (a.P - b.P).cwiseAbs().maxCoeff() / a.P.cwiseAbs().maxCoeff();
+}
+
+enum UpdateType { UPDATE_MAG, UPDATE_BARO, UPDATE_GPS, UPDATE_AIRSPEED, UPDATE_INCIDENCE, NB_UPDATE };
+static const char *update_names[NB_UPDATE] = { "mag", "baro", "pos_speed", "airspeed", "incidence" };
+
+struct Measures {
+  struct FloatVect3 mag, pos, speed;
+  float baro, airspeed, aoa, aos;
+};
+
+static void do_update(enum UpdateType type, struct Measures *m)
+{
+  switch (type) {
+    case UPDATE_MAG: ins_mekf_wind_update_mag(&m->mag, false); break;
+    case UPDATE_BARO: ins_mekf_wind_update_baro(m->baro); break;
+    case UPDATE_GPS: ins_mekf_wind_update_pos_speed(&m->pos, &m->speed); break;
+    case UPDATE_AIRSPEED: ins_mekf_wind_update_airspeed(m->airspeed); break;
+    case UPDATE_INCIDENCE: ins_mekf_wind_update_incidence(m->aoa, m->aos); break;
+    default: break;
+  }
+}
+
+int main(void)
+{
+  srand(1);
+
+  ins_mekf_wind_init();
+  ins_mekf_wind_params.disable_wind = false;
+  struct FloatVect3 mag_h = { 0.5180f, -0.0071f, 0.8554f };
+  ins_mekf_wind_set_mag_h(&mag_h);
+
+  // truth: level flight to the north at 15 m/s airspeed, 50 m high, constant wind
+  const Vector3f wind(2.f, 1.f, 0.f);
+  const Vector3f airspeed(15.f, 0.f, 0.f);
+  Vector3f pos(0.f, 0.f, -50.f);
+  const Vector3f speed = airspeed + wind;
+  struct NedCoor_f p0 = { pos(0), pos(1), pos(2) };
+  struct NedCoor_f s0 = { speed(0), speed(1), speed(2) };
+  ins_mekf_wind_set_pos_ned(&p0);
+  ins_mekf_wind_set_speed_ned(&s0);
+
+  // one filter per path, starting from the same state
+  struct InsMekfWindPrivate dense = mwp, seq = mwp;
+  float max_diff[NB_UPDATE] = { 0.f }, max_cov[NB_UPDATE] = { 0.f };
+  double time[2][NB_UPDATE] = {{ 0. }};
+  int nb[NB_UPDATE] = { 0 };
+
+  const int nb_steps = (int)(DURATION / DT);
+  for (int step = 0; step < nb_steps; step++) {
+    pos += speed * DT;
+    struct FloatRates gyro = { rand_gauss(0.01f), rand_gauss(0.01f), rand_gauss(0.01f) };
+    struct FloatVect3 accel = { rand_gauss(0.1f), rand_gauss(0.1f), -9.81f + rand_gauss(0.1f) };
+    struct Measures m;
+    m.mag.x = mag_h.x + rand_gauss(0.01f);
+    m.mag.y = mag_h.y + rand_gauss(0.01f);
+    m.mag.z = mag_h.z + rand_gauss(0.01f);
+    m.pos.x = pos(0) + rand_gauss(1.f);
+    m.pos.y = pos(1) + rand_gauss(1.f);
+    m.pos.z = pos(2) + rand_gauss(2.f);
+    m.speed.x = speed(0) + rand_gauss(0.2f);
+    m.speed.y = speed(1) + rand_gauss(0.2f);
+    m.speed.z = speed(2) + rand_gauss(0.3f);
+    m.baro = pos(2) + rand_gauss(1.f);
+    m.airspeed = airspeed.norm() + rand_gauss(0.3f);
+    m.aoa = rand_gauss(0.02f);
+    m.aos = rand_gauss(0.02f);
+
+    // updates due at this step: mag and airspeed at 50Hz, baro and incidence at 20Hz, gps at 4Hz
+    bool due[NB_UPDATE];
+    due[UPDATE_MAG] = step % 2 == 0;
+    due[UPDATE_BARO] = step % 5 == 0;
+    due[UPDATE_GPS] = step % 25 == 0;
+    due[UPDATE_AIRSPEED] = step % 2 == 1;
+    due[UPDATE_INCIDENCE] = step % 5 == 2;
+
+    // both filters propagate
+    mwp = dense;
+    ins_mekf_wind_propagate(&gyro, &accel, DT);
+    dense = mwp;
+    mwp = seq;
+    ins_mekf_wind_propagate(&gyro, &accel, DT);
+    seq = mwp;
+
+    for (int u = 0; u < NB_UPDATE; u++) {
+      if (!due[u]) {
+        continue;
+      }
+      // same prior for both paths
+      struct InsMekfWindPrivate prior = dense;
+      mwp = prior;
+      ins_mekf_wind_params.sequential_update = false;
+      double t0 = now();
+      do_update((enum UpdateType)u, &m);
+      double t1 = now();
+      struct InsMekfWindPrivate post_dense = mwp;
+      mwp = prior;
+      ins_mekf_wind_params.sequential_update = true;
+      double t2 = now();
+      do_update((enum UpdateType)u, &m);
+      double t3 = now();
+      max_diff[u] = fmaxf(max_diff[u], state_diff(post_dense, mwp));
+      max_cov[u] = fmaxf(max_cov[u], cov_diff(post_dense, mwp));
+      time[0][u] += t1 - t0;
+      time[1][u] += t3 - t2;
+      nb[u]++;
+      dense = post_dense;
+
+      // independent sequential filter
+      mwp = seq;
+      do_update((enum UpdateType)u, &m);
+      seq = mwp;
+    }
+  }
+
+  int failed = 0;
+  printf("update      max state diff  max rel cov diff  full (ns)  sequential (ns)\n");
+  for (int u = 0; u < NB_UPDATE; u++) {
+    const bool ok = nb[u] > 0 && max_diff[u] < 1e-3f && max_cov[u] < 1e-3f;
+    failed |= !ok;
+    printf("%-10s  %14g  %16g  %9.0f  %15.0f  %s\n", update_names[u], max_diff[u], max_cov[u],
+           time[0][u] / nb[u] * 1e9, time[1][u] / nb[u] * 1e9, ok ? "ok" : "FAILED");
+  }
+  const float traj_diff = state_diff(dense, seq);
+  const bool traj_ok = traj_diff < 1e-2f;
+  failed |= !traj_ok;
+  printf("after %.0f s of flight, state diff between both filters: %g %s\n", DURATION, traj_diff,
+         traj_ok ? "ok" : "FAILED");
+  printf("wind estimate: %.2f %.2f %.2f (truth %.2f %.2f %.2f)\n", seq.state.wind(0), seq.state.wind(1),
+         seq.state.wind(2), wind(0), wind(1), wind(2));
+
+  return failed;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/ins/test_ukf_wind_sr.c
+ *
+ * Compare the generated and hand written UKF of the wind estimator.
+ *
+ * A fixedwing flying circles in wind is simulated at 50Hz with noisy
+ * measurements. Both filters are initialized like in the wind_estimator
+ * module and run side by side on the same inputs, their state and
+ * covariance square root are compared after each step. The mean time of
+ * a step is reported for both filters.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "modules/meteo/ukf_wind_sr.h"
+#include "test_utils.h"
+
+#define DT 0.02f
+#define DURATION 300.f
+
+#define MAT_EL(_m, _l, _c, _n) _m[_l + _c * _n]
+
+/** same tuning as the wind_estimator module defaults */
+static void init_ukf(void)
+{
+  memset(&ukf_U, 0, sizeof(ExtU));
+  memset(&ukf_Y, 0, sizeof(ExtY));
+  memset(&ukf_DW, 0, sizeof(DW));
+  memset(&ukf_init, 0, sizeof(ukf_init_type));
+  memset(&ukf_params, 0, sizeof(ukf_params_type));
+  ukf_wind_sr_reset();
+
+  ukf_init.x0[6] = 1.f;
+  for (int i = 0; i < 7; i++) {
+    MAT_EL(ukf_init.P0, i, i, 7) = 0.2f;
+  }
+  const float r[6] = { 0.5f, 0.5f, 0.5f, 0.5f, 0.002f, 0.002f };
+  for (int i = 0; i < 6; i++) {
+    MAT_EL(ukf_params.R, i, i, 6) = r[i] * r[i];
+  }
+  const float q[7] = { 0.1f, 0.1f, 0.1f, 0.001f, 0.001f, 0.001f, 0.0001f };
+  for (int i = 0; i < 7; i++) {
+    MAT_EL(ukf_params.Q, i, i, 7) = q[i] * q[i];
+  }
+  ukf_init.ki = 0.f;
+  ukf_init.alpha = 0.5f;
+  ukf_init.beta = 2.f;
+  ukf_params.dt = DT;
+}
+
+int main(void)
+{
+  srand(1);
+  init_ukf();
+
+  // truth: circles at 15 m/s airspeed with varying bank, constant wind
+  const float wind[3] = { 3.f, -2.f, 0.3f };
+  const float va_body[3] = { 15.f, 0.2f, 0.8f };
+  float psi = 0.f;
+
+  float max_x = 0.f, max_p = 0.f;
+  double time_gen = 0., time_sr = 0.;
+  ExtY y_gen;
+
+  const int nb_steps = (int)(DURATION / DT);
+  for (int step = 0; step < nb_steps; step++) {
+    const float t = step * DT;
+    const float phi = 0.4f * sinf(0.02f * t);
+    const float theta = 0.05f;
+    const float r = 9.81f * tanf(phi) / va_body[0];
+    psi += r * DT;
+
+    // NED to body quaternion
+    const float cp = cosf(phi / 2.f), sp = sinf(phi / 2.f);
+    const float ct = cosf(theta / 2.f), st = sinf(theta / 2.f);
+    const float cs = cosf(psi / 2.f), ss = sinf(psi / 2.f);
+    const float qt[4] = {
+      cp * ct * cs + sp * st * ss,
+      sp * ct * cs - cp * st * ss,
+      cp * st * cs + sp * ct * ss,
+      cp * ct * ss - sp * st * cs
+    };
+    // body to NED rotation of the airspeed
+    const float q0 = qt[0], q1 = qt[1], q2 = qt[2], q3 = qt[3];
+    const float rm[3][3] = {
+      { q0 * q0 + q1 * q1 - q2 * q2 - q3 * q3, 2.f * (q1 * q2 - q0 * q3), 2.f * (q1 * q3 + q0 * q2) },
+      { 2.f * (q1 * q2 + q0 * q3), q0 * q0 - q1 * q1 + q2 * q2 - q3 * q3, 2.f * (q2 * q3 - q0 * q1) },
+      { 2.f * (q1 * q3 - q0 * q2), 2.f * (q2 * q3 + q0 * q1), q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3 }
+    };
+
+    // body rates, the accelerations keep the airspeed constant in body frame
+    const float rates[3] = { 0.008f * cosf(0.02f * t), 0.f, r };
+    ukf_U.rates[0] = rates[0] + rand_gauss(0.01f);
+    ukf_U.rates[1] = rates[1] + rand_gauss(0.01f);
+    ukf_U.rates[2] = rates[2] + rand_gauss(0.01f);
+    ukf_U.accel[0] = rates[1] * va_body[2] - rates[2] * va_body[1] + rand_gauss(0.2f);
+    ukf_U.accel[1] = rates[2] * va_body[0] - rates[0] * va_body[2] + rand_gauss(0.2f);
+    ukf_U.accel[2] = rates[0] * va_body[1] - rates[1] * va_body[0] + rand_gauss(0.2f);
+    memcpy(ukf_U.q, qt, sizeof(qt));
+    for (int i = 0; i < 3; i++) {
+      ukf_U.vk[i] = rm[i][0] * va_body[0] + rm[i][1] * va_body[1] + rm[i][2] * va_body[2] + wind[i]
+                    + rand_gauss(0.3f);
+    }
+    const float va = sqrtf(va_body[0] * va_body[0] + va_body[1] * va_body[1] + va_body[2] * va_body[2]);
+    ukf_U.va = va + rand_gauss(0.3f);
+    ukf_U.aoa = atan2f(va_body[2], va_body[0]) + rand_gauss(0.01f);
+    ukf_U.sideslip = asinf(va_body[1] / va) + rand_gauss(0.01f);
+
+    double t0 = now();
+    UKF_Wind_Estimator_step();
+    double t1 = now();
+    y_gen = ukf_Y;
+    double t2 = now();
+    ukf_wind_sr_step();
+    double t3 = now();
+    time_gen += t1 - t0;
+    time_sr += t3 - t2;
+
+    float p_max = 0.f, dp = 0.f;
+    for (int i = 0; i < 7; i++) {
+      max_x = fmaxf(max_x, fabsf(y_gen.xout[i] - ukf_Y.xout[i]));
+    }
+    for (int i = 0; i < 49; i++) {
+      p_max = fmaxf(p_max, fabsf(y_gen.Pout[i]));
+      dp = fmaxf(dp, fabsf(y_gen.Pout[i] - ukf_Y.Pout[i]));
+    }
+    max_p = fmaxf(max_p, dp / p_max);
+  }
+
+  const bool x_ok = max_x < 1e-3f;
+  const bool p_ok = max_p < 1e-3f;
+  float wind_err = 0.f;
+  for (int i = 0; i < 3; i++) {
+    wind_err = fmaxf(wind_err, fabsf(ukf_Y.xout[3 + i] - wind[i]));
+  }
+  const bool wind_ok = wind_err < 0.5f;
+
+  printf("after %.0f s of flight at %.0f Hz\n", DURATION, 1.f / DT);
+  printf("max state diff: %g %s\n", max_x, x_ok ? "ok" : "FAILED");
+  printf("max rel covariance square root diff: %g %s\n", max_p, p_ok ? "ok" : "FAILED");
+  printf("wind estimate: %.2f %.2f %.2f (truth %.2f %.2f %.2f) %s\n", ukf_Y.xout[3], ukf_Y.xout[4],
+         ukf_Y.xout[5], wind[0], wind[1], wind[2], wind_ok ? "ok" : "FAILED");
+  printf("step time: generated %.2f us, hand written %.2f us\n", time_gen / nb_steps * 1e6,
+         time_sr / nb_steps * 1e6);
+
+  return !(x_ok && p_ok && wind_ok);
+}
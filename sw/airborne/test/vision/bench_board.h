@@ -0,0 +1,10 @@
+/* Minimal board configuration for the host vision benchmarks */
+
+#ifndef BENCH_BOARD_H
+#define BENCH_BOARD_H
+
+#include "peripherals/video_device.h"
+
+extern struct video_config_t front_camera;
+
+#endif /* BENCH_BOARD_H */
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench_textons.c
+ *
+ * Benchmark of the texton dictionary learning and distribution extraction.
+ *
+ * Runs on recorded raw UYVY frames (all frames concatenated in one file, e.g. from
+ * a V4L2 capture) or on generated frames when no file is given:
+ *   ./bench_textons [frames.yuv width height]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "modules/computer_vision/cv.h"
+#include "modules/computer_vision/textons.h"
+
+#define NB_GENERATED_FRAMES 20
+#define NB_RUNS 500
+
+/* The module registers itself on a camera, which does not exist here */
+struct video_config_t front_camera;
+struct video_listener *cv_add_to_device(struct video_config_t *device __attribute__((unused)),
+                                        cv_function func __attribute__((unused)),
+                                        uint16_t fps __attribute__((unused)))
+{
+  return NULL;
+}
+
+static double get_time_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+/* Smooth gradients with some noise, so the textons have something to learn */
+static void generate_frame(uint8_t *frame, uint16_t w, uint16_t h, int seed)
+{
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      uint8_t *p = &frame[2 * (y * w + x)];
+      p[0] = (x % 2 == 0) ? (uint8_t)(128 + (x + seed) % 64) : (uint8_t)(128 + (y - seed) % 64);
+      p[1] = (uint8_t)((x * y + seed * 7) % 200 + rand() % 56);
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  uint16_t w = 320;
+  uint16_t h = 240;
+  uint32_t nb_frames = NB_GENERATED_FRAMES;
+  uint8_t *frames;
+
+  if (argc >= 4) {
+    w = atoi(argv[2]);
+    h = atoi(argv[3]);
+    FILE *f = fopen(argv[1], "rb");
+    if (f == NULL) {
+      perror("Could not open frames");
+      return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    nb_frames = ftell(f) / (2 * w * h);
+    fseek(f, 0, SEEK_SET);
+    if (nb_frames == 0) {
+      printf("No complete %dx%d frame in %s\n", w, h, argv[1]);
+      fclose(f);
+      return 1;
+    }
+    frames = malloc(nb_frames * 2 * w * h);
+    if (fread(frames, 2 * w * h, nb_frames, f) != nb_frames) {
+      perror("Could not read frames");
+      fclose(f);
+      return 1;
+    }
+    fclose(f);
+  } else {
+    frames = malloc(nb_frames * 2 * w * h);
+    for (uint32_t i = 0; i < nb_frames; i++) {
+      generate_frame(&frames[i * 2 * w * h], w, h, i);
+    }
+  }
+  printf("%d frames of %dx%d, %d textons, patch size %d, %d samples per image\n",
+         nb_frames, w, h, n_textons, patch_size, n_samples_image);
+
+  textons_init();
+
+  // Learn a dictionary on the frames
+  load_dictionary = 0;
+  double start = get_time_us();
+  uint32_t nb_learn = 0;
+  while (learned_samples < n_learning_samples) {
+    DictionaryTrainingYUV(&frames[(nb_learn % nb_frames) * 2 * w * h], w, h);
+    nb_learn++;
+  }
+  double learn_time = get_time_us() - start;
+  printf("learning:   %8.1f us/frame (%d frames)\n", learn_time / nb_learn, nb_learn);
+
+  // Extract the distributions
+  start = get_time_us();
+  for (uint32_t i = 0; i < NB_RUNS; i++) {
+    DistributionExtraction(&frames[(i % nb_frames) * 2 * w * h], w, h);
+  }
+  double extract_time = get_time_us() - start;
+  printf("extraction: %8.1f us/frame (%.0f Hz)\n", extract_time / NB_RUNS, 1e6 * NB_RUNS / extract_time);
+
+  FULL_SAMPLING = 1;
+  start = get_time_us();
+  for (uint32_t i = 0; i < nb_frames; i++) {
+    DistributionExtraction(&frames[i * 2 * w * h], w, h);
+  }
+  extract_time = get_time_us() - start;
+  printf("full:       %8.1f us/frame (%.0f Hz)\n", extract_time / nb_frames, 1e6 * nb_frames / extract_time);
+
+  float sum = 0;
+  for (int i = 0; i < n_textons; i++) {
+    sum += texton_distribution[i];
+  }
+  printf("distribution sum: %f\n", sum);
+
+  textons_stop();
+  free(frames);
+  return 0;
+}
@@ -0,0 +1,307 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_blob_labeling.c
+ *
+ * Check the run-length union-find blob labeling against a flood fill.
+ *
+ * Random masks of several densities and sizes, and adversarial ones (U shapes,
+ * spirals, diagonal touches, checkerboards, runs over the whole width and
+ * blobs crossing the thread bands) are labeled both ways, with 1, 2 and
+ * BLOB_FINDER_MAX_THREADS bands. The blob count and, for every blob, its
+ * area, first pixel and centroid must be the same.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "modules/computer_vision/blob/blob_finder.h"
+
+#define MAX_LABELS 4096
+
+#ifndef BLOB_FINDER_MAX_THREADS
+#define BLOB_FINDER_MAX_THREADS 4
+#endif
+
+/* Blob found by the flood fill */
+struct ref_blob_t {
+  uint32_t pixel_cnt;
+  uint16_t x_min;
+  uint16_t y_min;
+  uint32_t x_sum;
+  uint32_t y_sum;
+};
+
+static struct image_label_t labels[MAX_LABELS];
+static struct ref_blob_t ref[MAX_LABELS];
+
+/* 8-connected flood fill, blobs ordered by their first pixel in the image like the runs labeling */
+static uint16_t flood_fill_labeling(struct image_mask_t *mask, uint16_t max_labels)
+{
+  uint32_t size = mask->w * mask->h;
+  uint8_t *seen = calloc(size, 1);
+  uint32_t *stack = malloc(sizeof(uint32_t) * size);
+  uint16_t cnt = 0;
+
+  for (uint32_t p = 0; p < size && cnt < max_labels; p++) {
+    if (!mask->buf[p] || seen[p]) {
+      continue;
+    }
+    struct ref_blob_t *b = &ref[cnt++];
+    memset(b, 0, sizeof(*b));
+    b->x_min = p % mask->w;
+    b->y_min = p / mask->w;
+    uint32_t top = 0;
+    stack[top++] = p;
+    seen[p] = 1;
+    while (top > 0) {
+      uint32_t q = stack[--top];
+      int x = q % mask->w, y = q / mask->w;
+      b->pixel_cnt++;
+      b->x_sum += x;
+      b->y_sum += y;
+      if (x < b->x_min) {
+        b->x_min = x;
+      }
+      for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+          int nx = x + dx, ny = y + dy;
+          if (nx < 0 || ny < 0 || nx >= mask->w || ny >= mask->h) {
+            continue;
+          }
+          uint32_t n = ny * mask->w + nx;
+          if (mask->buf[n] && !seen[n]) {
+            seen[n] = 1;
+            stack[top++] = n;
+          }
+        }
+      }
+    }
+  }
+  free(seen);
+  free(stack);
+  return cnt;
+}
+
+/* Label a mask both ways, 0 if they agree */
+static int check_mask(const char *name, struct image_mask_t *mask, uint16_t max_labels)
+{
+  int errors = 0;
+  uint16_t ref_cnt = flood_fill_labeling(mask, max_labels);
+  struct image_runs_t runs;
+  image_runs_create(&runs, mask->w, mask->h);
+
+  // the same labeling memory keeps its worker threads, also when fewer bands are used
+  uint8_t threads[3] = { 1, BLOB_FINDER_MAX_THREADS, 2 };
+  for (int t = 0; t < 3; t++) {
+    uint16_t cnt = max_labels;
+    image_labeling_runs(mask, &runs, labels, &cnt, threads[t]);
+    if (cnt != ref_cnt) {
+      printf("%s (%dx%d, %d threads): %d blobs instead of %d\n", name, mask->w, mask->h, threads[t], cnt, ref_cnt);
+      errors++;
+      continue;
+    }
+    for (uint16_t i = 0; i < cnt; i++) {
+      struct image_label_t *l = &labels[i];
+      struct ref_blob_t *r = &ref[i];
+      if (l->pixel_cnt != r->pixel_cnt || l->x_min != r->x_min || l->y_min != r->y_min ||
+          l->x_sum != r->x_sum || l->y_sum != r->y_sum) {
+        printf("%s (%dx%d, %d threads): blob %d has %u pixels at (%d, %d) centroid (%.2f, %.2f), "
+               "flood fill %u pixels at (%d, %d) centroid (%.2f, %.2f)\n",
+               name, mask->w, mask->h, threads[t], i, l->pixel_cnt, l->x_min, l->y_min,
+               (float)l->x_sum / l->pixel_cnt, (float)l->y_sum / l->pixel_cnt,
+               r->pixel_cnt, r->x_min, r->y_min, (float)r->x_sum / r->pixel_cnt, (float)r->y_sum / r->pixel_cnt);
+        errors++;
+        break;
+      }
+    }
+  }
+  image_runs_free(&runs);
+  return errors;
+}
+
+static void mask_init(struct image_mask_t *mask, uint16_t w, uint16_t h)
+{
+  memset(mask, 0, sizeof(*mask));
+  mask->w = w;
+  mask->h = h;
+  mask->buf = calloc(w * h, 1);
+}
+
+#define PIX(_m, _x, _y) (_m)->buf[(_y) * (_m)->w + (_x)]
+
+static void draw_rect(struct image_mask_t *mask, int x0, int y0, int x1, int y1)
+{
+  for (int y = y0; y <= y1; y++) {
+    for (int x = x0; x <= x1; x++) {
+      PIX(mask, x, y) = 1;
+    }
+  }
+}
+
+/* U shapes open to the top, the arms are only joined on the last rows */
+static void draw_u_shapes(struct image_mask_t *mask)
+{
+  for (int x0 = 1; x0 + 9 < mask->w; x0 += 12) {
+    int depth = 3 + (x0 * 7) % (mask->h - 4);
+    draw_rect(mask, x0, 1, x0 + 1, depth);
+    draw_rect(mask, x0 + 8, 1, x0 + 9, depth);
+    draw_rect(mask, x0, depth, x0 + 9, depth);
+    // nested U in the first one
+    draw_rect(mask, x0 + 3, 1, x0 + 3, depth - 2);
+    draw_rect(mask, x0 + 6, 1, x0 + 6, depth - 2);
+    draw_rect(mask, x0 + 3, depth - 2, x0 + 6, depth - 2);
+  }
+}
+
+/* Square spiral, one blob merged many times */
+static void draw_spiral(struct image_mask_t *mask)
+{
+  int x0 = 0, y0 = 0, x1 = mask->w - 1, y1 = mask->h - 1;
+  while (x0 <= x1 && y0 <= y1) {
+    draw_rect(mask, x0, y0, x1, y0);
+    draw_rect(mask, x1, y0, x1, y1);
+    draw_rect(mask, x0, y1, x1, y1);
+    if (y0 + 2 <= y1) {
+      draw_rect(mask, x0, y0 + 2, x0, y1);
+    }
+    if (x0 + 2 <= x1 && y0 + 2 <= y1) {
+      PIX(mask, x0 + 1, y0 + 2) = 1;
+    }
+    x0 += 2; y0 += 2; x1 -= 2; y1 -= 2;
+  }
+}
+
+/* Diagonal lines and single pixels only touching by a corner */
+static void draw_diagonals(struct image_mask_t *mask)
+{
+  for (int k = 0; k < mask->w + mask->h; k += 5) {
+    for (int y = 0; y < mask->h; y++) {
+      int x = k - y;
+      if (x >= 0 && x < mask->w) {
+        PIX(mask, x, y) = 1;
+      }
+      x = k + y - mask->h;
+      if (x >= 0 && x < mask->w) {
+        PIX(mask, x, y) = 1;
+      }
+    }
+  }
+}
+
+static void draw_checkerboard(struct image_mask_t *mask)
+{
+  for (int y = 0; y < mask->h; y++) {
+    for (int x = 0; x < mask->w; x++) {
+      PIX(mask, x, y) = (x + y) % 2;
+    }
+  }
+}
+
+/* Rows over the whole width, some joined by a pixel at either border */
+static void draw_full_rows(struct image_mask_t *mask)
+{
+  for (int y = 0; y < mask->h; y += 2) {
+    draw_rect(mask, 0, y, mask->w - 1, y);
+    if (y % 6 == 0 && y + 1 < mask->h) {
+      PIX(mask, (y % 12 == 0) ? 0 : mask->w - 1, y + 1) = 1;
+    }
+  }
+}
+
+/* Vertical bars over the whole height, crossing all the thread bands */
+static void draw_bars(struct image_mask_t *mask)
+{
+  for (int x = 0; x < mask->w; x += 3) {
+    draw_rect(mask, x, 0, x, mask->h - 1);
+  }
+  // diagonal touches exactly on the band borders
+  for (int b = 1; b < BLOB_FINDER_MAX_THREADS; b++) {
+    int y = mask->h * b / BLOB_FINDER_MAX_THREADS;
+    for (int x = 1; x + 1 < mask->w; x += 3) {
+      PIX(mask, x, y) = 0;
+      PIX(mask, x + 1, y - 1) = (x / 3) % 2;
+    }
+  }
+}
+
+static void draw_random(struct image_mask_t *mask, int density)
+{
+  for (uint32_t i = 0; i < (uint32_t)mask->w * mask->h; i++) {
+    mask->buf[i] = (rand() % 100) < density;
+  }
+}
+
+int main(void)
+{
+  int errors = 0, nb_masks = 0;
+  struct image_mask_t mask;
+  srand(7);
+
+  const uint16_t sizes[][2] = { {1, 1}, {1, 37}, {53, 1}, {2, 2}, {17, 9}, {64, 48}, {101, 77}, {320, 240} };
+  const int nb_sizes = sizeof(sizes) / sizeof(sizes[0]);
+  void (*shapes[])(struct image_mask_t *) = { draw_u_shapes, draw_spiral, draw_diagonals, draw_checkerboard,
+                                              draw_full_rows, draw_bars };
+  const char *shape_names[] = { "u shapes", "spiral", "diagonals", "checkerboard", "full rows", "bars" };
+
+  for (int s = 0; s < nb_sizes; s++) {
+    uint16_t w = sizes[s][0], h = sizes[s][1];
+
+    // empty and full
+    mask_init(&mask, w, h);
+    errors += check_mask("empty", &mask, MAX_LABELS);
+    memset(mask.buf, 1, w * h);
+    errors += check_mask("full", &mask, MAX_LABELS);
+    free(mask.buf);
+    nb_masks += 2;
+
+    // adversarial shapes, only when they fit
+    for (int k = 0; k < 6 && w >= 12 && h >= 8; k++) {
+      mask_init(&mask, w, h);
+      shapes[k](&mask);
+      errors += check_mask(shape_names[k], &mask, MAX_LABELS);
+      free(mask.buf);
+      nb_masks++;
+    }
+
+    // random masks
+    for (int density = 5; density <= 95; density += 15) {
+      for (int r = 0; r < 5; r++) {
+        mask_init(&mask, w, h);
+        draw_random(&mask, density);
+        errors += check_mask("random", &mask, MAX_LABELS);
+        free(mask.buf);
+        nb_masks++;
+      }
+    }
+  }
+
+  // more blobs than labels, the first ones must still be complete
+  mask_init(&mask, 320, 240);
+  draw_random(&mask, 30);
+  errors += check_mask("random, labels overflow", &mask, 50);
+  free(mask.buf);
+  nb_masks++;
+
+  printf("%d masks labeled with runs and flood fill: %s\n", nb_masks, errors ? "FAILED" : "ok");
+  return errors != 0;
+}
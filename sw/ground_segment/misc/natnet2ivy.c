@@ -26,6 +26,10 @@
 * NatNet UDP stream and forwards it to the ivy bus. An aircraft with the gps
 * subsystem "datalink" is then able to parse the GPS position and use it to
 * navigate inside the Optitrack system.
+*
+*   The frames are parsed in place and the positions are transmitted as soon
+* as a frame arrives (at most at the transmit frequency), either on the ivy bus
+* or as pprzlink frames sent directly to the aircraft over UDP (-ac_udp).
 */
 
 #include <glib.h>
@@ -105,22 +109,29 @@ struct RigidBody {
   float error;                      ///< Error of the position in cm
   int nSamples;                     ///< Number of samples since last transmit
   bool posSampled;                  ///< If the position is sampled last sampling
+  double sampleTime;                ///< Reception time of the last position sample in seconds
 
   double vel_x, vel_y, vel_z;       ///< Sum of the (last_vel_* - current_vel_*) during nVelocitySamples
+  double velTime;                   ///< Reception time of the sample the velocity sum starts from
   struct EcefCoor_d ecef_vel;       ///< Last valid ECEF velocity in meters
   int nVelocitySamples;             ///< Number of velocity samples gathered
-  int totalVelocitySamples;         ///< Total amount of velocity samples possible
-  int nVelocityTransmit;            ///< Amount of transmits since last valid velocity transmit
 };
-struct RigidBody rigidBodies[MAX_RIGIDBODIES];    ///< All rigid bodies which are tracked
 
 /** Mapping between rigid body and aircraft */
 struct Aircraft {
   uint8_t ac_id;
-  float lastSample;
+  double lastSample;
   bool connected;
+  struct RigidBody rigid;           ///< The rigid body followed for this aircraft
+  bool udp_output;                  ///< Send pprzlink frames directly to the aircraft instead of the ivy bus
+  struct UdpSocket udp;
 };
-struct Aircraft aircrafts[MAX_RIGIDBODIES];                  ///< Mapping from rigid body ID to aircraft ID
+struct Aircraft aircrafts[MAX_RIGIDBODIES];                  ///< Followed aircraft
+int nb_aircrafts = 0;
+
+/** Hash from the rigid body ID to the index in aircrafts (open addressing, -1 when empty) */
+#define RIGID_HASH_SIZE   (2 * MAX_RIGIDBODIES)
+int16_t rigid_hash[RIGID_HASH_SIZE];
 
 /** Natnet socket connections */
 struct UdpSocket natnet_data, natnet_cmd;
@@ -132,603 +143,753 @@ double tracking_offset_angle;       ///< The offset from the tracking system to
 /** Save the latency from natnet */
 float natnet_latency;
 
-/** Parse the packet from NatNet */
-void natnet_parse(unsigned char *in)
+/** Time of the next transmit in seconds */
+double next_transmit = 0;
+
+/** pprzlink (v2) frame of a datalink message sent by the ground */
+#define PPRZ_STX                    0x99
+#define PPRZ_DATALINK_CLASS_ID      2
+#define PPRZ_REMOTE_GPS_SMALL_ID    54
+#define PPRZ_REMOTE_GPS_ID          55
+
+/** Monotonic time in seconds */
+static double get_time(void)
 {
-  int i, j, k;
+  return g_get_monotonic_time() / 1e6;
+}
+
+static inline uint32_t rigid_hash_of_id(int id)
+{
+  return ((uint32_t)id * 2654435761u) & (RIGID_HASH_SIZE - 1);
+}
+
+/** Find the aircraft following a rigid body, NULL if the rigid body is not followed */
+static struct Aircraft *aircraft_of_rigid(int id)
+{
+  for (uint32_t h = rigid_hash_of_id(id); rigid_hash[h] >= 0; h = (h + 1) & (RIGID_HASH_SIZE - 1)) {
+    if (aircrafts[rigid_hash[h]].rigid.id == id) {
+      return &aircrafts[rigid_hash[h]];
+    }
+  }
+  return NULL;
+}
+
+/** Follow a rigid body for an aircraft */
+static struct Aircraft *aircraft_add(int id, uint8_t ac_id)
+{
+  struct Aircraft *ac = aircraft_of_rigid(id);
+  if (ac == NULL) {
+    if (nb_aircrafts >= MAX_RIGIDBODIES) {
+      fprintf(stderr, "Can not follow more than %d (MAX_RIGIDBODIES) rigid bodies\n", MAX_RIGIDBODIES);
+      exit(EXIT_FAILURE);
+    }
+    uint32_t h = rigid_hash_of_id(id);
+    while (rigid_hash[h] >= 0) {
+      h = (h + 1) & (RIGID_HASH_SIZE - 1);
+    }
+    rigid_hash[h] = nb_aircrafts;
+    ac = &aircrafts[nb_aircrafts++];
+    ac->rigid.id = id;
+  }
+  ac->ac_id = ac_id;
+  return ac;
+}
+
+/** Bounds checked reader, the fields are read in place from the received packet */
+struct NatNetReader {
+  const uint8_t *ptr;
+  const uint8_t *end;
+  bool error;                       ///< Set when reading beyond the end of the packet
+};
+
+static inline const uint8_t *natnet_take(struct NatNetReader *r, size_t len)
+{
+  if (r->error || (size_t)(r->end - r->ptr) < len) {
+    r->error = TRUE;
+    return NULL;
+  }
+  const uint8_t *p = r->ptr;
+  r->ptr += len;
+  return p;
+}
+
+static inline int32_t natnet_int(struct NatNetReader *r)
+{
+  int32_t v = 0;
+  const uint8_t *p = natnet_take(r, 4);
+  if (p) { memcpy(&v, p, 4); }
+  return v;
+}
+
+static inline int16_t natnet_short(struct NatNetReader *r)
+{
+  int16_t v = 0;
+  const uint8_t *p = natnet_take(r, 2);
+  if (p) { memcpy(&v, p, 2); }
+  return v;
+}
+
+static inline float natnet_float(struct NatNetReader *r)
+{
+  float v = 0;
+  const uint8_t *p = natnet_take(r, 4);
+  if (p) { memcpy(&v, p, 4); }
+  return v;
+}
+
+static inline double natnet_double(struct NatNetReader *r)
+{
+  double v = 0;
+  const uint8_t *p = natnet_take(r, 8);
+  if (p) { memcpy(&v, p, 8); }
+  return v;
+}
+
+/** Null terminated string inside the packet */
+static inline const char *natnet_string(struct NatNetReader *r)
+{
+  const uint8_t *nul = r->error ? NULL : memchr(r->ptr, '\0', r->end - r->ptr);
+  if (nul == NULL) {
+    r->error = TRUE;
+    return "";
+  }
+  return (const char *)natnet_take(r, nul - r->ptr + 1);
+}
+
+/** Array of count elements of size bytes inside the packet */
+static inline const uint8_t *natnet_array(struct NatNetReader *r, int32_t count, size_t size)
+{
+  if (count < 0 || (!r->error && (size_t)count > (size_t)(r->end - r->ptr) / size)) {
+    r->error = TRUE;
+    return NULL;
+  }
+  return natnet_take(r, count * size);
+}
+
+static inline float natnet_float_at(const uint8_t *array, int i)
+{
+  float v;
+  memcpy(&v, array + i * 4, 4);
+  return v;
+}
+
+static inline int32_t natnet_int_at(const uint8_t *array, int i)
+{
+  int32_t v;
+  memcpy(&v, array + i * 4, 4);
+  return v;
+}
+
+/** Print the markers of a rigid body (verbose only) */
+static void natnet_print_markers(int nMarkers, const uint8_t *markerData, const uint8_t *markerIDs,
+                                 const uint8_t *markerSizes)
+{
+  int k;
+  for (k = 0; k < nMarkers && verbose > 1; k++) {
+    if (markerIDs != NULL && markerSizes != NULL) {
+      printf_natnet("\tMarker %d: id=%d\tsize=%3.1f\tpos=[%3.2f,%3.2f,%3.2f]\n", k, natnet_int_at(markerIDs, k),
+                    natnet_float_at(markerSizes, k), natnet_float_at(markerData, k * 3),
+                    natnet_float_at(markerData, k * 3 + 1), natnet_float_at(markerData, k * 3 + 2));
+    } else {
+      printf_natnet("\tMarker %d: pos = [%3.2f,%3.2f,%3.2f]\n", k, natnet_float_at(markerData, k * 3),
+                    natnet_float_at(markerData, k * 3 + 1), natnet_float_at(markerData, k * 3 + 2));
+    }
+  }
+}
+
+/** Update the state of a followed rigid body with a new sample */
+static void rigid_update(struct RigidBody *rb, float x, float y, float z, float qx, float qy, float qz, float qw,
+                         double now)
+{
+  // Differentiate the position to get the speed (TODO: crossreference with labeled markers for occlussion)
+  if (rb->x != x || rb->y != y || rb->z != z || rb->qx != qx || rb->qy != qy || rb->qz != qz || rb->qw != qw) {
+    if (rb->posSampled) {
+      if (rb->nVelocitySamples == 0) {
+        rb->velTime = rb->sampleTime;
+      }
+      rb->vel_x += (x - rb->x);
+      rb->vel_y += (y - rb->y);
+      rb->vel_z += (z - rb->z);
+      rb->nVelocitySamples++;
+    }
 
-  // Create a pointer to go trough the packet
-  char *ptr = (char *)in;
+    rb->nSamples++;
+    rb->posSampled = TRUE;
+    rb->sampleTime = now;
+  } else {
+    rb->posSampled = FALSE;
+  }
+
+  rb->x = x;
+  rb->y = y;
+  rb->z = z;
+  rb->qx = qx;
+  rb->qy = qy;
+  rb->qz = qz;
+  rb->qw = qw;
+}
+
+/** Parse the packet from NatNet
+ * @param[in] in The received packet
+ * @param[in] len The length of the packet
+ * @param[in] now Reception time of the packet in seconds
+ * @return 0 when a frame of data is parsed, -1 otherwise
+ */
+int natnet_parse(const uint8_t *in, int len, double now)
+{
+  int i, j, k;
+  struct NatNetReader r = { in, in + len, FALSE };
   printf_natnet("Begin Packet\n-------\n");
 
   // Message ID
-  int MessageID = 0;
-  memcpy(&MessageID, ptr, 2); ptr += 2;
+  int MessageID = (uint16_t)natnet_short(&r);
   printf_natnet("Message ID : %d\n", MessageID);
 
   // Packet size
-  int nBytes = 0;
-  memcpy(&nBytes, ptr, 2); ptr += 2;
+  int nBytes = (uint16_t)natnet_short(&r);
   printf_natnet("Byte count : %d\n", nBytes);
 
-  if (MessageID == NAT_FRAMEOFDATA) {   // FRAME OF MOCAP DATA packet
-    // Frame number
-    int frameNumber = 0; memcpy(&frameNumber, ptr, 4); ptr += 4;
-    printf_natnet("Frame # : %d\n", frameNumber);
-
-    // ========== MARKERSETS ==========
-    // Number of data sets (markersets, rigidbodies, etc)
-    int nMarkerSets = 0; memcpy(&nMarkerSets, ptr, 4); ptr += 4;
-    printf_natnet("Marker Set Count : %d\n", nMarkerSets);
-
-    for (i = 0; i < nMarkerSets; i++) {
-      // Markerset name
-      char szName[256];
-      strcpy(szName, ptr);
-      int nDataBytes = (int) strlen(szName) + 1;
-      ptr += nDataBytes;
-      printf_natnet("Model Name: %s\n", szName);
-
-      // marker data
-      int nMarkers = 0; memcpy(&nMarkers, ptr, 4); ptr += 4;
-      printf_natnet("Marker Count : %d\n", nMarkers);
-
-      for (j = 0; j < nMarkers; j++) {
-        float x = 0; memcpy(&x, ptr, 4); ptr += 4;
-        float y = 0; memcpy(&y, ptr, 4); ptr += 4;
-        float z = 0; memcpy(&z, ptr, 4); ptr += 4;
-        printf_natnet("\tMarker %d : [x=%3.2f,y=%3.2f,z=%3.2f]\n", j, x, y, z);
-      }
-    }
-
-    // Unidentified markers
-    int nOtherMarkers = 0; memcpy(&nOtherMarkers, ptr, 4); ptr += 4;
-    printf_natnet("Unidentified Marker Count : %d\n", nOtherMarkers);
-    for (j = 0; j < nOtherMarkers; j++) {
-      float x = 0.0f; memcpy(&x, ptr, 4); ptr += 4;
-      float y = 0.0f; memcpy(&y, ptr, 4); ptr += 4;
-      float z = 0.0f; memcpy(&z, ptr, 4); ptr += 4;
-      printf_natnet("\tMarker %d : pos = [%3.2f,%3.2f,%3.2f]\n", j, x, y, z);
-    }
+  if (MessageID != NAT_FRAMEOFDATA) {
+    return -1;
+  }
 
-    // ========== RIGID BODIES ==========
-    // Rigid bodies
-    int nRigidBodies = 0;
-    memcpy(&nRigidBodies, ptr, 4); ptr += 4;
-    printf_natnet("Rigid Body Count : %d\n", nRigidBodies);
+  // FRAME OF MOCAP DATA packet
+  // Frame number
+  int frameNumber = natnet_int(&r);
+  printf_natnet("Frame # : %d\n", frameNumber);
+
+  // ========== MARKERSETS ==========
+  // Number of data sets (markersets, rigidbodies, etc)
+  int nMarkerSets = natnet_int(&r);
+  printf_natnet("Marker Set Count : %d\n", nMarkerSets);
+
+  for (i = 0; i < nMarkerSets && !r.error; i++) {
+    // Markerset name
+    const char *szName = natnet_string(&r);
+    printf_natnet("Model Name: %s\n", szName);
+
+    // marker data
+    int nMarkers = natnet_int(&r);
+    printf_natnet("Marker Count : %d\n", nMarkers);
+    const uint8_t *markerData = natnet_array(&r, nMarkers, 3 * sizeof(float));
+    natnet_print_markers(r.error ? 0 : nMarkers, markerData, NULL, NULL);
+  }
 
-    // Check if there ie enough space for the rigid bodies
-    if (nRigidBodies > MAX_RIGIDBODIES) {
-      fprintf(stderr,
-              "Could not sample all the rigid bodies because the amount of rigid bodies is bigger then %d (MAX_RIGIDBODIES).\r\n",
-              MAX_RIGIDBODIES);
-      exit(EXIT_FAILURE);
+  // Unidentified markers
+  int nOtherMarkers = natnet_int(&r);
+  printf_natnet("Unidentified Marker Count : %d\n", nOtherMarkers);
+  const uint8_t *otherMarkers = natnet_array(&r, nOtherMarkers, 3 * sizeof(float));
+  natnet_print_markers(r.error ? 0 : nOtherMarkers, otherMarkers, NULL, NULL);
+
+  // ========== RIGID BODIES ==========
+  // Rigid bodies
+  int nRigidBodies = natnet_int(&r);
+  printf_natnet("Rigid Body Count : %d\n", nRigidBodies);
+
+  for (j = 0; j < nRigidBodies && !r.error; j++) {
+    // rigid body pos/ori
+    int id = natnet_int(&r);
+    float y = natnet_float(&r);   //x --> Y
+    float z = natnet_float(&r);   //y --> Z
+    float x = natnet_float(&r);   //z --> X
+    float qx = natnet_float(&r);  //qx --> QX
+    float qz = natnet_float(&r);  //qy --> QZ
+    float qy = natnet_float(&r);  //qz --> QY
+    float qw = natnet_float(&r);  //qw --> QW
+    printf_natnet("ID (%d) : %d\n", j, id);
+    printf_natnet("pos: [%3.2f,%3.2f,%3.2f]\n", x, y, z);
+    printf_natnet("ori: [%3.2f,%3.2f,%3.2f,%3.2f]\n", qx, qy, qz, qw);
+
+    // Associated marker positions
+    int nMarkers = natnet_int(&r);
+    printf_natnet("Marker Count: %d\n", nMarkers);
+    const uint8_t *markerData = natnet_array(&r, nMarkers, 3 * sizeof(float));
+    const uint8_t *markerIDs = NULL, *markerSizes = NULL;
+
+    if (natnet_major >= 2) {
+      // Associated marker IDs and sizes
+      markerIDs = natnet_array(&r, nMarkers, sizeof(int32_t));
+      markerSizes = natnet_array(&r, nMarkers, sizeof(float));
     }
+    natnet_print_markers(r.error ? 0 : nMarkers, markerData, markerIDs, markerSizes);
 
-    for (j = 0; j < nRigidBodies; j++) {
-      // rigid body pos/ori
-      struct RigidBody old_rigid;
-      memcpy(&old_rigid, &rigidBodies[j], sizeof(struct RigidBody));
-
-      memcpy(&rigidBodies[j].id, ptr, 4); ptr += 4;
-      memcpy(&rigidBodies[j].y, ptr, 4); ptr += 4;   //x --> Y
-      memcpy(&rigidBodies[j].z, ptr, 4); ptr += 4;   //y --> Z
-      memcpy(&rigidBodies[j].x, ptr, 4); ptr += 4;   //z --> X
-      memcpy(&rigidBodies[j].qx, ptr, 4); ptr += 4;  //qx --> QX
-      memcpy(&rigidBodies[j].qz, ptr, 4); ptr += 4;  //qy --> QZ
-      memcpy(&rigidBodies[j].qy, ptr, 4); ptr += 4;  //qz --> QY
-      memcpy(&rigidBodies[j].qw, ptr, 4); ptr += 4;  //qw --> QW
-      printf_natnet("ID (%d) : %d\n", j, rigidBodies[j].id);
-      printf_natnet("pos: [%3.2f,%3.2f,%3.2f]\n", rigidBodies[j].x, rigidBodies[j].y, rigidBodies[j].z);
-      printf_natnet("ori: [%3.2f,%3.2f,%3.2f,%3.2f]\n", rigidBodies[j].qx, rigidBodies[j].qy, rigidBodies[j].qz,
-                    rigidBodies[j].qw);
-
-      // Differentiate the position to get the speed (TODO: crossreference with labeled markers for occlussion)
-      rigidBodies[j].totalVelocitySamples++;
-      if (old_rigid.x != rigidBodies[j].x || old_rigid.y != rigidBodies[j].y || old_rigid.z != rigidBodies[j].z
-          || old_rigid.qx != rigidBodies[j].qx || old_rigid.qy != rigidBodies[j].qy || old_rigid.qz != rigidBodies[j].qz
-          || old_rigid.qw != rigidBodies[j].qw) {
-
-        if (old_rigid.posSampled) {
-          rigidBodies[j].vel_x += (rigidBodies[j].x - old_rigid.x);
-          rigidBodies[j].vel_y += (rigidBodies[j].y - old_rigid.y);
-          rigidBodies[j].vel_z += (rigidBodies[j].z - old_rigid.z);
-          rigidBodies[j].nVelocitySamples++;
-        }
-
-        rigidBodies[j].nSamples++;
-        rigidBodies[j].posSampled = TRUE;
-      } else {
-        rigidBodies[j].posSampled = FALSE;
-      }
+    float error = 0.0f;
+    if (natnet_major >= 2) {
+      // Mean marker error
+      error = natnet_float(&r);
+      printf_natnet("Mean marker error: %3.8f\n", error);
+    }
 
-      // When marker id changed, reset the velocity
-      if (old_rigid.id != rigidBodies[j].id) {
-        rigidBodies[j].vel_x = 0;
-        rigidBodies[j].vel_y = 0;
-        rigidBodies[j].vel_z = 0;
-        rigidBodies[j].nSamples = 0;
-        rigidBodies[j].nVelocitySamples = 0;
-        rigidBodies[j].totalVelocitySamples = 0;
-        rigidBodies[j].posSampled = FALSE;
-      }
+    // 2.6 and later
+    if (((natnet_major == 2) && (natnet_minor >= 6)) || (natnet_major > 2) || (natnet_major == 0)) {
+      // params
+      natnet_short(&r);
+//           bool bTrackingValid = params & 0x01; // 0x01 : rigid body was successfully tracked in this frame
+    }
 
-      // Associated marker positions
-      memcpy(&rigidBodies[j].nMarkers, ptr, 4); ptr += 4;
-      printf_natnet("Marker Count: %d\n", rigidBodies[j].nMarkers);
-      int nBytes = rigidBodies[j].nMarkers * 3 * sizeof(float);
-      float *markerData = (float *)malloc(nBytes);
-      memcpy(markerData, ptr, nBytes);
-      ptr += nBytes;
-
-      if (natnet_major >= 2) {
-        // Associated marker IDs
-        nBytes = rigidBodies[j].nMarkers * sizeof(int);
-        int *markerIDs = (int *)malloc(nBytes);
-        memcpy(markerIDs, ptr, nBytes);
-        ptr += nBytes;
-
-        // Associated marker sizes
-        nBytes = rigidBodies[j].nMarkers * sizeof(float);
-        float *markerSizes = (float *)malloc(nBytes);
-        memcpy(markerSizes, ptr, nBytes);
-        ptr += nBytes;
-
-        for (k = 0; k < rigidBodies[j].nMarkers; k++) {
-          printf_natnet("\tMarker %d: id=%d\tsize=%3.1f\tpos=[%3.2f,%3.2f,%3.2f]\n", k, markerIDs[k], markerSizes[k],
-                        markerData[k * 3], markerData[k * 3 + 1], markerData[k * 3 + 2]);
+    // Only keep the rigid bodies we follow
+    struct Aircraft *ac = aircraft_of_rigid(id);
+    if (ac != NULL && !r.error) {
+      ac->rigid.nMarkers = nMarkers;
+      ac->rigid.error = error;
+      rigid_update(&ac->rigid, x, y, z, qx, qy, qz, qw, now);
+    }
+  } // next rigid body
+
+  // ========== SKELETONS ==========
+  // Skeletons (version 2.1 and later)
+  if (((natnet_major == 2) && (natnet_minor > 0)) || (natnet_major > 2)) {
+    int nSkeletons = natnet_int(&r);
+    printf_natnet("Skeleton Count : %d\n", nSkeletons);
+    for (j = 0; j < nSkeletons && !r.error; j++) {
+      // Skeleton id
+      int skeletonID = natnet_int(&r);
+      printf_natnet("Skeleton ID : %d\n", skeletonID);
+      // # of rigid bodies (bones) in skeleton
+      int nBones = natnet_int(&r);
+      printf_natnet("Rigid Body Count : %d\n", nBones);
+      for (k = 0; k < nBones && !r.error; k++) {
+        // Rigid body pos/ori
+        int ID = natnet_int(&r);
+        const uint8_t *pose = natnet_array(&r, 7, sizeof(float));
+        if (pose != NULL) {
+          printf_natnet("ID : %d\n", ID);
+          printf_natnet("pos: [%3.2f,%3.2f,%3.2f]\n", natnet_float_at(pose, 0), natnet_float_at(pose, 1),
+                        natnet_float_at(pose, 2));
+          printf_natnet("ori: [%3.2f,%3.2f,%3.2f,%3.2f]\n", natnet_float_at(pose, 3), natnet_float_at(pose, 4),
+                        natnet_float_at(pose, 5), natnet_float_at(pose, 6));
         }
 
-        if (markerIDs) {
-          free(markerIDs);
-        }
-        if (markerSizes) {
-          free(markerSizes);
+        // Associated marker positions, IDs and sizes
+        int nRigidMarkers = natnet_int(&r);
+        printf_natnet("Marker Count: %d\n", nRigidMarkers);
+        const uint8_t *markerData = natnet_array(&r, nRigidMarkers, 3 * sizeof(float));
+        const uint8_t *markerIDs = natnet_array(&r, nRigidMarkers, sizeof(int32_t));
+        const uint8_t *markerSizes = natnet_array(&r, nRigidMarkers, sizeof(float));
+        natnet_print_markers(r.error ? 0 : nRigidMarkers, markerData, markerIDs, markerSizes);
+
+        // Mean marker error (2.0 and later)
+        if (natnet_major >= 2) {
+          float fError = natnet_float(&r);
+          printf_natnet("Mean marker error: %3.2f\n", fError);
         }
 
-      } else {
-        for (k = 0; k < rigidBodies[j].nMarkers; k++) {
-          printf_natnet("\tMarker %d: pos = [%3.2f,%3.2f,%3.2f]\n", k, markerData[k * 3], markerData[k * 3 + 1],
-                        markerData[k * 3 + 2]);
+        // Tracking flags (2.6 and later)
+        if (((natnet_major == 2) && (natnet_minor >= 6)) || (natnet_major > 2) || (natnet_major == 0)) {
+          // params
+          natnet_short(&r);
+          //bool bTrackingValid = params & 0x01; // 0x01 : rigid body was successfully tracked in this frame
         }
-      }
-      if (markerData) {
-        free(markerData);
-      }
+      } // next rigid body
+    } // next skeleton
+  }
 
-      if (natnet_major >= 2) {
-        // Mean marker error
-        memcpy(&rigidBodies[j].error, ptr, 4); ptr += 4;
-        printf_natnet("Mean marker error: %3.8f\n", rigidBodies[j].error);
-      }
+  // ========== LABELED MARKERS ==========
+  // Labeled markers (version 2.3 and later)
+  if (((natnet_major == 2) && (natnet_minor >= 3)) || (natnet_major > 2)) {
+    int nLabeledMarkers = natnet_int(&r);
+    printf_natnet("Labeled Marker Count : %d\n", nLabeledMarkers);
+    for (j = 0; j < nLabeledMarkers && !r.error; j++) {
+      int ID = natnet_int(&r);
+      float x = natnet_float(&r);
+      float y = natnet_float(&r);
+      float z = natnet_float(&r);
+      float size = natnet_float(&r);
 
       // 2.6 and later
       if (((natnet_major == 2) && (natnet_minor >= 6)) || (natnet_major > 2) || (natnet_major == 0)) {
-        // params
-        short params = 0; memcpy(&params, ptr, 2); ptr += 2;
-//           bool bTrackingValid = params & 0x01; // 0x01 : rigid body was successfully tracked in this frame
+        // marker params
+        natnet_short(&r);
+        // bool bOccluded = params & 0x01;     // marker was not visible (occluded) in this frame
+        // bool bPCSolved = params & 0x02;     // position provided by point cloud solve
+        // bool bModelSolved = params & 0x04;  // position provided by model solve
       }
-    } // next rigid body
-
-    // ========== SKELETONS ==========
-    // Skeletons (version 2.1 and later)
-    if (((natnet_major == 2) && (natnet_minor > 0)) || (natnet_major > 2)) {
-      int nSkeletons = 0;
-      memcpy(&nSkeletons, ptr, 4); ptr += 4;
-      printf_natnet("Skeleton Count : %d\n", nSkeletons);
-      for (j = 0; j < nSkeletons; j++) {
-        // Skeleton id
-        int skeletonID = 0;
-        memcpy(&skeletonID, ptr, 4); ptr += 4;
-        // # of rigid bodies (bones) in skeleton
-        int nRigidBodies = 0;
-        memcpy(&nRigidBodies, ptr, 4); ptr += 4;
-        printf_natnet("Rigid Body Count : %d\n", nRigidBodies);
-        for (j = 0; j < nRigidBodies; j++) {
-          // Rigid body pos/ori
-          int ID = 0; memcpy(&ID, ptr, 4); ptr += 4;
-          float x = 0.0f; memcpy(&x, ptr, 4); ptr += 4;
-          float y = 0.0f; memcpy(&y, ptr, 4); ptr += 4;
-          float z = 0.0f; memcpy(&z, ptr, 4); ptr += 4;
-          float qx = 0; memcpy(&qx, ptr, 4); ptr += 4;
-          float qy = 0; memcpy(&qy, ptr, 4); ptr += 4;
-          float qz = 0; memcpy(&qz, ptr, 4); ptr += 4;
-          float qw = 0; memcpy(&qw, ptr, 4); ptr += 4;
-          printf_natnet("ID : %d\n", ID);
-          printf_natnet("pos: [%3.2f,%3.2f,%3.2f]\n", x, y, z);
-          printf_natnet("ori: [%3.2f,%3.2f,%3.2f,%3.2f]\n", qx, qy, qz, qw);
-
-          // Associated marker positions
-          int nRigidMarkers = 0;  memcpy(&nRigidMarkers, ptr, 4); ptr += 4;
-          printf_natnet("Marker Count: %d\n", nRigidMarkers);
-          int nBytes = nRigidMarkers * 3 * sizeof(float);
-          float *markerData = (float *)malloc(nBytes);
-          memcpy(markerData, ptr, nBytes);
-          ptr += nBytes;
-
-          // Associated marker IDs
-          nBytes = nRigidMarkers * sizeof(int);
-          int *markerIDs = (int *)malloc(nBytes);
-          memcpy(markerIDs, ptr, nBytes);
-          ptr += nBytes;
-
-          // Associated marker sizes
-          nBytes = nRigidMarkers * sizeof(float);
-          float *markerSizes = (float *)malloc(nBytes);
-          memcpy(markerSizes, ptr, nBytes);
-          ptr += nBytes;
-
-          for (k = 0; k < nRigidMarkers; k++) {
-            printf_natnet("\tMarker %d: id=%d\tsize=%3.1f\tpos=[%3.2f,%3.2f,%3.2f]\n", k, markerIDs[k], markerSizes[k],
-                          markerData[k * 3], markerData[k * 3 + 1], markerData[k * 3 + 2]);
-          }
-
-          // Mean marker error (2.0 and later)
-          if (natnet_major >= 2) {
-            float fError = 0.0f; memcpy(&fError, ptr, 4); ptr += 4;
-            printf_natnet("Mean marker error: %3.2f\n", fError);
-          }
-
-          // Tracking flags (2.6 and later)
-          if (((natnet_major == 2) && (natnet_minor >= 6)) || (natnet_major > 2) || (natnet_major == 0)) {
-            // params
-            short params = 0; memcpy(&params, ptr, 2); ptr += 2;
-            //bool bTrackingValid = params & 0x01; // 0x01 : rigid body was successfully tracked in this frame
-          }
-
-          // Release resources
-          if (markerIDs) {
-            free(markerIDs);
-          }
-          if (markerSizes) {
-            free(markerSizes);
-          }
-          if (markerData) {
-            free(markerData);
-          }
-        } // next rigid body
-      } // next skeleton
-    }
-
-    // ========== LABELED MARKERS ==========
-    // Labeled markers (version 2.3 and later)
-    if (((natnet_major == 2) && (natnet_minor >= 3)) || (natnet_major > 2)) {
-      int nLabeledMarkers = 0;
-      memcpy(&nLabeledMarkers, ptr, 4); ptr += 4;
-      printf_natnet("Labeled Marker Count : %d\n", nLabeledMarkers);
-      for (j = 0; j < nLabeledMarkers; j++) {
-        int ID = 0; memcpy(&ID, ptr, 4); ptr += 4;
-        float x = 0.0f; memcpy(&x, ptr, 4); ptr += 4;
-        float y = 0.0f; memcpy(&y, ptr, 4); ptr += 4;
-        float z = 0.0f; memcpy(&z, ptr, 4); ptr += 4;
-        float size = 0.0f; memcpy(&size, ptr, 4); ptr += 4;
-
-        // 2.6 and later
-        if (((natnet_major == 2) && (natnet_minor >= 6)) || (natnet_major > 2) || (natnet_major == 0)) {
-          // marker params
-          short params = 0; memcpy(&params, ptr, 2); ptr += 2;
-          // bool bOccluded = params & 0x01;     // marker was not visible (occluded) in this frame
-          // bool bPCSolved = params & 0x02;     // position provided by point cloud solve
-          // bool bModelSolved = params & 0x04;  // position provided by model solve
-        }
 
-        printf_natnet("ID  : %d\n", ID);
-        printf_natnet("pos : [%3.2f,%3.2f,%3.2f]\n", x, y, z);
-        printf_natnet("size: [%3.2f]\n", size);
-      }
+      printf_natnet("ID  : %d\n", ID);
+      printf_natnet("pos : [%3.2f,%3.2f,%3.2f]\n", x, y, z);
+      printf_natnet("size: [%3.2f]\n", size);
     }
+  }
 
-    // Force Plate data (version 2.9 and later)
-    if (((natnet_major == 2) && (natnet_minor >= 9)) || (natnet_major > 2)) {
-      int nForcePlates;
-      memcpy(&nForcePlates, ptr, 4); ptr += 4;
-      int iForcePlate;
-      for (iForcePlate = 0; iForcePlate < nForcePlates; iForcePlate++) {
-        // ID
-        int ID = 0; memcpy(&ID, ptr, 4); ptr += 4;
-        printf_natnet("Force Plate : %d\n", ID);
-
-        // Channel Count
-        int nChannels = 0; memcpy(&nChannels, ptr, 4); ptr += 4;
-
-        // Channel Data
-        for (i = 0; i < nChannels; i++) {
-          printf_natnet(" Channel %d : ", i);
-          int nFrames = 0; memcpy(&nFrames, ptr, 4); ptr += 4;
-          for (j = 0; j < nFrames; j++) {
-            float val = 0.0f;  memcpy(&val, ptr, 4); ptr += 4;
-            printf_natnet("%3.2f   ", val);
-          }
-          printf_natnet("\n");
+  // Force Plate data (version 2.9 and later)
+  if (((natnet_major == 2) && (natnet_minor >= 9)) || (natnet_major > 2)) {
+    int nForcePlates = natnet_int(&r);
+    int iForcePlate;
+    for (iForcePlate = 0; iForcePlate < nForcePlates && !r.error; iForcePlate++) {
+      // ID
+      int ID = natnet_int(&r);
+      printf_natnet("Force Plate : %d\n", ID);
+
+      // Channel Count
+      int nChannels = natnet_int(&r);
+
+      // Channel Data
+      for (i = 0; i < nChannels && !r.error; i++) {
+        printf_natnet(" Channel %d : ", i);
+        int nFrames = natnet_int(&r);
+        const uint8_t *values = natnet_array(&r, nFrames, sizeof(float));
+        for (j = 0; values != NULL && j < nFrames && verbose > 1; j++) {
+          printf_natnet("%3.2f   ", natnet_float_at(values, j));
         }
+        printf_natnet("\n");
       }
     }
+  }
 
-    // Latency
-    natnet_latency = 0.0f; memcpy(&natnet_latency, ptr, 4); ptr += 4;
-    printf_natnet("latency : %3.3f\n", natnet_latency);
-
-    // Timecode
-    unsigned int timecode = 0;  memcpy(&timecode, ptr, 4);  ptr += 4;
-    unsigned int timecodeSub = 0; memcpy(&timecodeSub, ptr, 4); ptr += 4;
-    printf_natnet("timecode : %d %d\n", timecode, timecodeSub);
+  // Latency
+  natnet_latency = natnet_float(&r);
+  printf_natnet("latency : %3.3f\n", natnet_latency);
+
+  // Timecode
+  unsigned int timecode = natnet_int(&r);
+  unsigned int timecodeSub = natnet_int(&r);
+  printf_natnet("timecode : %d %d\n", timecode, timecodeSub);
+
+  // timestamp
+  double timestamp = 0.0f;
+  // 2.7 and later - increased from single to double precision
+  if (((natnet_major == 2) && (natnet_minor >= 7)) || (natnet_major > 2)) {
+    timestamp = natnet_double(&r);
+  } else {
+    timestamp = (double)natnet_float(&r);
+  }
+  printf_natnet("timestamp : %f\n", timestamp);
 
-    // timestamp
-    double timestamp = 0.0f;
-    // 2.7 and later - increased from single to double precision
-    if (((natnet_major == 2) && (natnet_minor >= 7)) || (natnet_major > 2)) {
-      memcpy(&timestamp, ptr, 8); ptr += 8;
-    } else {
-      float fTemp = 0.0f;
-      memcpy(&fTemp, ptr, 4); ptr += 4;
-      timestamp = (double)fTemp;
-    }
+  // frame params
+  natnet_short(&r);
+  // bool bIsRecording = params & 0x01;                  // 0x01 Motive is recording
+  // bool bTrackedModelsChanged = params & 0x02;         // 0x02 Actively tracked model list has changed
 
-    // frame params
-    short params = 0;  memcpy(&params, ptr, 2); ptr += 2;
-    // bool bIsRecording = params & 0x01;                  // 0x01 Motive is recording
-    // bool bTrackedModelsChanged = params & 0x02;         // 0x02 Actively tracked model list has changed
+  // End of data tag
+  natnet_int(&r);
+  printf_natnet("End Packet\n-------------\n");
 
-    // End of data tag
-    int eod = 0; memcpy(&eod, ptr, 4); ptr += 4;
-    printf_natnet("End Packet\n-------------\n");
+  if (r.error) {
+    fprintf(stderr, "Truncated or malformed NatNet frame %d (%d bytes)\n", frameNumber, len);
+    return -1;
   }
+  return 0;
 }
 
-/** The transmitter periodic function */
-gboolean timeout_transmit_callback(gpointer data)
+/** Send a datalink message directly to an aircraft as a pprzlink frame */
+static void send_pprzlink(struct Aircraft *ac, uint8_t msg_id, const uint8_t *payload, uint8_t len)
 {
+  uint8_t frame[255];
+  uint8_t ck_a, ck_b;
   int i;
 
-  // Loop trough all the available rigidbodies (TODO: optimize)
-  for (i = 0; i < MAX_RIGIDBODIES; i++) {
-    // Check if ID's are correct
-    if (rigidBodies[i].id >= MAX_RIGIDBODIES) {
-      fprintf(stderr,
-              "Could not parse rigid body %d from NatNet, because ID is higher then or equal to %d (MAX_RIGIDBODIES-1).\r\n",
-              rigidBodies[i].id, MAX_RIGIDBODIES - 1);
-      exit(EXIT_FAILURE);
-    }
+  frame[0] = PPRZ_STX;
+  frame[1] = len + 8;                 // STX, length, sender, receiver, class, message ID and checksums
+  frame[2] = 0;                       // sender: ground
+  frame[3] = ac->ac_id;               // receiver
+  frame[4] = PPRZ_DATALINK_CLASS_ID;  // component 0 and class
+  frame[5] = msg_id;
+  memcpy(&frame[6], payload, len);
+  ck_a = ck_b = frame[1];
+  for (i = 2; i < len + 6; i++) {
+    ck_a += frame[i];
+    ck_b += ck_a;
+  }
+  frame[len + 6] = ck_a;
+  frame[len + 7] = ck_b;
+  udp_socket_send_dontwait(&ac->udp, frame, len + 8);
+}
 
-    // Check if we want to transmit (follow) this rigid
-    if (aircrafts[rigidBodies[i].id].ac_id == 0) {
-      continue;
-    }
-
-    // When we don't track anymore and timeout or start tracking
-    if (rigidBodies[i].nSamples < 1
-        && aircrafts[rigidBodies[i].id].connected
-        && (natnet_latency - aircrafts[rigidBodies[i].id].lastSample) > CONNECTION_TIMEOUT) {
-      aircrafts[rigidBodies[i].id].connected = FALSE;
-      fprintf(stderr, "#error Lost tracking rigid id %d, aircraft id %d.\n",
-              rigidBodies[i].id, aircrafts[rigidBodies[i].id].ac_id);
-    } else if (rigidBodies[i].nSamples > 0 && !aircrafts[rigidBodies[i].id].connected) {
-      fprintf(stderr, "#pragma message: Now tracking rigid id %d, aircraft id %d.\n",
-              rigidBodies[i].id, aircrafts[rigidBodies[i].id].ac_id);
-    }
-
-    // Check if we still track the rigid
-    if (rigidBodies[i].nSamples < 1) {
-      continue;
-    }
-
-    // Update the last tracked
-    aircrafts[rigidBodies[i].id].connected = TRUE;
-    aircrafts[rigidBodies[i].id].lastSample = natnet_latency;
-
-    // Defines to make easy use of paparazzi math
-    struct EnuCoor_d pos, speed;
-    struct EcefCoor_d ecef_pos;
-    struct LlaCoor_d lla_pos;
-    struct DoubleQuat orient;
-    struct DoubleEulers orient_eulers;
-
-    // Add the Optitrack angle to the x and y positions
-    pos.x = cos(tracking_offset_angle) * rigidBodies[i].x - sin(tracking_offset_angle) * rigidBodies[i].y;
-    pos.y = sin(tracking_offset_angle) * rigidBodies[i].x + cos(tracking_offset_angle) * rigidBodies[i].y;
-    pos.z = rigidBodies[i].z;
-
-    // Convert the position to ecef and lla based on the Optitrack LTP
-    ecef_of_enu_point_d(&ecef_pos , &tracking_ltp , &pos);
-    lla_of_ecef_d(&lla_pos, &ecef_pos);
-
-    // Check if we have enough samples to estimate the velocity
-    rigidBodies[i].nVelocityTransmit++;
-    if (rigidBodies[i].nVelocitySamples >= min_velocity_samples) {
-      // Calculate the derevative of the sum to get the correct velocity     (1 / freq_transmit) * (samples / total_samples)
-      double sample_time = //((double)rigidBodies[i].nVelocitySamples / (double)rigidBodies[i].totalVelocitySamples) /
-        ((double)rigidBodies[i].nVelocityTransmit / (double)freq_transmit);
-      rigidBodies[i].vel_x = rigidBodies[i].vel_x / sample_time;
-      rigidBodies[i].vel_y = rigidBodies[i].vel_y / sample_time;
-      rigidBodies[i].vel_z = rigidBodies[i].vel_z / sample_time;
-
-      // Add the Optitrack angle to the x and y velocities
-      speed.x = cos(tracking_offset_angle) * rigidBodies[i].vel_x - sin(tracking_offset_angle) * rigidBodies[i].vel_y;
-      speed.y = sin(tracking_offset_angle) * rigidBodies[i].vel_x + cos(tracking_offset_angle) * rigidBodies[i].vel_y;
-      speed.z = rigidBodies[i].vel_z;
-
-      // Conver the speed to ecef based on the Optitrack LTP
-      ecef_of_enu_vect_d(&rigidBodies[i].ecef_vel , &tracking_ltp , &speed);
-    }
-
-    // Copy the quaternions and convert to euler angles for the heading
-    orient.qi = rigidBodies[i].qw;
-    orient.qx = rigidBodies[i].qx;
-    orient.qy = rigidBodies[i].qy;
-    orient.qz = rigidBodies[i].qz;
-    double_eulers_of_quat(&orient_eulers, &orient);
-
-    // Calculate the heading by adding the Natnet offset angle and normalizing it
-    double heading = -orient_eulers.psi + 90.0 / 57.6 -
-                     tracking_offset_angle; //the optitrack axes are 90 degrees rotated wrt ENU
-    NormRadAngle(heading);
-
-    printf_debug("[%d -> %d]Samples: %d\t%d\t\tTiming: %3.3f latency\n", rigidBodies[i].id,
-                 aircrafts[rigidBodies[i].id].ac_id
-                 , rigidBodies[i].nSamples, rigidBodies[i].nVelocitySamples, natnet_latency);
-    printf_debug("    Heading: %f\t\tPosition: %f\t%f\t%f\t\tVelocity: %f\t%f\t%f\n", DegOfRad(heading),
-                 rigidBodies[i].x, rigidBodies[i].y, rigidBodies[i].z,
-                 rigidBodies[i].ecef_vel.x, rigidBodies[i].ecef_vel.y, rigidBodies[i].ecef_vel.z);
-
-
-    /* Construct time of time of week (tow) */
-    struct timeval now;
-    gettimeofday(&now, NULL);
-    struct tm *ts = localtime(&now.tv_sec);
-
-    uint32_t tow = ts->tm_wday * (24 * 60 * 60 * 1000) + ts->tm_hour * (60 * 60 * 1000) + ts->tm_min *
-                   (60 * 1000) + ts->tm_sec * 1000 + now.tv_usec / 1000 ;
-
-    // Transmit the REMOTE_GPS packet on the ivy bus (either small or big)
-    if (small_packets) {
-      /* The local position is an int32 and the 11 LSBs of the (signed) x and y axis are compressed into
-       * a single integer. The z axis is considered unsigned and only the latter 10 LSBs are
-       * used.
-       */
-
-      uint32_t pos_xyz = 0;
-      // check if position within limits
-      if (fabs(pos.x * 100.) < pow(2, 10)) {
-        pos_xyz = (((uint32_t)(pos.x * 100.0)) & 0x7FF) << 21;                     // bits 31-21 x position in cm
-      } else {
-        fprintf(stderr, "Warning!! X position out of maximum range of small message (±%.2fm): %.2f", pow(2, 10) / 100, pos.x);
-        pos_xyz = (((uint32_t)(pow(2, 10) * pos.x / fabs(pos.x))) & 0x7FF) << 21;  // bits 31-21 x position in cm
-      }
+#define PutField(_buf, _pos, _v) { memcpy(&(_buf)[_pos], &(_v), sizeof(_v)); (_pos) += sizeof(_v); }
 
-      if (fabs(pos.y * 100.) < pow(2, 10)) {
-        pos_xyz |= (((uint32_t)(pos.y * 100.0)) & 0x7FF) << 10;                    // bits 20-10 y position in cm
-      } else {
-        fprintf(stderr, "Warning!! Y position out of maximum range of small message (±%.2fm): %.2f", pow(2, 10) / 100, pos.y);
-        pos_xyz |= (((uint32_t)(pow(2, 10) * pos.y / fabs(pos.y))) & 0x7FF) << 10; // bits 20-10 y position in cm
-      }
+/** Check the connection of an aircraft, TRUE when it has new samples */
+static bool check_tracking(struct Aircraft *ac, double now)
+{
+  struct RigidBody *rb = &ac->rigid;
+
+  // When we don't track anymore and timeout or start tracking
+  if (rb->nSamples < 1 && ac->connected && (now - ac->lastSample) > CONNECTION_TIMEOUT) {
+    ac->connected = FALSE;
+    fprintf(stderr, "#error Lost tracking rigid id %d, aircraft id %d.\n", rb->id, ac->ac_id);
+  } else if (rb->nSamples > 0 && !ac->connected) {
+    fprintf(stderr, "#pragma message: Now tracking rigid id %d, aircraft id %d.\n", rb->id, ac->ac_id);
+  }
 
-      if (pos.z * 100. < pow(2, 10) && pos.z > 0.) {
-        pos_xyz |= (((uint32_t)(fabs(pos.z) * 100.0)) & 0x3FF);                          // bits 9-0 z position in cm
-      } else if (pos.z > 0.) {
-        fprintf(stderr, "Warning!! Z position out of maximum range of small message (%.2fm): %.2f", pow(2, 10) / 100, pos.z);
-        pos_xyz |= (((uint32_t)(pow(2, 10))) & 0x3FF);                             // bits 9-0 z position in cm
-      }
-      // printf("ENU Pos: %u (%.2f, %.2f, %.2f)\n", pos_xyz, pos.x, pos.y, pos.z);
-
-      /* The speed is an int32 and the 11 LSBs of the x and y axis and 10 LSBs of z (all signed) are compressed into
-       * a single integer.
-       */
-      uint32_t speed_xyz = 0;
-      // check if speed within limits
-      if (fabs(speed.x * 100) < pow(2, 10)) {
-        speed_xyz = (((uint32_t)(speed.x * 100.0)) & 0x7FF) << 21;                       // bits 31-21 speed x in cm/s
-      } else {
-        fprintf(stderr, "Warning!! X Speed out of maximum range of small message (±%.2fm/s): %.2f", pow(2, 10) / 100, speed.x);
-        speed_xyz = (((uint32_t)(pow(2, 10) * speed.x / fabs(speed.x))) & 0x7FF) << 21;  // bits 31-21 speed x in cm/s
-      }
+  // Check if we still track the rigid
+  if (rb->nSamples < 1) {
+    return FALSE;
+  }
 
-      if (fabs(speed.y * 100) < pow(2, 10)) {
-        speed_xyz |= (((uint32_t)(speed.y * 100.0)) & 0x7FF) << 10;                      // bits 20-10 speed y in cm/s
-      } else {
-        fprintf(stderr, "Warning!! Y Speed out of maximum range of small message (±%.2fm/s): %.2f", pow(2, 10) / 100, speed.y);
-        speed_xyz |= (((uint32_t)(pow(2, 10) * speed.y / fabs(speed.y))) & 0x7FF) << 10; // bits 20-10 speed y in cm/s
-      }
+  // Update the last tracked
+  ac->connected = TRUE;
+  ac->lastSample = now;
+  return TRUE;
+}
 
-      if (fabs(speed.z * 100) < pow(2, 9)) {
-        speed_xyz |= (((uint32_t)(speed.z * 100.0)) & 0x3FF);                            // bits 9-0 speed z in cm/s
-      } else {
-        fprintf(stderr, "Warning!! Z Speed out of maximum range of small message (±%.2fm/s): %.2f", pow(2, 9) / 100, speed.z);
-        speed_xyz |= (((uint32_t)(pow(2, 9) * speed.z / fabs(speed.z))) & 0x3FF);       // bits 9-0 speed z in cm/s
-      }
+/** Transmit the position of an aircraft */
+static void transmit_aircraft(struct Aircraft *ac, double now)
+{
+  struct RigidBody *rb = &ac->rigid;
+
+  if (!check_tracking(ac, now)) {
+    return;
+  }
+
+  // Defines to make easy use of paparazzi math
+  struct EnuCoor_d pos, speed = { 0., 0., 0. };
+  struct EcefCoor_d ecef_pos;
+  struct LlaCoor_d lla_pos;
+  struct DoubleQuat orient;
+  struct DoubleEulers orient_eulers;
+
+  // Add the Optitrack angle to the x and y positions
+  pos.x = cos(tracking_offset_angle) * rb->x - sin(tracking_offset_angle) * rb->y;
+  pos.y = sin(tracking_offset_angle) * rb->x + cos(tracking_offset_angle) * rb->y;
+  pos.z = rb->z;
+
+  // Convert the position to ecef and lla based on the Optitrack LTP
+  ecef_of_enu_point_d(&ecef_pos , &tracking_ltp , &pos);
+  lla_of_ecef_d(&lla_pos, &ecef_pos);
+
+  // Check if we have enough samples to estimate the velocity
+  if (rb->nVelocitySamples >= min_velocity_samples && rb->sampleTime > rb->velTime) {
+    // Calculate the derevative of the sum over the time between the samples
+    double sample_time = rb->sampleTime - rb->velTime;
+    rb->vel_x = rb->vel_x / sample_time;
+    rb->vel_y = rb->vel_y / sample_time;
+    rb->vel_z = rb->vel_z / sample_time;
+
+    // Add the Optitrack angle to the x and y velocities
+    speed.x = cos(tracking_offset_angle) * rb->vel_x - sin(tracking_offset_angle) * rb->vel_y;
+    speed.y = sin(tracking_offset_angle) * rb->vel_x + cos(tracking_offset_angle) * rb->vel_y;
+    speed.z = rb->vel_z;
+
+    // Conver the speed to ecef based on the Optitrack LTP
+    ecef_of_enu_vect_d(&rb->ecef_vel , &tracking_ltp , &speed);
+  }
 
-      /* The gps_small msg should always be less than 20 bytes including the pprz header of 6 bytes
-       * This is primarily due to the maximum packet size of the bluetooth msgs of 19 bytes
-       * increases the probability that a complete message will be accepted
-       */
+  // Copy the quaternions and convert to euler angles for the heading
+  orient.qi = rb->qw;
+  orient.qx = rb->qx;
+  orient.qy = rb->qy;
+  orient.qz = rb->qz;
+  double_eulers_of_quat(&orient_eulers, &orient);
+
+  // Calculate the heading by adding the Natnet offset angle and normalizing it
+  double heading = -orient_eulers.psi + 90.0 / 57.6 -
+                   tracking_offset_angle; //the optitrack axes are 90 degrees rotated wrt ENU
+  NormRadAngle(heading);
+
+  printf_debug("[%d -> %d]Samples: %d\t%d\t\tTiming: %3.3f latency\n", rb->id, ac->ac_id,
+               rb->nSamples, rb->nVelocitySamples, natnet_latency);
+  printf_debug("    Heading: %f\t\tPosition: %f\t%f\t%f\t\tVelocity: %f\t%f\t%f\n", DegOfRad(heading),
+               rb->x, rb->y, rb->z, rb->ecef_vel.x, rb->ecef_vel.y, rb->ecef_vel.z);
+
+
+  /* Construct time of time of week (tow) */
+  struct timeval tv_now;
+  gettimeofday(&tv_now, NULL);
+  struct tm *ts = localtime(&tv_now.tv_sec);
+
+  uint32_t tow = ts->tm_wday * (24 * 60 * 60 * 1000) + ts->tm_hour * (60 * 60 * 1000) + ts->tm_min *
+                 (60 * 1000) + ts->tm_sec * 1000 + tv_now.tv_usec / 1000 ;
+
+  // Transmit the REMOTE_GPS packet on the ivy bus or to the aircraft (either small or big)
+  if (small_packets) {
+    /* The local position is an int32 and the 11 LSBs of the (signed) x and y axis are compressed into
+     * a single integer. The z axis is considered unsigned and only the latter 10 LSBs are
+     * used.
+     */
+
+    uint32_t pos_xyz = 0;
+    // check if position within limits
+    if (fabs(pos.x * 100.) < pow(2, 10)) {
+      pos_xyz = (((uint32_t)(pos.x * 100.0)) & 0x7FF) << 21;                     // bits 31-21 x position in cm
+    } else {
+      fprintf(stderr, "Warning!! X position out of maximum range of small message (±%.2fm): %.2f", pow(2, 10) / 100, pos.x);
+      pos_xyz = (((uint32_t)(pow(2, 10) * pos.x / fabs(pos.x))) & 0x7FF) << 21;  // bits 31-21 x position in cm
+    }
+
+    if (fabs(pos.y * 100.) < pow(2, 10)) {
+      pos_xyz |= (((uint32_t)(pos.y * 100.0)) & 0x7FF) << 10;                    // bits 20-10 y position in cm
+    } else {
+      fprintf(stderr, "Warning!! Y position out of maximum range of small message (±%.2fm): %.2f", pow(2, 10) / 100, pos.y);
+      pos_xyz |= (((uint32_t)(pow(2, 10) * pos.y / fabs(pos.y))) & 0x7FF) << 10; // bits 20-10 y position in cm
+    }
+
+    if (pos.z * 100. < pow(2, 10) && pos.z > 0.) {
+      pos_xyz |= (((uint32_t)(fabs(pos.z) * 100.0)) & 0x3FF);                          // bits 9-0 z position in cm
+    } else if (pos.z > 0.) {
+      fprintf(stderr, "Warning!! Z position out of maximum range of small message (%.2fm): %.2f", pow(2, 10) / 100, pos.z);
+      pos_xyz |= (((uint32_t)(pow(2, 10))) & 0x3FF);                             // bits 9-0 z position in cm
+    }
+    // printf("ENU Pos: %u (%.2f, %.2f, %.2f)\n", pos_xyz, pos.x, pos.y, pos.z);
+
+    /* The speed is an int32 and the 11 LSBs of the x and y axis and 10 LSBs of z (all signed) are compressed into
+     * a single integer.
+     */
+    uint32_t speed_xyz = 0;
+    // check if speed within limits
+    if (fabs(speed.x * 100) < pow(2, 10)) {
+      speed_xyz = (((uint32_t)(speed.x * 100.0)) & 0x7FF) << 21;                       // bits 31-21 speed x in cm/s
+    } else {
+      fprintf(stderr, "Warning!! X Speed out of maximum range of small message (±%.2fm/s): %.2f", pow(2, 10) / 100, speed.x);
+      speed_xyz = (((uint32_t)(pow(2, 10) * speed.x / fabs(speed.x))) & 0x7FF) << 21;  // bits 31-21 speed x in cm/s
+    }
+
+    if (fabs(speed.y * 100) < pow(2, 10)) {
+      speed_xyz |= (((uint32_t)(speed.y * 100.0)) & 0x7FF) << 10;                      // bits 20-10 speed y in cm/s
+    } else {
+      fprintf(stderr, "Warning!! Y Speed out of maximum range of small message (±%.2fm/s): %.2f", pow(2, 10) / 100, speed.y);
+      speed_xyz |= (((uint32_t)(pow(2, 10) * speed.y / fabs(speed.y))) & 0x7FF) << 10; // bits 20-10 speed y in cm/s
+    }
+
+    if (fabs(speed.z * 100) < pow(2, 9)) {
+      speed_xyz |= (((uint32_t)(speed.z * 100.0)) & 0x3FF);                            // bits 9-0 speed z in cm/s
+    } else {
+      fprintf(stderr, "Warning!! Z Speed out of maximum range of small message (±%.2fm/s): %.2f", pow(2, 9) / 100, speed.z);
+      speed_xyz |= (((uint32_t)(pow(2, 9) * speed.z / fabs(speed.z))) & 0x3FF);       // bits 9-0 speed z in cm/s
+    }
+
+    /* The gps_small msg should always be less than 20 bytes including the pprz header of 6 bytes
+     * This is primarily due to the maximum packet size of the bluetooth msgs of 19 bytes
+     * increases the probability that a complete message will be accepted
+     */
+    int16_t heading_small = (int16_t)(heading * 10000);     // int16_t heading in rad*1e4 (2 bytes)
+    if (ac->udp_output) {
+      uint8_t buf[15];
+      int n = 0;
+      PutField(buf, n, heading_small);
+      PutField(buf, n, pos_xyz);
+      PutField(buf, n, speed_xyz);
+      PutField(buf, n, tow);
+      PutField(buf, n, ac->ac_id);
+      send_pprzlink(ac, PPRZ_REMOTE_GPS_SMALL_ID, buf, n);
+    } else {
       IvySendMsg("0 REMOTE_GPS_SMALL %d %d %d %d %d",
-                 (int16_t)(heading * 10000),       // int16_t heading in rad*1e4 (2 bytes)
+                 heading_small,                    // int16_t heading in rad*1e4 (2 bytes)
                  pos_xyz,                          // uint32 ENU X, Y and Z in CM (4 bytes)
                  speed_xyz,                        // uint32 ENU velocity X, Y, Z in cm/s (4 bytes)
                  tow,                              // uint32_t time of day
-                 aircrafts[rigidBodies[i].id].ac_id); // uint8 rigid body ID (1 byte)
+                 ac->ac_id);                       // uint8 rigid body ID (1 byte)
+    }
 
+  } else {
+    int32_t fields[12] = {
+      (int32_t)(ecef_pos.x * 100.0),              //int32 ECEF X in CM
+      (int32_t)(ecef_pos.y * 100.0),              //int32 ECEF Y in CM
+      (int32_t)(ecef_pos.z * 100.0),              //int32 ECEF Z in CM
+      (int32_t)(DegOfRad(lla_pos.lat) * 10000000.0),        //int32 LLA latitude in deg*1e7
+      (int32_t)(DegOfRad(lla_pos.lon) * 10000000.0),        //int32 LLA longitude in deg*1e7
+      (int32_t)(lla_pos.alt * 1000.0),            //int32 LLA altitude in mm above elipsoid
+      (int32_t)(rb->z * 1000.0),                  //int32 HMSL height above mean sea level in mm
+      (int32_t)(rb->ecef_vel.x * 100.0),          //int32 ECEF velocity X in cm/s
+      (int32_t)(rb->ecef_vel.y * 100.0),          //int32 ECEF velocity Y in cm/s
+      (int32_t)(rb->ecef_vel.z * 100.0),          //int32 ECEF velocity Z in cm/s
+      (int32_t)tow,
+      (int32_t)(heading * 10000000.0)             //int32 Course in rad*1e7
+    };
+    if (ac->udp_output) {
+      uint8_t buf[2 + sizeof(fields)];
+      uint8_t numsv = rb->nMarkers;               //uint8 Number of markers (sv_num)
+      int n = 0;
+      PutField(buf, n, ac->ac_id);
+      PutField(buf, n, numsv);
+      memcpy(&buf[n], fields, sizeof(fields));
+      send_pprzlink(ac, PPRZ_REMOTE_GPS_ID, buf, sizeof(buf));
     } else {
-      IvySendMsg("0 REMOTE_GPS %d %d %d %d %d %d %d %d %d %d %d %d %d %d", aircrafts[rigidBodies[i].id].ac_id,
-                 rigidBodies[i].nMarkers,                //uint8 Number of markers (sv_num)
-                 (int)(ecef_pos.x * 100.0),              //int32 ECEF X in CM
-                 (int)(ecef_pos.y * 100.0),              //int32 ECEF Y in CM
-                 (int)(ecef_pos.z * 100.0),              //int32 ECEF Z in CM
-                 (int)(DegOfRad(lla_pos.lat) * 10000000.0),        //int32 LLA latitude in deg*1e7
-                 (int)(DegOfRad(lla_pos.lon) * 10000000.0),        //int32 LLA longitude in deg*1e7
-                 (int)(lla_pos.alt * 1000.0),            //int32 LLA altitude in mm above elipsoid
-                 (int)(rigidBodies[i].z * 1000.0),       //int32 HMSL height above mean sea level in mm
-                 (int)(rigidBodies[i].ecef_vel.x * 100.0), //int32 ECEF velocity X in cm/s
-                 (int)(rigidBodies[i].ecef_vel.y * 100.0), //int32 ECEF velocity Y in cm/s
-                 (int)(rigidBodies[i].ecef_vel.z * 100.0), //int32 ECEF velocity Z in cm/s
-                 tow,
-                 (int)(heading * 10000000.0));           //int32 Course in rad*1e7
-    }
-    if (must_log) {
-      if (log_exists == 0) {
-        fp = fopen(nameOfLogfile, "w");
-        log_exists = 1;
-      }
-
-      if (fp == NULL) {
-        printf("I couldn't open file for writing.\n");
-        exit(0);
-      } else {
-        struct timeval cur_time;
-        gettimeofday(&cur_time, NULL);
-        fprintf(fp, "%d %d %d %d %d %d %d %d %d %d %d %d %d %d %d\n", aircrafts[rigidBodies[i].id].ac_id,
-                rigidBodies[i].nMarkers,                //uint8 Number of markers (sv_num)
-                (int)(ecef_pos.x * 100.0),              //int32 ECEF X in CM
-                (int)(ecef_pos.y * 100.0),              //int32 ECEF Y in CM
-                (int)(ecef_pos.z * 100.0),              //int32 ECEF Z in CM
-                (int)(DegOfRad(lla_pos.lat) * 1e7),     //int32 LLA latitude in deg*1e7
-                (int)(DegOfRad(lla_pos.lon) * 1e7),     //int32 LLA longitude in deg*1e7
-                (int)(lla_pos.alt * 1000.0),            //int32 LLA altitude in mm above elipsoid
-                (int)(rigidBodies[i].z * 1000.0),       //int32 HMSL height above mean sea level in mm
-                (int)(rigidBodies[i].ecef_vel.x * 100.0), //int32 ECEF velocity X in cm/s
-                (int)(rigidBodies[i].ecef_vel.y * 100.0), //int32 ECEF velocity Y in cm/s
-                (int)(rigidBodies[i].ecef_vel.z * 100.0), //int32 ECEF velocity Z in cm/s
-                (int)(heading * 10000000.0),            //int32 Course in rad*1e7
-                (int)cur_time.tv_sec,
-                (int)cur_time.tv_usec);
-      }
+      IvySendMsg("0 REMOTE_GPS %d %d %d %d %d %d %d %d %d %d %d %d %u %d", ac->ac_id,
+                 rb->nMarkers,                    //uint8 Number of markers (sv_num)
+                 fields[0], fields[1], fields[2], fields[3], fields[4], fields[5],
+                 fields[6], fields[7], fields[8], fields[9], tow, fields[11]);
+    }
+  }
+  if (must_log) {
+    if (log_exists == 0) {
+      fp = fopen(nameOfLogfile, "w");
+      log_exists = 1;
     }
 
+    if (fp == NULL) {
+      printf("I couldn't open file for writing.\n");
+      exit(0);
+    } else {
+      struct timeval cur_time;
+      gettimeofday(&cur_time, NULL);
+      fprintf(fp, "%d %d %d %d %d %d %d %d %d %d %d %d %d %d %d\n", ac->ac_id,
+              rb->nMarkers,                           //uint8 Number of markers (sv_num)
+              (int)(ecef_pos.x * 100.0),              //int32 ECEF X in CM
+              (int)(ecef_pos.y * 100.0),              //int32 ECEF Y in CM
+              (int)(ecef_pos.z * 100.0),              //int32 ECEF Z in CM
+              (int)(DegOfRad(lla_pos.lat) * 1e7),     //int32 LLA latitude in deg*1e7
+              (int)(DegOfRad(lla_pos.lon) * 1e7),     //int32 LLA longitude in deg*1e7
+              (int)(lla_pos.alt * 1000.0),            //int32 LLA altitude in mm above elipsoid
+              (int)(rb->z * 1000.0),                  //int32 HMSL height above mean sea level in mm
+              (int)(rb->ecef_vel.x * 100.0),          //int32 ECEF velocity X in cm/s
+              (int)(rb->ecef_vel.y * 100.0),          //int32 ECEF velocity Y in cm/s
+              (int)(rb->ecef_vel.z * 100.0),          //int32 ECEF velocity Z in cm/s
+              (int)(heading * 10000000.0),            //int32 Course in rad*1e7
+              (int)cur_time.tv_sec,
+              (int)cur_time.tv_usec);
+    }
+  }
 
+  // Reset the velocity differentiator if we calculated the velocity
+  if (rb->nVelocitySamples >= min_velocity_samples) {
+    rb->vel_x = 0;
+    rb->vel_y = 0;
+    rb->vel_z = 0;
+    rb->nVelocitySamples = 0;
+  }
 
+  rb->nSamples = 0;
+}
 
+/** Transmit all the aircraft when a frame arrives, at most at freq_transmit */
+static void transmit(double now)
+{
+  int i;
 
-    // Reset the velocity differentiator if we calculated the velocity
-    if (rigidBodies[i].nVelocitySamples >= min_velocity_samples) {
-      rigidBodies[i].vel_x = 0;
-      rigidBodies[i].vel_y = 0;
-      rigidBodies[i].vel_z = 0;
-      rigidBodies[i].nVelocitySamples = 0;
-      rigidBodies[i].totalVelocitySamples = 0;
-      rigidBodies[i].nVelocityTransmit = 0;
+  if (freq_transmit > 0) {
+    if (now < next_transmit) {
+      return;
     }
+    // Keep the rate when frames arrive a bit early, restart after a gap
+    next_transmit += 1.0 / freq_transmit;
+    if (next_transmit < now) {
+      next_transmit = now + 1.0 / freq_transmit;
+    }
+  }
 
-    rigidBodies[i].nSamples = 0;
+  for (i = 0; i < nb_aircrafts; i++) {
+    transmit_aircraft(&aircrafts[i], now);
   }
+}
 
+/** Detect lost tracking when no frames arrive anymore */
+gboolean timeout_tracking_callback(gpointer data)
+{
+  int i;
+  double now = get_time();
+
+  for (i = 0; i < nb_aircrafts; i++) {
+    check_tracking(&aircrafts[i], now);
+  }
   return TRUE;
 }
 
-/** The NatNet sampler periodic function */
+/** The NatNet sampler function, transmitting as soon as a frame is parsed */
 static gboolean sample_data(GIOChannel *chan, GIOCondition cond, gpointer data)
 {
   static unsigned char buffer_data[MAX_PACKETSIZE];
-  static int bytes_data = 0;
 
-  // Keep on reading until we have the whole packet
-  bytes_data += udp_socket_recv(&natnet_data, buffer_data, MAX_PACKETSIZE);
+  // One datagram is one packet
+  int bytes_data = udp_socket_recv(&natnet_data, buffer_data, MAX_PACKETSIZE);
+  double now = get_time();
 
   // Parse NatNet data
-  if (bytes_data >= 2) {
-    uint16_t packet_size = ((uint16_t)buffer_data[3])<<8 | (uint16_t)buffer_data[2];
-    if( bytes_data - 4 >= packet_size) {  // 4 bytes for message id and packet size
-      natnet_parse(buffer_data);
+  if (bytes_data >= 4) {
+    uint16_t packet_size = ((uint16_t)buffer_data[3]) << 8 | (uint16_t)buffer_data[2];
+    if (bytes_data - 4 >= packet_size) {  // 4 bytes for message id and packet size
+      if (natnet_parse(buffer_data, packet_size + 4, now) == 0) {
+        transmit(now);
+      }
     }
-    bytes_data = 0;
   }
 
   return TRUE;
@@ -744,7 +905,9 @@ void print_help(char *filename)
     "   -h, --help                Display this help\n"
     "   -v, --verbose <level>     Verbosity level 0-2 (0)\n\n"
 
-    "   -ac <rigid_id> <ac_id>    Use rigid ID for GPS of ac_id (multiple possible)\n\n"
+    "   -ac <rigid_id> <ac_id>    Use rigid ID for GPS of ac_id (multiple possible)\n"
+    "   -ac_udp <rigid_id> <ac_id> <ip> <port>\n"
+    "                             Same, sending pprzlink frames directly to the aircraft over UDP instead of Ivy\n\n"
     "   -log <name of file>         Log to a file\n\n"
     "   -multicast_addr <ip>      NatNet server multicast address (239.255.42.99)\n"
     "   -server <ip>              NatNet server IP address (255.255.255.255)\n"
@@ -756,7 +919,7 @@ void print_help(char *filename)
     "   -lla <lat> <lon> <alt>    Latitude, longitude and altitude of the tracking system\n"
     "   -offset_angle <degree>    Tracking system angle offset compared to the North in degrees\n\n"
 
-    "   -tf <freq>                Transmit frequency to the ivy bus in hertz (60)\n"
+    "   -tf <freq>                Maximum transmit frequency in hertz, 0 to transmit every frame (30)\n"
     "   -vel_samples <samples>    Minimum amount of samples for the velocity differentiator (4)\n"
     "   -small                    Send small packets instead of bigger (FALSE)\n\n"
 
@@ -798,13 +961,23 @@ static void parse_options(int argc, char **argv)
 
       int rigid_id = atoi(argv[++i]);
       uint8_t ac_id = atoi(argv[++i]);
+      aircraft_add(rigid_id, ac_id);
+      count_ac++;
+    }
+    // Set an rigid body to ac_id with direct UDP output
+    else if (strcmp(argv[i], "-ac_udp") == 0) {
+      check_argcount(argc, argv, i, 4);
 
-      if (rigid_id >= MAX_RIGIDBODIES) {
-        fprintf(stderr, "Rigid body ID must be less then %d (MAX_RIGIDBODIES)\n\n", MAX_RIGIDBODIES);
-        print_help(argv[0]);
+      int rigid_id = atoi(argv[++i]);
+      uint8_t ac_id = atoi(argv[++i]);
+      struct Aircraft *ac = aircraft_add(rigid_id, ac_id);
+      char *host = argv[++i];
+      int port = atoi(argv[++i]);
+      if (udp_socket_create(&ac->udp, host, port, -1, 0) < 0) {
+        fprintf(stderr, "Could not create UDP output to %s:%d\n", host, port);
         exit(EXIT_FAILURE);
       }
-      aircrafts[rigid_id].ac_id = ac_id;
+      ac->udp_output = TRUE;
       count_ac++;
     }
     // See if we want to log to a file
@@ -926,6 +1099,7 @@ int main(int argc, char **argv)
   ltp_def_from_lla_d(&tracking_ltp, &tracking_lla);
 
   // Parse the options from cmdline
+  memset(rigid_hash, -1, sizeof(rigid_hash));
   parse_options(argc, argv);
   printf_debug("Tracking system Latitude: %f Longitude: %f Offset to North: %f degrees\n", DegOfRad(tracking_ltp.lla.lat),
                DegOfRad(tracking_ltp.lla.lon), DegOfRad(tracking_offset_angle));
@@ -946,10 +1120,10 @@ int main(int argc, char **argv)
   IvyInit("natnet2ivy", "natnet2ivy READY", 0, 0, 0, 0);
   IvyStart(ivy_bus);
 
-  // Create the main timers
-  printf_debug("Starting transmitting and sampling timeouts (transmitting frequency: %dHz, minimum velocity samples: %d)\n",
+  // Transmit on frame arrival, only check the tracking periodically
+  printf_debug("Starting sampling (transmitting frequency: %dHz, minimum velocity samples: %d)\n",
                freq_transmit, min_velocity_samples);
-  g_timeout_add(1000 / freq_transmit, timeout_transmit_callback, NULL);
+  g_timeout_add(CONNECTION_TIMEOUT * 1000, timeout_tracking_callback, NULL);
 
   GIOChannel *sk = g_io_channel_unix_new(natnet_data.sockfd);
   g_io_add_watch(sk, G_IO_IN | G_IO_NVAL | G_IO_HUP,
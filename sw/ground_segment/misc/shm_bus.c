@@ -0,0 +1,304 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file shm_bus.c
+ * Shared memory message bus, see shm_bus.h.
+ *
+ * The writers reserve the space of a record by moving the head of the ring
+ * forward, then write the record and finally its stamp, the position of the
+ * record in the stream. A reader at position pos only reads a record stamped
+ * pos, and checks after copying it that no writer reserved the same space on
+ * the next turn of the ring. A record never wraps around the end of the buffer,
+ * the writer pads the end instead.
+ */
+
+#include "shm_bus.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#define SHM_BUS_MAGIC 0x4d485350 // "PSHM"
+#define SHM_BUS_VERSION 1
+#define SHM_BUS_HEADER_SIZE 128
+#define SHM_BUS_ALIGN 16
+#define SHM_BUS_PAD 0xFFFF       ///< Record length of the padding at the end of the buffer
+
+struct shm_bus_header {
+  uint32_t magic;       ///< Set last when creating the bus
+  uint32_t version;
+  uint64_t size;        ///< Ring buffer size, power of 2
+  uint32_t origins;     ///< Last writer id
+  uint32_t notify;      ///< Incremented on publication, futex word
+  uint32_t waiters;     ///< Number of waiting readers
+  uint8_t unused[36];
+  uint64_t head;        ///< Bytes reserved since the creation, on its own cache line
+};
+
+_Static_assert(offsetof(struct shm_bus_header, head) == 64, "head not on its own cache line");
+_Static_assert(sizeof(struct shm_bus_header) <= SHM_BUS_HEADER_SIZE, "header too large");
+
+struct shm_bus_record {
+  uint64_t stamp;       ///< Position of the record in the stream once written
+  uint32_t size;        ///< Record size with header and alignment
+  uint16_t len;         ///< Payload length or SHM_BUS_PAD
+  uint16_t origin;
+};
+
+static inline uint32_t record_size(uint16_t len)
+{
+  return (sizeof(struct shm_bus_record) + len + SHM_BUS_ALIGN - 1) & ~(SHM_BUS_ALIGN - 1);
+}
+
+static inline struct shm_bus_record *record_at(struct shm_bus *bus, uint64_t pos)
+{
+  return (struct shm_bus_record *)(bus->data + (pos & (bus->hdr->size - 1)));
+}
+
+static inline int topic_of(const uint8_t *payload)
+{
+  return (payload[2] & 0x0F) * 256 + payload[3];
+}
+
+int shm_bus_open(struct shm_bus *bus, const char *name, size_t size)
+{
+  memset(bus, 0, sizeof(*bus));
+  if (size == 0) {
+    size = SHM_BUS_DEFAULT_SIZE;
+  }
+  if ((size & (size - 1)) != 0 || size < 4096) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  bool created = true;
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0666);
+  if (fd < 0 && errno == EEXIST) {
+    created = false;
+    fd = shm_open(name, O_RDWR, 0666);
+  }
+  if (fd < 0) {
+    return -1;
+  }
+
+  struct stat st;
+  if (created) {
+    if (ftruncate(fd, SHM_BUS_HEADER_SIZE + size) < 0) {
+      close(fd);
+      shm_unlink(name);
+      return -1;
+    }
+  } else {
+    // the creator may not have sized it yet
+    for (int i = 0; i < 100 && fstat(fd, &st) == 0 && st.st_size == 0; i++) {
+      usleep(10000);
+    }
+    if (fstat(fd, &st) < 0 || st.st_size <= SHM_BUS_HEADER_SIZE) {
+      close(fd);
+      errno = EINVAL;
+      return -1;
+    }
+    size = st.st_size - SHM_BUS_HEADER_SIZE;
+  }
+
+  bus->map_size = SHM_BUS_HEADER_SIZE + size;
+  void *map = mmap(NULL, bus->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return -1;
+  }
+  bus->hdr = map;
+  bus->data = (uint8_t *)map + SHM_BUS_HEADER_SIZE;
+
+  if (created) {
+    bus->hdr->version = SHM_BUS_VERSION;
+    bus->hdr->size = size;
+    __atomic_store_n(&bus->hdr->magic, SHM_BUS_MAGIC, __ATOMIC_RELEASE);
+  } else {
+    for (int i = 0; i < 100 && __atomic_load_n(&bus->hdr->magic, __ATOMIC_ACQUIRE) != SHM_BUS_MAGIC; i++) {
+      usleep(10000);
+    }
+    if (bus->hdr->magic != SHM_BUS_MAGIC || bus->hdr->version != SHM_BUS_VERSION ||
+        bus->hdr->size != size) {
+      fprintf(stderr, "shm_bus: %s is not a compatible bus\n", name);
+      munmap(map, bus->map_size);
+      errno = EINVAL;
+      return -1;
+    }
+  }
+
+  do {
+    bus->origin = __atomic_add_fetch(&bus->hdr->origins, 1, __ATOMIC_RELAXED);
+  } while (bus->origin == 0);
+  bus->read_pos = __atomic_load_n(&bus->hdr->head, __ATOMIC_ACQUIRE);
+  return 0;
+}
+
+void shm_bus_close(struct shm_bus *bus)
+{
+  if (bus->hdr != NULL) {
+    munmap(bus->hdr, bus->map_size);
+    bus->hdr = NULL;
+  }
+}
+
+int shm_bus_unlink(const char *name)
+{
+  return shm_unlink(name);
+}
+
+void shm_bus_subscribe(struct shm_bus *bus, int class_id, int msg_id)
+{
+  for (int c = 0; c < SHM_BUS_NB_CLASSES; c++) {
+    if (class_id >= 0 && c != class_id) {
+      continue;
+    }
+    for (int m = 0; m < 256; m++) {
+      if (msg_id < 0 || m == msg_id) {
+        int topic = c * 256 + m;
+        bus->topics[topic / 32] |= 1u << (topic % 32);
+      }
+    }
+  }
+}
+
+void shm_bus_unsubscribe_all(struct shm_bus *bus)
+{
+  memset(bus->topics, 0, sizeof(bus->topics));
+}
+
+static void notify(struct shm_bus_header *hdr)
+{
+  __atomic_add_fetch(&hdr->notify, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&hdr->waiters, __ATOMIC_SEQ_CST) > 0) {
+#ifdef __linux__
+    syscall(SYS_futex, &hdr->notify, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+#endif
+  }
+}
+
+int shm_bus_publish(struct shm_bus *bus, const uint8_t *payload, uint16_t len)
+{
+  if (len < 4 || len > SHM_BUS_MAX_PAYLOAD) {
+    return -1;
+  }
+  struct shm_bus_header *hdr = bus->hdr;
+  uint32_t size = record_size(len);
+  uint64_t head = __atomic_load_n(&hdr->head, __ATOMIC_RELAXED);
+  uint64_t pad;
+  do {
+    uint64_t offset = head & (hdr->size - 1);
+    pad = (offset + size > hdr->size) ? hdr->size - offset : 0;
+  } while (!__atomic_compare_exchange_n(&hdr->head, &head, head + pad + size, true,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+
+  if (pad > 0) {
+    struct shm_bus_record *rec = record_at(bus, head);
+    rec->size = pad;
+    rec->len = SHM_BUS_PAD;
+    rec->origin = bus->origin;
+    __atomic_store_n(&rec->stamp, head, __ATOMIC_RELEASE);
+    head += pad;
+  }
+  struct shm_bus_record *rec = record_at(bus, head);
+  rec->size = size;
+  rec->len = len;
+  rec->origin = bus->origin;
+  memcpy(rec + 1, payload, len);
+  __atomic_store_n(&rec->stamp, head, __ATOMIC_RELEASE);
+
+  notify(hdr);
+  return 0;
+}
+
+int shm_bus_read(struct shm_bus *bus, uint8_t *buf)
+{
+  struct shm_bus_header *hdr = bus->hdr;
+  for (;;) {
+    uint64_t head = __atomic_load_n(&hdr->head, __ATOMIC_ACQUIRE);
+    if (bus->read_pos == head) {
+      return 0;
+    }
+    if (head - bus->read_pos > hdr->size) {
+      // overrun, restart from the newest messages
+      bus->lost++;
+      bus->read_pos = head;
+      return 0;
+    }
+
+    struct shm_bus_record *rec = record_at(bus, bus->read_pos);
+    if (__atomic_load_n(&rec->stamp, __ATOMIC_ACQUIRE) != bus->read_pos) {
+      // reserved but still being written
+      return 0;
+    }
+    uint32_t size = rec->size;
+    uint16_t len = rec->len;
+    bool wanted = false;
+    if (len != SHM_BUS_PAD && len <= SHM_BUS_MAX_PAYLOAD && rec->origin != bus->origin) {
+      const uint8_t *payload = (const uint8_t *)(rec + 1);
+      int topic = topic_of(payload);
+      if (bus->topics[topic / 32] & (1u << (topic % 32))) {
+        memcpy(buf, payload, len);
+        wanted = true;
+      }
+    }
+
+    // the record is valid if it was not overwritten while reading it
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&hdr->head, __ATOMIC_RELAXED) - bus->read_pos > hdr->size ||
+        size < sizeof(struct shm_bus_record) || size > hdr->size) {
+      bus->lost++;
+      bus->read_pos = __atomic_load_n(&hdr->head, __ATOMIC_ACQUIRE);
+      return 0;
+    }
+    bus->read_pos += size;
+    if (wanted) {
+      return len;
+    }
+  }
+}
+
+bool shm_bus_wait(struct shm_bus *bus, int timeout_ms)
+{
+  struct shm_bus_header *hdr = bus->hdr;
+  uint32_t seq = __atomic_load_n(&hdr->notify, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&hdr->head, __ATOMIC_ACQUIRE) != bus->read_pos) {
+    return true;
+  }
+#ifdef __linux__
+  struct timespec ts = { timeout_ms / 1000, (timeout_ms % 1000) * 1000000L };
+  __atomic_add_fetch(&hdr->waiters, 1, __ATOMIC_SEQ_CST);
+  syscall(SYS_futex, &hdr->notify, FUTEX_WAIT, seq, timeout_ms < 0 ? NULL : &ts, NULL, 0);
+  __atomic_sub_fetch(&hdr->waiters, 1, __ATOMIC_SEQ_CST);
+#else
+  (void)seq;
+  usleep(timeout_ms < 0 || timeout_ms > 1 ? 1000 : timeout_ms * 1000);
+#endif
+  return __atomic_load_n(&hdr->head, __ATOMIC_ACQUIRE) != bus->read_pos;
+}
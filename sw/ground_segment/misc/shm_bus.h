@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file shm_bus.h
+ * Shared memory message bus for the ground tools running on one host.
+ *
+ * Messages are binary pprzlink v2 payloads without transport:
+ *   SENDER RECEIVER COMP_CLASS MSG_ID FIELDS...
+ * They are written in a ring buffer in POSIX shared memory (/dev/shm/<name>)
+ * by any number of processes, and every reader follows the ring at its own
+ * pace. The topics of a reader are the message types (class and id) it
+ * subscribed to, other messages are skipped without being copied.
+ *
+ * A reader too slow to follow the writers loses messages: it then restarts
+ * from the newest message and its lost counter is incremented.
+ *
+ * Legacy Ivy clients are served by sw/ground_segment/python/shm_bus/shm_ivy_bridge.py.
+ */
+
+#ifndef SHM_BUS_H
+#define SHM_BUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SHM_BUS_DEFAULT_SIZE (4 << 20)  ///< Default ring buffer size in bytes
+#define SHM_BUS_MAX_PAYLOAD 255
+#define SHM_BUS_NB_CLASSES 16           ///< Class ids are 4 bits in COMP_CLASS
+#define SHM_BUS_NB_TOPICS (SHM_BUS_NB_CLASSES * 256)
+
+struct shm_bus_header;
+
+struct shm_bus {
+  struct shm_bus_header *hdr;
+  uint8_t *data;
+  size_t map_size;
+  uint16_t origin;          ///< Writer id, the messages it published are not read back
+  uint64_t read_pos;
+  uint64_t lost;            ///< Number of times the reader was overrun
+  uint32_t topics[SHM_BUS_NB_TOPICS / 32];
+};
+
+/** Open a bus, creating it if needed
+    @param[in] name The shared memory object name, e.g. "/paparazzi"
+    @param[in] size The ring buffer size when creating it (power of 2), 0 for the default
+    @return 0 on success, -1 on error (errno is set) */
+extern int shm_bus_open(struct shm_bus *bus, const char *name, size_t size);
+extern void shm_bus_close(struct shm_bus *bus);
+
+/** Remove the bus name, the memory is freed when the last process closes it */
+extern int shm_bus_unlink(const char *name);
+
+/** Subscribe to a message type, a msg_id < 0 subscribes to the whole class
+    and a class_id < 0 to all messages */
+extern void shm_bus_subscribe(struct shm_bus *bus, int class_id, int msg_id);
+extern void shm_bus_unsubscribe_all(struct shm_bus *bus);
+
+/** Publish a message
+    @param[in] payload,len The pprzlink v2 payload, from SENDER to the last field
+    @return 0 on success, -1 if the message is invalid */
+extern int shm_bus_publish(struct shm_bus *bus, const uint8_t *payload, uint16_t len);
+
+/** Read the next subscribed message
+    @param[out] buf A buffer of SHM_BUS_MAX_PAYLOAD bytes at least
+    @return The payload length, 0 if there is no message to read yet */
+extern int shm_bus_read(struct shm_bus *bus, uint8_t *buf);
+
+/** Wait for new messages
+    @param[in] timeout_ms The maximum waiting time, < 0 to wait forever
+    @return true if a message may be available */
+extern bool shm_bus_wait(struct shm_bus *bus, int timeout_ms);
+
+#endif /* SHM_BUS_H */
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+/**
+ * @file shm_bus_bench.c
+ * Throughput and consistency check of the shared memory bus.
+ *
+ * shm_bus_bench [-w writers] [-n messages] [-s size]
+ *
+ * Every writer process publishes NPS_WIND like messages with a counter, the
+ * reader checks that the counters of every writer increase and that the
+ * payloads are not torn.
+ */
+
+#include "shm_bus.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#define BENCH_LEN 16
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void writer(const char *name, int id, long n)
+{
+  struct shm_bus bus;
+  if (shm_bus_open(&bus, name, 0) < 0) {
+    perror("writer");
+    exit(EXIT_FAILURE);
+  }
+  uint8_t payload[BENCH_LEN] = { id, 0, 1, 244 };
+  for (uint32_t i = 0; i < n; i++) {
+    memcpy(&payload[4], &i, 4);
+    memset(&payload[8], (uint8_t)(i ^ id), BENCH_LEN - 8);
+    shm_bus_publish(&bus, payload, BENCH_LEN);
+  }
+  shm_bus_close(&bus);
+  exit(EXIT_SUCCESS);
+}
+
+int main(int argc, char **argv)
+{
+  int nb_writers = 4, opt;
+  long n = 1000000;
+  size_t size = 0;
+  while ((opt = getopt(argc, argv, "w:n:s:")) != -1) {
+    switch (opt) {
+      case 'w': nb_writers = atoi(optarg); break;
+      case 'n': n = atol(optarg); break;
+      case 's': size = atol(optarg); break;
+      default:
+        fprintf(stderr, "Usage: %s [-w writers] [-n messages per writer] [-s bus size]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  if (nb_writers < 1 || nb_writers > 255) {
+    fprintf(stderr, "1 to 255 writers\n");
+    return EXIT_FAILURE;
+  }
+
+  char name[64];
+  snprintf(name, sizeof(name), "/shm_bus_bench_%d", (int)getpid());
+  struct shm_bus bus;
+  if (shm_bus_open(&bus, name, size) < 0) {
+    perror(name);
+    return EXIT_FAILURE;
+  }
+  shm_bus_subscribe(&bus, 1, 244);
+
+  double start = now();
+  for (int w = 0; w < nb_writers; w++) {
+    if (fork() == 0) {
+      writer(name, w + 1, n);
+    }
+  }
+
+  long received = 0, errors = 0;
+  int64_t last[256];
+  memset(last, -1, sizeof(last));
+  int running = nb_writers;
+  uint8_t buf[SHM_BUS_MAX_PAYLOAD];
+  while (running > 0 || shm_bus_wait(&bus, 0)) {
+    int len;
+    while ((len = shm_bus_read(&bus, buf)) > 0) {
+      uint32_t i;
+      memcpy(&i, &buf[4], 4);
+      bool torn = false;
+      for (int k = 8; k < BENCH_LEN; k++) {
+        torn |= buf[k] != (uint8_t)(i ^ buf[0]);
+      }
+      if (len != BENCH_LEN || torn || (int64_t)i <= last[buf[0]]) {
+        errors++;
+      }
+      last[buf[0]] = i;
+      received++;
+    }
+    if (waitpid(-1, NULL, WNOHANG) > 0) {
+      running--;
+    } else if (running > 0) {
+      shm_bus_wait(&bus, 10);
+    }
+  }
+  double dt = now() - start;
+
+  printf("%d writers, %ld messages sent, %ld received (%.1f%%), %lu overruns, %ld errors\n",
+         nb_writers, n * nb_writers, received, 100. * received / (n * nb_writers),
+         (unsigned long)bus.lost, errors);
+  printf("%.2f s, %.0f messages/s\n", dt, received / dt);
+  shm_bus_close(&bus);
+  shm_bus_unlink(name);
+  return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
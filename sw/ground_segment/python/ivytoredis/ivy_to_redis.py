@@ -8,48 +8,190 @@ import signal
 import argparse
 import sys
 import os
+import threading
+from collections import deque
 
 # if PAPARAZZI_SRC not set, then assume the tree containing this
 # file is a reasonable substitute
 PPRZ_SRC = os.getenv("PAPARAZZI_SRC", os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)),
                                                                     '../../../../')))
+PPRZ_HOME = os.getenv("PAPARAZZI_HOME", PPRZ_SRC)
 PPRZ_LIB_PYTHON = os.path.join(PPRZ_SRC, "sw/lib/python")
 sys.path.append(PPRZ_LIB_PYTHON)
+sys.path.append(PPRZ_HOME + "/var/lib/python")
 
 from pprzlink.ivy import IvyMessagesInterface
+from pprzlink.message import PprzMessage
 
 server = None
 
+METRICS_KEY = "ivy2redis.metrics"
+
 
 class Ivy2RedisServer():
-    def __init__(self, redishost, redisport, verbose=False):
+    """Forward the Ivy messages to Redis
+
+    The messages received from Ivy are queued and written every tick in a
+    single pipelined batch: for every message a PUBLISH and a SET of its JSON
+    payload on "class.name.ac_id", and with streams enabled an XADD of its
+    binary payload on "stream.class.name.ac_id".
+
+    The queue is bounded: when Redis does not follow, the oldest messages
+    are dropped, like the batches lost on a Redis error. The backpressure
+    metrics are written every second in the "ivy2redis.metrics" hash.
+    """
+
+    def __init__(self, redishost, redisport, verbose=False, tick=0.05, max_pending=100000,
+                 streams=False, stream_maxlen=10000, pubsub=True, interface=True):
         self.verbose = verbose
-        self.interface = IvyMessagesInterface("Ivy2Redis")
-        self.interface.subscribe(self.message_recv)
+        self.tick = tick
+        self.streams = streams
+        self.stream_maxlen = stream_maxlen
+        self.pubsub = pubsub
+        self.pending = deque(maxlen=max_pending)
+        self.lock = threading.Lock()
         self.r = redis.StrictRedis(host=redishost, port=redisport, db=0)
         self.keep_running = True
+        self.error_time = 0.
+        self.errors = 0
+        self.reset_metrics()
+        self.interface = None
+        if interface:
+            self.interface = IvyMessagesInterface("Ivy2Redis")
+            self.interface.subscribe(self.message_recv)
         print("Connected to redis server %s on port %i" % (redishost, redisport))
 
+    def reset_metrics(self):
+        """Reset the counters, with the lock held once the Ivy thread runs"""
+        self.received = 0
+        self.written = 0
+        self.dropped = 0
+        self.batches = 0
+        self.max_batch = 0
+        self.flush_time = 0.
+        self.max_lag = 0.
+        self.metrics_time = time.time()
+
     def message_recv(self, ac_id, msg):
+        t = time.time()
+        with self.lock:
+            if len(self.pending) == self.pending.maxlen:
+                self.dropped += 1
+            self.pending.append((t, ac_id, msg))
+            self.received += 1
+
+    def key(self, ac_id, msg):
         # if ac_id is not 0 (i.e. telemetry from an aircraft) include it in the key
         # don't add it to the key for ground messages
         if ac_id:
-            key = "{0}.{1}.{2}".format(msg.msg_class, msg.name, ac_id)
+            return "{0}.{1}.{2}".format(msg.msg_class, msg.name, ac_id)
         else:
-            key = "{0}.{1}".format(msg.msg_class, msg.name)
-        if self.verbose:
-            print("received message, key=%s, msg=%s" % (key, msg.to_json(payload_only=True)))
+            return "{0}.{1}".format(msg.msg_class, msg.name)
+
+    def flush(self):
+        """Write the queued messages in one pipelined batch"""
+        with self.lock:
+            batch = self.pending
+            self.pending = deque(maxlen=batch.maxlen)
+        if not batch:
+            return 0
+        start = time.time()
+        pipe = self.r.pipeline(transaction=False)
+        for (t, ac_id, msg) in batch:
+            key = self.key(ac_id, msg)
+            if self.pubsub:
+                json = msg.to_json(payload_only=True)
+                if self.verbose:
+                    print("received message, key=%s, msg=%s" % (key, json))
+                pipe.publish(key, json)
+                pipe.set(key, json)
+            if self.streams:
+                fields = {'t': repr(t), 'ac_id': str(ac_id), 'msg_id': str(msg.msg_id),
+                          'payload': bytes(msg.payload_to_binary())}
+                pipe.xadd("stream." + key, fields, maxlen=self.stream_maxlen, approximate=True)
+        try:
+            pipe.execute()
+        except redis.exceptions.RedisError:
+            # the batch is lost, also counted when only some commands failed
+            with self.lock:
+                self.dropped += len(batch)
+            raise
+        end = time.time()
+
+        with self.lock:
+            self.written += len(batch)
+            self.batches += 1
+            self.max_batch = max(self.max_batch, len(batch))
+            self.flush_time += end - start
+            self.max_lag = max(self.max_lag, end - batch[0][0])
+        return len(batch)
+
+    def send_metrics(self):
+        # snapshot and reset together, so that no message received meanwhile is lost
+        with self.lock:
+            dt = time.time() - self.metrics_time
+            metrics = {
+                'received_rate': self.received / dt,
+                'written_rate': self.written / dt,
+                'dropped': self.dropped,
+                'pending': len(self.pending),
+                'batches': self.batches,
+                'max_batch': self.max_batch,
+                'flush_load': self.flush_time / dt,  # fraction of the time spent writing to redis
+                'max_lag': self.max_lag,             # oldest message age when written, in s
+            }
+            self.reset_metrics()
+        # one field at a time, hset(mapping=) needs redis-py >= 3.5
+        pipe = self.r.pipeline(transaction=False)
+        for k, v in metrics.items():
+            pipe.hset(METRICS_KEY, k, v)
+        pipe.execute()
+        if self.verbose or metrics['dropped'] > 0:
+            print(' '.join('%s=%.3g' % (k, v) for k, v in sorted(metrics.items())))
             sys.stdout.flush()
-        self.r.publish(key, msg.to_json(payload_only=True))
-        self.r.set(key, msg.to_json(payload_only=True))
 
     def run(self):
         while self.keep_running:
-            time.sleep(0.1)
+            start = time.time()
+            try:
+                self.flush()
+                if start - self.metrics_time >= 1.:
+                    self.send_metrics()
+            except redis.exceptions.RedisError as e:
+                self.redis_error(e)
+            time.sleep(max(0., self.tick - (time.time() - start)))
+
+    def redis_error(self, e):
+        """Print the Redis errors at most once per second, they repeat every tick"""
+        self.errors += 1
+        now = time.time()
+        if now - self.error_time >= 1.:
+            if self.errors > 1:
+                print("Redis error: %s (%d errors in %.0f s)" % (e, self.errors, now - self.error_time))
+            else:
+                print("Redis error: %s" % e)
+            sys.stdout.flush()
+            self.error_time = now
+            self.errors = 0
 
     def stop(self):
         self.keep_running = False
-        self.interface.shutdown()
+        if self.interface is not None:
+            self.interface.shutdown()
+
+    def test(self, nb_msgs, nb_aircraft):
+        """Write synthetic ATTITUDE messages to check the throughput of a local Redis"""
+        msg = PprzMessage("telemetry", "ATTITUDE")
+        msg.set_values([0.1, 0.2, 0.3])
+        start = time.time()
+        for i in range(nb_msgs):
+            self.message_recv(i % nb_aircraft + 1, msg)
+            if i % 10000 == 9999:
+                self.flush()
+        self.flush()
+        dt = time.time() - start
+        print("%d messages in %.2f s, %.0f msgs/s, %d batches" % (nb_msgs, dt, nb_msgs / dt, self.batches))
+        self.send_metrics()
 
 
 def signal_handler(signal, frame):
@@ -62,9 +204,19 @@ def main():
     parser = argparse.ArgumentParser()
     parser.add_argument("-s", "--server", help="hostname here redis runs", default="localhost")
     parser.add_argument("-p", "--port", help="port used by redis", type=int, default=6379)
+    parser.add_argument("-t", "--tick", help="period of the batched writes in s", type=float, default=0.05)
+    parser.add_argument("-m", "--max_pending", help="maximum number of queued messages", type=int, default=100000)
+    parser.add_argument("--streams", help="also add the binary payloads to Redis streams", action="store_true")
+    parser.add_argument("--stream_maxlen", help="approximate length of the streams", type=int, default=10000)
+    parser.add_argument("--no_pubsub", help="do not publish and set the JSON payloads", action="store_true")
+    parser.add_argument("--test", help="write N synthetic messages without Ivy and exit", type=int, default=0)
     parser.add_argument("-v", "--verbose", dest="verbose", action="store_true")
     args = parser.parse_args()
-    server = Ivy2RedisServer(args.server, args.port, args.verbose)
+    server = Ivy2RedisServer(args.server, args.port, args.verbose, args.tick, args.max_pending,
+                             args.streams, args.stream_maxlen, not args.no_pubsub, interface=args.test == 0)
+    if args.test > 0:
+        server.test(args.test, 50)
+        return
     signal.signal(signal.SIGINT, signal_handler)
     server.run()
 
@@ -13,7 +13,7 @@ def create(parent):
 
 [wxID_PLOTFRAME, wxID_PLOTFRAMECHECKAUTOSCALE, wxID_PLOTFRAMEEDITMAX, wxID_PLOTFRAMEEDITMIN, wxID_PLOTFRAMEEDITTIME, wxID_PLOTFRAMEPANEL1, wxID_PLOTFRAMESLIDERTIME, wxID_PLOTFRAMESTATICTEXT1, wxID_PLOTFRAMESTATICTEXT2, wxID_PLOTFRAMESTATICTEXT3] = [wx.NewId() for _init_ctrls in range(10)]
 
-[wxID_PLOTFRAMEMENU1ITEM_ADD, wxID_PLOTFRAMEMENU1ITEM_PAUSE, wxID_PLOTFRAMEMENU1ITEM_RESET] = [wx.NewId() for _init_coll_menuPlot_Items in range(3)]
+[wxID_PLOTFRAMEMENU1ITEM_ADD, wxID_PLOTFRAMEMENU1ITEM_PAUSE, wxID_PLOTFRAMEMENU1ITEM_RESET, wxID_PLOTFRAMEMENU1ITEM_EXPORT] = [wx.NewId() for _init_coll_menuPlot_Items in range(4)]
 
 class PlotFrame(wx.Frame):
     def _init_coll_boxSizer1_Items(self, parent):
@@ -46,9 +46,11 @@ class PlotFrame(wx.Frame):
         parent.Append(help=u'Add plots', id=wxID_PLOTFRAMEMENU1ITEM_ADD, kind=wx.ITEM_NORMAL, text=u'&Add\tCtrl+A')
         parent.Append(help=u'Reset plot scale', id=wxID_PLOTFRAMEMENU1ITEM_RESET, kind=wx.ITEM_NORMAL, text=u'&Reset\tCtrl+L')
         parent.Append(help=u'Pause the plot', id=wxID_PLOTFRAMEMENU1ITEM_PAUSE, kind=wx.ITEM_CHECK, text=u'&Pause\tCtrl+P')
+        parent.Append(help=u'Export the curves data', id=wxID_PLOTFRAMEMENU1ITEM_EXPORT, kind=wx.ITEM_NORMAL, text=u'&Export\tCtrl+E')
         self.Bind(wx.EVT_MENU, self.OnMenu1Item_addMenu, id=wxID_PLOTFRAMEMENU1ITEM_ADD)
         self.Bind(wx.EVT_MENU, self.OnMenu1Item_resetMenu, id=wxID_PLOTFRAMEMENU1ITEM_RESET)
         self.Bind(wx.EVT_MENU, self.OnMenu1Item_pauseMenu, id=wxID_PLOTFRAMEMENU1ITEM_PAUSE)
+        self.Bind(wx.EVT_MENU, self.OnMenu1Item_exportMenu, id=wxID_PLOTFRAMEMENU1ITEM_EXPORT)
 
     def _init_sizers(self):
         # generated method, don't edit
@@ -172,6 +174,17 @@ class PlotFrame(wx.Frame):
     def OnMenu1Item_pauseMenu(self, event):
         self.canvas.Pause(event.IsChecked())
 
+    def OnMenu1Item_exportMenu(self, event):
+        dialog = wx.FileDialog(self, "Export the curves", defaultFile="plot.col",
+                               wildcard="Columnar (*.col)|*.col|Parquet (*.parquet)|*.parquet|HDF5 (*.h5)|*.h5",
+                               style=wx.FD_SAVE | wx.FD_OVERWRITE_PROMPT)
+        if dialog.ShowModal() == wx.ID_OK:
+            try:
+                self.canvas.Export(dialog.GetPath())
+            except ImportError as e:
+                wx.MessageBox("Export failed: %s" % e, "Export")
+        dialog.Destroy()
+
     def AddCurve(self, menu_id, title, use_as_x = False):
         curveMenu = wx.Menu(title='')
 
@@ -8,8 +8,11 @@ from textdroptarget import *
 import math
 import random
 import sys
+import time
+import numpy as np
 from os import getenv, path
 import messagepicker
+from ringbuffer import RingBuffer, decimate, write_columnar
 
 # if PAPARAZZI_SRC or PAPARAZZI_HOME not set, then assume the tree containing this
 # file is a reasonable substitute
@@ -28,6 +31,8 @@ class PlotData:
         self.id = ivy_msg_id
         self.title = title
         self.SetPlotSize(width)
+        self.buffer = RingBuffer()
+        self.last_value = np.nan
         self.x_min = 1e32
         self.x_max = 1e-32
 
@@ -54,21 +59,12 @@ class PlotData:
         self.scale = value
 
     def SetPlotSize(self, size):
-        self.size = size
-        self.index = size - 1  # holds the index of the next point to add and the first point to draw
-        self.data = []  # holds the list of points to plot
-        for i in range(size):
-            self.data.append(None)
+        self.size = size  # number of points drawn in real time and x axis modes
 
-        self.avg = 0.0
-        self.std_dev = 0.0
-
-    def AddPoint(self, point, x_axis):
-        self.data[self.index] = point
-
-        if self.real_time or (x_axis is not None):
-            self.index = (self.index + 1) % self.size  # increment index to next point
-            self.data[self.index] = None
+    def AddPoint(self, point, t, x_axis):
+        x = x_axis.last_value if x_axis is not None else np.nan
+        self.buffer.append(t, point, x)
+        self.last_value = point
 
     def DrawTitle(self, dc, margin, width, height):
 
@@ -80,17 +76,23 @@ class PlotData:
         dc.DrawText(text, width - 2 * margin - w - h, height)
         return h
 
-    def DrawCurve(self, dc, width, height, margin, _max_, _min_, x_axis):
-        if width != self.size:
-            self.SetPlotSize(width)
-            return
-
-        if (not self.real_time) and (x_axis is None):
-            self.index = (self.index + 1) % self.size  # increment index to next point
-            self.data[self.index] = None
-
+    def Points(self, width, now, duration, x_axis):
+        """Pixel columns and values of the points to draw, and the raw visible samples"""
         if x_axis is not None:
             (x_min, x_max) = x_axis.GetXMinMax()
+            _, v, x = self.buffer.last(self.size)
+            valid = ~np.isnan(x)
+            return (x[valid] - x_min) * (width - 1) / (x_max - x_min), v[valid], v[valid]
+        if self.real_time:
+            _, v, _ = self.buffer.last(self.size)
+            return np.arange(self.size - len(v), self.size) * width / self.size, v, v
+        t, v = self.buffer.window(now - duration, now)
+        xs, points = decimate(t, v, now - duration, now, width)
+        return xs, points, v
+
+    def DrawCurve(self, dc, width, height, margin, _max_, _min_, x_axis, now, duration):
+        if width != self.size:
+            self.SetPlotSize(width)
 
         dc.SetPen(wx.Pen(self.color, 1))
         if _max_ < _min_:
@@ -100,53 +102,23 @@ class PlotData:
         delta = _max_ - _min_
         dy = (height - margin * 2) / delta
 
-        n = 0
-        sums = 0.0
-        sum_squares = 0.0
-        lines = []
-        point_1 = None
-        for i in range(self.size):
-            ix = (i + self.index) % self.size
-            point = self.data[ix]
-            if point is None:
-                continue
-            n += 1
-            sums = sums + point
-            sum_squares = sum_squares + (point * point)
-
-            if x_axis is not None:
-                x = x_axis.data[ix]
-                if x is None:
-                    continue
-                dx = (width - 1) / (x_max - x_min)
-                x = int((x - x_min) * dx)
-
-            else:
-                x = i * width / self.size
-
-            scaled_point = (point + self.offset) * self.scale
-            y = height - margin - int((scaled_point - _min_) * dy)
-
-            if point_1 is not None:
-                line = (point_1[0], point_1[1], x, y)
-                lines.append(line)
-            point_1 = (x, y)
-            dc.DrawLineList(lines)
-
-            if n > 0:
-                self.avg = sums / n
-                self.std_dev = math.sqrt(math.fabs((sum_squares / n) - (self.avg * self.avg)))
+        (xs, points, samples) = self.Points(width, now, duration, x_axis)
+        if len(samples) > 0:
+            # on all the visible samples, the decimated points depend on the zoom
+            self.avg = float(np.mean(samples))
+            self.std_dev = float(np.std(samples))
+        if len(points) < 2:
+            return
 
-    def GetXMinMax(self):
-        x_min = 1e32
-        x_max = -1e32
+        ys = height - margin - ((points + self.offset) * self.scale - _min_) * dy
+        dc.DrawLines(list(zip(xs.astype(int).tolist(), ys.astype(int).tolist())))
 
-        for i in range(self.size):
-            point = self.data[i]
-            if point is None:
-                continue
-            x_min = min(x_min, point)
-            x_max = max(x_max, point)
+    def GetXMinMax(self):
+        _, v, _ = self.buffer.last(self.size)
+        if len(v) > 0:
+            (x_min, x_max) = (float(np.min(v)), float(np.max(v)))
+        else:
+            (x_min, x_max) = (1e32, -1e32)
 
         if x_max < x_min:
             (x_min, x_max) = (-1, 1)  # prevent divide by zero or inversion
@@ -251,6 +223,7 @@ class PlotPanel(object):
         if message not in self.plots[ac_id]:
             return
 
+        t = time.time()
         for field in self.plots[ac_id][message]:
             plot = self.plots[ac_id][message][field]
             ix = messages_xml_map.message_dictionary["telemetry"][message].index(field)
@@ -262,9 +235,7 @@ class PlotPanel(object):
                     self.max = max(self.max, scaled_point)
                     self.min = min(self.min, scaled_point)
 
-            if self.x_axis is not None:
-                plot.index = self.x_axis.index
-            plot.AddPoint(point, self.x_axis)
+            plot.AddPoint(point, t, self.x_axis)
 
     def BindCurve(self, ac_id, message, field, color=None, use_as_x=False, scale=1.0):
         # -- add this telemetry to our list of things to plot ...
@@ -291,10 +262,12 @@ class PlotPanel(object):
 
     def CalcMinMax(self, plot):
         if not self.auto_scale: return
-        for x in plot.data:
-            self.max = max(self.max, x)
-            self.min = min(self.min, x)
-            self.frame.SetMinMax(self.min, self.max)
+        _, v, _ = plot.buffer.last(plot.size)
+        if len(v) == 0: return
+        v = (v + plot.offset) * plot.scale
+        self.max = max(self.max, float(np.max(v)))
+        self.min = min(self.min, float(np.min(v)))
+        self.frame.SetMinMax(self.min, self.max)
 
     def FindPlotName(self, ivy_id):
         for ac_id in self.plots:
@@ -330,8 +303,7 @@ class PlotPanel(object):
             return
 
         plot.SetOffset(offset)
-        print('panel value: %.2f' % value)
-        CalcMinMax(plot)
+        self.CalcMinMax(plot)
 
     def ScalePlot(self, ivy_id, offset):
         plot = self.FindPlot(ivy_id)
@@ -339,7 +311,7 @@ class PlotPanel(object):
             return
 
         plot.SetScale(offset)
-        CalcMinMax(plot)
+        self.CalcMinMax(plot)
 
     def SetRealTime(self, ivy_id, value):
         plot = self.FindPlot(ivy_id)
@@ -358,6 +330,18 @@ class PlotPanel(object):
     def ClearXAxis(self):
         self.x_axis = None
 
+    def Export(self, filename):
+        """Export the buffered samples of all the curves to a columnar file"""
+        columns = {}
+        for ac_id in self.plots:
+            for message in self.plots[ac_id]:
+                for field in self.plots[ac_id][message]:
+                    plot = self.plots[ac_id][message][field]
+                    (t, v, _) = plot.buffer.last()
+                    columns[plot.title + ':time'] = t
+                    columns[plot.title] = v
+        write_columnar(filename, columns)
+
     def OnSize(self, size):
         (width, height) = size
         if self.width == width and self.height == height:
@@ -383,6 +367,8 @@ class PlotPanel(object):
 
         self.DrawBackground(bdc, self.width, self.height)
 
+        now = time.time()
+        duration = self.plot_interval * self.width / 1000.0
         title_y = 2
         for ac_id in self.plots:
             for message in self.plots[ac_id]:
@@ -391,7 +377,8 @@ class PlotPanel(object):
                     if (self.x_axis is not None) and (self.x_axis.id == plot.id):
                         continue
                     title_height = plot.DrawTitle(bdc, 2, self.width, title_y)
-                    plot.DrawCurve(bdc, self.width, self.height, self.margin, self.max, self.min, self.x_axis)
+                    plot.DrawCurve(bdc, self.width, self.height, self.margin, self.max, self.min, self.x_axis,
+                                   now, duration)
 
                     title_y += title_height + 2
 
@@ -0,0 +1,198 @@
+"""
+Numeric storage of the plotted fields
+
+Every curve keeps its samples in numpy arrays used as a ring buffer, so
+adding a point is amortized constant time and an hour of data at 100 Hz
+does not grow any Python list. The arrays are sized from the history:
+they start small and double when full, up to the capacity.
+
+For display, the samples are decimated to the min and max of each pixel
+column, which draws the same envelope as the full series with at most four
+points per column.
+
+The buffers can be exported to a columnar file: Parquet when pyarrow is
+available, HDF5 with h5py, otherwise a simple binary format (see
+write_columnar and read_columnar).
+"""
+
+from __future__ import absolute_import, print_function, division
+
+import json
+import struct
+
+import numpy as np
+
+DEFAULT_CAPACITY = 1 << 19  # samples per curve at most, about 1h30 at 100 Hz
+INITIAL_SIZE = 1 << 12  # samples allocated at first
+
+
+class RingBuffer(object):
+    """Buffer of the last capacity (time, value, x) samples"""
+
+    def __init__(self, capacity=DEFAULT_CAPACITY):
+        self.capacity = capacity
+        self.count = 0  # total number of samples added
+        self._allocate(min(INITIAL_SIZE, capacity))
+
+    def _allocate(self, size):
+        self.size = size  # allocated samples, capacity once the history is long enough
+        self.t = np.empty(size, dtype=np.float64)
+        self.v = np.empty(size, dtype=np.float64)
+        self.x = np.empty(size, dtype=np.float64)
+
+    def __len__(self):
+        return min(self.count, self.size)
+
+    def clear(self):
+        self.count = 0
+        self._allocate(min(INITIAL_SIZE, self.capacity))
+
+    def append(self, t, v, x=np.nan):
+        if self.count == self.size and self.size < self.capacity:
+            # not wrapped yet, the samples keep their indexes
+            (old_t, old_v, old_x) = (self.t, self.v, self.x)
+            self._allocate(min(2 * self.size, self.capacity))
+            self.t[:self.count] = old_t
+            self.v[:self.count] = old_v
+            self.x[:self.count] = old_x
+        i = self.count % self.size
+        self.t[i] = t
+        self.v[i] = v
+        self.x[i] = x
+        self.count += 1
+
+    def _ordered(self, a, n=None):
+        """The last n samples of a column, oldest first"""
+        size = len(self)
+        if n is None or n > size:
+            n = size
+        end = self.count % self.size
+        start = end - n
+        if start >= 0:
+            return a[start:end]
+        return np.concatenate((a[start:], a[:end]))
+
+    def last(self, n=None):
+        """(t, v, x) arrays of the last n samples"""
+        return self._ordered(self.t, n), self._ordered(self.v, n), self._ordered(self.x, n)
+
+    def window(self, t_min, t_max):
+        """(t, v) arrays of the samples in [t_min, t_max]"""
+        t, v, _ = self.last()
+        # times are increasing, as they are reception times
+        i0 = np.searchsorted(t, t_min, side='left')
+        i1 = np.searchsorted(t, t_max, side='right')
+        return t[i0:i1], v[i0:i1]
+
+
+def decimate(x, y, x_min, x_max, width):
+    """Reduce a series to the first, min, max and last points of each pixel column
+
+    :param x: increasing abscissas
+    :param width: number of pixel columns over [x_min, x_max]
+    :return: (columns, values) arrays to draw, in drawing order
+    """
+    if len(x) <= 4 * width or width <= 0 or x_max <= x_min:
+        return (x - x_min) * (width - 1) / max(x_max - x_min, 1e-12), y
+    col = ((x - x_min) * (width - 1) / (x_max - x_min)).astype(np.int64)
+    # start index of every non empty column
+    starts = np.flatnonzero(np.r_[True, col[1:] != col[:-1]])
+    ends = np.r_[starts[1:], len(col)] - 1
+    y_min = np.minimum.reduceat(y, starts)
+    y_max = np.maximum.reduceat(y, starts)
+    cols = col[starts].astype(np.float64)
+    # keep the continuity with the neighbour columns: first, min, max, last
+    out_x = np.repeat(cols, 4)
+    out_y = np.empty(4 * len(starts))
+    out_y[0::4] = y[starts]
+    out_y[1::4] = y_min
+    out_y[2::4] = y_max
+    out_y[3::4] = y[ends]
+    return out_x, out_y
+
+
+_COLUMNAR_MAGIC = b'PPRZCOL1'
+
+
+def write_columnar(path, columns):
+    """Write named 1D arrays to a columnar file
+
+    The format is chosen from the extension: .parquet (pyarrow), .h5/.hdf5
+    (h5py), anything else the built-in binary format:
+        magic 'PPRZCOL1', uint32 header length, JSON header, 8 bytes aligned columns
+    where the header lists the name, dtype, length and offset of every column.
+    Columns may have different lengths.
+
+    A Parquet table has a single length: the shorter columns are padded with
+    nulls, keeping their type, and the length of every column is stored as
+    JSON in the 'pprz.lengths' schema metadata. read_columnar uses it to
+    give back the original columns.
+    """
+    if path.endswith('.parquet'):
+        import pyarrow as pa
+        import pyarrow.parquet as pq
+        n = max(len(c) for c in columns.values()) if columns else 0
+        arrays = {}
+        for k, c in columns.items():
+            c = np.asarray(c)
+            pad = np.zeros(n - len(c), dtype=c.dtype)
+            mask = np.r_[np.zeros(len(c), dtype=bool), np.ones(n - len(c), dtype=bool)]
+            arrays[k] = pa.array(np.r_[c, pad], mask=mask)
+        lengths = dict((k, len(c)) for k, c in columns.items())
+        table = pa.table(arrays).replace_schema_metadata({'pprz.lengths': json.dumps(lengths)})
+        pq.write_table(table, path)
+        return
+    if path.endswith('.h5') or path.endswith('.hdf5'):
+        import h5py
+        with h5py.File(path, 'w') as f:
+            for name, c in columns.items():
+                f.create_dataset(name, data=c, compression='gzip')
+        return
+
+    header = []
+    offset = 0
+    for name, c in columns.items():
+        c = np.ascontiguousarray(c)
+        header.append({'name': name, 'dtype': c.dtype.str, 'length': len(c), 'offset': offset})
+        offset += (c.nbytes + 7) & ~7
+    head = json.dumps({'columns': header}).encode()
+    head += b' ' * (-(len(_COLUMNAR_MAGIC) + 4 + len(head)) % 8)
+    with open(path, 'wb') as f:
+        f.write(_COLUMNAR_MAGIC)
+        f.write(struct.pack('<I', len(head)))
+        f.write(head)
+        for name, c in columns.items():
+            data = np.ascontiguousarray(c).tobytes()
+            f.write(data)
+            f.write(b'\0' * (-len(data) % 8))
+
+
+def read_columnar(path):
+    """Read a columnar file written by write_columnar
+
+    Columns of the built-in format are memory mapped. Parquet columns are
+    cut to the lengths of the 'pprz.lengths' metadata, without it they keep
+    the table length with nulls read as NaN.
+    """
+    if path.endswith('.parquet'):
+        import pyarrow.parquet as pq
+        table = pq.read_table(path)
+        meta = table.schema.metadata or {}
+        lengths = json.loads(meta.get(b'pprz.lengths', b'{}').decode())
+        # cut before the conversion, so that integer columns stay integers
+        return dict((k, table.column(k).slice(0, lengths.get(k, table.num_rows)).to_numpy())
+                    for k in table.column_names)
+    with open(path, 'rb') as f:
+        if f.read(len(_COLUMNAR_MAGIC)) != _COLUMNAR_MAGIC:
+            raise ValueError("%s is not a columnar file" % path)
+        head_len, = struct.unpack('<I', f.read(4))
+        header = json.loads(f.read(head_len).decode())
+    base = len(_COLUMNAR_MAGIC) + 4 + head_len
+    columns = {}
+    for c in header['columns']:
+        if c['length'] == 0:
+            columns[c['name']] = np.empty(0, dtype=np.dtype(c['dtype']))
+            continue
+        columns[c['name']] = np.memmap(path, dtype=np.dtype(c['dtype']), mode='r',
+                                       offset=base + c['offset'], shape=(c['length'],))
+    return columns
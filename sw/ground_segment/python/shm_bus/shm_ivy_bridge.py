@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2026 The Paparazzi Team
+#
+# This file is part of paparazzi.
+#
+# paparazzi is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2, or (at your option)
+# any later version.
+#
+# paparazzi is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with paparazzi; see the file COPYING.  If not, write to
+# the Free Software Foundation, 59 Temple Place - Suite 330,
+# Boston, MA 02111-1307, USA.
+#
+
+"""
+Bridge between the shared memory ground bus and the Ivy bus, so that the
+legacy Ivy clients see the messages published on the shared memory bus and
+the other way round.
+
+Only the message classes given with --classes are bridged. A message is never
+sent back to the bus it came from.
+"""
+
+from __future__ import print_function
+
+import os
+import sys
+import threading
+
+# if PAPARAZZI_SRC not set, then assume the tree containing this
+# file is a reasonable substitute
+PAPARAZZI_SRC = os.getenv("PAPARAZZI_SRC", os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), '../../../../')))
+PAPARAZZI_HOME = os.getenv("PAPARAZZI_HOME", PAPARAZZI_SRC)
+sys.path.append(PAPARAZZI_SRC + "/sw/lib/python")
+sys.path.append(PAPARAZZI_HOME + "/var/lib/python")
+
+import pprzlink.ivy
+import pprzlink.messages_xml_map as messages_xml_map
+import pprzlink.message as message
+
+import shm_bus
+
+CLASS_IDS = {'telemetry': 1, 'datalink': 2, 'ground': 3, 'alert': 4, 'intermcu': 5}
+
+
+class ShmIvyBridge(object):
+    def __init__(self, bus_name, ivy_bus, classes, to_ivy=True, to_shm=True, verbose=False):
+        messages_xml_map.parse_messages()
+        self.classes = classes
+        self.class_names = dict((CLASS_IDS[c], c) for c in classes)
+        self.verbose = verbose
+        self.running = True
+        self.templates = {}
+        self.nb_to_ivy = 0
+        self.nb_to_shm = 0
+
+        self.bus = shm_bus.ShmBus(bus_name)
+        for c in classes:
+            self.bus.subscribe(CLASS_IDS[c])
+        self.ivy = pprzlink.ivy.IvyMessagesInterface("ShmIvyBridge", start_ivy=False, ivy_bus=ivy_bus)
+        if to_shm:
+            self.ivy.subscribe(self.on_ivy_msg)
+        self.to_ivy = to_ivy
+
+    def template(self, class_id, msg_id):
+        """Message object reused to decode the payloads of a type"""
+        key = (class_id, msg_id)
+        msg = self.templates.get(key)
+        if msg is None:
+            msg = message.PprzMessage(self.class_names[class_id], msg_id)
+            self.templates[key] = msg
+        return msg
+
+    def on_ivy_msg(self, sender_id, msg):
+        if msg.msg_class not in self.class_names.values():
+            return
+        try:
+            sender = int(sender_id)
+        except (TypeError, ValueError):
+            sender = 0
+        payload = bytearray([sender & 0xFF, 0, CLASS_IDS[msg.msg_class] & 0x0F, msg.msg_id])
+        payload += msg.payload_to_binary()
+        try:
+            self.bus.publish(payload)
+            self.nb_to_shm += 1
+        except ValueError as e:
+            if self.verbose:
+                print("%s: %s" % (msg.name, e))
+
+    def shm_to_ivy(self):
+        for payload in self.bus.messages(timeout_ms=100):
+            if not self.running:
+                break
+            if payload is None or not self.to_ivy:
+                continue
+            sender, receiver, comp_class, msg_id = bytearray(payload[:4])
+            try:
+                msg = self.template(comp_class & 0x0F, msg_id)
+                msg.binary_to_payload(payload[4:])
+            except Exception as e:
+                if self.verbose:
+                    print("Unknown message %d/%d: %s" % (comp_class & 0x0F, msg_id, e))
+                continue
+            self.ivy.send(msg, sender, receiver)
+            self.nb_to_ivy += 1
+
+    def run(self):
+        self.ivy.start()
+        reader = threading.Thread(target=self.shm_to_ivy)
+        reader.start()
+        try:
+            while reader.is_alive():
+                reader.join(1.0)
+                if self.verbose:
+                    print("to ivy: %d, to shm: %d, overruns: %d" % (self.nb_to_ivy, self.nb_to_shm, self.bus.lost))
+        except (KeyboardInterrupt, SystemExit):
+            self.running = False
+            reader.join()
+        finally:
+            self.ivy.shutdown()
+            self.bus.close()
+
+
+def main():
+    from argparse import ArgumentParser
+    parser = ArgumentParser(description="Bridge between the shared memory ground bus and Ivy")
+    parser.add_argument("-n", "--name", default=shm_bus.DEFAULT_NAME, help="shared memory bus name [default: %(default)s]")
+    parser.add_argument("-b", "--bus", default=pprzlink.ivy.IVY_BUS, help="Ivy bus [default to system IVY bus]")
+    parser.add_argument("-c", "--classes", default="telemetry,ground",
+                        help="comma separated message classes to bridge [default: %(default)s]")
+    parser.add_argument("--no_to_ivy", action="store_true", help="do not forward the shared memory messages to Ivy")
+    parser.add_argument("--no_to_shm", action="store_true", help="do not forward the Ivy messages to shared memory")
+    parser.add_argument("-v", "--verbose", action="store_true", help="print statistics")
+    args = parser.parse_args()
+
+    classes = [c for c in args.classes.split(',') if c]
+    for c in classes:
+        if c not in CLASS_IDS:
+            parser.error("unknown message class %s" % c)
+    bridge = ShmIvyBridge(args.name, args.bus, classes, not args.no_to_ivy, not args.no_to_shm, args.verbose)
+    bridge.run()
+
+
+if __name__ == '__main__':
+    main()
@@ -31,6 +31,7 @@
  * Several clients can be connected at the same time with full or restricted access
  */
 
+#define _GNU_SOURCE // sendmmsg
 #include <glib.h>
 #include <gio/gio.h>
 #include <Ivy/ivy.h>
@@ -40,6 +41,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <libxml/xmlreader.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
 
 
 char defaultAppPass[] = "1234"; //4 char password to control ac's over app "pass ground stg stg stg..
@@ -55,6 +61,9 @@ char* AppPass;
 #define MAXWPNUMB 50  //NUMBER OF WP PER AC (MAX)
 #define MAXWPNAMELEN 50  //WP NAME LENGTH (MAX)
 
+#define MAXPENDINGMSG 256 //Ivy messages coalesced per broadcast tick (MAX)
+#define PENDINGBUFLEN (MAXPENDINGMSG * 256)
+
 // Default TCP port (listen clients commands)
 int tcp_port = 5010;
 // Default UDP port (broadcast data to clients)
@@ -67,7 +76,20 @@ char defaultIvyBus[] = "127.255.255.255:2010";
 #endif
 char* IvyBus;
 
-char ivybuffer[BUFLEN];
+// Default coalescing period of the broadcast in ms (0 to send every message immediately)
+int coalesce_period = 20;
+
+//Ivy messages waiting for the next broadcast tick
+char pending_buf[PENDINGBUFLEN];
+size_t pending_len = 0;
+struct iovec pending_msgs[MAXPENDINGMSG];
+int pending_nb = 0;
+guint pending_timer = 0;
+
+//Single udp socket used to send to all clients, dual stack when possible
+int udp_socket = -1;
+//Family of the udp socket, AF_INET when IPv6 is not available
+int udp_family = AF_INET6;
 
 // verbose flag
 int verbose = 0;
@@ -114,6 +136,9 @@ typedef struct {
   char client_ip[MAXIPLEN];
   //Pointer for tcp connection;
   gpointer ClientTcpData;
+  //Udp destination, resolved once when the client connects (length 0 if none)
+  struct sockaddr_storage udp_addr;
+  socklen_t udp_addr_len;
 } client_data;
 
 client_data ConnectedClients[MAXCLIENT];  //Holds all status of devices
@@ -157,6 +182,40 @@ void remove_client(char* RemClientIpAd) {
   }
 }
 
+//Udp destination of a client for the family of the udp socket,
+//IPv4 addresses are mapped for the dual stack socket
+int client_udp_address(const char *ip, struct sockaddr_storage *addr, socklen_t *len) {
+  struct in_addr addr4;
+  memset(addr, 0, sizeof(*addr));
+  *len = 0;
+  if (udp_family == AF_INET) {
+    struct sockaddr_in *addr_in = (struct sockaddr_in *)addr;
+    //IPv4 client seen through a mapped address
+    if (g_str_has_prefix(ip, "::ffff:")) {
+      ip += strlen("::ffff:");
+    }
+    if (inet_pton(AF_INET, ip, &addr_in->sin_addr) != 1) {
+      return -1;
+    }
+    addr_in->sin_family = AF_INET;
+    addr_in->sin_port = htons(udp_port);
+    *len = sizeof(struct sockaddr_in);
+    return 0;
+  }
+  struct sockaddr_in6 *addr_in6 = (struct sockaddr_in6 *)addr;
+  if (inet_pton(AF_INET, ip, &addr4) == 1) {
+    addr_in6->sin6_addr.s6_addr[10] = 0xff;
+    addr_in6->sin6_addr.s6_addr[11] = 0xff;
+    memcpy(&addr_in6->sin6_addr.s6_addr[12], &addr4, sizeof(addr4));
+  } else if (inet_pton(AF_INET6, ip, &addr_in6->sin6_addr) != 1) {
+    return -1;
+  }
+  addr_in6->sin6_family = AF_INET6;
+  addr_in6->sin6_port = htons(udp_port);
+  *len = sizeof(struct sockaddr_in6);
+  return 0;
+}
+
 //Record client (if new)
 void add_client(char* ClientIpAd, gpointer connection_in) {
   /* Check if client exists. If exists return else record it */
@@ -176,6 +235,10 @@ void add_client(char* ClientIpAd, gpointer connection_in) {
     //record new client ip
     g_stpcpy(ConnectedClients[i].client_ip,ClientIpAd);
     ConnectedClients[i].ClientTcpData = connection_in;
+    if (client_udp_address(ClientIpAd, &ConnectedClients[i].udp_addr, &ConnectedClients[i].udp_addr_len) < 0) {
+      printf("App Server: invalid client address %s\n", ClientIpAd);
+      fflush(stdout);
+    }
     //
     ConnectedClients[i].used = 1;
     if (verbose) {
@@ -272,59 +335,84 @@ int get_bl_data(char* InStr, char* RetBuf) {
   return AcID;
 }
 
-//Bfoadcast ivy msgs to clients
+#ifndef __linux__
+struct mmsghdr {
+  struct msghdr msg_hdr;
+  unsigned int msg_len;
+};
+#endif
+
+//Send udp datagrams, as few system calls as possible
+void send_datagrams(struct mmsghdr *msgs, int nb) {
+  int sent = 0;
+  while (sent < nb) {
+#ifdef __linux__
+    int ret = sendmmsg(udp_socket, msgs + sent, nb - sent, 0);
+#else
+    int ret = (sendmsg(udp_socket, &msgs[sent].msg_hdr, 0) < 0) ? -1 : 1;
+#endif
+    if (ret < 0) {
+      printf("App Server: stg wrong with send func\n");
+      fflush(stdout);
+      return;
+    }
+    sent += ret;
+  }
+}
+
+//Broadcast the pending ivy msgs to clients
 void broadcast_to_clients () {
 
-  int i;
+  int i, j;
+
+  if (pending_nb == 0) {
+    return;
+  }
 
   if (uTCP) {
-    //broadcast using tcp connection
+    //broadcast using tcp connection, all messages of the tick in one write
     GError *error = NULL;
 
     for (i = 0; i < MAXCLIENT; i++) {
       if (ConnectedClients[i].used > 0) {
         GOutputStream * ostream = g_io_stream_get_output_stream (ConnectedClients[i].ClientTcpData);
-        g_output_stream_write(ostream, ivybuffer, strlen(ivybuffer), NULL, &error);
+        g_output_stream_write(ostream, pending_buf, pending_len, NULL, &error);
+        g_clear_error(&error);
       }
-
     }
-    return;
   }
+  else {
+    //one datagram per message and client, all sent on the same socket
+    static struct mmsghdr msgs[MAXPENDINGMSG];
+    int nb = 0;
 
-  i=0;
-  for (i = 0; i < MAXCLIENT; i++) {
-    if (ConnectedClients[i].used > 0) {
-
-      //Send data
-      GInetAddress *udpAddress;
-      GSocketAddress *udpSocketAddress;
-      GSocket *udpSocket;
-
-      udpAddress = g_inet_address_new_from_string(ConnectedClients[i].client_ip);
-
-      udpSocketAddress = g_inet_socket_address_new(udpAddress, udp_port);
-
-      udpSocket = g_socket_new(G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM, 17, NULL);
-
-      if (g_socket_connect(udpSocket, udpSocketAddress, NULL, NULL) == FALSE) {
-        printf("App Server: stg wrong with socket connect\n");
-        fflush(stdout);
-      }
-      if (g_socket_send(udpSocket, ivybuffer, strlen(ivybuffer) , NULL, NULL) < 0) {
-        printf("App Server: stg wrong with send func\n");
-        fflush(stdout);
-      }
-      if (g_socket_close(udpSocket, NULL) == FALSE) {
-        printf("App Server: stg wrong with socket close\n");
-        fflush(stdout);
+    for (i = 0; i < MAXCLIENT; i++) {
+      if (ConnectedClients[i].used > 0 && ConnectedClients[i].udp_addr_len > 0) {
+        for (j = 0; j < pending_nb; j++) {
+          memset(&msgs[nb], 0, sizeof(struct mmsghdr));
+          msgs[nb].msg_hdr.msg_name = &ConnectedClients[i].udp_addr;
+          msgs[nb].msg_hdr.msg_namelen = ConnectedClients[i].udp_addr_len;
+          msgs[nb].msg_hdr.msg_iov = &pending_msgs[j];
+          msgs[nb].msg_hdr.msg_iovlen = 1;
+          if (++nb == MAXPENDINGMSG) {
+            send_datagrams(msgs, nb);
+            nb = 0;
+          }
+        }
       }
-      //Unref objects
-      g_object_unref(udpAddress);
-      g_object_unref(udpSocketAddress);
-      g_object_unref(udpSocket);
     }
+    send_datagrams(msgs, nb);
   }
 
+  pending_nb = 0;
+  pending_len = 0;
+}
+
+//Broadcast tick, started by the first message to send
+gboolean broadcast_tick(gpointer data) {
+  pending_timer = 0;
+  broadcast_to_clients();
+  return FALSE;
 }
 
 //Read tcp requests of connected clients
@@ -487,12 +575,32 @@ void request_ac_config(int ac_id_req) {
 //Ivy msg function
 void Ivy_All_Msgs(IvyClientPtr app, void *user_data, int argc, char *argv[]){
 
-  //For compatibility.. This will be joined in upcoming releases..
-  if (uTCP) sprintf(ivybuffer, "%s\n", argv[0]);
-  else sprintf(ivybuffer, "%s", argv[0]);
+  size_t len = strlen(argv[0]);
+  if (len > BUFLEN - 2) {
+    len = BUFLEN - 2;
+  }
 
-  //Ivy msg received broadcast to clients..
-  broadcast_to_clients();
+  //No room left for this tick, send the previous messages now
+  if (pending_nb == MAXPENDINGMSG || pending_len + len + 1 > PENDINGBUFLEN) {
+    broadcast_to_clients();
+  }
+
+  char *msg = pending_buf + pending_len;
+  memcpy(msg, argv[0], len);
+  //For compatibility.. This will be joined in upcoming releases..
+  if (uTCP) msg[len++] = '\n';
+  pending_msgs[pending_nb].iov_base = msg;
+  pending_msgs[pending_nb].iov_len = len;
+  pending_nb++;
+  pending_len += len;
+
+  //Ivy msg received broadcast to clients on the next tick..
+  if (coalesce_period <= 0) {
+    broadcast_to_clients();
+  }
+  else if (pending_timer == 0) {
+    pending_timer = g_timeout_add(coalesce_period, broadcast_tick, NULL);
+  }
 
 }
 
@@ -819,6 +927,7 @@ void print_help() {
   printf("   -b <Ivy bus>\tdefault is %s\n", defaultIvyBus);
   printf("   -p <password>\tpassword for connection with control capabilities (default is %s)\n", defaultAppPass);
   printf("   -utcp \t\tUse TCP communication to send ivy messages (default: UDP )\n");
+  printf("   -c <period>\tcoalesce ivy messages sent to clients during period ms, 0 to disable (default: %d)\n", coalesce_period);
   printf("   -v\tverbose\n");
   printf("   -h --help show this help\n");
 }
@@ -866,6 +975,9 @@ int main(int argc, char **argv) {
     else if (strcmp(argv[i], "-utcp") == 0) {
       uTCP = 1;
     }
+    else if (strcmp(argv[i], "-c") == 0) {
+      coalesce_period = atoi(argv[++i]);
+    }
     else {
       printf("App Server: Unknown option\n");
       print_help();
@@ -887,6 +999,29 @@ int main(int argc, char **argv) {
   }
 
 
+  //Create udp socket, shared by all clients
+  if (!uTCP) {
+    int v6only = 0;
+    udp_socket = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+    if (udp_socket >= 0 && setsockopt(udp_socket, IPPROTO_IPV6, IPV6_V6ONLY, &v6only, sizeof(v6only)) < 0) {
+      close(udp_socket);
+      udp_socket = -1;
+    }
+    if (udp_socket < 0) {
+      //no dual stack socket (IPv6 disabled), IPv4 clients only
+      udp_family = AF_INET;
+      udp_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+      if (udp_socket < 0) {
+        perror("App Server: udp socket");
+        exit(1);
+      }
+      if (verbose) {
+        printf("App Server: IPv6 not available, udp broadcast to IPv4 clients only\n");
+        fflush(stdout);
+      }
+    }
+  }
+
   //Create tcp listener
 #if !GLIB_CHECK_VERSION (2, 35, 1)
   // init GLib type system (only for older version)
@@ -27,6 +27,12 @@ let gps_mode_3D = 3
 let no_md5_check = ref false
 let replay_old_log = ref false
 
+(** Sharding of the aircrafts over several server processes (-shards) *)
+let nb_shards = ref 1
+let shard = ref 0
+(** Messages received by this shard, reported periodically when sharded *)
+let shard_msgs = ref 0
+
 
 open Printf
 open Latlong
@@ -56,13 +62,18 @@ let get_indexed_value = fun ?(text="UNK") t i ->
 (** The aircrafts store *)
 let aircrafts = Hashtbl.create 3
 
+(** Aircrafts handled by the other shards, known by the first shard only *)
+let shard_aircrafts = Hashtbl.create 3
+
 (** Broadcast of the received aircrafts *)
 let aircraft_msg_period = 500 (* ms *)
 let wind_msg_period = 5000 (* ms *)
 let aircraft_alerts_period = 1000 (* ms *)
 let send_aircrafts_msg = fun _asker _values ->
   assert(_values = []);
-  let names = String.concat "," (Hashtbl.fold (fun k _v r -> k::r) aircrafts []) ^ "," in
+  let names = Hashtbl.fold (fun k _v r -> k::r) aircrafts [] in
+  let names = Hashtbl.fold (fun k _v r -> if List.mem k r then r else k::r) shard_aircrafts names in
+  let names = String.concat "," names ^ "," in
   ["ac_list", PprzLink.String names]
 
 
@@ -117,6 +128,7 @@ let start_time = U.gettimeofday ()
 let logger = fun () ->
   let d = U.localtime start_time in
   let basename = sprintf "%02d_%02d_%02d__%02d_%02d_%02d" (d.U.tm_year mod 100) (d.U.tm_mon+1) (d.U.tm_mday) (d.U.tm_hour) (d.U.tm_min) (d.U.tm_sec) in
+  let basename = if !nb_shards > 1 then sprintf "%s_shard%d" basename !shard else basename in
   if not (Sys.file_exists logs_path) then begin
     printf "Creating '%s'\n" logs_path; flush stdout;
     Unix.mkdir logs_path 0o755
@@ -160,6 +172,7 @@ let ac_msg = fun messages_xml logging ac_name ac ->
   let module Tele_Pprz = PprzLink.MessagesOfXml(struct let xml = messages_xml let name="telemetry" end) in
   fun ts m ->
     try
+      incr shard_msgs;
       let timestamp = try Some (float_of_string ts) with _ -> None in
       let (msg_id, values) = Tele_Pprz.values_of_string m in
       let msg = Tele_Pprz.message_of_id msg_id in
@@ -501,6 +514,18 @@ let replayed = fun ac_id ->
   else
     (false, ac_id, "", conf_xml)
 
+(** Shard of an A/C: numeric ids are dealt in turn, other names by hash *)
+let shard_of_ac = fun ac_id ->
+  let n = String.length ac_id in
+  let id = if n > 6 && String.sub ac_id 0 6 = "replay" then String.sub ac_id 6 (n - 6) else ac_id in
+  let key = try abs (int_of_string id) with _ -> Hashtbl.hash id in
+  key mod !nb_shards
+
+let owned = fun ac_id -> !nb_shards = 1 || shard_of_ac ac_id = !shard
+
+(** The first shard answers the requests which are not specific to an A/C *)
+let main_shard = fun () -> !shard = 0
+
 (* Store of unknown received A/C ids. To be able to report an error only once *)
 let unknown_aircrafts = Hashtbl.create 5
 
@@ -665,7 +690,8 @@ let register_aircraft = fun name a ->
 (** Identifying message from an A/C *)
 let ident_msg = fun log timestamp name vs ->
   try
-    if not (Hashtbl.mem aircrafts name) &&
+    if owned name &&
+      not (Hashtbl.mem aircrafts name) &&
       not (Hashtbl.mem unknown_aircrafts name) then
       let get_md5sum = fun () -> PprzLink.assoc "md5sum" vs in
       let ac, messages_xml = new_aircraft get_md5sum name in
@@ -682,6 +708,19 @@ let ident_msg = fun log timestamp name vs ->
 let new_color = fun () ->
   sprintf "#%02x%02x%02x" (Random.int 256) (Random.int 256) (Random.int 256)
 
+(** Keep the list of the aircrafts of the other shards for the AIRCRAFTS answer *)
+let listen_shards = fun () ->
+  ignore (Ground_Pprz.message_bind "NEW_AIRCRAFT" (fun _sender vs ->
+    let name = PprzLink.string_assoc "ac_id" vs in
+    if not (owned name) then Hashtbl.replace shard_aircrafts name ()))
+
+(** Periodic report of the load of the shard *)
+let shard_report_period = 10000 (* ms *)
+let report_shard = fun () ->
+  fprintf stderr "server shard %d/%d: %d aircraft(s), %.0f msgs/s\n%!" !shard !nb_shards
+    (Hashtbl.length aircrafts) (float !shard_msgs *. 1000. /. float shard_report_period);
+  shard_msgs := 0
+
 (* Waits for new aircrafts *)
 let listen_acs = fun log timestamp ->
   (** Wait for any message (they all are identified with the A/C) *)
@@ -884,7 +923,9 @@ let link_report = fun logging _sender vs ->
 (** Get the 'ground' uplink messages, log them and send 'datalink' messages *)
 let ground_to_uplink = fun logging ->
   let bind_log_and_send = fun name handler ->
-    ignore (Ground_Pprz.message_bind name (handler logging)) in
+    (* only the shard of the A/C forwards the message *)
+    ignore (Ground_Pprz.message_bind name (fun sender vs ->
+      if owned (PprzLink.string_assoc "ac_id" vs) then handler logging sender vs)) in
   bind_log_and_send "MOVE_WAYPOINT" move_wp;
   bind_log_and_send "DL_EMERGENCY_CMD" emergency_cmd;
   bind_log_and_send "DL_SETTING" setting;
@@ -899,7 +940,8 @@ let () =
   let ivy_bus = ref Defivybus.default_ivy_bus
   and logging = ref true
   and http = ref false
-  and timestamp = ref false in
+  and timestamp = ref false
+  and fork_shards = ref true in
 
   let options =
     [ "-b", Arg.String (fun x -> ivy_bus := x), (sprintf "Bus\tDefault is %s" !ivy_bus);
@@ -911,15 +953,46 @@ let () =
       "-n", Arg.Clear logging, "Disable log";
       "-timestamp", Arg.Set timestamp, "Bind on timestampped messages";
       "-no_md5_check", Arg.Set no_md5_check, "Disable safety matching of live and current configurations";
-      "-replay_old_log", Arg.Set replay_old_log, "Enable aircraft registering on PPRZ_MODE messages"] in
+      "-replay_old_log", Arg.Set replay_old_log, "Enable aircraft registering on PPRZ_MODE messages";
+      "-shards", Arg.Set_int nb_shards, "<n> Share the aircrafts among n server processes (by ac_id modulo n)";
+      "-shard", Arg.Int (fun i -> shard := i; fork_shards := false), "<i> Only run the shard i of -shards, the other ones being started separately"] in
 
   Arg.parse
     options
     (fun x -> Printf.fprintf stderr "%s: Warning: Don't do anything with '%s' argument\n" Sys.argv.(0) x)
     "Usage: ";
 
+  if !nb_shards < 1 || !shard < 0 || !shard >= !nb_shards then begin
+    fprintf stderr "%s: invalid shard %d of %d\n" Sys.argv.(0) !shard !nb_shards;
+    exit 1
+  end;
+  (* This process is the first shard, fork the other ones *)
+  if !fork_shards && !nb_shards > 1 then begin
+    let parent = U.getpid ()
+    and children = ref [] in
+    for i = 1 to !nb_shards - 1 do
+      if main_shard () then
+        match U.fork () with
+        | 0 -> shard := i
+        | pid -> children := pid :: !children
+    done;
+    if main_shard () then begin
+      (* stop the other shards with the first one *)
+      at_exit (fun () -> List.iter (fun pid -> try U.kill pid Sys.sigterm with _ -> ()) !children);
+      let stop = Sys.Signal_handle (fun _ -> exit 0) in
+      Sys.set_signal Sys.sigterm stop;
+      Sys.set_signal Sys.sigint stop
+    end;
+    (* Every second: a forked shard exits when the first one is gone (it may
+       have been killed with SIGKILL), and the first one gets a chance to
+       handle its signals while the main loop waits *)
+    ignore (Glib.Timeout.add 1000 (fun () ->
+      if not (main_shard ()) && U.getppid () <> parent then exit 0;
+      true))
+  end;
+
   Srtm.add_path srtm_path;
-  Ivy.init "Paparazzi server" "READY" (fun _ _ -> ());
+  Ivy.init (if !nb_shards > 1 then sprintf "Paparazzi server %d" !shard else "Paparazzi server") "READY" (fun _ _ -> ());
   Ivy.start !ivy_bus;
 
   let logging =
@@ -932,17 +1005,24 @@ let () =
   (* Waits for new aircrafts *)
   listen_acs logging !timestamp;
 
-  (* wait for new external vehicles/intruders *)
-  listen_intruders logging;
-
   (* Forward messages from ground agents to vehicles *)
   ground_to_uplink logging;
 
-  (* call periodic_handle_intruders every second *)
-  ignore (Glib.Timeout.add 1000 (fun () -> periodic_handle_intruders (); true));
+  if main_shard () then begin
+    (* wait for new external vehicles/intruders *)
+    listen_intruders logging;
 
-  (* Waits for client configurations requests on the Ivy bus *)
-  ivy_server !http;
+    (* call periodic_handle_intruders every second *)
+    ignore (Glib.Timeout.add 1000 (fun () -> periodic_handle_intruders (); true));
+
+    (* Waits for client configurations requests on the Ivy bus *)
+    ivy_server !http
+  end;
+
+  if !nb_shards > 1 then begin
+    if main_shard () then listen_shards ();
+    ignore (Glib.Timeout.add shard_report_period (fun () -> report_shard (); true))
+  end;
 
   let loop = Glib.Main.create true in
   while Glib.Main.is_running loop do ignore (Glib.Main.iteration true) done
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2026 The Paparazzi Team
+#
+# This file is part of paparazzi.
+#
+# paparazzi is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2, or (at your option)
+# any later version.
+#
+# paparazzi is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with paparazzi; see the file COPYING.  If not, write to
+# the Free Software Foundation, 59 Temple Place - Suite 330,
+# Boston, MA 02111-1307, USA.
+#
+
+"""
+Decoding of binary pprzlink v2 frames, as sent by the NPS display output
+(nps --display_udp host:port).
+
+A datagram holds one or more frames:
+    STX(0x99) LEN SENDER RECEIVER COMP_CLASS MSG_ID PAYLOAD CK_A CK_B
+
+Messages are decoded with precompiled struct formats built from the message
+definitions, so a ground tool can read the values without the text round trip
+through Ivy. With --ivy the messages are forwarded to the Ivy bus in the usual
+text format.
+"""
+
+from __future__ import print_function
+
+import os
+import sys
+import struct
+import socket
+
+from pprz_env import PAPARAZZI_HOME
+
+sys.path.append(PAPARAZZI_HOME + "/var/lib/python")
+
+STX = 0x99
+HEADER_LEN = 6
+CLASS_NAMES = {1: 'telemetry', 2: 'datalink', 3: 'ground', 4: 'alert', 5: 'intermcu'}
+
+# struct codes of the scalar field types
+TYPE_CODES = {
+    'uint8': 'B', 'int8': 'b', 'uint16': 'H', 'int16': 'h',
+    'uint32': 'I', 'int32': 'i', 'uint64': 'Q', 'int64': 'q',
+    'float': 'f', 'double': 'd', 'char': 'c'
+}
+
+
+def checksum(frame):
+    """Checksums of a frame, computed from LEN to the end of the payload"""
+    ck_a = ck_b = frame[1]
+    for b in frame[2:frame[1] - 2]:
+        ck_a = (ck_a + b) & 0xFF
+        ck_b = (ck_b + ck_a) & 0xFF
+    return ck_a, ck_b
+
+
+def iter_frames(data):
+    """Iterate on the valid frames of a buffer
+
+    Yields (sender, receiver, class_id, msg_id, payload) with the payload
+    as a memoryview. Broken data is skipped up to the next STX.
+    """
+    data = memoryview(data)
+    pos = 0
+    end = len(data)
+    while pos + HEADER_LEN + 2 <= end:
+        if data[pos] != STX:
+            pos += 1
+            continue
+        length = data[pos + 1]
+        if length < HEADER_LEN + 2 or pos + length > end:
+            pos += 1
+            continue
+        frame = data[pos:pos + length]
+        if checksum(frame) != (frame[-2], frame[-1]):
+            pos += 1
+            continue
+        yield frame[2], frame[3], frame[4] & 0x0F, frame[5], frame[HEADER_LEN:-2]
+        pos += length
+
+
+class Decoder(object):
+    """Decodes message payloads into (name, field names, values)
+
+    The struct of each message is built once, on its first reception. Only
+    messages with scalar fields (and a last array field) are handled,
+    which covers the NPS display messages.
+    """
+
+    def __init__(self):
+        from pprzlink import messages_xml_map
+        messages_xml_map.parse_messages()
+        self._map = messages_xml_map
+        self._cache = {}
+
+    def _compile(self, class_name, msg_id):
+        name = self._map.message_dictionary_id_name[class_name][msg_id]
+        names = self._map.message_dictionary_types[class_name][msg_id]
+        fields = self._map.message_dictionary[class_name][name]
+        fmt = '<'
+        for i, t in enumerate(names):
+            if t.endswith('[]'):
+                if i != len(names) - 1:
+                    return name, fields, None
+                break
+            fmt += TYPE_CODES[t]
+        return name, fields, struct.Struct(fmt)
+
+    def decode(self, class_id, msg_id, payload):
+        key = (class_id, msg_id)
+        entry = self._cache.get(key)
+        if entry is None:
+            entry = self._compile(CLASS_NAMES[class_id], msg_id)
+            self._cache[key] = entry
+        name, fields, st = entry
+        if st is None or len(payload) < st.size:
+            return name, fields, None
+        return name, fields, st.unpack_from(payload)
+
+
+def main():
+    import argparse
+    parser = argparse.ArgumentParser(description="Decode binary pprzlink frames received over UDP")
+    parser.add_argument('-p', '--port', type=int, default=4260, help="UDP port to listen on")
+    parser.add_argument('--ivy', action='store_true', help="forward the messages to the Ivy bus")
+    parser.add_argument('-b', '--bus', default="", help="Ivy bus address")
+    args = parser.parse_args()
+
+    decoder = Decoder()
+    ivy = None
+    if args.ivy:
+        from pprzlink.ivy import IvyMessagesInterface
+        ivy = IvyMessagesInterface("pprz_frames", start_ivy=True, ivy_bus=args.bus)
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(('', args.port))
+    try:
+        while True:
+            data = sock.recv(65536)
+            for sender, _, class_id, msg_id, payload in iter_frames(data):
+                try:
+                    name, _, values = decoder.decode(class_id, msg_id, payload)
+                except KeyError:
+                    continue
+                if values is None:
+                    continue
+                text = "%d %s %s" % (sender, name, ' '.join(
+                    v.decode() if isinstance(v, bytes) else repr(v) for v in values))
+                if ivy is not None:
+                    ivy.send(text)
+                else:
+                    print(text)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if ivy is not None:
+            ivy.shutdown()
+
+
+if __name__ == '__main__':
+    main()
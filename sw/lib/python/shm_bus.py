@@ -0,0 +1,135 @@
+#
+# Copyright (C) 2026 The Paparazzi Team
+#
+# This file is part of paparazzi.
+#
+# paparazzi is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2, or (at your option)
+# any later version.
+#
+# paparazzi is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with paparazzi; see the file COPYING.  If not, write to
+# the Free Software Foundation, 59 Temple Place - Suite 330,
+# Boston, MA 02111-1307, USA.
+#
+
+"""
+Python access to the shared memory ground bus (sw/ground_segment/misc/shm_bus.h)
+
+The bus implementation is shared with the C tools through libshm_bus.so,
+built in sw/ground_segment/misc.
+
+    bus = ShmBus("/paparazzi")
+    bus.subscribe(1)              # all telemetry messages
+    for payload in bus.messages(timeout_ms=100):
+        sender, receiver, comp_class, msg_id = payload[:4]
+"""
+
+from __future__ import print_function
+
+import os
+import ctypes
+import errno
+
+from pprz_env import PAPARAZZI_SRC
+
+DEFAULT_NAME = "/paparazzi"
+MAX_PAYLOAD = 255
+NB_TOPICS = 16 * 256
+
+_LIB_PATH = os.getenv("SHM_BUS_LIB", os.path.join(PAPARAZZI_SRC, "sw/ground_segment/misc/libshm_bus.so"))
+
+
+class _ShmBus(ctypes.Structure):
+    _fields_ = [
+        ('hdr', ctypes.c_void_p),
+        ('data', ctypes.c_void_p),
+        ('map_size', ctypes.c_size_t),
+        ('origin', ctypes.c_uint16),
+        ('read_pos', ctypes.c_uint64),
+        ('lost', ctypes.c_uint64),
+        ('topics', ctypes.c_uint32 * (NB_TOPICS // 32)),
+    ]
+
+
+_lib = None
+
+
+def _load():
+    global _lib
+    if _lib is None:
+        lib = ctypes.CDLL(_LIB_PATH, use_errno=True)
+        lib.shm_bus_open.argtypes = [ctypes.POINTER(_ShmBus), ctypes.c_char_p, ctypes.c_size_t]
+        lib.shm_bus_close.argtypes = [ctypes.POINTER(_ShmBus)]
+        lib.shm_bus_unlink.argtypes = [ctypes.c_char_p]
+        lib.shm_bus_subscribe.argtypes = [ctypes.POINTER(_ShmBus), ctypes.c_int, ctypes.c_int]
+        lib.shm_bus_unsubscribe_all.argtypes = [ctypes.POINTER(_ShmBus)]
+        lib.shm_bus_publish.argtypes = [ctypes.POINTER(_ShmBus), ctypes.c_char_p, ctypes.c_uint16]
+        lib.shm_bus_read.argtypes = [ctypes.POINTER(_ShmBus), ctypes.c_char_p]
+        lib.shm_bus_wait.argtypes = [ctypes.POINTER(_ShmBus), ctypes.c_int]
+        lib.shm_bus_wait.restype = ctypes.c_bool
+        _lib = lib
+    return _lib
+
+
+class ShmBus(object):
+    """A connection to the bus, to publish and read messages"""
+
+    def __init__(self, name=DEFAULT_NAME, size=0):
+        self._lib = _load()
+        self._bus = _ShmBus()
+        self._buf = ctypes.create_string_buffer(MAX_PAYLOAD)
+        if self._lib.shm_bus_open(ctypes.byref(self._bus), name.encode(), size) < 0:
+            err = ctypes.get_errno()
+            raise OSError(err, "shm_bus %s: %s" % (name, os.strerror(err)))
+
+    def close(self):
+        if self._bus.hdr:
+            self._lib.shm_bus_close(ctypes.byref(self._bus))
+
+    @property
+    def lost(self):
+        """Number of times the reader was overrun by the writers"""
+        return self._bus.lost
+
+    def subscribe(self, class_id=-1, msg_id=-1):
+        self._lib.shm_bus_subscribe(ctypes.byref(self._bus), class_id, msg_id)
+
+    def unsubscribe_all(self):
+        self._lib.shm_bus_unsubscribe_all(ctypes.byref(self._bus))
+
+    def publish(self, payload):
+        """Publish a pprzlink v2 payload (sender, receiver, comp_class, msg_id, fields)"""
+        if self._lib.shm_bus_publish(ctypes.byref(self._bus), bytes(payload), len(payload)) < 0:
+            raise ValueError("invalid payload of %d bytes" % len(payload))
+
+    def read(self):
+        """Next subscribed payload, None if there is none yet"""
+        n = self._lib.shm_bus_read(ctypes.byref(self._bus), self._buf)
+        return self._buf.raw[:n] if n > 0 else None
+
+    def wait(self, timeout_ms=-1):
+        return self._lib.shm_bus_wait(ctypes.byref(self._bus), timeout_ms)
+
+    def messages(self, timeout_ms=100):
+        """Iterate on the subscribed payloads, yields None on timeout"""
+        while True:
+            payload = self.read()
+            if payload is not None:
+                yield payload
+            elif not self.wait(timeout_ms):
+                yield None
+
+
+def unlink(name=DEFAULT_NAME):
+    try:
+        _load().shm_bus_unlink(name.encode())
+    except OSError as e:
+        if e.errno != errno.ENOENT:
+            raise
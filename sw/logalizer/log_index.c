@@ -0,0 +1,535 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+/** Indexed flight log container, see log_index.h for the layout */
+
+#include "log_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define PPRZLOG_STX 0x99
+#define PPRZLOG_HEADER_LEN 7    ///< STX, LEN, SOURCE, TIMESTAMP[4]
+#define NAMES_HASH_SIZE 4096    ///< Must be a power of 2 above the maximum number of names
+
+/*
+ * Reading
+ */
+
+/** Open and map a log
+    @return 0 on success, -1 on error (with a message on stderr) */
+int plx_open(struct plx_file *f, const char *path)
+{
+  struct stat st;
+
+  memset(f, 0, sizeof(*f));
+  f->fd = open(path, O_RDONLY);
+  if (f->fd < 0 || fstat(f->fd, &st) < 0) {
+    perror(path);
+    return -1;
+  }
+  f->size = st.st_size;
+  if (f->size < sizeof(struct plx_header)) {
+    fprintf(stderr, "%s: not an indexed log\n", path);
+    close(f->fd);
+    return -1;
+  }
+  f->map = mmap(NULL, f->size, PROT_READ, MAP_SHARED, f->fd, 0);
+  if (f->map == MAP_FAILED) {
+    perror(path);
+    close(f->fd);
+    return -1;
+  }
+
+  f->hdr = (const struct plx_header *)f->map;
+  const struct plx_header *h = f->hdr;
+  if (memcmp(h->magic, PLX_MAGIC, 8) != 0 || h->version != PLX_VERSION ||
+      h->acs_offset + (uint64_t)h->acs_cnt * PLX_NAME_LEN > f->size ||
+      h->chunks_offset + (uint64_t)h->chunks_cnt * sizeof(struct plx_chunk) > f->size ||
+      h->types_offset + (uint64_t)h->types_cnt * sizeof(struct plx_type) > f->size ||
+      h->data_offset + h->data_size > f->size) {
+    fprintf(stderr, "%s: not an indexed log or unsupported version\n", path);
+    plx_close(f);
+    return -1;
+  }
+  f->chunks = (const struct plx_chunk *)(f->map + h->chunks_offset);
+  f->types = (const struct plx_type *)(f->map + h->types_offset);
+  f->acs = (const char (*)[PLX_NAME_LEN])(f->map + h->acs_offset);
+
+  // Mostly read sequentially
+  madvise(f->map, f->size, MADV_SEQUENTIAL);
+  return 0;
+}
+
+void plx_close(struct plx_file *f)
+{
+  if (f->map != NULL && f->map != MAP_FAILED) {
+    munmap(f->map, f->size);
+  }
+  if (f->fd >= 0) {
+    close(f->fd);
+  }
+  f->map = NULL;
+  f->fd = -1;
+}
+
+/** @return The type index of a message name, -1 if not in the log */
+int plx_find_type(const struct plx_file *f, const char *name)
+{
+  for (uint32_t i = 0; i < f->hdr->types_cnt; i++) {
+    if (strncmp(f->types[i].name, name, PLX_NAME_LEN) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/** @return The aircraft index of an aircraft name, -1 if not in the log */
+int plx_find_ac(const struct plx_file *f, const char *name)
+{
+  for (uint32_t i = 0; i < f->hdr->acs_cnt; i++) {
+    if (strncmp(f->acs[i], name, PLX_NAME_LEN) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/** @return The first chunk which may contain records at or after time t
+    (chunks_cnt if there is none) */
+uint32_t plx_seek_chunk(const struct plx_file *f, double t)
+{
+  // t_max never decreases, so the first chunk reaching t is found by bisection
+  uint32_t lo = 0, hi = f->hdr->chunks_cnt;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (f->chunks[mid].t_max < t) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/** @return The offset of the first record at or after time t
+    (plx_data_end() if there is none) */
+uint64_t plx_seek(const struct plx_file *f, double t)
+{
+  uint32_t c = plx_seek_chunk(f, t);
+  if (c >= f->hdr->chunks_cnt) {
+    return plx_data_end(f);
+  }
+  uint64_t offset = f->chunks[c].offset;
+  while (offset < plx_data_end(f) && plx_record_at(f, offset)->t < t) {
+    offset = plx_next(f, offset);
+  }
+  return offset;
+}
+
+const struct plx_record *plx_record_at(const struct plx_file *f, uint64_t offset)
+{
+  return (const struct plx_record *)(f->map + offset);
+}
+
+uint64_t plx_next(const struct plx_file *f, uint64_t offset)
+{
+  return offset + PLX_ALIGN(sizeof(struct plx_record) + plx_record_at(f, offset)->len);
+}
+
+/** @return The numbers of the chunks containing records of a type
+    (f->types[type].chunks_cnt of them) */
+const uint32_t *plx_type_chunks(const struct plx_file *f, int type)
+{
+  return (const uint32_t *)(f->map + f->types[type].chunks_offset);
+}
+
+/*
+ * Writing
+ */
+
+/* Growing array */
+struct plx_array {
+  void *buf;
+  size_t cnt;
+  size_t size;
+};
+
+static void *plx_array_add(struct plx_array *a, size_t elem_size)
+{
+  if (a->cnt == a->size) {
+    a->size = a->size ? 2 * a->size : 64;
+    a->buf = realloc(a->buf, a->size * elem_size);
+    if (a->buf == NULL) {
+      fprintf(stderr, "Out of memory\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  return (uint8_t *)a->buf + (a->cnt++) * elem_size;
+}
+
+/* Table of names with a hash index */
+struct plx_names {
+  struct plx_array names;       ///< char[PLX_NAME_LEN]
+  int32_t hash[NAMES_HASH_SIZE];
+};
+
+static void plx_names_init(struct plx_names *n)
+{
+  memset(n, 0, sizeof(*n));
+  memset(n->hash, -1, sizeof(n->hash));
+}
+
+static int plx_names_get(struct plx_names *n, const char *name)
+{
+  uint32_t h = 2166136261u;
+  for (const char *c = name; *c != '\0'; c++) {
+    h = (h ^ (uint8_t)*c) * 16777619u;
+  }
+  for (uint32_t i = h & (NAMES_HASH_SIZE - 1);; i = (i + 1) & (NAMES_HASH_SIZE - 1)) {
+    int32_t idx = n->hash[i];
+    if (idx < 0) {
+      if (n->names.cnt >= NAMES_HASH_SIZE / 2) {
+        return -1;
+      }
+      char *entry = plx_array_add(&n->names, PLX_NAME_LEN);
+      memset(entry, 0, PLX_NAME_LEN);
+      strncpy(entry, name, PLX_NAME_LEN - 1);
+      n->hash[i] = n->names.cnt - 1;
+      return n->names.cnt - 1;
+    }
+    if (strncmp((char *)n->names.buf + idx * PLX_NAME_LEN, name, PLX_NAME_LEN - 1) == 0) {
+      return idx;
+    }
+  }
+}
+
+/* Writing state of a type */
+struct plx_writer_type {
+  uint64_t records_cnt;
+  uint32_t last_chunk;
+  struct plx_array chunks;      ///< uint32_t
+};
+
+struct plx_writer {
+  FILE *fp;
+  struct plx_header hdr;
+  struct plx_names acs;
+  struct plx_names type_names;
+  struct plx_array types;       ///< struct plx_writer_type
+  struct plx_array chunks;      ///< struct plx_chunk
+  double t_max;
+};
+
+/** Create a new indexed log
+    @return The writer, NULL on error */
+struct plx_writer *plx_writer_open(const char *path, enum plx_encoding encoding)
+{
+  struct plx_writer *w = calloc(1, sizeof(struct plx_writer));
+  w->fp = fopen(path, "wb");
+  if (w->fp == NULL) {
+    perror(path);
+    free(w);
+    return NULL;
+  }
+  // Large buffer, records are small
+  setvbuf(w->fp, NULL, _IOFBF, 1 << 20);
+
+  memcpy(w->hdr.magic, PLX_MAGIC, 8);
+  w->hdr.version = PLX_VERSION;
+  w->hdr.encoding = encoding;
+  w->hdr.data_offset = sizeof(struct plx_header);
+  w->hdr.chunk_records = PLX_CHUNK_RECORDS;
+  plx_names_init(&w->acs);
+  plx_names_init(&w->type_names);
+
+  // The header is written again when closing
+  if (fwrite(&w->hdr, sizeof(w->hdr), 1, w->fp) != 1) {
+    perror(path);
+    fclose(w->fp);
+    free(w);
+    return NULL;
+  }
+  return w;
+}
+
+/** @return The index of an aircraft name for plx_writer_add_idx(), -1 if the table is full */
+int plx_writer_ac(struct plx_writer *w, const char *ac)
+{
+  int idx = plx_names_get(&w->acs, ac);
+  if (idx < 0) {
+    fprintf(stderr, "Too many aircraft in the log\n");
+  }
+  return idx;
+}
+
+/** @return The index of a message name for plx_writer_add_idx(), -1 if the table is full */
+int plx_writer_type(struct plx_writer *w, const char *type)
+{
+  int idx = plx_names_get(&w->type_names, type);
+  if (idx < 0) {
+    fprintf(stderr, "Too many message types in the log\n");
+  }
+  return idx;
+}
+
+/** Append a record, records are expected in (mostly) increasing time
+    @return 0 on success, -1 on error */
+int plx_writer_add(struct plx_writer *w, double t, const char *ac, const char *type,
+                   const void *payload, uint32_t len)
+{
+  int ac_idx = plx_writer_ac(w, ac);
+  int type_idx = plx_writer_type(w, type);
+  if (ac_idx < 0 || type_idx < 0) {
+    return -1;
+  }
+  return plx_writer_add_idx(w, t, ac_idx, type_idx, payload, len);
+}
+
+/** Append a record with the indexes of its names
+    @return 0 on success, -1 on error */
+int plx_writer_add_idx(struct plx_writer *w, double t, uint16_t ac_idx, uint16_t type_idx,
+                       const void *payload, uint32_t len)
+{
+  static const uint8_t padding[8] = {0};
+
+  // Start a new chunk
+  uint64_t offset = w->hdr.data_offset + w->hdr.data_size;
+  if (w->hdr.records_cnt % PLX_CHUNK_RECORDS == 0) {
+    struct plx_chunk *c = plx_array_add(&w->chunks, sizeof(struct plx_chunk));
+    memset(c, 0, sizeof(*c));
+    c->t_min = t;
+    c->offset = offset;
+    c->first_record = w->hdr.records_cnt;
+  }
+  uint32_t chunk_nb = w->chunks.cnt - 1;
+  struct plx_chunk *c = (struct plx_chunk *)w->chunks.buf + chunk_nb;
+  if (t < c->t_min) {
+    c->t_min = t;
+  }
+  if (w->hdr.records_cnt == 0 || t > w->t_max) {
+    w->t_max = t;
+  }
+  if (w->hdr.records_cnt == 0 || t < w->hdr.t_start) {
+    w->hdr.t_start = t;
+  }
+  c->t_max = w->t_max;
+  c->records_cnt++;
+
+  // Type index
+  while (w->types.cnt <= (size_t)type_idx) {
+    struct plx_writer_type *wt = plx_array_add(&w->types, sizeof(struct plx_writer_type));
+    memset(wt, 0, sizeof(*wt));
+  }
+  struct plx_writer_type *wt = (struct plx_writer_type *)w->types.buf + type_idx;
+  if (wt->records_cnt == 0 || wt->last_chunk != chunk_nb) {
+    *(uint32_t *)plx_array_add(&wt->chunks, sizeof(uint32_t)) = chunk_nb;
+    wt->last_chunk = chunk_nb;
+  }
+  wt->records_cnt++;
+
+  // Record
+  struct plx_record rec = { .t = t, .ac = ac_idx, .type = type_idx, .len = len };
+  size_t size = PLX_ALIGN(sizeof(rec) + len);
+  size_t pad = size - sizeof(rec) - len;
+  if (fwrite(&rec, sizeof(rec), 1, w->fp) != 1 ||
+      (len > 0 && fwrite(payload, len, 1, w->fp) != 1) ||
+      (pad > 0 && fwrite(padding, pad, 1, w->fp) != 1)) {
+    perror("Writing the log");
+    return -1;
+  }
+  w->hdr.data_size += size;
+  w->hdr.records_cnt++;
+  return 0;
+}
+
+/** Write the indexes and close the log
+    @return 0 on success, -1 on error */
+int plx_writer_close(struct plx_writer *w)
+{
+  int ret = 0;
+  uint64_t offset = w->hdr.data_offset + w->hdr.data_size;
+
+  w->hdr.t_end = w->t_max;
+  w->hdr.chunks_offset = offset;
+  w->hdr.chunks_cnt = w->chunks.cnt;
+  if (w->chunks.cnt > 0 && fwrite(w->chunks.buf, sizeof(struct plx_chunk), w->chunks.cnt, w->fp) != w->chunks.cnt) {
+    ret = -1;
+  }
+  offset += w->chunks.cnt * sizeof(struct plx_chunk);
+
+  // Types, followed by their chunk lists
+  w->hdr.types_offset = offset;
+  w->hdr.types_cnt = w->types.cnt;
+  uint64_t lists_offset = offset + w->types.cnt * sizeof(struct plx_type);
+  for (size_t i = 0; i < w->types.cnt; i++) {
+    struct plx_writer_type *wt = (struct plx_writer_type *)w->types.buf + i;
+    struct plx_type type;
+    memset(&type, 0, sizeof(type));
+    memcpy(type.name, (char *)w->type_names.names.buf + i * PLX_NAME_LEN, PLX_NAME_LEN);
+    type.records_cnt = wt->records_cnt;
+    type.chunks_offset = lists_offset;
+    type.chunks_cnt = wt->chunks.cnt;
+    lists_offset += wt->chunks.cnt * sizeof(uint32_t);
+    if (fwrite(&type, sizeof(type), 1, w->fp) != 1) {
+      ret = -1;
+    }
+  }
+  for (size_t i = 0; i < w->types.cnt; i++) {
+    struct plx_writer_type *wt = (struct plx_writer_type *)w->types.buf + i;
+    if (wt->chunks.cnt > 0 && fwrite(wt->chunks.buf, sizeof(uint32_t), wt->chunks.cnt, w->fp) != wt->chunks.cnt) {
+      ret = -1;
+    }
+    free(wt->chunks.buf);
+  }
+
+  w->hdr.acs_offset = lists_offset;
+  w->hdr.acs_cnt = w->acs.names.cnt;
+  if (w->acs.names.cnt > 0 && fwrite(w->acs.names.buf, PLX_NAME_LEN, w->acs.names.cnt, w->fp) != w->acs.names.cnt) {
+    ret = -1;
+  }
+
+  // Final header
+  if (fseek(w->fp, 0, SEEK_SET) != 0 || fwrite(&w->hdr, sizeof(w->hdr), 1, w->fp) != 1) {
+    ret = -1;
+  }
+  if (fclose(w->fp) != 0) {
+    ret = -1;
+  }
+  if (ret < 0) {
+    perror("Writing the log index");
+  }
+
+  free(w->chunks.buf);
+  free(w->types.buf);
+  free(w->acs.names.buf);
+  free(w->type_names.names.buf);
+  free(w);
+  return ret;
+}
+
+/*
+ * Original log formats
+ */
+
+/** Write a record of a text log as a .data line, the original line */
+int plx_write_data_line(FILE *out, const struct plx_file *f, const struct plx_record *rec)
+{
+  const char *p = (const char *)plx_payload(rec);
+  const char *sep = memchr(p, ' ', rec->len);
+  int t_len = (sep != NULL) ? sep - p : (int)rec->len;
+  int fields_len = (sep != NULL) ? (int)rec->len - t_len - 1 : 0;
+  return fprintf(out, "%.*s %s %s %.*s\n", t_len, p, f->acs[rec->ac], f->types[rec->type].name,
+                 fields_len, (sep != NULL) ? sep + 1 : p);
+}
+
+/** Write a record of a pprzlog log as a pprzlog frame (the .tlm format) */
+int plx_write_pprzlog(FILE *out, const struct plx_file *f __attribute__((unused)), const struct plx_record *rec)
+{
+  const uint8_t *p = plx_payload(rec);
+  if (rec->len < 1) {
+    return 0;
+  }
+  uint8_t data_len = rec->len - 1;
+  uint32_t ts = (uint32_t)(rec->t * 1e4 + 0.5);
+  uint8_t frame[PPRZLOG_HEADER_LEN + 256];
+
+  frame[0] = PPRZLOG_STX;
+  frame[1] = data_len;
+  frame[2] = p[0];
+  frame[3] = ts & 0xff;
+  frame[4] = (ts >> 8) & 0xff;
+  frame[5] = (ts >> 16) & 0xff;
+  frame[6] = (ts >> 24) & 0xff;
+  memcpy(&frame[PPRZLOG_HEADER_LEN], &p[1], data_len);
+  uint8_t ck = 0;
+  for (int i = 1; i < PPRZLOG_HEADER_LEN + data_len; i++) {
+    ck += frame[i];
+  }
+  frame[PPRZLOG_HEADER_LEN + data_len] = ck;
+  return fwrite(frame, PPRZLOG_HEADER_LEN + data_len + 1, 1, out) == 1 ? 0 : -1;
+}
+
+/** Split a .data line "time ac_id MSG_NAME fields"
+    @param[out] t_text,t_len The time as written in the line
+    @param[out] ac,type At least PLX_NAME_LEN bytes
+    @param[out] fields Points to the fields in the line (without the newline)
+    @return 0 on success, -1 if the line is not a message */
+int plx_parse_data_line(const char *line, double *t, const char **t_text, int *t_len,
+                        char *ac, char *type, const char **fields)
+{
+  int n = 0, t_start = 0, t_end = 0;
+  if (sscanf(line, " %n%lf%n %31s %31s%n", &t_start, t, &t_end, ac, type, &n) != 3) {
+    return -1;
+  }
+  *t_text = line + t_start;
+  *t_len = t_end - t_start;
+  const char *c = line + n;
+  while (*c == ' ') {
+    c++;
+  }
+  *fields = c;
+  return 0;
+}
+
+/** Parse one pprzlog frame (STX, LEN, SOURCE, TIMESTAMP[4], DATA[LEN], CHECKSUM)
+    @return The length of the frame, 0 if buf is too short for the frame,
+    -1 if there is no valid frame at the start of buf */
+long plx_parse_pprzlog(const uint8_t *buf, size_t len, double *t, uint8_t *source,
+                       const uint8_t **data, uint8_t *data_len)
+{
+  if (len < PPRZLOG_HEADER_LEN + 1) {
+    return 0;
+  }
+  if (buf[0] != PPRZLOG_STX) {
+    return -1;
+  }
+  size_t frame_len = PPRZLOG_HEADER_LEN + buf[1] + 1;
+  if (len < frame_len) {
+    return 0;
+  }
+  uint8_t ck = 0;
+  for (size_t i = 1; i < frame_len - 1; i++) {
+    ck += buf[i];
+  }
+  if (ck != buf[frame_len - 1] || buf[1] < 2) {
+    return -1;
+  }
+  uint32_t ts = buf[3] | (buf[4] << 8) | (buf[5] << 16) | ((uint32_t)buf[6] << 24);
+  *t = ts / 1e4;
+  *source = buf[2];
+  *data = &buf[PPRZLOG_HEADER_LEN];
+  *data_len = buf[1];
+  return frame_len;
+}
+
+/** Names of a pprzlink message in a pprzlog frame: the sender id and the message id
+    prefixed with its class (telemetry for source 0, datalink otherwise) */
+void plx_pprzlog_names(uint8_t source, const uint8_t *data, uint8_t data_len, char *ac, char *type)
+{
+  snprintf(ac, PLX_NAME_LEN, "%u", data_len > 0 ? data[0] : 0);
+  snprintf(type, PLX_NAME_LEN, "%s_%u", source == 0 ? "tm" : "dl", data_len > 1 ? data[1] : 0);
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+/** Indexed flight log container (.plx)
+
+    The records of a .data or .tlm log are stored one after the other, followed
+    by a time index and an index per message type, so a log can be memory mapped
+    and seeked or filtered without parsing every record.
+
+    File layout (little endian):
+    - struct plx_header
+    - records: struct plx_record followed by its payload, padded to 8 bytes
+    - chunk table: one struct plx_chunk per PLX_CHUNK_RECORDS records
+    - type table: one struct plx_type per message type
+    - chunk lists: for every type, the uint32_t numbers of the chunks containing it
+    - aircraft table: one name of PLX_NAME_LEN bytes per aircraft
+
+    Payloads keep the encoding of the original log:
+    PLX_ENCODING_TEXT for .data logs (the time as written in the line, a space and the
+    fields of the line after the message name, so that lines are extracted unchanged),
+    PLX_ENCODING_PPRZLOG for .tlm logs (the pprzlink data: sender, message id and fields).
+
+    Only files of version PLX_VERSION are read, older ones must be indexed again.
+*/
+
+#ifndef LOG_INDEX_H
+#define LOG_INDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stddef.h>
+
+#define PLX_MAGIC "PPRZPLX1"
+#define PLX_VERSION 2
+#define PLX_CHUNK_RECORDS 1024   ///< Records per chunk of the time index
+#define PLX_NAME_LEN 32          ///< Maximum length of a message or aircraft name (with terminator)
+#define PLX_ALIGN(_x) (((_x) + 7) & ~((uint64_t)7))
+
+enum plx_encoding {
+  PLX_ENCODING_TEXT = 0,
+  PLX_ENCODING_PPRZLOG = 1
+};
+
+struct plx_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t encoding;          ///< enum plx_encoding
+  uint64_t records_cnt;
+  uint64_t data_offset;
+  uint64_t data_size;
+  uint64_t chunks_offset;
+  uint64_t types_offset;
+  uint64_t acs_offset;
+  uint32_t chunks_cnt;
+  uint32_t types_cnt;
+  uint32_t acs_cnt;
+  uint32_t chunk_records;     ///< Records per chunk (PLX_CHUNK_RECORDS when written)
+  double t_start;             ///< Lowest time in the log
+  double t_end;               ///< Highest time in the log
+};
+
+struct plx_record {
+  double t;                   ///< Time of the record in seconds
+  uint16_t ac;                ///< Index in the aircraft table
+  uint16_t type;              ///< Index in the type table
+  uint32_t len;               ///< Length of the payload following the record
+};
+
+struct plx_chunk {
+  double t_min;               ///< Lowest time in the chunk
+  double t_max;               ///< Highest time up to and including the chunk (never decreases)
+  uint64_t offset;            ///< File offset of the first record
+  uint64_t first_record;      ///< Number of the first record
+  uint32_t records_cnt;
+  uint32_t pad;
+};
+
+struct plx_type {
+  char name[PLX_NAME_LEN];
+  uint64_t records_cnt;
+  uint64_t chunks_offset;     ///< File offset of the uint32_t chunk numbers
+  uint32_t chunks_cnt;
+  uint32_t pad;
+};
+
+/** Memory mapped log */
+struct plx_file {
+  int fd;
+  uint8_t *map;
+  size_t size;
+  const struct plx_header *hdr;
+  const struct plx_chunk *chunks;
+  const struct plx_type *types;
+  const char (*acs)[PLX_NAME_LEN];
+};
+
+/* Reading */
+extern int plx_open(struct plx_file *f, const char *path);
+extern void plx_close(struct plx_file *f);
+extern int plx_find_type(const struct plx_file *f, const char *name);
+extern int plx_find_ac(const struct plx_file *f, const char *name);
+extern uint32_t plx_seek_chunk(const struct plx_file *f, double t);
+extern uint64_t plx_seek(const struct plx_file *f, double t);
+extern const struct plx_record *plx_record_at(const struct plx_file *f, uint64_t offset);
+extern uint64_t plx_next(const struct plx_file *f, uint64_t offset);
+extern const uint32_t *plx_type_chunks(const struct plx_file *f, int type);
+
+static inline const uint8_t *plx_payload(const struct plx_record *rec)
+{
+  return (const uint8_t *)(rec + 1);
+}
+
+static inline uint64_t plx_data_end(const struct plx_file *f)
+{
+  return f->hdr->data_offset + f->hdr->data_size;
+}
+
+/* Writing */
+struct plx_writer;
+extern struct plx_writer *plx_writer_open(const char *path, enum plx_encoding encoding);
+extern int plx_writer_add(struct plx_writer *w, double t, const char *ac, const char *type,
+                          const void *payload, uint32_t len);
+extern int plx_writer_ac(struct plx_writer *w, const char *ac);
+extern int plx_writer_type(struct plx_writer *w, const char *type);
+extern int plx_writer_add_idx(struct plx_writer *w, double t, uint16_t ac_idx, uint16_t type_idx,
+                              const void *payload, uint32_t len);
+extern int plx_writer_close(struct plx_writer *w);
+
+/* Original log formats */
+extern int plx_write_data_line(FILE *out, const struct plx_file *f, const struct plx_record *rec);
+extern int plx_write_pprzlog(FILE *out, const struct plx_file *f, const struct plx_record *rec);
+extern int plx_parse_data_line(const char *line, double *t, const char **t_text, int *t_len,
+                               char *ac, char *type, const char **fields);
+extern long plx_parse_pprzlog(const uint8_t *buf, size_t len, double *t, uint8_t *source,
+                              const uint8_t **data, uint8_t *data_len);
+extern void plx_pprzlog_names(uint8_t source, const uint8_t *data, uint8_t data_len, char *ac, char *type);
+extern int plx_convert_pprzlog(const uint8_t *buf, size_t size, struct plx_writer *w, int nb_threads,
+                               uint64_t *nb_msgs, uint64_t *nb_errors);
+
+#endif /* LOG_INDEX_H */
@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+/** Converts .data and .tlm logs to indexed logs (.plx) and extracts
+    time ranges, messages or aircraft from them.
+
+    logindex convert [-j threads] <log.data[.gz|.bz2]|log.tlm|sdlog.LOG> <log.plx>
+    logindex info <log.plx>
+    logindex extract <log.plx> [-s start] [-e end] [-m message] [-a ac_id] [-o output]
+
+    Raw pprzlog streams (.tlm files, sdlog_chibios and openlog logs) are decoded
+    in parallel, see pprzlog_decode.c.
+    Extracted records are written in the format of the original log.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include "log_index.h"
+
+static bool has_suffix(const char *s, const char *suffix)
+{
+  size_t l = strlen(s), ls = strlen(suffix);
+  return l >= ls && strcmp(s + l - ls, suffix) == 0;
+}
+
+/* Raw pprzlog streams start with a frame, text logs with a time */
+static bool is_pprzlog(const char *path)
+{
+  if (has_suffix(path, ".tlm") || has_suffix(path, ".LOG")) {
+    return true;
+  }
+  FILE *fp = fopen(path, "rb");
+  int c = (fp != NULL) ? fgetc(fp) : EOF;
+  if (fp != NULL) {
+    fclose(fp);
+  }
+  return c == 0x99;
+}
+
+/* Open a text log, decompressing it on the fly like Ocaml_tools.open_compress */
+static FILE *open_compressed(const char *path, bool *is_pipe)
+{
+  char cmd[1024];
+  *is_pipe = true;
+  if (has_suffix(path, ".gz") || has_suffix(path, ".Z")) {
+    snprintf(cmd, sizeof(cmd), "gzip -dc '%s'", path);
+  } else if (has_suffix(path, ".bz2")) {
+    snprintf(cmd, sizeof(cmd), "bzip2 -dc '%s'", path);
+  } else {
+    *is_pipe = false;
+    return fopen(path, "r");
+  }
+  return popen(cmd, "r");
+}
+
+static int convert_data(const char *in, const char *out)
+{
+  bool is_pipe;
+  FILE *fp = open_compressed(in, &is_pipe);
+  if (fp == NULL) {
+    perror(in);
+    return EXIT_FAILURE;
+  }
+  struct plx_writer *w = plx_writer_open(out, PLX_ENCODING_TEXT);
+  if (w == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  char *line = NULL, *payload = NULL;
+  size_t line_size = 0;
+  ssize_t n;
+  uint64_t nb_lines = 0, nb_skipped = 0;
+  int ret = EXIT_SUCCESS;
+  while ((n = getline(&line, &line_size, fp)) > 0) {
+    double t;
+    char ac[PLX_NAME_LEN], type[PLX_NAME_LEN];
+    const char *t_text, *fields;
+    int t_len;
+    nb_lines++;
+    if (line[n - 1] == '\n') {
+      line[--n] = '\0';
+    }
+    if (plx_parse_data_line(line, &t, &t_text, &t_len, ac, type, &fields) < 0) {
+      nb_skipped++;
+      continue;
+    }
+    // payload: the time as written, a space and the fields
+    payload = realloc(payload, line_size + 1);
+    int fields_len = line + n - fields;
+    memcpy(payload, t_text, t_len);
+    payload[t_len] = ' ';
+    memcpy(payload + t_len + 1, fields, fields_len);
+    if (plx_writer_add(w, t, ac, type, payload, t_len + 1 + fields_len) < 0) {
+      ret = EXIT_FAILURE;
+      break;
+    }
+  }
+  free(line);
+  free(payload);
+  if (is_pipe) {
+    pclose(fp);
+  } else {
+    fclose(fp);
+  }
+  if (plx_writer_close(w) < 0) {
+    ret = EXIT_FAILURE;
+  }
+  printf("%s: %lu lines, %lu skipped\n", out, (unsigned long)nb_lines, (unsigned long)nb_skipped);
+  return ret;
+}
+
+static int convert_pprzlog(const char *in, const char *out, int nb_threads)
+{
+  int fd = open(in, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) < 0) {
+    perror(in);
+    return EXIT_FAILURE;
+  }
+  const uint8_t *buf = NULL;
+  if (st.st_size > 0) {
+    buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (buf == MAP_FAILED) {
+      perror(in);
+      close(fd);
+      return EXIT_FAILURE;
+    }
+    madvise((void *)buf, st.st_size, MADV_SEQUENTIAL);
+  }
+  struct plx_writer *w = plx_writer_open(out, PLX_ENCODING_PPRZLOG);
+  if (w == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  size_t size = st.st_size;
+  uint64_t nb_msgs = 0, nb_errors = 0;
+  int ret = EXIT_SUCCESS;
+  if (plx_convert_pprzlog(buf, size, w, nb_threads, &nb_msgs, &nb_errors) < 0) {
+    ret = EXIT_FAILURE;
+  }
+  if (buf != NULL) {
+    munmap((void *)buf, size);
+  }
+  close(fd);
+  if (plx_writer_close(w) < 0) {
+    ret = EXIT_FAILURE;
+  }
+  printf("%s: %lu messages, %lu broken\n", out, (unsigned long)nb_msgs, (unsigned long)nb_errors);
+  return ret;
+}
+
+static int info(const char *path)
+{
+  struct plx_file f;
+  if (plx_open(&f, path) < 0) {
+    return EXIT_FAILURE;
+  }
+  const struct plx_header *h = f.hdr;
+  printf("%s: %s log, %lu records, %.3f s to %.3f s, %u chunks\n", path,
+         h->encoding == PLX_ENCODING_TEXT ? "text" : "pprzlog", (unsigned long)h->records_cnt,
+         h->t_start, h->t_end, h->chunks_cnt);
+  printf("aircraft:");
+  for (uint32_t i = 0; i < h->acs_cnt; i++) {
+    printf(" %s", f.acs[i]);
+  }
+  printf("\n");
+  for (uint32_t i = 0; i < h->types_cnt; i++) {
+    printf("  %-32s %10lu records in %u chunks\n", f.types[i].name,
+           (unsigned long)f.types[i].records_cnt, f.types[i].chunks_cnt);
+  }
+  plx_close(&f);
+  return EXIT_SUCCESS;
+}
+
+static int extract(struct plx_file *f, double start, double end, int type, int ac, FILE *out)
+{
+  int (*write)(FILE *, const struct plx_file *, const struct plx_record *) =
+    (f->hdr->encoding == PLX_ENCODING_TEXT) ? plx_write_data_line : plx_write_pprzlog;
+  uint32_t first = plx_seek_chunk(f, start);
+
+  // Only the chunks with the message when filtering on it
+  const uint32_t *chunks = NULL;
+  uint32_t chunks_cnt = f->hdr->chunks_cnt;
+  uint32_t c_idx = first;
+  if (type >= 0) {
+    chunks = plx_type_chunks(f, type);
+    chunks_cnt = f->types[type].chunks_cnt;
+    c_idx = 0;
+    while (c_idx < chunks_cnt && chunks[c_idx] < first) {
+      c_idx++;
+    }
+  }
+
+  for (; c_idx < chunks_cnt; c_idx++) {
+    const struct plx_chunk *c = &f->chunks[chunks ? chunks[c_idx] : c_idx];
+    if (c->t_min > end) {
+      break;
+    }
+    uint64_t offset = c->offset;
+    for (uint32_t i = 0; i < c->records_cnt; i++, offset = plx_next(f, offset)) {
+      const struct plx_record *rec = plx_record_at(f, offset);
+      if (rec->t < start || rec->t > end || (type >= 0 && rec->type != type) || (ac >= 0 && rec->ac != ac)) {
+        continue;
+      }
+      if (write(out, f, rec) < 0) {
+        perror("Writing");
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+static void usage(const char *name)
+{
+  fprintf(stderr, "Usage:\n"
+          "  %s convert [-j threads] <log.data[.gz|.bz2]|log.tlm|sdlog.LOG> <log.plx>\n"
+          "  %s info <log.plx>\n"
+          "  %s extract <log.plx> [-s start] [-e end] [-m message] [-a ac_id] [-o output]\n",
+          name, name, name);
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 3) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (strcmp(argv[1], "convert") == 0) {
+    int nb_threads = 0, opt;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "j:")) != -1) {
+      if (opt == 'j') {
+        nb_threads = atoi(optarg);
+      } else {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+      }
+    }
+    if (argc - optind != 2) {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    const char *in = argv[optind];
+    if (is_pprzlog(in)) {
+      return convert_pprzlog(in, argv[optind + 1], nb_threads);
+    }
+    return convert_data(in, argv[optind + 1]);
+  } else if (strcmp(argv[1], "info") == 0) {
+    return info(argv[2]);
+  } else if (strcmp(argv[1], "extract") == 0) {
+    double start = -1e300, end = 1e300;
+    const char *msg = NULL, *ac_name = NULL, *output = NULL;
+    int opt;
+    optind = 3;
+    while ((opt = getopt(argc, argv, "s:e:m:a:o:")) != -1) {
+      switch (opt) {
+        case 's': start = atof(optarg); break;
+        case 'e': end = atof(optarg); break;
+        case 'm': msg = optarg; break;
+        case 'a': ac_name = optarg; break;
+        case 'o': output = optarg; break;
+        default: usage(argv[0]); return EXIT_FAILURE;
+      }
+    }
+
+    struct plx_file f;
+    if (plx_open(&f, argv[2]) < 0) {
+      return EXIT_FAILURE;
+    }
+    int type = -1, ac = -1;
+    if (msg != NULL && (type = plx_find_type(&f, msg)) < 0) {
+      fprintf(stderr, "No %s message in %s\n", msg, argv[2]);
+      plx_close(&f);
+      return EXIT_SUCCESS;
+    }
+    if (ac_name != NULL && (ac = plx_find_ac(&f, ac_name)) < 0) {
+      fprintf(stderr, "No aircraft %s in %s\n", ac_name, argv[2]);
+      plx_close(&f);
+      return EXIT_SUCCESS;
+    }
+    FILE *out = stdout;
+    if (output != NULL && (out = fopen(output, "wb")) == NULL) {
+      perror(output);
+      plx_close(&f);
+      return EXIT_FAILURE;
+    }
+    int ret = extract(&f, start, end, type, ac, out);
+    if (out != stdout) {
+      fclose(out);
+    }
+    plx_close(&f);
+    return ret;
+  }
+
+  usage(argv[0]);
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+/** Parallel decoding of pprzlog streams (.tlm files, sdlog_chibios and openlog logs)
+
+    The mapped log is split in segments which are decoded by a pool of threads:
+    every thread looks for the frame boundaries in its segment, checking the
+    checksums and resynchronizing on the next STX after broken data. The frames
+    are then written in order by the calling thread.
+
+    A thread starts decoding in the middle of a frame of the previous segment,
+    so its first frames may be wrong. Decoding is deterministic from any position,
+    so the writer continues sequentially from the end of the previous segment
+    until it reaches a frame found by the thread, after which both agree. The
+    result is exactly the same as a sequential decoding of the whole log.
+*/
+
+#include "log_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define PPRZLOG_STX 0x99
+#define PPRZLOG_HEADER_LEN 7
+#define DECODE_SEGMENT_SIZE (8 << 20)   ///< Bytes decoded by a thread at once
+#define DECODE_AHEAD 4                  ///< Segments decoded in advance per thread (bounds the memory)
+#define DECODE_FRAME_SKIPPED 0x80000000u ///< Flag on a frame preceded by broken data
+
+struct decode_segment {
+  uint32_t *frames;     ///< Frame offsets from the segment start, with DECODE_FRAME_SKIPPED
+  size_t cnt;
+  size_t size;
+  bool done;
+};
+
+struct decoder {
+  const uint8_t *buf;
+  size_t size;
+  struct decode_segment *segments;
+  size_t segments_cnt;
+  size_t next;          ///< Next segment to decode
+  size_t consumed;      ///< Segments written
+  size_t ahead;         ///< Maximum segments decoded but not written
+  bool abort;
+  pthread_mutex_t mutex;
+  pthread_cond_t decoded;
+  pthread_cond_t released;
+};
+
+/** One step of the sequential decoding
+    @param[out] frame Whether a valid frame starts at pos
+    @return The position of the next step */
+static size_t decode_step(const uint8_t *buf, size_t size, size_t pos, bool *frame)
+{
+  double t;
+  uint8_t source, data_len;
+  const uint8_t *data;
+  long len = plx_parse_pprzlog(buf + pos, size - pos, &t, &source, &data, &data_len);
+
+  *frame = (len > 0);
+  if (len > 0) {
+    return pos + len;
+  } else if (len == 0) {
+    // Truncated frame at the end of the log
+    return size;
+  }
+  const uint8_t *next = memchr(buf + pos + 1, PPRZLOG_STX, size - pos - 1);
+  return (next == NULL) ? size : (size_t)(next - buf);
+}
+
+static void decode_segment(struct decoder *d, size_t k)
+{
+  struct decode_segment *seg = &d->segments[k];
+  size_t start = k * DECODE_SEGMENT_SIZE;
+  size_t end = (start + DECODE_SEGMENT_SIZE < d->size) ? start + DECODE_SEGMENT_SIZE : d->size;
+  bool skipped = false;
+
+  seg->size = DECODE_SEGMENT_SIZE / 64;
+  seg->frames = malloc(seg->size * sizeof(uint32_t));
+  for (size_t pos = start; pos < end;) {
+    bool frame;
+    size_t next = decode_step(d->buf, d->size, pos, &frame);
+    if (frame) {
+      if (seg->cnt == seg->size) {
+        seg->size *= 2;
+        seg->frames = realloc(seg->frames, seg->size * sizeof(uint32_t));
+      }
+      seg->frames[seg->cnt++] = (pos - start) | (skipped ? DECODE_FRAME_SKIPPED : 0);
+      skipped = false;
+    } else {
+      skipped = true;
+    }
+    pos = next;
+  }
+}
+
+static void *decode_thread(void *arg)
+{
+  struct decoder *d = arg;
+
+  pthread_mutex_lock(&d->mutex);
+  while (!d->abort && d->next < d->segments_cnt) {
+    if (d->next >= d->consumed + d->ahead) {
+      pthread_cond_wait(&d->released, &d->mutex);
+      continue;
+    }
+    size_t k = d->next++;
+    pthread_mutex_unlock(&d->mutex);
+
+    decode_segment(d, k);
+
+    pthread_mutex_lock(&d->mutex);
+    d->segments[k].done = true;
+    pthread_cond_broadcast(&d->decoded);
+  }
+  pthread_mutex_unlock(&d->mutex);
+  return NULL;
+}
+
+/* Name indexes of the messages in the writer */
+struct decode_names {
+  int ac[256];
+  int type[2][256];
+};
+
+static int write_frame(struct plx_writer *w, struct decode_names *names, const uint8_t *frame)
+{
+  uint8_t payload[1 + 255];
+  uint8_t data_len = frame[1];
+  uint8_t source = frame[2] ? 1 : 0;
+  const uint8_t *data = &frame[PPRZLOG_HEADER_LEN];
+  uint32_t ts = frame[3] | (frame[4] << 8) | (frame[5] << 16) | ((uint32_t)frame[6] << 24);
+
+  int *ac = &names->ac[data[0]];
+  int *type = &names->type[source][data[1]];
+  if (*ac < 0 || *type < 0) {
+    char ac_name[PLX_NAME_LEN], type_name[PLX_NAME_LEN];
+    plx_pprzlog_names(frame[2], data, data_len, ac_name, type_name);
+    if ((*ac = plx_writer_ac(w, ac_name)) < 0 || (*type = plx_writer_type(w, type_name)) < 0) {
+      return -1;
+    }
+  }
+
+  // The payload is the source followed by the pprzlink data
+  payload[0] = frame[2];
+  memcpy(&payload[1], data, data_len);
+  return plx_writer_add_idx(w, ts / 1e4, *ac, *type, payload, data_len + 1);
+}
+
+/** Decode a pprzlog stream into an indexed log
+    @param[in] buf,size The (mapped) log
+    @param[in] nb_threads The number of decoding threads, 0 for the number of processors
+    @param[out] nb_msgs,nb_errors The number of messages and of broken parts
+    @return 0 on success, -1 on error */
+int plx_convert_pprzlog(const uint8_t *buf, size_t size, struct plx_writer *w, int nb_threads,
+                        uint64_t *nb_msgs, uint64_t *nb_errors)
+{
+  struct decoder d;
+  struct decode_names names;
+  int ret = 0;
+
+  if (nb_threads <= 0) {
+    nb_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nb_threads <= 0) {
+      nb_threads = 1;
+    }
+  }
+  memset(&d, 0, sizeof(d));
+  memset(&names, -1, sizeof(names));
+  d.buf = buf;
+  d.size = size;
+  d.segments_cnt = (size + DECODE_SEGMENT_SIZE - 1) / DECODE_SEGMENT_SIZE;
+  d.segments = calloc(d.segments_cnt + 1, sizeof(struct decode_segment));
+  d.ahead = DECODE_AHEAD * nb_threads;
+  pthread_mutex_init(&d.mutex, NULL);
+  pthread_cond_init(&d.decoded, NULL);
+  pthread_cond_init(&d.released, NULL);
+
+  // Without any decoding thread the segments are decoded by the writer
+  pthread_t threads[nb_threads];
+  int nb_started = 0;
+  for (int i = 0; i < nb_threads; i++) {
+    if (pthread_create(&threads[nb_started], NULL, decode_thread, &d) == 0) {
+      nb_started++;
+    }
+  }
+
+  *nb_msgs = 0;
+  *nb_errors = 0;
+  size_t pos = 0;
+  bool skipped = false;
+  for (size_t k = 0; k < d.segments_cnt && ret == 0; k++) {
+    struct decode_segment *seg = &d.segments[k];
+    if (nb_started == 0) {
+      decode_segment(&d, k);
+      seg->done = true;
+    }
+    pthread_mutex_lock(&d.mutex);
+    while (!seg->done) {
+      pthread_cond_wait(&d.decoded, &d.mutex);
+    }
+    pthread_mutex_unlock(&d.mutex);
+
+    size_t start = k * DECODE_SEGMENT_SIZE;
+    size_t end = (start + DECODE_SEGMENT_SIZE < size) ? start + DECODE_SEGMENT_SIZE : size;
+    size_t j = 0;
+    while (pos < end && ret == 0) {
+      while (j < seg->cnt && start + (seg->frames[j] & ~DECODE_FRAME_SKIPPED) < pos) {
+        j++;
+      }
+
+      if (j < seg->cnt && start + (seg->frames[j] & ~DECODE_FRAME_SKIPPED) == pos) {
+        // Same path as the thread, take its frames
+        // (broken data before the first one is only known from our own path)
+        seg->frames[j] &= ~DECODE_FRAME_SKIPPED;
+        for (; j < seg->cnt && ret == 0; j++) {
+          pos = start + (seg->frames[j] & ~DECODE_FRAME_SKIPPED);
+          if (skipped || (seg->frames[j] & DECODE_FRAME_SKIPPED)) {
+            (*nb_errors)++;
+          }
+          skipped = false;
+          ret = write_frame(w, &names, buf + pos);
+          (*nb_msgs)++;
+        }
+        pos += PPRZLOG_HEADER_LEN + buf[pos + 1] + 1;
+        break;
+      }
+
+      // Not synchronized with the thread yet
+      bool frame;
+      size_t next = decode_step(buf, size, pos, &frame);
+      if (frame) {
+        if (skipped) {
+          (*nb_errors)++;
+        }
+        skipped = false;
+        ret = write_frame(w, &names, buf + pos);
+        (*nb_msgs)++;
+      } else {
+        skipped = true;
+      }
+      pos = next;
+    }
+
+    free(seg->frames);
+    pthread_mutex_lock(&d.mutex);
+    d.consumed++;
+    pthread_cond_broadcast(&d.released);
+    pthread_mutex_unlock(&d.mutex);
+  }
+  if (skipped) {
+    (*nb_errors)++;
+  }
+
+  // Stop the threads (on error they may still be running)
+  pthread_mutex_lock(&d.mutex);
+  d.abort = true;
+  pthread_cond_broadcast(&d.released);
+  pthread_mutex_unlock(&d.mutex);
+  for (int i = 0; i < nb_started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  for (size_t k = d.consumed; k < d.segments_cnt; k++) {
+    free(d.segments[k].frames);
+  }
+  free(d.segments);
+  pthread_mutex_destroy(&d.mutex);
+  pthread_cond_destroy(&d.decoded);
+  pthread_cond_destroy(&d.released);
+  return ret;
+}
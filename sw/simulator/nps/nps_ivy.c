@@ -4,6 +4,11 @@
 #include <stdio.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
 #include <Ivy/ivy.h>
 
 #include <Ivy/ivyloop.h>
@@ -202,68 +207,175 @@ static void on_DL_SETTING(IvyClientPtr app __attribute__((unused)),
 }
 
 
-void nps_ivy_display(struct NpsFdm* fdm_data, struct NpsSensors* sensors_data)
+/*
+ * Binary display output
+ *
+ * The NPS messages are packed as pprzlink v2 telemetry frames, all the frames
+ * of a display step in a single UDP datagram. They can be decoded with
+ * sw/lib/python/pprz_frames.py or forwarded to the Ivy bus by udp_link.
+ */
+#define NPS_DISPLAY_STX 0x99
+#define NPS_DISPLAY_CLASS_TELEMETRY 1
+#define NPS_DISPLAY_BUF_SIZE 512
+
+static int nps_display_fd = -1;
+static struct sockaddr_in nps_display_addr;
+static uint8_t nps_display_buf[NPS_DISPLAY_BUF_SIZE];
+static int nps_display_len;
+
+/** Send the display messages to a host:port instead of the Ivy bus
+ *  @return false if the address can't be resolved or the socket created
+ */
+bool nps_ivy_display_udp_init(const char *host_port)
 {
-  struct NpsFdm fdm_ivy;
-  memcpy (&fdm_ivy, fdm_data, sizeof(struct NpsFdm));
-
-  struct NpsSensors sensors_ivy;
-  memcpy (&sensors_ivy, sensors_data, sizeof(struct NpsSensors));
-
-  IvySendMsg("%d NPS_RATE_ATTITUDE %f %f %f %f %f %f",
-             AC_ID,
-             DegOfRad(fdm_ivy.body_ecef_rotvel.p),
-             DegOfRad(fdm_ivy.body_ecef_rotvel.q),
-             DegOfRad(fdm_ivy.body_ecef_rotvel.r),
-             DegOfRad(fdm_ivy.ltp_to_body_eulers.phi),
-             DegOfRad(fdm_ivy.ltp_to_body_eulers.theta),
-             DegOfRad(fdm_ivy.ltp_to_body_eulers.psi));
-  IvySendMsg("%d NPS_POS_LLH %f %f %f %f %f %f %f %f %f",
-             AC_ID,
-             (fdm_ivy.lla_pos_pprz.lat),
-             (fdm_ivy.lla_pos_geod.lat),
-             (fdm_ivy.lla_pos_geoc.lat),
-             (fdm_ivy.lla_pos_pprz.lon),
-             (fdm_ivy.lla_pos_geod.lon),
-             (fdm_ivy.lla_pos_pprz.alt),
-             (fdm_ivy.lla_pos_geod.alt),
-             (fdm_ivy.agl),
-             (fdm_ivy.hmsl));
-  IvySendMsg("%d NPS_SPEED_POS %f %f %f %f %f %f %f %f %f",
-             AC_ID,
-             (fdm_ivy.ltpprz_ecef_accel.x),
-             (fdm_ivy.ltpprz_ecef_accel.y),
-             (fdm_ivy.ltpprz_ecef_accel.z),
-             (fdm_ivy.ltpprz_ecef_vel.x),
-             (fdm_ivy.ltpprz_ecef_vel.y),
-             (fdm_ivy.ltpprz_ecef_vel.z),
-             (fdm_ivy.ltpprz_pos.x),
-             (fdm_ivy.ltpprz_pos.y),
-             (fdm_ivy.ltpprz_pos.z));
-  IvySendMsg("%d NPS_GYRO_BIAS %f %f %f",
-             AC_ID,
-             DegOfRad(RATE_FLOAT_OF_BFP(sensors_ivy.gyro.bias_random_walk_value.x) + sensors_ivy.gyro.bias_initial.x),
-             DegOfRad(RATE_FLOAT_OF_BFP(sensors_ivy.gyro.bias_random_walk_value.y) + sensors_ivy.gyro.bias_initial.y),
-             DegOfRad(RATE_FLOAT_OF_BFP(sensors_ivy.gyro.bias_random_walk_value.z) + sensors_ivy.gyro.bias_initial.z));
+  char host[128];
+  const char *sep = strrchr(host_port, ':');
+  if (sep == NULL || sep == host_port || sep - host_port >= (int)sizeof(host) || sep[1] == '\0') {
+    fprintf(stderr, "NPS: invalid display address %s, expected host:port\n", host_port);
+    return false;
+  }
+  memcpy(host, host_port, sep - host_port);
+  host[sep - host_port] = '\0';
+
+  /* host name or IPv4 address, the first address found is used */
+  struct addrinfo hints, *res;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  int err = getaddrinfo(host, sep + 1, &hints, &res);
+  if (err != 0) {
+    fprintf(stderr, "NPS: could not resolve display address %s: %s\n", host_port, gai_strerror(err));
+    return false;
+  }
+  memcpy(&nps_display_addr, res->ai_addr, sizeof(nps_display_addr));
+  freeaddrinfo(res);
+
+  nps_display_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (nps_display_fd < 0) {
+    perror("NPS: display socket");
+    return false;
+  }
+  return true;
+}
+
+/** Append a message with only float fields to the display datagram */
+static void nps_display_put(uint8_t msg_id, const double *fields, int nb_fields)
+{
+  int len = 2 + 4 + 4 * nb_fields + 2;
+  if (nps_display_len + len > NPS_DISPLAY_BUF_SIZE) {
+    return;
+  }
+  uint8_t *frame = &nps_display_buf[nps_display_len];
+  frame[0] = NPS_DISPLAY_STX;
+  frame[1] = len;
+  frame[2] = AC_ID;                       // sender
+  frame[3] = 0;                           // receiver (ground)
+  frame[4] = NPS_DISPLAY_CLASS_TELEMETRY; // component 0, telemetry class
+  frame[5] = msg_id;
+  for (int i = 0; i < nb_fields; i++) {
+    float f = fields[i];
+    memcpy(&frame[6 + 4 * i], &f, sizeof(f)); // little endian host
+  }
+  uint8_t ck_a = len, ck_b = len;
+  for (int i = 2; i < len - 2; i++) {
+    ck_a += frame[i];
+    ck_b += ck_a;
+  }
+  frame[len - 2] = ck_a;
+  frame[len - 1] = ck_b;
+  nps_display_len += len;
+}
+
+static void nps_display_flush(void)
+{
+  if (nps_display_len > 0 &&
+      sendto(nps_display_fd, nps_display_buf, nps_display_len, 0,
+             (struct sockaddr *)&nps_display_addr, sizeof(nps_display_addr)) < 0) {
+    perror("NPS: display");
+  }
+  nps_display_len = 0;
+}
+
+#define NPS_DISPLAY_NB(_a) (int)(sizeof(_a) / sizeof(_a[0]))
+
+void nps_ivy_display(struct NpsFdm* fdm_ivy, struct NpsSensors* sensors_ivy)
+{
+  // fdm and sensors are copies made by the display thread
+  double rate_attitude[] = {
+    DegOfRad(fdm_ivy->body_ecef_rotvel.p),
+    DegOfRad(fdm_ivy->body_ecef_rotvel.q),
+    DegOfRad(fdm_ivy->body_ecef_rotvel.r),
+    DegOfRad(fdm_ivy->ltp_to_body_eulers.phi),
+    DegOfRad(fdm_ivy->ltp_to_body_eulers.theta),
+    DegOfRad(fdm_ivy->ltp_to_body_eulers.psi)
+  };
+  double pos_llh[] = {
+    fdm_ivy->lla_pos_pprz.lat,
+    fdm_ivy->lla_pos_geod.lat,
+    fdm_ivy->lla_pos_geoc.lat,
+    fdm_ivy->lla_pos_pprz.lon,
+    fdm_ivy->lla_pos_geod.lon,
+    fdm_ivy->lla_pos_pprz.alt,
+    fdm_ivy->lla_pos_geod.alt,
+    fdm_ivy->agl,
+    fdm_ivy->hmsl
+  };
+  double speed_pos[] = {
+    fdm_ivy->ltpprz_ecef_accel.x,
+    fdm_ivy->ltpprz_ecef_accel.y,
+    fdm_ivy->ltpprz_ecef_accel.z,
+    fdm_ivy->ltpprz_ecef_vel.x,
+    fdm_ivy->ltpprz_ecef_vel.y,
+    fdm_ivy->ltpprz_ecef_vel.z,
+    fdm_ivy->ltpprz_pos.x,
+    fdm_ivy->ltpprz_pos.y,
+    fdm_ivy->ltpprz_pos.z
+  };
+  double gyro_bias[] = {
+    DegOfRad(RATE_FLOAT_OF_BFP(sensors_ivy->gyro.bias_random_walk_value.x) + sensors_ivy->gyro.bias_initial.x),
+    DegOfRad(RATE_FLOAT_OF_BFP(sensors_ivy->gyro.bias_random_walk_value.y) + sensors_ivy->gyro.bias_initial.y),
+    DegOfRad(RATE_FLOAT_OF_BFP(sensors_ivy->gyro.bias_random_walk_value.z) + sensors_ivy->gyro.bias_initial.z)
+  };
 
   /* transform magnetic field to body frame */
   struct DoubleVect3 h_body;
-  double_quat_vmult(&h_body, &fdm_ivy.ltp_to_body_quat, &fdm_ivy.ltp_h);
-
-  IvySendMsg("%d NPS_SENSORS_SCALED %f %f %f %f %f %f",
-             AC_ID,
-             ((sensors_ivy.accel.value.x - sensors_ivy.accel.neutral.x) / NPS_ACCEL_SENSITIVITY_XX),
-             ((sensors_ivy.accel.value.y - sensors_ivy.accel.neutral.y) / NPS_ACCEL_SENSITIVITY_YY),
-             ((sensors_ivy.accel.value.z - sensors_ivy.accel.neutral.z) / NPS_ACCEL_SENSITIVITY_ZZ),
-             h_body.x,
-             h_body.y,
-             h_body.z);
-
-  IvySendMsg("%d NPS_WIND %f %f %f",
-             AC_ID,
-             fdm_ivy.wind.x,
-             fdm_ivy.wind.y,
-             fdm_ivy.wind.z);
+  double_quat_vmult(&h_body, &fdm_ivy->ltp_to_body_quat, &fdm_ivy->ltp_h);
+
+  double sensors_scaled[] = {
+    (sensors_ivy->accel.value.x - sensors_ivy->accel.neutral.x) / NPS_ACCEL_SENSITIVITY_XX,
+    (sensors_ivy->accel.value.y - sensors_ivy->accel.neutral.y) / NPS_ACCEL_SENSITIVITY_YY,
+    (sensors_ivy->accel.value.z - sensors_ivy->accel.neutral.z) / NPS_ACCEL_SENSITIVITY_ZZ,
+    h_body.x,
+    h_body.y,
+    h_body.z
+  };
+  double wind[] = { fdm_ivy->wind.x, fdm_ivy->wind.y, fdm_ivy->wind.z };
+
+  if (nps_display_fd >= 0) {
+    nps_display_put(PPRZ_MSG_ID_NPS_RATE_ATTITUDE, rate_attitude, NPS_DISPLAY_NB(rate_attitude));
+    nps_display_put(PPRZ_MSG_ID_NPS_POS_LLH, pos_llh, NPS_DISPLAY_NB(pos_llh));
+    nps_display_put(PPRZ_MSG_ID_NPS_SPEED_POS, speed_pos, NPS_DISPLAY_NB(speed_pos));
+    nps_display_put(PPRZ_MSG_ID_NPS_GYRO_BIAS, gyro_bias, NPS_DISPLAY_NB(gyro_bias));
+    nps_display_put(PPRZ_MSG_ID_NPS_SENSORS_SCALED, sensors_scaled, NPS_DISPLAY_NB(sensors_scaled));
+    nps_display_put(PPRZ_MSG_ID_NPS_WIND, wind, NPS_DISPLAY_NB(wind));
+    nps_display_flush();
+  } else {
+    IvySendMsg("%d NPS_RATE_ATTITUDE %f %f %f %f %f %f", AC_ID,
+               rate_attitude[0], rate_attitude[1], rate_attitude[2],
+               rate_attitude[3], rate_attitude[4], rate_attitude[5]);
+    IvySendMsg("%d NPS_POS_LLH %f %f %f %f %f %f %f %f %f", AC_ID,
+               pos_llh[0], pos_llh[1], pos_llh[2], pos_llh[3], pos_llh[4],
+               pos_llh[5], pos_llh[6], pos_llh[7], pos_llh[8]);
+    IvySendMsg("%d NPS_SPEED_POS %f %f %f %f %f %f %f %f %f", AC_ID,
+               speed_pos[0], speed_pos[1], speed_pos[2], speed_pos[3], speed_pos[4],
+               speed_pos[5], speed_pos[6], speed_pos[7], speed_pos[8]);
+    IvySendMsg("%d NPS_GYRO_BIAS %f %f %f", AC_ID,
+               gyro_bias[0], gyro_bias[1], gyro_bias[2]);
+    IvySendMsg("%d NPS_SENSORS_SCALED %f %f %f %f %f %f", AC_ID,
+               sensors_scaled[0], sensors_scaled[1], sensors_scaled[2],
+               sensors_scaled[3], sensors_scaled[4], sensors_scaled[5]);
+    IvySendMsg("%d NPS_WIND %f %f %f", AC_ID, wind[0], wind[1], wind[2]);
+  }
 
   if(nps_ivy_send_world_env){
     nps_ivy_send_WORLD_ENV_REQ();
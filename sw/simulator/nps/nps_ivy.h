@@ -7,6 +7,7 @@
 bool nps_ivy_send_world_env;
 
 extern void nps_ivy_init(char *ivy_bus);
+extern bool nps_ivy_display_udp_init(const char *host_port);
 extern void nps_ivy_display(struct NpsFdm* fdm_ivy, struct NpsSensors* sensors_ivy);
 extern void nps_ivy_send_WORLD_ENV_REQ(void);
 
@@ -65,6 +65,8 @@ struct NpsMain {
   bool norc;
   char *ivy_bus;
   bool nodisplay;
+  char *display_udp;      ///< host:port of the binary display output, NULL for Ivy text messages
+  double display_freq;    ///< display messages frequency in Hz
 };
 
 struct NpsMain nps_main;
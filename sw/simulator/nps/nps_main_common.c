@@ -159,6 +159,8 @@ bool nps_main_parse_options(int argc, char **argv)
   nps_main.host_time_factor = 1.0;
   nps_main.fg_fdm = 0;
   nps_main.nodisplay = false;
+  nps_main.display_udp = NULL;
+  nps_main.display_freq = 1. / (3 * DISPLAY_DT);
 
   static const char *usage =
     "Usage: %s [options]\n"
@@ -175,6 +177,8 @@ bool nps_main_parse_options(int argc, char **argv)
     "   --ivy_bus <ivy bus>                    e.g. 127.255.255.255\n"
     "   --time_factor <factor>                 e.g. 2.5\n"
     "   --nodisplay                            e.g. disable NPS ivy messages\n"
+    "   --display_udp <host:port>              e.g. localhost:4260 to send NPS messages as pprzlink frames\n"
+    "   --display_freq <frequency>             e.g. 30 (default 10 Hz)\n"
     "   --fg_fdm";
 
 
@@ -193,6 +197,8 @@ bool nps_main_parse_options(int argc, char **argv)
       {"fg_fdm", 0, NULL, 0},
       {"fg_port_in", 1, NULL, 0},
       {"nodisplay", 0, NULL, 0},
+      {"display_udp", 1, NULL, 0},
+      {"display_freq", 1, NULL, 0},
       {0, 0, 0, 0}
     };
     int option_index = 0;
@@ -231,6 +237,13 @@ bool nps_main_parse_options(int argc, char **argv)
             nps_main.fg_port_in = atoi(optarg); break;
           case 11:
             nps_main.nodisplay = true; break;
+          case 12:
+            nps_main.display_udp = strdup(optarg); break;
+          case 13:
+            if (atof(optarg) > 0) {
+              nps_main.display_freq = atof(optarg);
+            }
+            break;
           default:
             break;
         }
@@ -308,13 +321,16 @@ void *nps_main_display(void *data __attribute__((unused)))
   struct timespec requestStart;
   struct timespec requestEnd;
   struct timespec waitFor;
-  long int period_ns = 3 * DISPLAY_DT * 1000000000L; // thread period in nanoseconds
+  long int period_ns = 1000000000L / nps_main.display_freq; // thread period in nanoseconds
   long int task_ns = 0; // time it took to finish the task in nanoseconds
 
   struct NpsFdm fdm_ivy;
   struct NpsSensors sensors_ivy;
 
   nps_ivy_init(nps_main.ivy_bus);
+  if (nps_main.display_udp != NULL && !nps_ivy_display_udp_init(nps_main.display_udp)) {
+    exit(EXIT_FAILURE);
+  }
 
   // start the loop only if no_display is false
   if (!nps_main.nodisplay) {
@@ -335,8 +351,8 @@ void *nps_main_display(void *data __attribute__((unused)))
 
       // task took less than one period, sleep for the rest of time
       if (task_ns < period_ns) {
-        waitFor.tv_sec = 0;
-        waitFor.tv_nsec = period_ns - task_ns;
+        waitFor.tv_sec = (period_ns - task_ns) / 1000000000L;
+        waitFor.tv_nsec = (period_ns - task_ns) % 1000000000L;
         nanosleep(&waitFor, NULL);
       } else {
         // task took longer than the period
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2026 The Paparazzi Team
+#
+# This file is part of paparazzi.
+#
+# paparazzi is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2, or (at your option)
+# any later version.
+#
+# paparazzi is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with paparazzi; see the file COPYING.  If not, see
+# <http://www.gnu.org/licenses/>.
+#
+
+'''
+Generate the const lookup tables of the interpolated fixed point trig
+functions (sw/airborne/math/pprz_trig_int_tables.h).
+
+The tables have 2^bits + 1 points, plus one padding point so that the
+interpolation never needs a bound check:
+ - sine over a quarter of turn [0, pi/2], unsigned Q15
+ - arc tangent over [0, 1], unsigned Q16 radians
+
+usage:
+    ./gen_trig_int_tables.py [--bits 8] > sw/airborne/math/pprz_trig_int_tables.h
+or from sw/airborne/math:
+    make trig_tables
+'''
+
+from __future__ import print_function
+
+import argparse
+import math
+
+SIN_FRAC = 15
+ATAN_FRAC = 16
+
+
+def sin_table(bits):
+    n = 1 << bits
+    tab = [int(round(math.sin(math.pi / 2. * i / n) * (1 << SIN_FRAC))) for i in range(n + 1)]
+    return tab + [tab[-1]]
+
+
+def atan_table(bits):
+    n = 1 << bits
+    tab = [int(round(math.atan(float(i) / n) * (1 << ATAN_FRAC))) for i in range(n + 1)]
+    return tab + [tab[-1]]
+
+
+def c_array(name, tab, per_line=12):
+    lines = ['static const uint16_t %s[TRIG_INT_INTERP_SIZE + 2] = {' % name]
+    for i in range(0, len(tab), per_line):
+        lines.append('  ' + ', '.join('%5d' % v for v in tab[i:i + per_line]) + ',')
+    lines[-1] = lines[-1].rstrip(',')
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate the interpolated trig tables')
+    parser.add_argument('-b', '--bits', type=int, default=8,
+                        help='log2 of the number of intervals (default 8, max 10)')
+    args = parser.parse_args()
+    if not 2 <= args.bits <= 10:
+        parser.error('bits must be in [2, 10]')
+
+    print('''/*
+ * This file is generated by sw/tools/gen_trig_int_tables.py, do not edit.
+ */
+
+/**
+ * @file pprz_trig_int_tables.h
+ * @brief Const tables of the interpolated fixed point trig functions.
+ *
+ * Only included by pprz_trig_int.c.
+ */
+
+#ifndef PPRZ_TRIG_INT_TABLES_H
+#define PPRZ_TRIG_INT_TABLES_H
+
+#if TRIG_INT_INTERP_BITS != %d
+#error "pprz_trig_int_tables.h generated for a different TRIG_INT_INTERP_BITS"
+#endif
+
+#define TRIG_INT_INTERP_SIN_FRAC %d
+#define TRIG_INT_INTERP_ATAN_FRAC %d
+
+/** sin(pi/2 * i / TRIG_INT_INTERP_SIZE) with TRIG_INT_INTERP_SIN_FRAC */
+%s
+
+/** atan(i / TRIG_INT_INTERP_SIZE) with TRIG_INT_INTERP_ATAN_FRAC */
+%s
+
+#endif /* PPRZ_TRIG_INT_TABLES_H */''' % (args.bits, SIN_FRAC, ATAN_FRAC,
+                                           c_array('pprz_trig_int_interp_sin', sin_table(args.bits)),
+                                           c_array('pprz_trig_int_interp_atan', atan_table(args.bits))))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,467 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2026 The Paparazzi Team
+#
+# This file is part of paparazzi.
+#
+# paparazzi is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2, or (at your option)
+# any later version.
+#
+# paparazzi is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with paparazzi; see the file COPYING.  If not, see
+# <http://www.gnu.org/licenses/>.
+#
+
+'''
+Time accurate replay of flight logs over Ivy or UDP (pprzlink).
+
+The messages are sent at their recorded time against a monotonic clock,
+scaled by a speed factor (0 to replay as fast as possible). Seeking uses a
+time index: the chunk table of indexed logs (.plx, see sw/logalizer/logindex)
+or an index built while opening .data logs.
+
+usage examples:
+    ./log_replay.py var/logs/flight.data
+    ./log_replay.py var/logs/flight.plx --speed 20 --start 600 --end 1200
+    ./log_replay.py var/logs/flight.data --speed 0 --udp 127.0.0.1:4242
+
+While replaying, commands are read from stdin:
+    p            pause / resume
+    s <time>     seek to a log time in seconds
+    x <speed>    change the speed factor (0 for maximum speed)
+    q            quit
+'''
+
+from __future__ import print_function
+
+import argparse
+import bisect
+import mmap
+import os
+import socket
+import struct
+import sys
+import threading
+import time
+
+# if PAPARAZZI_HOME not set, then assume the tree containing this
+# file is a reasonable substitute
+PAPARAZZI_HOME = os.getenv("PAPARAZZI_HOME", os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), '../../')))
+sys.path.append(PAPARAZZI_HOME + "/var/lib/python")
+
+
+class DataLog(object):
+    '''
+    Text .data log, with a time index of one entry every INDEX_PERIOD lines
+    '''
+    INDEX_PERIOD = 1024
+
+    def __init__(self, filename):
+        self.file = open(filename, 'rb')
+        self.map = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ)
+        self.index_t = []
+        self.index_offset = []
+        t_max = None
+        offset = 0
+        nb = 0
+        while True:
+            end = self.map.find(b'\n', offset)
+            if end < 0:
+                end = len(self.map)
+            if end > offset:
+                t = self._time(offset, end)
+                if t is not None:
+                    # Highest time so far, so the index stays sorted
+                    t_max = t if t_max is None or t > t_max else t_max
+                    if nb % self.INDEX_PERIOD == 0:
+                        self.index_t.append(t_max)
+                        self.index_offset.append(offset)
+                    nb += 1
+            if end >= len(self.map):
+                break
+            offset = end + 1
+        self.t_start = self.index_t[0] if self.index_t else 0.
+        self.t_end = t_max if t_max is not None else 0.
+        self.size = nb
+
+    def _time(self, start, end):
+        space = self.map.find(b' ', start, end)
+        try:
+            return float(self.map[start:space])
+        except ValueError:
+            return None
+
+    def records(self, start=None):
+        '''
+        Iterate over (time, ac_id, message) from the first record at or after start,
+        the message being the Ivy string "MSG_NAME fields"
+        '''
+        i = 0
+        if start is not None:
+            i = max(bisect.bisect_left(self.index_t, start) - 1, 0)
+        offset = self.index_offset[i] if self.index_offset else len(self.map)
+        while offset < len(self.map):
+            end = self.map.find(b'\n', offset)
+            if end < 0:
+                end = len(self.map)
+            fields = self.map[offset:end].decode(errors='replace').split(' ', 2)
+            offset = end + 1
+            if len(fields) < 3:
+                continue
+            try:
+                t = float(fields[0])
+            except ValueError:
+                continue
+            if start is not None and t < start:
+                continue
+            yield t, fields[1], fields[2]
+
+    def close(self):
+        self.map.close()
+        self.file.close()
+
+
+class PlxLog(object):
+    '''
+    Indexed log (.plx) written by sw/logalizer/logindex, see log_index.h for the layout
+    '''
+    HEADER = struct.Struct('<8sIIQQQQQQIIIIdd')
+    RECORD = struct.Struct('<dHHI')
+    CHUNK = struct.Struct('<ddQQII')
+    TYPE = struct.Struct('<32sQQII')
+    NAME_LEN = 32
+    ENCODING_TEXT = 0
+    VERSION = 2  # PLX_VERSION of log_index.h
+
+    def __init__(self, filename):
+        self.file = open(filename, 'rb')
+        self.map = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ)
+        (magic, version, self.encoding, self.size, self.data_offset, self.data_size,
+         chunks_offset, types_offset, acs_offset, chunks_cnt, types_cnt, acs_cnt,
+         _, self.t_start, self.t_end) = self.HEADER.unpack_from(self.map, 0)
+        if magic != b'PPRZPLX1' or version != self.VERSION:
+            raise ValueError("%s is not an indexed log or has an unsupported version" % filename)
+        self.chunks = [self.CHUNK.unpack_from(self.map, chunks_offset + i * self.CHUNK.size)
+                       for i in range(chunks_cnt)]
+        self.chunks_t_max = [c[1] for c in self.chunks]
+        self.types = [self._name(self.TYPE.unpack_from(self.map, types_offset + i * self.TYPE.size)[0])
+                      for i in range(types_cnt)]
+        self.acs = [self._name(self.map[acs_offset + i * self.NAME_LEN:acs_offset + (i + 1) * self.NAME_LEN])
+                    for i in range(acs_cnt)]
+
+    @staticmethod
+    def _name(raw):
+        return raw.split(b'\0', 1)[0].decode()
+
+    def records(self, start=None):
+        '''
+        Iterate over (time, ac_id, message) from the first record at or after start.
+        The message is the Ivy string "MSG_NAME fields" for text logs, and
+        the raw pprzlink data for logs converted from pprzlog streams.
+        '''
+        c = 0
+        if start is not None:
+            c = bisect.bisect_left(self.chunks_t_max, start)
+        if c >= len(self.chunks):
+            return
+        offset = self.chunks[c][2]
+        end = self.data_offset + self.data_size
+        text = (self.encoding == self.ENCODING_TEXT)
+        while offset < end:
+            t, ac, msg_type, length = self.RECORD.unpack_from(self.map, offset)
+            payload = self.map[offset + self.RECORD.size:offset + self.RECORD.size + length]
+            offset += (self.RECORD.size + length + 7) & ~7
+            if start is not None and t < start:
+                continue
+            if text:
+                # text payloads start with the time as written in the .data log
+                fields = payload.decode(errors='replace')
+                fields = fields.split(' ', 1)[1] if ' ' in fields else ''
+                yield t, self.acs[ac], self.types[msg_type] + ' ' + fields
+            else:
+                yield t, self.acs[ac], payload
+
+    def close(self):
+        self.map.close()
+        self.file.close()
+
+
+def open_log(filename):
+    with open(filename, 'rb') as f:
+        magic = f.read(8)
+    if magic == b'PPRZPLX1':
+        return PlxLog(filename)
+    return DataLog(filename)
+
+
+class IvySink(object):
+    '''
+    Send messages on the Ivy bus, like the live link does
+    '''
+    def __init__(self, bus=""):
+        from ivy.std_api import IvyInit, IvyStart
+        IvyInit("LogReplay %i" % os.getpid(), "READY", 0, lambda x, y: y, lambda x, y: y)
+        IvyStart(bus)
+        # seems there is a sleep needed before you can send something
+        time.sleep(0.2)
+        self.binary_warned = False
+
+    def send(self, ac_id, msg):
+        from ivy.std_api import IvySendMsg
+        if isinstance(msg, (bytes, bytearray)):
+            msg = self.decode_binary(msg)
+            if msg is None:
+                return
+        IvySendMsg("%s %s" % (ac_id, msg))
+
+    def decode_binary(self, data):
+        # Raw pprzlink data (source byte, then sender, message id and fields)
+        try:
+            from pprzlink.message import PprzMessage
+            msg_class = "telemetry" if data[0] == 0 else "datalink"
+            msg = PprzMessage(msg_class, data[2])
+            msg.binary_to_payload(bytes(data[3:]))
+            return "%s %s" % (msg.name, msg.payload_to_ivy_string())
+        except Exception as e:
+            if not self.binary_warned:
+                print("Could not decode binary messages for Ivy (%s), use --udp" % e, file=sys.stderr)
+                self.binary_warned = True
+            return None
+
+    def close(self):
+        from ivy.std_api import IvyStop
+        IvyStop()
+
+
+class UdpSink(object):
+    '''
+    Send messages as pprzlink frames over UDP, like an aircraft link does
+    '''
+    STX = 0x99
+
+    def __init__(self, host, port, msg_class="telemetry"):
+        self.socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.address = (host, port)
+        self.msg_class = msg_class
+        self.transport = None
+
+    @classmethod
+    def frame(cls, data):
+        ''' pprz transport frame: STX, length, data, checksums '''
+        length = len(data) + 4
+        ck_a = ck_b = length
+        for b in bytearray(data):
+            ck_a = (ck_a + b) & 0xff
+            ck_b = (ck_b + ck_a) & 0xff
+        return bytes(bytearray([cls.STX, length])) + bytes(data) + bytes(bytearray([ck_a, ck_b]))
+
+    def send(self, ac_id, msg):
+        if isinstance(msg, (bytes, bytearray)):
+            # Raw pprzlink data from a pprzlog stream, without its source byte
+            data = self.frame(msg[1:])
+        else:
+            from pprzlink.message import PprzMessage
+            from pprzlink.pprz_transport import PprzTransport
+            if self.transport is None:
+                self.transport = PprzTransport(self.msg_class)
+            name, _, fields = msg.partition(' ')
+            pprz_msg = PprzMessage(self.msg_class, name)
+            pprz_msg.ivy_string_to_payload(fields)
+            data = self.transport.pack_pprz_msg(int(ac_id), pprz_msg)
+        self.socket.sendto(data, self.address)
+
+    def close(self):
+        self.socket.close()
+
+
+class ReplayEngine(object):
+    '''
+    Send the records of a log at their recorded time, scaled by a speed factor.
+    seek(), set_speed() and pause() can be called from another thread.
+    '''
+    def __init__(self, log, sink, speed=1., start=None, end=None, verbose=False):
+        self.log = log
+        self.sink = sink
+        self.speed = speed
+        self.end = end
+        self.verbose = verbose
+        self.lock = threading.Condition()
+        self.running = True
+        self.paused = False
+        self.seek_to = start
+        self.rebase = False
+        self.log_time = start if start is not None else log.t_start
+        self.sent = 0
+        self.max_drift = 0.
+
+    def seek(self, t):
+        with self.lock:
+            self.seek_to = t
+            self.lock.notify_all()
+
+    def set_speed(self, speed):
+        with self.lock:
+            # Keep the current log time at the current wall time
+            self.rebase = True
+            self.speed = speed
+            self.lock.notify_all()
+
+    def pause(self, paused=None):
+        with self.lock:
+            self.paused = not self.paused if paused is None else paused
+            self.rebase = True
+            self.lock.notify_all()
+
+    def stop(self):
+        with self.lock:
+            self.running = False
+            self.lock.notify_all()
+
+    def _wait(self, deadline):
+        '''
+        Wait until the monotonic deadline, or a control command
+        @return False when interrupted by a command
+        '''
+        with self.lock:
+            while self.running and not self.paused and self.seek_to is None and not self.rebase:
+                remaining = deadline - time.monotonic()
+                if remaining <= 0:
+                    return True
+                self.lock.wait(remaining)
+            return False
+
+    def run(self):
+        records = None
+        pending = None
+        t0 = wall0 = 0.
+        while True:
+            with self.lock:
+                while self.running and self.paused:
+                    self.lock.wait()
+                if not self.running:
+                    break
+                if self.seek_to is not None or records is None:
+                    t0 = self.seek_to if self.seek_to is not None else self.log_time
+                    records = self.log.records(t0)
+                    if self.verbose:
+                        print("Replay from t=%.2f s" % t0)
+                    pending = None
+                    wall0 = time.monotonic()
+                    self.seek_to = None
+                    self.rebase = False
+                elif self.rebase:
+                    t0 = self.log_time
+                    wall0 = time.monotonic()
+                    self.rebase = False
+                speed = self.speed
+
+            if pending is None:
+                try:
+                    pending = next(records)
+                except StopIteration:
+                    break
+            t, ac_id, msg = pending
+            if self.end is not None and t > self.end:
+                break
+
+            deadline = wall0 + (t - t0) / speed if speed > 0 else None
+            if deadline is not None and not self._wait(deadline):
+                # Seek, speed change or pause: the record is sent afterwards if still relevant
+                continue
+            self.sink.send(ac_id, msg)
+            if self.verbose:
+                self._print_record(t, ac_id, msg, deadline)
+            self.sent += 1
+            self.log_time = t
+            pending = None
+        self.running = False
+
+    def _print_record(self, t, ac_id, msg, deadline):
+        '''
+        Print a sent record with how late it was sent compared to its recorded time
+        '''
+        name = msg.split(' ', 1)[0] if isinstance(msg, str) else "<%d bytes>" % len(msg)
+        if deadline is None:
+            print("%.3f %s %s" % (t, ac_id, name))
+            return
+        drift = time.monotonic() - deadline
+        self.max_drift = max(self.max_drift, drift)
+        print("%.3f %s %s (%+.1f ms)" % (t, ac_id, name, drift * 1e3))
+
+    def status(self):
+        return "t=%.2f s (%.2f to %.2f), %d messages sent, speed %s%s" % (
+            self.log_time, self.log.t_start, self.log.t_end, self.sent,
+            "max" if self.speed <= 0 else "%gx" % self.speed, ", paused" if self.paused else "")
+
+
+def read_commands(engine):
+    for line in sys.stdin:
+        cmd = line.split()
+        try:
+            if not cmd:
+                print(engine.status())
+            elif cmd[0] == 'p':
+                engine.pause()
+            elif cmd[0] == 's':
+                engine.seek(float(cmd[1]))
+            elif cmd[0] == 'x':
+                engine.set_speed(float(cmd[1]))
+            elif cmd[0] == 'q':
+                break
+            else:
+                print("Unknown command '%s'" % line.strip())
+                continue
+            print(engine.status())
+        except (IndexError, ValueError):
+            print("Missing or wrong argument in '%s'" % line.strip())
+    engine.stop()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Time accurate replay of .data and .plx logs")
+    parser.add_argument("file", help="log file (.data or indexed .plx)")
+    parser.add_argument("-x", "--speed", type=float, default=1., help="speed factor, 0 for maximum speed (default: 1)")
+    parser.add_argument("-s", "--start", type=float, default=None, help="log time to start from in seconds")
+    parser.add_argument("-e", "--end", type=float, default=None, help="log time to stop at in seconds")
+    parser.add_argument("-b", "--bus", default="", help="Ivy bus (default: Ivy default bus)")
+    parser.add_argument("-u", "--udp", default=None, help="send pprzlink frames over UDP to host:port instead of Ivy")
+    parser.add_argument("-v", "--verbose", action="store_true", help="print every sent message with its delay")
+    args = parser.parse_args()
+
+    log = open_log(args.file)
+    print("Log %s: %d messages from %.2f s to %.2f s" % (args.file, log.size, log.t_start, log.t_end))
+
+    if args.udp is not None:
+        host, _, port = args.udp.rpartition(':')
+        sink = UdpSink(host or "127.0.0.1", int(port))
+    else:
+        sink = IvySink(args.bus)
+
+    engine = ReplayEngine(log, sink, args.speed, args.start, args.end, args.verbose)
+    if sys.stdin.isatty():
+        controls = threading.Thread(target=read_commands, args=(engine,))
+        controls.daemon = True
+        controls.start()
+
+    wall = time.monotonic()
+    try:
+        engine.run()
+    except KeyboardInterrupt:
+        engine.stop()
+    finally:
+        sink.close()
+        log.close()
+    print("Done, %s in %.2f s" % (engine.status(), time.monotonic() - wall))
+    if args.verbose and args.speed > 0:
+        print("Messages sent at most %.1f ms late" % (engine.max_drift * 1e3))
+
+
+if __name__ == '__main__':
+    main()
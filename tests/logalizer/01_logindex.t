@@ -0,0 +1,65 @@
+#!/usr/bin/perl -w
+
+#
+# Round trip of a .data log through an indexed log (.plx):
+# logindex convert then logindex extract must give back the original lines.
+#
+# Mandatory environment variables:
+#  PAPARAZZI_SRC : path to paparazzi source directory
+#
+
+use Test::More tests => 6;
+use File::Temp qw(tempdir);
+
+$|++;
+
+my $src = "$ENV{'PAPARAZZI_SRC'}/sw/logalizer";
+my $tmp = tempdir(CLEANUP => 1);
+my $logindex = "$tmp/logindex";
+
+ok(system("cc -std=gnu99 -O2 -o $logindex $src/logindex.c $src/log_index.c $src/pprzlog_decode.c -lpthread") == 0,
+   "logindex builds");
+
+# Sample log over several chunks: server lines (%.3f), sd2log lines (%.4f),
+# messages without fields and two aircraft
+my @lines;
+my $t = 0.;
+for my $i (0 .. 2999) {
+  $t += 0.0125;
+  my $ac = ($i % 7 == 0) ? "12" : "5";
+  if ($i % 5 == 0) {
+    push @lines, sprintf("%.4f %s ATTITUDE %.6f %.6f %.6f", $t, $ac, sin($i), cos($i), $i / 1000.);
+  } elsif ($i % 11 == 0) {
+    push @lines, sprintf("%.3f %s PING ", $t, $ac);
+  } else {
+    push @lines, sprintf("%.3f %s GPS 3 %d %d 1234 %d", $t, $ac, 36000000 + $i, 481000000 - $i, $i % 360);
+  }
+}
+my $data = join("\n", @lines) . "\n";
+open(my $fh, '>', "$tmp/sample.data") or die;
+print $fh $data;
+close($fh);
+
+ok(system("$logindex convert $tmp/sample.data $tmp/sample.plx > /dev/null") == 0, "logindex convert");
+
+sub extract
+{
+  my $options = shift;
+  system("$logindex extract $tmp/sample.plx $options -o $tmp/out.data") == 0 or return undef;
+  open(my $in, '<', "$tmp/out.data") or return undef;
+  local $/;
+  my $out = <$in>;
+  close($in);
+  return $out;
+}
+
+is(extract(""), $data, "extract gives back the original lines byte for byte");
+
+my $gps = join("", map { "$_\n" } grep { / GPS / } @lines);
+is(extract("-m GPS"), $gps, "extract of one message");
+
+my $ac = join("", map { "$_\n" } grep { /^\S+ 12 / } @lines);
+is(extract("-a 12"), $ac, "extract of one aircraft");
+
+my $range = join("", map { "$_\n" } grep { my ($lt) = split(/ /); $lt >= 10. && $lt <= 20. } @lines);
+is(extract("-s 10 -e 20"), $range, "extract of a time range");
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_algebra_batch.c
+ * @brief Batch rotation functions against the single element ones.
+ *
+ * The number of elements is not a multiple of four so that the scalar
+ * remainder is also checked. The timings of both versions are reported.
+ */
+
+#include <stdlib.h>
+#include "tap.h"
+#include "test_utils.h"
+#include "math/pprz_algebra_float.h"
+
+#define N 1001
+#define NB_RUNS 2000
+
+static float qi[N], qx[N], qy[N], qz[N];
+static float pi[N], px[N], py[N], pz[N];
+static float ci[N], cx[N], cy[N], cz[N];
+static float vx[N], vy[N], vz[N];
+static float ox[N], oy[N], oz[N];
+static float wp[N], wq[N], wr[N];
+
+static void rand_quat(float *i, float *x, float *y, float *z)
+{
+  struct FloatQuat q = { rand_float(), rand_float(), rand_float(), rand_float() };
+  float_quat_normalize(&q);
+  *i = q.qi;
+  *x = q.qx;
+  *y = q.qy;
+  *z = q.qz;
+}
+
+static float max_err;
+
+static void check(float a, float b)
+{
+  float e = fabsf(a - b);
+  max_err = e > max_err ? e : max_err;
+}
+
+int main()
+{
+  note("running batch algebra tests");
+  plan(4);
+  srand(1);
+
+  for (int i = 0; i < N; i++) {
+    rand_quat(&qi[i], &qx[i], &qy[i], &qz[i]);
+    rand_quat(&pi[i], &px[i], &py[i], &pz[i]);
+    vx[i] = rand_float();
+    vy[i] = rand_float();
+    vz[i] = rand_float();
+    wp[i] = 3.f * rand_float();
+    wq[i] = 3.f * rand_float();
+    wr[i] = 3.f * rand_float();
+  }
+  wp[N - 1] = wq[N - 1] = wr[N - 1] = 0.f;
+  wp[0] = wq[0] = wr[0] = 0.f;
+
+  struct FloatQuatArray q = { qi, qx, qy, qz };
+  struct FloatQuatArray p = { pi, px, py, pz };
+  struct FloatQuatArray c = { ci, cx, cy, cz };
+  struct FloatVect3Array v = { vx, vy, vz };
+  struct FloatVect3Array o = { ox, oy, oz };
+  struct FloatRatesArray w = { wp, wq, wr };
+  double t0, t_batch, t_single;
+
+  /* rotation matrix */
+  struct FloatEulers e = { 0.3f, -0.2f, 1.2f };
+  struct FloatRMat rm;
+  float_rmat_of_eulers(&rm, &e);
+  float_rmat_vmult_batch(&o, &rm, &v, N);
+  max_err = 0.f;
+  for (int i = 0; i < N; i++) {
+    struct FloatVect3 a = { vx[i], vy[i], vz[i] }, b;
+    float_rmat_vmult(&b, &rm, &a);
+    check(b.x, ox[i]);
+    check(b.y, oy[i]);
+    check(b.z, oz[i]);
+  }
+  ok(max_err < 1e-6f, "float_rmat_vmult_batch, max error %g", max_err);
+  t0 = now();
+  for (int r = 0; r < NB_RUNS; r++) {
+    float_rmat_vmult_batch(&o, &rm, &v, N);
+  }
+  t_batch = now() - t0;
+  t0 = now();
+  for (int r = 0; r < NB_RUNS; r++) {
+    for (int i = 0; i < N; i++) {
+      struct FloatVect3 a = { vx[i], vy[i], vz[i] }, b;
+      float_rmat_vmult(&b, &rm, &a);
+      ox[i] = b.x;
+      oy[i] = b.y;
+      oz[i] = b.z;
+    }
+  }
+  t_single = now() - t0;
+  note("  rmat_vmult: %.2f ns batch, %.2f ns single per vector", t_batch / NB_RUNS / N * 1e9,
+       t_single / NB_RUNS / N * 1e9);
+
+  /* quaternion rotation */
+  float_quat_vmult_batch(&o, &q, &v, N);
+  max_err = 0.f;
+  for (int i = 0; i < N; i++) {
+    struct FloatQuat qs = { qi[i], qx[i], qy[i], qz[i] };
+    struct FloatVect3 a = { vx[i], vy[i], vz[i] }, b;
+    float_quat_vmult(&b, &qs, &a);
+    check(b.x, ox[i]);
+    check(b.y, oy[i]);
+    check(b.z, oz[i]);
+  }
+  ok(max_err < 1e-6f, "float_quat_vmult_batch, max error %g", max_err);
+  t0 = now();
+  for (int r = 0; r < NB_RUNS; r++) {
+    float_quat_vmult_batch(&o, &q, &v, N);
+  }
+  t_batch = now() - t0;
+  t0 = now();
+  for (int r = 0; r < NB_RUNS; r++) {
+    for (int i = 0; i < N; i++) {
+      struct FloatQuat qs = { qi[i], qx[i], qy[i], qz[i] };
+      struct FloatVect3 a = { vx[i], vy[i], vz[i] }, b;
+      float_quat_vmult(&b, &qs, &a);
+      ox[i] = b.x;
+      oy[i] = b.y;
+      oz[i] = b.z;
+    }
+  }
+  t_single = now() - t0;
+  note("  quat_vmult: %.2f ns batch, %.2f ns single per vector", t_batch / NB_RUNS / N * 1e9,
+       t_single / NB_RUNS / N * 1e9);
+
+  /* composition */
+  float_quat_comp_batch(&c, &q, &p, N);
+  max_err = 0.f;
+  for (int i = 0; i < N; i++) {
+    struct FloatQuat a = { qi[i], qx[i], qy[i], qz[i] };
+    struct FloatQuat b = { pi[i], px[i], py[i], pz[i] };
+    struct FloatQuat r;
+    float_quat_comp(&r, &a, &b);
+    check(r.qi, ci[i]);
+    check(r.qx, cx[i]);
+    check(r.qy, cy[i]);
+    check(r.qz, cz[i]);
+  }
+  ok(max_err < 1e-6f, "float_quat_comp_batch, max error %g", max_err);
+
+  /* integration, in place on a copy */
+  for (int i = 0; i < N; i++) {
+    ci[i] = qi[i];
+    cx[i] = qx[i];
+    cy[i] = qy[i];
+    cz[i] = qz[i];
+  }
+  float_quat_integrate_batch(&c, &w, 0.01f, N);
+  max_err = 0.f;
+  for (int i = 0; i < N; i++) {
+    struct FloatQuat a = { qi[i], qx[i], qy[i], qz[i] };
+    struct FloatRates r = { wp[i], wq[i], wr[i] };
+    float_quat_integrate(&a, &r, 0.01f);
+    check(a.qi, ci[i]);
+    check(a.qx, cx[i]);
+    check(a.qy, cy[i]);
+    check(a.qz, cz[i]);
+  }
+  ok(max_err < 1e-6f, "float_quat_integrate_batch, max error %g", max_err);
+
+  done_testing();
+}
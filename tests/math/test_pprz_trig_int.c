@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_pprz_trig_int.c
+ * @brief Precision and timings of the fixed point trig functions.
+ *
+ * The interpolated sine, cosine and arc tangent are checked against the
+ * double precision functions, and compared with the full table and the
+ * self-normalizing atan2 approximations.
+ */
+
+#include <stdlib.h>
+#include "tap.h"
+#include "test_utils.h"
+#include "math/pprz_algebra_int.h"
+#include "math/pprz_trig_int.h"
+
+#define NB_RUNS 1000000
+
+/* error in units of the last bit of INT32_TRIG_FRAC */
+static double trig_err(int32_t v, double ref)
+{
+  return fabs(v - ref * (1 << INT32_TRIG_FRAC));
+}
+
+/* error in units of the last bit of INT32_ANGLE_FRAC, modulo 2 pi */
+static double angle_err(int32_t a, double ref)
+{
+  double d = ANGLE_FLOAT_OF_BFP((double)a) - ref;
+  d = remainder(d, 2. * M_PI);
+  return fabs(d) * (1 << INT32_ANGLE_FRAC);
+}
+
+static int32_t rand_int(int32_t range)
+{
+  return (int32_t)(((double)rand() / RAND_MAX * 2. - 1.) * range);
+}
+
+int main()
+{
+  note("running fixed point trig tests");
+  plan(6);
+  srand(5);
+
+  /* sine and cosine over a few turns, every angle */
+  double err_sin = 0., err_cos = 0., err_table = 0.;
+  for (int32_t a = -2 * INT32_ANGLE_2_PI; a <= 2 * INT32_ANGLE_2_PI; a++) {
+    const double ar = ANGLE_FLOAT_OF_BFP((double)a);
+    err_sin = fmax(err_sin, trig_err(pprz_itrig_sin_interp(a), sin(ar)));
+    err_cos = fmax(err_cos, trig_err(pprz_itrig_cos_interp(a), cos(ar)));
+    if (abs(a) <= INT32_ANGLE_PI) {
+      /* the full table normalizes with a truncated 2 pi */
+      err_table = fmax(err_table, trig_err(pprz_itrig_sin(a), sin(ar)));
+    }
+  }
+  ok(err_sin < 1., "pprz_itrig_sin_interp max error %.2f lsb (full table %.2f lsb)", err_sin, err_table);
+  ok(err_cos < 1., "pprz_itrig_cos_interp max error %.2f lsb", err_cos);
+
+  /* exact values and symmetry */
+  int sym = 1;
+  for (int32_t a = 0; a < INT32_ANGLE_2_PI; a++) {
+    sym &= pprz_itrig_sin_interp(-a) == -pprz_itrig_sin_interp(a);
+  }
+  ok(sym && pprz_itrig_sin_interp(0) == 0 && pprz_itrig_cos_interp(0) == TRIG_BFP_OF_REAL(1.) &&
+     pprz_itrig_sin_interp(INT32_ANGLE_PI_2) == TRIG_BFP_OF_REAL(1.) &&
+     pprz_itrig_sin_interp(-INT32_ANGLE_PI_2) == -TRIG_BFP_OF_REAL(1.),
+     "pprz_itrig_sin_interp is odd and exact at 0 and pi/2");
+
+  /* arc tangent on random vectors of all sizes */
+  double err_atan = 0., err_atan1 = 0., err_atan2 = 0.;
+  for (int s = 0; s < 200000; s++) {
+    const int32_t range = 1 << (s % 24 + 4);
+    const int32_t y = rand_int(range);
+    const int32_t x = rand_int(range);
+    if (x == 0 && y == 0) {
+      continue;
+    }
+    const double ref = atan2(y, x);
+    err_atan = fmax(err_atan, angle_err(int32_atan2_interp(y, x), ref));
+    if (hypot(x, y) >= 256. && range <= (1 << 15)) {
+      /* the self-normalizing versions are biased on small vectors and overflow above */
+      err_atan1 = fmax(err_atan1, angle_err(int32_atan2(y, x), ref));
+      err_atan2 = fmax(err_atan2, angle_err(int32_atan2_2(y, x), ref));
+    }
+  }
+  ok(err_atan < 1., "int32_atan2_interp max error %.2f lsb (int32_atan2 %.1f lsb, int32_atan2_2 %.1f lsb)",
+     err_atan, err_atan1, err_atan2);
+
+  /* axes and bounds */
+  ok(int32_atan2_interp(0, 0) == 0 && int32_atan2_interp(0, 1) == 0 &&
+     angle_err(int32_atan2_interp(0, -1), M_PI) < 1. && angle_err(int32_atan2_interp(1, 0), M_PI_2) < 1. &&
+     angle_err(int32_atan2_interp(-1, 0), -M_PI_2) < 1. &&
+     angle_err(int32_atan2_interp(INT32_MIN, INT32_MIN), -3. * M_PI_4) < 1. &&
+     angle_err(int32_atan2_interp(INT32_MAX, INT32_MIN), 3. * M_PI_4) < 1.,
+     "int32_atan2_interp on the axes and at the int32 bounds");
+
+  /* sin(atan2(y, x)) round trip */
+  double err_trip = 0.;
+  for (int s = 0; s < 100000; s++) {
+    const int32_t y = rand_int(1 << 20);
+    const int32_t x = rand_int(1 << 20);
+    const double n = sqrt((double)x * x + (double)y * y);
+    if (n < 1.) {
+      continue;
+    }
+    const int32_t a = int32_atan2_interp(y, x);
+    err_trip = fmax(err_trip, trig_err(pprz_itrig_sin_interp(a), y / n));
+    err_trip = fmax(err_trip, trig_err(pprz_itrig_cos_interp(a), x / n));
+  }
+  ok(err_trip < 4., "sin/cos of int32_atan2_interp max error %.2f lsb", err_trip);
+
+  /* timings, the inputs are stored in a table so that they are not folded */
+  static int32_t in_a[1024], in_x[1024], in_y[1024];
+  for (int i = 0; i < 1024; i++) {
+    in_a[i] = rand_int(INT32_ANGLE_2_PI);
+    in_x[i] = rand_int(1 << 14);
+    in_y[i] = rand_int(1 << 14);
+  }
+  volatile int32_t sum = 0;
+  volatile float sumf = 0.f;
+  double t[8];
+  t[0] = now();
+  for (int s = 0; s < NB_RUNS; s++) {
+    sum += pprz_itrig_sin(in_a[s & 1023]);
+  }
+  t[1] = now();
+  for (int s = 0; s < NB_RUNS; s++) {
+    sum += pprz_itrig_sin_interp(in_a[s & 1023]);
+  }
+  t[2] = now();
+  for (int s = 0; s < NB_RUNS; s++) {
+    sumf += sinf(ANGLE_FLOAT_OF_BFP(in_a[s & 1023]));
+  }
+  t[3] = now();
+  for (int s = 0; s < NB_RUNS; s++) {
+    sum += int32_atan2(in_y[s & 1023], in_x[s & 1023]);
+  }
+  t[4] = now();
+  for (int s = 0; s < NB_RUNS; s++) {
+    sum += int32_atan2_2(in_y[s & 1023], in_x[s & 1023]);
+  }
+  t[5] = now();
+  for (int s = 0; s < NB_RUNS; s++) {
+    sum += int32_atan2_interp(in_y[s & 1023], in_x[s & 1023]);
+  }
+  t[6] = now();
+  for (int s = 0; s < NB_RUNS; s++) {
+    sumf += atan2f(in_y[s & 1023], in_x[s & 1023]);
+  }
+  t[7] = now();
+  note("sin: %.1f ns table, %.1f ns interp, %.1f ns sinf", (t[1] - t[0]) / NB_RUNS * 1e9,
+       (t[2] - t[1]) / NB_RUNS * 1e9, (t[3] - t[2]) / NB_RUNS * 1e9);
+  note("atan2: %.1f ns int32_atan2, %.1f ns int32_atan2_2, %.1f ns interp, %.1f ns atan2f",
+       (t[4] - t[3]) / NB_RUNS * 1e9, (t[5] - t[4]) / NB_RUNS * 1e9, (t[6] - t[5]) / NB_RUNS * 1e9,
+       (t[7] - t[6]) / NB_RUNS * 1e9);
+
+  done_testing();
+}
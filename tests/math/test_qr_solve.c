@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_qr_solve.c
+ * @brief Tests of the least squares solvers of math/qr_solve.
+ *
+ * The workspace and fixed size solvers are checked against qr_solve on
+ * random full rank and rank deficient systems, and timed.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "tap.h"
+#include "test_utils.h"
+#include "math/qr_solve/qr_solve.h"
+#include "math/qr_solve/qr_solve_fixed.h"
+
+#define M 8
+#define N 4
+#define NB_SYSTEMS 1000
+
+QR_SOLVE_FIXED_DEFINE(8, 4)
+QR_SOLVE_FIXED_DEFINE(3, 5)
+
+static void rand_system(int m, int n, float *a, float *b)
+{
+  for (int i = 0; i < m * n; i++) {
+    a[i] = rand_float();
+  }
+  for (int i = 0; i < m; i++) {
+    b[i] = rand_float();
+  }
+}
+
+/* |A x - b| with A column-major */
+static float residual(int m, int n, const float *a, const float *b, const float *x)
+{
+  float r2 = 0.f;
+  for (int i = 0; i < m; i++) {
+    float r = -b[i];
+    for (int j = 0; j < n; j++) {
+      r += a[i + j * m] * x[j];
+    }
+    r2 += r * r;
+  }
+  return sqrtf(r2);
+}
+
+static float max_diff(int n, const float *x, const float *y)
+{
+  float d = 0.f;
+  for (int i = 0; i < n; i++) {
+    d = fmaxf(d, fabsf(x[i] - y[i]));
+  }
+  return d;
+}
+
+int main()
+{
+  note("running qr_solve tests");
+  plan(6);
+  srand(42);
+
+  float a[M * N], b[M], x_ref[N], x[N];
+  float work[QR_SOLVE_WORK_SIZE(M, N)];
+  int iwork[QR_SOLVE_IWORK_SIZE(M, N)];
+
+  /* the workspace version is the same computation as qr_solve */
+  int same = 1;
+  for (int s = 0; s < NB_SYSTEMS; s++) {
+    rand_system(M, N, a, b);
+    qr_solve(M, N, a, b, x_ref);
+    qr_solve_ws(M, N, a, b, x, work, iwork);
+    same &= memcmp(x, x_ref, sizeof(x)) == 0;
+  }
+  ok(same, "qr_solve_ws gives the same results as qr_solve");
+
+  /* full rank: same solution up to rounding */
+  float err = 0.f;
+  int full_rank = 1;
+  for (int s = 0; s < NB_SYSTEMS; s++) {
+    rand_system(M, N, a, b);
+    qr_solve(M, N, a, b, x_ref);
+    full_rank &= qr_solve_fixed_8x4(a, b, x) == N;
+    float scale = fmaxf(1.f, max_diff(N, x_ref, (float[N]) {0}));
+    err = fmaxf(err, max_diff(N, x, x_ref) / scale);
+  }
+  ok(full_rank && err < 1e-4f, "qr_solve_fixed_8x4 full rank, max relative error %g", err);
+
+  /* rank deficient: exactly zero column, the dependent unknown is zero */
+  float res_err = 0.f;
+  int rank3 = 1;
+  for (int s = 0; s < NB_SYSTEMS; s++) {
+    rand_system(M, N, a, b);
+    memset(&a[2 * M], 0, M * sizeof(float));
+    qr_solve(M, N, a, b, x_ref);
+    rank3 &= qr_solve_fixed_8x4(a, b, x) == 3 && x[2] == 0.f;
+    res_err = fmaxf(res_err, fabsf(residual(M, N, a, b, x) - residual(M, N, a, b, x_ref)));
+  }
+  ok(rank3 && res_err < 1e-4f, "qr_solve_fixed_8x4 zero column, max residual difference %g", res_err);
+
+  /* numerically dependent column: both solvers use the LINPACK tolerance which
+   * is at the rounding level in single precision, so the rank is not always
+   * detected. Compare the residuals when both detect it, the basic solutions
+   * may differ. qr_solve sets the dependent unknown to zero. */
+  res_err = 0.f;
+  int nb_detected = 0;
+  for (int s = 0; s < NB_SYSTEMS; s++) {
+    rand_system(M, N, a, b);
+    for (int i = 0; i < M; i++) {
+      a[i + 3 * M] = a[i] - 0.5f * a[i + M];
+    }
+    qr_solve(M, N, a, b, x_ref);
+    int ref_rank3 = x_ref[0] == 0.f || x_ref[1] == 0.f || x_ref[3] == 0.f;
+    if (qr_solve_fixed_8x4(a, b, x) == 3 && ref_rank3) {
+      nb_detected++;
+      res_err = fmaxf(res_err, fabsf(residual(M, N, a, b, x) - residual(M, N, a, b, x_ref)));
+    }
+  }
+  ok(nb_detected > 0 && res_err < 1e-4f, "qr_solve_fixed_8x4 dependent column (%d/%d detected by both), max residual difference %g",
+     nb_detected, NB_SYSTEMS, res_err);
+
+  /* underdetermined: exact solution */
+  float a35[3 * 5], b3[3], x5[5];
+  float res = 0.f;
+  for (int s = 0; s < NB_SYSTEMS; s++) {
+    rand_system(3, 5, a35, b3);
+    qr_solve_fixed_3x5(a35, b3, x5);
+    res = fmaxf(res, residual(3, 5, a35, b3, x5));
+  }
+  ok(res < 1e-4f, "qr_solve_fixed_3x5 underdetermined, max residual %g", res);
+
+  /* zero matrix */
+  memset(a, 0, sizeof(a));
+  ok(qr_solve_fixed_8x4(a, b, x) == 0 && x[0] == 0.f && x[N - 1] == 0.f, "qr_solve_fixed_8x4 of a zero matrix");
+
+  /* timings */
+  const int nb = 100000;
+  float sum = 0.f;
+  rand_system(M, N, a, b);
+  double t0 = now();
+  for (int s = 0; s < nb; s++) {
+    b[0] = s * 1e-6f;
+    qr_solve(M, N, a, b, x);
+    sum += x[0];
+  }
+  double t1 = now();
+  for (int s = 0; s < nb; s++) {
+    b[0] = s * 1e-6f;
+    qr_solve_ws(M, N, a, b, x, work, iwork);
+    sum += x[0];
+  }
+  double t2 = now();
+  for (int s = 0; s < nb; s++) {
+    b[0] = s * 1e-6f;
+    qr_solve_fixed_8x4(a, b, x);
+    sum += x[0];
+  }
+  double t3 = now();
+  note("8x4 solve: qr_solve %.0f ns, qr_solve_ws %.0f ns, qr_solve_fixed %.0f ns (%g)",
+       (t1 - t0) / nb * 1e9, (t2 - t1) / nb * 1e9, (t3 - t2) / nb * 1e9, sum);
+
+  done_testing();
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_ransac.c
+ * @brief Tests of the RANSAC linear fit.
+ *
+ * The batched hypothesis selection is checked against a plain evaluation
+ * of every hypothesis on all samples.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include "tap.h"
+#include "test_utils.h"
+#include "math/RANSAC.h"
+
+#define D 2
+#define COUNT 300
+#define N_HYP 23
+
+int main()
+{
+  note("running RANSAC tests");
+  plan(3);
+  srand(7);
+
+  float samples[COUNT][D], targets[COUNT];
+  float hypotheses[N_HYP * (D + 1)];
+  const float threshold = 0.2f;
+
+  /* plane with 30% of outliers */
+  for (int p = 0; p < COUNT; p++) {
+    samples[p][0] = 10.f * rand_float();
+    samples[p][1] = 10.f * rand_float();
+    targets[p] = 0.5f * samples[p][0] - 2.f * samples[p][1] + 3.f + 0.05f * rand_float();
+    if (p % 10 < 3) {
+      targets[p] += 20.f * rand_float();
+    }
+  }
+
+  /* hypotheses close to the plane, the selection must match a plain evaluation */
+  int same = 1;
+  for (int trial = 0; trial < 50; trial++) {
+    for (int h = 0; h < N_HYP * (D + 1); h++) {
+      const float plane[D + 1] = {0.5f, -2.f, 3.f};
+      hypotheses[h] = plane[h % (D + 1)] + 0.1f * rand_float();
+    }
+    int ref = 0;
+    float ref_err = 0.f;
+    for (int h = 0; h < N_HYP; h++) {
+      float err = 0.f;
+      for (int p = 0; p < COUNT; p++) {
+        float e = fabsf(predict_value(samples[p], &hypotheses[h * (D + 1)], D, true) - targets[p]);
+        err += (e > threshold) ? threshold : e;
+      }
+      if (h == 0 || err < ref_err) {
+        ref_err = err;
+        ref = h;
+      }
+    }
+    float err;
+    int best = RANSAC_best_linear_hypothesis(N_HYP, D, hypotheses, samples, targets, COUNT, threshold, &err);
+    same &= best == ref && fabsf(err - ref_err) < 1e-3f * ref_err;
+  }
+  ok(same, "RANSAC_best_linear_hypothesis selects the same hypothesis as a plain evaluation");
+
+  /* the fit finds the plane */
+  float params[D + 1], fit_error;
+  RANSAC_linear_model(D + 1, 50, threshold, targets, D, samples, COUNT, params, &fit_error);
+  ok(fabsf(params[0] - 0.5f) < 0.05f && fabsf(params[1] + 2.f) < 0.05f && fabsf(params[2] - 3.f) < 0.2f,
+     "RANSAC_linear_model fit [%f, %f, %f]", params[0], params[1], params[2]);
+  ok(fit_error < 0.5f * COUNT * threshold, "RANSAC_linear_model capped error %f", fit_error);
+
+  done_testing();
+}
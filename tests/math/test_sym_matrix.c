@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_sym_matrix.c
+ * @brief Packed symmetric covariance kernels against the full matrix macros.
+ *
+ * The covariance steps of ahrs_float_mlkf (6 states, 3D measurements) are
+ * done with pprz_simple_matrix.h and with pprz_matrix_sym_float.h, and
+ * timed. The 3 states propagation of hf_float is checked against its
+ * hand expanded form.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "tap.h"
+#include "test_utils.h"
+#include "math/pprz_simple_matrix.h"
+#include "math/pprz_matrix_sym_float.h"
+
+#define NB_RUNS 100000
+
+SYM_MAT_FIXED_DEFINE(6)
+SYM_MAT_FIXED_UPDATE_DEFINE(6, 3)
+SYM_MAT_FIXED_DEFINE(3)
+
+/* random symmetric positive definite matrix A A' + I */
+static void rand_spd6(float P[6][6])
+{
+  float A[6][6];
+  for (int i = 0; i < 6; i++) {
+    for (int j = 0; j < 6; j++) {
+      A[i][j] = rand_float();
+    }
+  }
+  MAT_MUL_T(6, 6, 6, P, A, A);
+  for (int i = 0; i < 6; i++) {
+    P[i][i] += 1.f;
+  }
+}
+
+/* mlkf transition matrix for random rates */
+static void mlkf_F(float F[6][6], float dt)
+{
+  const float dp = 3.f * rand_float() * dt;
+  const float dq = 3.f * rand_float() * dt;
+  const float dr = 3.f * rand_float() * dt;
+  float F0[6][6] = {{  1.,   dr,  -dq,  -dt,   0.,   0.  },
+    { -dr,   1.,   dp,   0.,  -dt,   0.  },
+    {  dq,  -dp,   1.,   0.,   0.,  -dt  },
+    {  0.,   0.,   0.,   1.,   0.,   0.  },
+    {  0.,   0.,   0.,   0.,   1.,   0.  },
+    {  0.,   0.,   0.,   0.,   0.,   1.  }
+  };
+  memcpy(F, F0, sizeof(F0));
+}
+
+/* mlkf measurement matrix for a random expected vector */
+static void mlkf_H(float H[3][6])
+{
+  const float x = rand_float(), y = rand_float(), z = rand_float();
+  float H0[3][6] = {{ 0., -z,  y, 0., 0., 0.},
+    {  z, 0., -x, 0., 0., 0.},
+    { -y,  x, 0., 0., 0., 0.}
+  };
+  memcpy(H, H0, sizeof(H0));
+}
+
+/* full matrix propagation as in the original mlkf */
+static void full_propagate(float P[6][6], float F[6][6], const float Q[6])
+{
+  float tmp[6][6];
+  MAT_MUL(6, 6, 6, tmp, F, P);
+  MAT_MUL_T(6, 6, 6, P, tmp, F);
+  for (int i = 0; i < 6; i++) {
+    P[i][i] += Q[i];
+  }
+}
+
+/* full matrix update as in the original mlkf, returns K */
+static void full_update(float P[6][6], float H[3][6], const float R[3], float K[6][3])
+{
+  float tmp[3][6];
+  MAT_MUL(3, 6, 6, tmp, H, P);
+  float S[3][3];
+  MAT_MUL_T(3, 6, 3, S, tmp, H);
+  S[0][0] += R[0];
+  S[1][1] += R[1];
+  S[2][2] += R[2];
+  float invS[3][3];
+  MAT_INV33(invS, S);
+  float tmp2[6][3];
+  MAT_MUL_T(6, 6, 3, tmp2, P, H);
+  MAT_MUL(6, 3, 3, K, tmp2, invS);
+  float tmp3[6][6];
+  MAT_MUL(6, 3, 6, tmp3, K, H);
+  float I6[6][6] = {{ 1., 0., 0., 0., 0., 0. },
+    {  0., 1., 0., 0., 0., 0. },
+    {  0., 0., 1., 0., 0., 0. },
+    {  0., 0., 0., 1., 0., 0. },
+    {  0., 0., 0., 0., 1., 0. },
+    {  0., 0., 0., 0., 0., 1. }
+  };
+  float tmp4[6][6];
+  MAT_SUB(6, 6, tmp4, I6, tmp3);
+  float tmp5[6][6];
+  MAT_MUL(6, 6, 6, tmp5, tmp4, P);
+  memcpy(P, tmp5, sizeof(tmp5));
+}
+
+/* packed update as in the mlkf, returns K */
+static void sym_update(float *p, float H[3][6], const float R[3], float K[6][3])
+{
+  float PHt[6][3];
+  sym_mat_pht_6x3(&PHt[0][0], p, &H[0][0]);
+  float S[3][3];
+  sym_mat_hpht_6x3(&S[0][0], &H[0][0], &PHt[0][0], R);
+  float invS[3][3];
+  MAT_INV33(invS, S);
+  MAT_MUL(6, 3, 3, K, PHt, invS);
+  sym_mat_correct_6x3(p, &K[0][0], &PHt[0][0]);
+}
+
+/* largest difference relative to the largest element of the full matrix */
+static float rel_diff6(float P[6][6], const float *p)
+{
+  float d = 0.f, m = 0.f;
+  for (int i = 0; i < 6; i++) {
+    for (int j = 0; j < 6; j++) {
+      d = fmaxf(d, fabsf(P[i][j] - sym_mat_get(6, p, i, j)));
+      m = fmaxf(m, fabsf(P[i][j]));
+    }
+  }
+  return d / m;
+}
+
+int main()
+{
+  note("running symmetric matrix tests");
+  plan(5);
+  srand(3);
+
+  const float dt = 1.f / 512.f;
+  const float Q[6] = {dt *dt * 10e-3, dt *dt * 10e-3, dt *dt * 10e-3, dt *dt * 9e-6, dt *dt * 9e-6, dt *dt * 9e-6 };
+  const float R[3] = { 0.2f, 0.2f, 0.2f };
+  float P[6][6], F[6][6], H[3][6], K[6][3], Ks[6][3], U[6][6];
+  float p[SYM_MAT_SIZE(6)];
+
+  /* pack and unpack */
+  rand_spd6(P);
+  sym_mat_pack_6(p, &P[0][0]);
+  sym_mat_unpack_6(&U[0][0], p);
+  ok(memcmp(P, U, sizeof(P)) == 0 && p[SYM_MAT_IDX(6, 2, 4)] == P[4][2], "sym_mat_pack_6 / sym_mat_unpack_6");
+
+  /* propagation */
+  float err = 0.f;
+  for (int s = 0; s < 1000; s++) {
+    rand_spd6(P);
+    sym_mat_pack_6(p, &P[0][0]);
+    mlkf_F(F, dt);
+    full_propagate(P, F, Q);
+    sym_mat_propagate_6(p, &F[0][0], Q);
+    err = fmaxf(err, rel_diff6(P, p));
+  }
+  ok(err < 1e-6f, "sym_mat_propagate_6 as FPF' + Q, max relative error %g", err);
+
+  /* update */
+  err = 0.f;
+  float err_k = 0.f;
+  for (int s = 0; s < 1000; s++) {
+    rand_spd6(P);
+    sym_mat_pack_6(p, &P[0][0]);
+    mlkf_H(H);
+    full_update(P, H, R, K);
+    sym_update(p, H, R, Ks);
+    err = fmaxf(err, rel_diff6(P, p));
+    for (int i = 0; i < 6; i++) {
+      for (int j = 0; j < 3; j++) {
+        err_k = fmaxf(err_k, fabsf(K[i][j] - Ks[i][j]));
+      }
+    }
+  }
+  ok(err < 1e-5f && err_k < 1e-5f, "sym_mat_correct_6x3 as (I-KH)P, max relative error %g, gain error %g", err, err_k);
+
+  /* a long run of the mlkf covariance stays symmetric positive */
+  rand_spd6(P);
+  sym_mat_pack_6(p, &P[0][0]);
+  int positive = 1;
+  for (int s = 0; s < 10000; s++) {
+    mlkf_F(F, dt);
+    sym_mat_propagate_6(p, &F[0][0], Q);
+    if (s % 10 == 0) {
+      mlkf_H(H);
+      sym_update(p, H, R, Ks);
+    }
+    for (int i = 0; i < 6; i++) {
+      positive &= p[SYM_MAT_IDX(6, i, i)] > 0.f;
+    }
+  }
+  ok(positive, "packed mlkf covariance stays positive over 10000 steps");
+
+  /* hf_float propagation, hand expanded */
+  float xP[3][3] = {{ 2.f, 0.3f, -0.1f }, { 0.3f, 1.f, 0.05f }, { -0.1f, 0.05f, 0.5f }};
+  float F3[3][3] = {{ 1.f, dt, 0.f }, { 0.f, 1.f, -dt }, { 0.f, 0.f, 1.f }};
+  float p3[SYM_MAT_SIZE(3)];
+  sym_mat_pack_3(p3, &xP[0][0]);
+  sym_mat_propagate_3(p3, &F3[0][0], NULL);
+  const float FPF00 = xP[0][0] + dt * (xP[1][0] + xP[0][1] + dt * xP[1][1]);
+  const float FPF01 = xP[0][1] + dt * (xP[1][1] - xP[0][2] - dt * xP[1][2]);
+  const float FPF02 = xP[0][2] + dt * (xP[1][2]);
+  const float FPF11 = xP[1][1] + dt * (-xP[2][1] - xP[1][2] + dt * xP[2][2]);
+  const float FPF12 = xP[1][2] + dt * (-xP[2][2]);
+  const float FPF22 = xP[2][2];
+  const float ref3[SYM_MAT_SIZE(3)] = { FPF00, FPF01, FPF02, FPF11, FPF12, FPF22 };
+  err = 0.f;
+  for (int i = 0; i < SYM_MAT_SIZE(3); i++) {
+    err = fmaxf(err, fabsf(p3[i] - ref3[i]));
+  }
+  ok(err < 1e-6f, "sym_mat_propagate_3 as the hf_float expansion, max error %g", err);
+
+  /* timings of the mlkf steps */
+  rand_spd6(P);
+  sym_mat_pack_6(p, &P[0][0]);
+  mlkf_F(F, dt);
+  mlkf_H(H);
+  float sum = 0.f;
+  double t0 = now();
+  for (int s = 0; s < NB_RUNS; s++) {
+    full_propagate(P, F, Q);
+    sum += P[0][0];
+  }
+  double t1 = now();
+  for (int s = 0; s < NB_RUNS; s++) {
+    sym_mat_propagate_6(p, &F[0][0], Q);
+    sum += p[0];
+  }
+  double t2 = now();
+  for (int s = 0; s < NB_RUNS; s++) {
+    /* same setup as the packed version, removed from the timings */
+    rand_spd6(U);
+    sym_mat_pack_6(p, &U[0][0]);
+    full_update(U, H, R, K);
+    sum += K[0][0];
+  }
+  double t3 = now();
+  for (int s = 0; s < NB_RUNS; s++) {
+    rand_spd6(U);
+    sym_mat_pack_6(p, &U[0][0]);
+    sym_update(p, H, R, Ks);
+    sum += Ks[0][0];
+  }
+  double t4 = now();
+  for (int s = 0; s < NB_RUNS; s++) {
+    rand_spd6(U);
+    sym_mat_pack_6(p, &U[0][0]);
+  }
+  double t5 = now();
+  const double t_init = (t5 - t4) / NB_RUNS;
+  note("mlkf propagation: %.0f ns full, %.0f ns packed", (t1 - t0) / NB_RUNS * 1e9, (t2 - t1) / NB_RUNS * 1e9);
+  note("mlkf 3D update: %.0f ns full, %.0f ns packed (%g)", ((t3 - t2) / NB_RUNS - t_init) * 1e9,
+       ((t4 - t3) / NB_RUNS - t_init) * 1e9, sum);
+
+  done_testing();
+}
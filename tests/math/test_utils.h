@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_utils.h
+ *
+ * Random values and timing shared by the tests and benchmarks,
+ * here and in sw/airborne/test.
+ */
+
+#ifndef TEST_UTILS_H
+#define TEST_UTILS_H
+
+#include <stdlib.h>
+#include <time.h>
+
+/** uniform random value in [-1, 1] */
+static inline float rand_float(void)
+{
+  return 2.f * rand() / (float)RAND_MAX - 1.f;
+}
+
+/** centered random value of standard deviation sigma */
+static inline float rand_gauss(float sigma)
+{
+  // sum of uniform variables, good enough here
+  float s = 0.f;
+  for (int i = 0; i < 12; i++) {
+    s += rand() / (float)RAND_MAX;
+  }
+  return sigma * (s - 6.f);
+}
+
+/** monotonic time in s */
+static inline double now(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+#endif /* TEST_UTILS_H */
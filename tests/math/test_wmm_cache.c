@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2026 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_wmm_cache.c
+ * @brief Accuracy and cost of the cached WMM2020 evaluation.
+ *
+ * Fixedwing trajectories sampled at 10Hz are evaluated with mag_calc and
+ * with the cache, the angle between both fields has to stay small. The
+ * longitude wraps to -180 like the GPS one when crossing the antimeridian.
+ */
+
+#include <math.h>
+#include "tap.h"
+#include "test_utils.h"
+#include "std.h"
+#include "math/pprz_geodetic_wmm2020.h"
+
+#define DATE 2021.5
+#define DT 0.1
+#define EARTH_R 6371000.
+
+struct Trajectory {
+  const char *name;
+  double lat, lon, alt;   ///< start in degrees and km
+  double speed;           ///< m/s
+  double course;          ///< initial course in degrees
+  double turn_period;     ///< time between two 180 deg turns in s, 0 for a straight line
+  double climb;           ///< m/s
+  double duration;        ///< s
+};
+
+static double angle_deg(const double *a, const double *b)
+{
+  double dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+  double na = sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+  double nb = sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+  double c = dot / (na * nb);
+  return c >= 1. ? 0. : acos(c) * 180. / M_PI;
+}
+
+static void fly(const struct Trajectory *traj, double *max_angle, uint32_t *nb_eval, int *nb_steps,
+                int *nb_wrapped, double *t_direct, double *t_cache)
+{
+  double gha[MAXCOEFF];
+  int16_t nmax = extrapsh(DATE, GEO_EPOCH, NMAX_1, NMAX_2, gha);
+  struct Wmm2020Cache cache;
+  wmm2020_cache_init(&cache, DATE);
+
+  double lat = traj->lat, lon = traj->lon, alt = traj->alt, course = traj->course;
+  double direct[3], cached[3];
+  *max_angle = 0.;
+  *t_direct = 0.;
+  *t_cache = 0.;
+  *nb_steps = 0;
+  *nb_wrapped = 0;
+  for (double t = 0.; t < traj->duration; t += DT) {
+    double t0 = now();
+    mag_calc(1, lat, lon, alt, nmax, gha, &direct[0], &direct[1], &direct[2],
+             IEXT, EXT_COEFF1, EXT_COEFF2, EXT_COEFF3);
+    double t1 = now();
+    wmm2020_cache_get(&cache, lat, lon, alt, &cached[0], &cached[1], &cached[2]);
+    double t2 = now();
+    *t_direct += t1 - t0;
+    *t_cache += t2 - t1;
+    double a = angle_deg(direct, cached);
+    *max_angle = a > *max_angle ? a : *max_angle;
+    (*nb_steps)++;
+    if ((lon < 0.) != (traj->lon < 0.)) {
+      (*nb_wrapped)++;
+    }
+
+    // move
+    if (traj->turn_period > 0. && fmod(t, traj->turn_period) > traj->turn_period - 30.) {
+      course += 180. / 30. * DT;  // 6 deg/s turn
+    }
+    double d = traj->speed * DT / EARTH_R * 180. / M_PI;
+    lat += d * cos(course * M_PI / 180.);
+    lon += d * sin(course * M_PI / 180.) / cos(lat * M_PI / 180.);
+    // keep the longitude in [-180, 180[ like the GPS
+    if (lon >= 180.) {
+      lon -= 360.;
+    } else if (lon < -180.) {
+      lon += 360.;
+    }
+    alt += traj->climb * DT / 1000.;
+  }
+  *nb_eval = cache.nb_eval;
+}
+
+int main()
+{
+  const struct Trajectory trajs[] = {
+    { "long range, Toulouse to the north east", 43.6, 1.44, 0.2, 28., 45., 0., 0.5, 3. * 3600. },
+    { "survey pattern", 52.0, 4.37, 0.15, 18., 0., 120., 0., 2. * 3600. },
+    { "high latitude transit", 69.5, 18.9, 1.0, 25., 350., 0., 0., 2. * 3600. },
+    { "crossing the antimeridian", -16.5, 179.5, 0.3, 30., 90., 0., 0., 3600. },
+  };
+  const int nb_traj = sizeof(trajs) / sizeof(trajs[0]);
+
+  note("running cached WMM2020 tests");
+  plan(nb_traj + 1);
+
+  for (int i = 0; i < nb_traj; i++) {
+    double max_angle, t_direct, t_cache;
+    uint32_t nb_eval;
+    int nb_steps, nb_wrapped;
+    fly(&trajs[i], &max_angle, &nb_eval, &nb_steps, &nb_wrapped, &t_direct, &t_cache);
+    ok(max_angle < 0.05, "%s: max angle error %.4f deg", trajs[i].name, max_angle);
+    if (trajs[i].lon > 179.) {
+      ok(nb_wrapped > 0 && nb_wrapped < nb_steps, "%s: %d steps east and %d west of 180 deg",
+         trajs[i].name, nb_steps - nb_wrapped, nb_wrapped);
+    }
+    note("  %d steps, %u model evaluations, %.2f us direct, %.3f us cached per step",
+         nb_steps, nb_eval, t_direct / nb_steps * 1e6, t_cache / nb_steps * 1e6);
+  }
+
+  done_testing();
+}